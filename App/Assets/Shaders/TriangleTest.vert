@@ -19,23 +19,38 @@ layout (binding = 1) readonly buffer Indices {
     uint data[]; 
 } in_Indices[];
 
+// One per frame slot, the pre-recorded command buffer pushes which one it reads
 layout (binding = 2) uniform UniformBuffer { 
     mat4 WVP; 
-} ubo;
+} ubo[8]; // VulkanBindlessMeshResourceSet::FRAME_SLOTS
 
+layout (push_constant) uniform FramePushConstants {
+    uint frameSlot;
+} frame;
+
+// DEPTH_ONLY is the depth pre-pass permutation: position only, its pipeline has no fragment shader.
+// Both variants share the gl_Position path so the opaque pass can depth test EQUAL against the pre-pass
+invariant gl_Position;
+
+#ifndef DEPTH_ONLY
 layout (location = 0) out vec2 out_TexCoord;
-layout (location = 1) flat out uint out_MeshIndex;
+layout (location = 1) flat out uint out_TextureIndex;
+#endif
 
 void main()
 {
-    uint meshIndex = nonuniformEXT(uint(gl_InstanceIndex));
+    // firstInstance packs the mesh slot (low 16 bits) and texture slot (high 16 bits), see BindlessDrawId
+    uint drawId = uint(gl_InstanceIndex);
+    uint meshIndex = nonuniformEXT(drawId & 0xFFFFu);
     uint vertexIndex = in_Indices[meshIndex].data[gl_VertexIndex];
     VertexData vertex = in_Vertices[meshIndex].data[vertexIndex];
 
     vec3 pos = vec3(vertex.px, vertex.py, vertex.pz);
 
-    gl_Position = ubo.WVP * vec4(pos, 1.0);
+    gl_Position = ubo[frame.frameSlot].WVP * vec4(pos, 1.0);
 
+#ifndef DEPTH_ONLY
     out_TexCoord = vec2(vertex.u, vertex.v);
-    out_MeshIndex = uint(gl_InstanceIndex);
+    out_TextureIndex = drawId >> 16;
+#endif
 }
\ No newline at end of file
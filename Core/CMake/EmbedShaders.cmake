@@ -0,0 +1,152 @@
+#
+# Core/CMake/EmbedShaders.cmake
+# Build step that compiles GLSL with glslc -O (SPIRV-Tools optimiser) and embeds the result in a target.
+# Each shader becomes a constexpr word array, MarkEmbeddedShaderTable.inl lists them by file name
+#
+# mark_embed_shaders(<target> SHADERS <glsl files...> [PERMUTATIONS <"File.vert:NAME[=VALUE][,NAME...]">...])
+# Every shader is embedded without defines, each permutation adds a variant compiled with -DNAME=VALUE (VALUE
+# defaults to 1). Variants are named "File.vert:A=1,B=2" with names sorted, matching VulkanShaderCache's lookup
+#
+
+function(mark_embed_shaders _target)
+  cmake_parse_arguments(_arg "" "" "SHADERS;PERMUTATIONS" ${ARGN})
+
+  set(_outDir "${CMAKE_CURRENT_BINARY_DIR}/EmbeddedShaders")
+  file(MAKE_DIRECTORY "${_outDir}")
+
+  # One job per embedded module: name, source and the -D arguments it is compiled with
+  set(_jobNames "")
+  set(_jobSources "")
+  set(_jobDefines "")
+  set(_fileNames "")
+  foreach(_shader IN LISTS _arg_SHADERS)
+    get_filename_component(_name "${_shader}" NAME)
+    if (_name IN_LIST _fileNames)
+      message(FATAL_ERROR "Embedded shader name '${_name}' is used twice, lookups are by file name")
+    endif()
+    list(APPEND _fileNames "${_name}")
+    list(APPEND _jobNames "${_name}")
+    list(APPEND _jobSources "${_shader}")
+    list(APPEND _jobDefines "-")
+  endforeach()
+
+  foreach(_permutation IN LISTS _arg_PERMUTATIONS)
+    if (NOT _permutation MATCHES "^([^:]+):(.+)$")
+      message(FATAL_ERROR "Shader permutation '${_permutation}' should be <file name>:<NAME>[=VALUE][,...]")
+    endif()
+    set(_fileName "${CMAKE_MATCH_1}")
+    string(REPLACE "," ";" _defineList "${CMAKE_MATCH_2}")
+
+    list(FIND _fileNames "${_fileName}" _sourceIndex)
+    if (_sourceIndex EQUAL -1)
+      message(FATAL_ERROR "Shader permutation '${_permutation}' names a shader that isn't embedded")
+    endif()
+    list(GET _jobSources ${_sourceIndex} _shader)
+
+    # Same normalisation as the runtime cache key: sorted by name, a repeated name keeps the last value
+    set(_defineNames "")
+    foreach(_define IN LISTS _defineList)
+      if (_define MATCHES "^([A-Za-z_][A-Za-z0-9_]*)(=(.*))?$")
+        list(APPEND _defineNames "${CMAKE_MATCH_1}")
+        if (CMAKE_MATCH_2)
+          set(_value_${CMAKE_MATCH_1} "${CMAKE_MATCH_3}")
+        else()
+          set(_value_${CMAKE_MATCH_1} "1")
+        endif()
+      else()
+        message(FATAL_ERROR "Shader permutation '${_permutation}' has an invalid define '${_define}'")
+      endif()
+    endforeach()
+    list(REMOVE_DUPLICATES _defineNames)
+    list(SORT _defineNames)
+
+    set(_suffix "")
+    set(_args "")
+    foreach(_defineName IN LISTS _defineNames)
+      list(APPEND _suffix "${_defineName}=${_value_${_defineName}}")
+      list(APPEND _args "-D${_defineName}=${_value_${_defineName}}")
+      unset(_value_${_defineName})
+    endforeach()
+    list(JOIN _suffix "," _suffix)
+    list(JOIN _args "|" _args)
+
+    set(_name "${_fileName}:${_suffix}")
+    if (_name IN_LIST _jobNames)
+      message(FATAL_ERROR "Shader permutation '${_name}' is listed twice")
+    endif()
+    list(APPEND _jobNames "${_name}")
+    list(APPEND _jobSources "${_shader}")
+    list(APPEND _jobDefines "${_args}")
+  endforeach()
+
+  set(_includes "")
+  set(_entries "")
+  set(_generated "")
+  set(_symbols "")
+  list(LENGTH _jobNames _jobCount)
+  if (_jobCount EQUAL 0)
+    message(FATAL_ERROR "mark_embed_shaders(${_target}) was given no shaders")
+  endif()
+  math(EXPR _lastJob "${_jobCount} - 1")
+  foreach(_index RANGE ${_lastJob})
+    list(GET _jobNames ${_index} _name)
+    list(GET _jobSources ${_index} _shader)
+    list(GET _jobDefines ${_index} _defines)
+    if (_defines STREQUAL "-")
+      set(_defineArgs "")
+    else()
+      string(REPLACE "|" ";" _defineArgs "${_defines}")
+    endif()
+
+    # Permutation names aren't valid file names everywhere, generated files are named by symbol
+    string(MAKE_C_IDENTIFIER "${_name}" _symbol)
+    if (_symbol IN_LIST _symbols)
+      message(FATAL_ERROR "Embedded shader '${_name}' maps to the symbol '${_symbol}' which is already used")
+    endif()
+    list(APPEND _symbols "${_symbol}")
+    set(_spv "${_outDir}/${_symbol}.spv")
+    set(_inl "${_outDir}/${_symbol}.inl")
+
+    add_custom_command(
+      OUTPUT "${_spv}"
+      COMMAND Vulkan::glslc --target-env=vulkan1.3 --target-spv=spv1.6 -O ${_defineArgs}
+              -MD -MF "${_spv}.d" -o "${_spv}" "${_shader}"
+      DEPENDS "${_shader}"
+      DEPFILE "${_spv}.d"
+      COMMENT "Compiling embedded shader ${_name}"
+      VERBATIM
+    )
+    add_custom_command(
+      OUTPUT "${_inl}"
+      COMMAND ${CMAKE_COMMAND} -DINPUT=${_spv} -DOUTPUT=${_inl} -DSYMBOL=${_symbol}
+              -P "${CMAKE_CURRENT_FUNCTION_LIST_DIR}/SpirvToInl.cmake"
+      DEPENDS "${_spv}" "${CMAKE_CURRENT_FUNCTION_LIST_DIR}/SpirvToInl.cmake"
+      VERBATIM
+    )
+
+    list(APPEND _generated "${_inl}")
+    string(APPEND _includes "    #include \"${_symbol}.inl\"\n")
+    string(APPEND _entries "        { \"${_name}\", EmbeddedSpirv::${_symbol}, std::size(EmbeddedSpirv::${_symbol}) },\n")
+  endforeach()
+
+  # Only rewritten when the shader list changes
+  file(CONFIGURE OUTPUT "${_outDir}/MarkEmbeddedShaderTable.inl" CONTENT
+"// Generated by Core/CMake/EmbedShaders.cmake, do not edit
+#include <iterator>
+
+namespace Mark::RendererVK::EmbeddedSpirv
+{
+${_includes}}
+
+namespace Mark::RendererVK
+{
+    constexpr EmbeddedShader EMBEDDED_SHADERS[] = {
+${_entries}    };
+}
+" @ONLY)
+
+  target_sources(${_target} PRIVATE ${_generated})
+  source_group("Generated/EmbeddedShaders" FILES ${_generated})
+  target_include_directories(${_target} PRIVATE "${_outDir}")
+  target_compile_definitions(${_target} PRIVATE MARK_EMBEDDED_SHADERS=1)
+endfunction()
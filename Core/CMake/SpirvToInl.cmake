@@ -0,0 +1,23 @@
+#
+# Core/CMake/SpirvToInl.cmake
+# cmake -DINPUT=<file.spv> -DOUTPUT=<file.inl> -DSYMBOL=<name> -P SpirvToInl.cmake
+# Writes the SPIR-V binary as a constexpr uint32_t array named SYMBOL
+#
+
+file(READ "${INPUT}" _hex HEX)
+string(LENGTH "${_hex}" _hexLength)
+math(EXPR _remainder "${_hexLength} % 8")
+if (_hexLength EQUAL 0 OR NOT _remainder EQUAL 0)
+  message(FATAL_ERROR "${INPUT} is not a valid SPIR-V binary")
+endif()
+
+# SPIR-V words are little endian, reverse each group of four bytes
+string(REGEX REPLACE "([0-9a-f][0-9a-f])([0-9a-f][0-9a-f])([0-9a-f][0-9a-f])([0-9a-f][0-9a-f])" "0x\\4\\3\\2\\1u, " _words "${_hex}")
+string(REPEAT "0x[0-9a-f]+u, " 8 _eightWords) # CMake regex has no {n} repeat
+string(REGEX REPLACE "(${_eightWords})" "\\1\n    " _words "${_words}")
+
+get_filename_component(_inputName "${INPUT}" NAME)
+file(WRITE "${OUTPUT}"
+  "// Generated from ${_inputName} by Core/CMake/SpirvToInl.cmake, do not edit\n"
+  "constexpr uint32_t ${SYMBOL}[] = {\n    ${_words}\n};\n"
+)
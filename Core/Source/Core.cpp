@@ -1,6 +1,7 @@
 #include "Core.h"
 #include "Utils/Mark_Utils.h"
 #include "Renderer/Vulkan/Mark_WindowToVulkanHandler.h"
+#include "Renderer/Vulkan/Mark_VulkanCore.h"
 
 #include "Platform/Window.h" // TEMP FOR ACCESSING MAIN WINDOW IN run()
 
@@ -34,6 +35,8 @@ namespace Mark
             // End frame
             m_timeTracker.endFrame();
             m_engineStats.update(Utils::TimeTracker::deltaTime);
+            m_vulkanCore->pipelineDiskCache().update(Utils::TimeTracker::deltaTime);
+            m_vulkanCore->graphicsPipelineCache().update();
         }
 
         cleanUp();
@@ -45,7 +48,7 @@ namespace Mark
 
         Settings::MarkSettings::Get().initialize(m_windows->main().handle());
 
-        m_engineStats.initialize(m_windows->main());
+        m_engineStats.initialize(m_windows->main(), &m_vulkanCore->graphicsPipelineCache());
 
         m_timeTracker.start();
 
@@ -57,6 +60,9 @@ namespace Mark
         //Platform::Window& window2 = m_windows->create(600, 600, "Second", VkClearColorValue{ {0.0f, 1.0f, 0.0f, 1.0f} }, false);
         //window2.vkHandler().addMesh("Models/Curuthers.obj");
         //window2.vkHandler().initCameraController();
+
+        // Everything created so far is startup cost, compare across cold/warm launches
+        m_vulkanCore->pipelineDiskCache().logCreationStats();
     }
 
     std::vector<RendererVK::WindowToVulkanHandler*> Core::checkAndReturnForRebuildRequests()
@@ -0,0 +1,597 @@
+#pragma once
+#include "Bitmap.h"
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #define MARK_BITMAP_SSE2 1
+    #include <emmintrin.h>
+#else
+    #define MARK_BITMAP_SSE2 0
+#endif
+
+namespace Mark
+{
+    template<BitmapFormat Format> struct BitmapFormatTraits;
+
+    template<> struct BitmapFormatTraits<BitmapFormat_UnsignedByte>
+    {
+        using Type = uint8_t;
+        static constexpr float c_max = 255.0f;
+    };
+
+    template<> struct BitmapFormatTraits<BitmapFormat_Float>
+    {
+        using Type = float;
+        static constexpr float c_max = 1.0f;
+    };
+
+    // Non-owning, compile-time typed view over pixel memory (decoder output, staging memory, a Bitmap...)
+    // Stride is in bytes so padded rows and sub-rectangles can be wrapped without copying
+    // ReadOnly views (ConstBitmapView) wrap const memory and only hand out const pixels, a mutable view converts to one
+    template<BitmapFormat Format, int Components, bool ReadOnly = false>
+    struct BitmapView
+    {
+        static_assert(Components >= 1 && Components <= 4, "BitmapView supports 1 to 4 components");
+
+        using Component = typename BitmapFormatTraits<Format>::Type;
+        using Element = std::conditional_t<ReadOnly, const Component, Component>;
+        using Byte = std::conditional_t<ReadOnly, const uint8_t, uint8_t>;
+        static constexpr BitmapFormat c_format = Format;
+        static constexpr int c_components = Components;
+        static constexpr size_t c_pixelBytes = sizeof(Component) * Components;
+
+        BitmapView() = default;
+
+        // Stride of 0 means tightly packed rows
+        BitmapView(std::conditional_t<ReadOnly, const void*, void*> _data, int _width, int _height, size_t _strideBytes = 0)
+            : m_data(static_cast<Byte*>(_data)), m_width(_width), m_height(_height),
+              m_stride(_strideBytes ? _strideBytes : size_t(_width) * c_pixelBytes)
+        {}
+
+        operator BitmapView<Format, Components, true>() const requires (!ReadOnly)
+        {
+            return BitmapView<Format, Components, true>(m_data, m_width, m_height, m_stride);
+        }
+
+        // Views the Bitmap's storage, returns an empty view if the layout doesn't match
+        static BitmapView fromBitmap(std::conditional_t<ReadOnly, const Bitmap&, Bitmap&> _bitmap)
+        {
+            if (_bitmap.m_format != Format || _bitmap.m_components != Components) {
+                return BitmapView{};
+            }
+            return BitmapView(_bitmap.m_data.data(), _bitmap.m_width, _bitmap.m_height);
+        }
+
+        Byte* m_data = nullptr;
+        int m_width = 0;
+        int m_height = 0;
+        size_t m_stride = 0;
+
+        bool valid() const { return m_data != nullptr; }
+        bool isPacked() const { return m_stride == size_t(m_width) * c_pixelBytes; }
+
+        Element* row(int _y) const { return reinterpret_cast<Element*>(m_data + size_t(_y) * m_stride); }
+        Element* pixel(int _x, int _y) const { return row(_y) + size_t(_x) * Components; }
+
+        BitmapView subView(int _x, int _y, int _width, int _height) const
+        {
+            return BitmapView(pixel(_x, _y), _width, _height, m_stride);
+        }
+
+        // Normalised access, same convention as Bitmap::getPixel / setPixel
+        glm::vec4 getPixel(int _x, int _y) const
+        {
+            const Component* p = pixel(_x, _y);
+            glm::vec4 c(0.0f);
+            for (int i = 0; i < Components; i++) {
+                c[i] = float(p[i]) / BitmapFormatTraits<Format>::c_max;
+            }
+            return c;
+        }
+
+        void setPixel(int _x, int _y, const glm::vec4& _c) const requires (!ReadOnly)
+        {
+            Component* p = pixel(_x, _y);
+            for (int i = 0; i < Components; i++) {
+                p[i] = Component(_c[i] * BitmapFormatTraits<Format>::c_max);
+            }
+        }
+    };
+
+    template<BitmapFormat Format, int Components>
+    using ConstBitmapView = BitmapView<Format, Components, true>;
+
+    using BitmapViewR8 = BitmapView<BitmapFormat_UnsignedByte, 1>;
+    using BitmapViewRGBA8 = BitmapView<BitmapFormat_UnsignedByte, 4>;
+    using BitmapViewRGBA32F = BitmapView<BitmapFormat_Float, 4>;
+    using ConstBitmapViewR8 = ConstBitmapView<BitmapFormat_UnsignedByte, 1>;
+    using ConstBitmapViewRGBA8 = ConstBitmapView<BitmapFormat_UnsignedByte, 4>;
+    using ConstBitmapViewRGBA32F = ConstBitmapView<BitmapFormat_Float, 4>;
+
+    // Bulk operations over whole views, sources may be read-only. RGBA8 / same-component paths use SSE2 where available,
+    // 4 pixels per iteration. sRGB decode is a table lookup per byte, the filtering, stores and encode index math around it are vectorised
+    namespace BitmapOps
+    {
+        namespace Detail
+        {
+            inline float srgbToLinear(float _c)
+            {
+                return _c <= 0.04045f ? _c / 12.92f : std::pow((_c + 0.055f) / 1.055f, 2.4f);
+            }
+
+            inline float linearToSrgb(float _c)
+            {
+                _c = std::clamp(_c, 0.0f, 1.0f);
+                return _c <= 0.0031308f ? _c * 12.92f : 1.055f * std::pow(_c, 1.0f / 2.4f) - 0.055f;
+            }
+
+            // 8-bit sRGB -> linear float
+            inline const std::array<float, 256>& srgbDecodeTable()
+            {
+                static const std::array<float, 256> table = []()
+                {
+                    std::array<float, 256> t{};
+                    for (int i = 0; i < 256; i++) {
+                        t[i] = srgbToLinear(float(i) / 255.0f);
+                    }
+                    return t;
+                }();
+                return table;
+            }
+
+            // Linear float (quantised to 12 bits) -> 8-bit sRGB
+            constexpr int SRGB_ENCODE_BITS = 12;
+            constexpr int SRGB_ENCODE_SIZE = 1 << SRGB_ENCODE_BITS;
+
+            inline const std::array<uint8_t, SRGB_ENCODE_SIZE>& srgbEncodeTable()
+            {
+                static const std::array<uint8_t, SRGB_ENCODE_SIZE> table = []()
+                {
+                    std::array<uint8_t, SRGB_ENCODE_SIZE> t{};
+                    for (int i = 0; i < SRGB_ENCODE_SIZE; i++) {
+                        t[i] = uint8_t(linearToSrgb(float(i) / float(SRGB_ENCODE_SIZE - 1)) * 255.0f + 0.5f);
+                    }
+                    return t;
+                }();
+                return table;
+            }
+
+            inline uint8_t encodeSrgb8(float _linear)
+            {
+                const int index = int(std::clamp(_linear, 0.0f, 1.0f) * float(SRGB_ENCODE_SIZE - 1) + 0.5f);
+                return srgbEncodeTable()[index];
+            }
+
+            inline void convertRowU8ToF32(const uint8_t* _src, float* _dst, size_t _count)
+            {
+                size_t i = 0;
+#if MARK_BITMAP_SSE2
+                const __m128i zero = _mm_setzero_si128();
+                const __m128 scale = _mm_set1_ps(1.0f / 255.0f);
+                for (; i + 16 <= _count; i += 16)
+                {
+                    const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(_src + i));
+                    const __m128i lo = _mm_unpacklo_epi8(bytes, zero);
+                    const __m128i hi = _mm_unpackhi_epi8(bytes, zero);
+                    _mm_storeu_ps(_dst + i + 0,  _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(lo, zero)), scale));
+                    _mm_storeu_ps(_dst + i + 4,  _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(lo, zero)), scale));
+                    _mm_storeu_ps(_dst + i + 8,  _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(hi, zero)), scale));
+                    _mm_storeu_ps(_dst + i + 12, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(hi, zero)), scale));
+                }
+#endif
+                for (; i < _count; i++) {
+                    _dst[i] = float(_src[i]) * (1.0f / 255.0f);
+                }
+            }
+
+            inline void convertRowF32ToU8(const float* _src, uint8_t* _dst, size_t _count)
+            {
+                size_t i = 0;
+#if MARK_BITMAP_SSE2
+                const __m128 scale = _mm_set1_ps(255.0f);
+                const __m128 half = _mm_set1_ps(0.5f);
+                const __m128 lo = _mm_setzero_ps();
+                const __m128 hi = _mm_set1_ps(255.0f);
+                auto quantise = [&](const float* _p)
+                {
+                    __m128 v = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(_p), scale), half);
+                    return _mm_cvttps_epi32(_mm_min_ps(_mm_max_ps(v, lo), hi));
+                };
+                for (; i + 16 <= _count; i += 16)
+                {
+                    const __m128i a = _mm_packs_epi32(quantise(_src + i + 0), quantise(_src + i + 4));
+                    const __m128i b = _mm_packs_epi32(quantise(_src + i + 8), quantise(_src + i + 12));
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(_dst + i), _mm_packus_epi16(a, b));
+                }
+#endif
+                for (; i < _count; i++) {
+                    _dst[i] = uint8_t(std::clamp(_src[i] * 255.0f + 0.5f, 0.0f, 255.0f));
+                }
+            }
+
+#if MARK_BITMAP_SSE2
+            // 2x2 box filter of four RGBA8 output pixels, reads 32 bytes from each source row
+            inline void downsample4RGBA8(const uint8_t* _row0, const uint8_t* _row1, uint8_t* _dst)
+            {
+                const __m128i zero = _mm_setzero_si128();
+                const __m128i round = _mm_set1_epi16(2);
+
+                // Vertical sums of one 16 byte block, then add neighbouring pixels: 2 output pixels as 8 x u16
+                auto half = [&](const uint8_t* _a, const uint8_t* _b)
+                {
+                    const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(_a));
+                    const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(_b));
+                    const __m128i lo = _mm_add_epi16(_mm_unpacklo_epi8(a, zero), _mm_unpacklo_epi8(b, zero));
+                    const __m128i hi = _mm_add_epi16(_mm_unpackhi_epi8(a, zero), _mm_unpackhi_epi8(b, zero));
+                    const __m128i sum = _mm_add_epi16(_mm_unpacklo_epi64(lo, hi), _mm_unpackhi_epi64(lo, hi));
+                    return _mm_srli_epi16(_mm_add_epi16(sum, round), 2);
+                };
+
+                const __m128i first = half(_row0, _row1);
+                const __m128i second = half(_row0 + 16, _row1 + 16);
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(_dst), _mm_packus_epi16(first, second));
+            }
+
+            // Linear float -> 12-bit encode table index for four values, same rounding as encodeSrgb8
+            inline __m128i srgbEncodeIndex4(__m128 _linear)
+            {
+                const __m128 clamped = _mm_min_ps(_mm_max_ps(_linear, _mm_setzero_ps()), _mm_set1_ps(1.0f));
+                return _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(clamped, _mm_set1_ps(float(SRGB_ENCODE_SIZE - 1))), _mm_set1_ps(0.5f)));
+            }
+#endif
+
+            // 2x2 box filter of one RGBA8 output row
+            inline void downsampleRowRGBA8(const uint8_t* _row0, const uint8_t* _row1, uint8_t* _dst, int _dstWidth)
+            {
+                int x = 0;
+#if MARK_BITMAP_SSE2
+                for (; x + 4 <= _dstWidth; x += 4) {
+                    downsample4RGBA8(_row0 + x * 8, _row1 + x * 8, _dst + x * 4);
+                }
+#endif
+                for (; x < _dstWidth; x++)
+                {
+                    for (int c = 0; c < 4; c++) {
+                        _dst[x * 4 + c] = uint8_t((_row0[x * 8 + c] + _row0[x * 8 + 4 + c] + _row1[x * 8 + c] + _row1[x * 8 + 4 + c] + 2) >> 2);
+                    }
+                }
+            }
+
+            // 2x2 box filter of one sRGB RGBA8 output row, colour averaged in linear space and alpha averaged as is
+            inline void downsampleRowSrgbRGBA8(const uint8_t* _row0, const uint8_t* _row1, uint8_t* _dst, int _dstWidth)
+            {
+                const auto& decode = srgbDecodeTable();
+                const auto& encode = srgbEncodeTable();
+                int x = 0;
+#if MARK_BITMAP_SSE2
+                // The table decode is a per-byte lookup, the sums and the encode index math run 4 pixels at a time
+                auto load = [&](const uint8_t* _p)
+                {
+                    return _mm_setr_ps(decode[_p[0]], decode[_p[1]], decode[_p[2]], 0.0f);
+                };
+                const __m128 quarter = _mm_set1_ps(0.25f);
+
+                for (; x + 4 <= _dstWidth; x += 4)
+                {
+                    // Alpha comes from the plain box filter, its colour bytes are overwritten below
+                    downsample4RGBA8(_row0 + x * 8, _row1 + x * 8, _dst + x * 4);
+
+                    alignas(16) int32_t index[16];
+                    for (int p = 0; p < 4; p++)
+                    {
+                        const uint8_t* a = _row0 + (x + p) * 8;
+                        const uint8_t* b = _row1 + (x + p) * 8;
+                        const __m128 sum = _mm_add_ps(_mm_add_ps(load(a), load(a + 4)), _mm_add_ps(load(b), load(b + 4)));
+                        _mm_store_si128(reinterpret_cast<__m128i*>(index + p * 4), srgbEncodeIndex4(_mm_mul_ps(sum, quarter)));
+                    }
+
+                    for (int p = 0; p < 4; p++)
+                    {
+                        uint8_t* dst = _dst + (x + p) * 4;
+                        dst[0] = encode[index[p * 4 + 0]];
+                        dst[1] = encode[index[p * 4 + 1]];
+                        dst[2] = encode[index[p * 4 + 2]];
+                    }
+                }
+#endif
+                for (; x < _dstWidth; x++)
+                {
+                    for (int c = 0; c < 3; c++)
+                    {
+                        const int i0 = x * 8 + c;
+                        const float sum = decode[_row0[i0]] + decode[_row0[i0 + 4]] + decode[_row1[i0]] + decode[_row1[i0 + 4]];
+                        _dst[x * 4 + c] = encodeSrgb8(sum * 0.25f);
+                    }
+                    _dst[x * 4 + 3] = uint8_t((_row0[x * 8 + 3] + _row0[x * 8 + 7] + _row1[x * 8 + 3] + _row1[x * 8 + 7] + 2) >> 2);
+                }
+            }
+
+            // 8-bit sRGB -> linear float for one row, with 4 components the alpha value is scaled without the curve
+            inline void decodeRowSrgb8(const uint8_t* _src, float* _dst, int _count, int _components)
+            {
+                const auto& decode = srgbDecodeTable();
+                const bool hasAlpha = _components == 4;
+                int i = 0;
+#if MARK_BITMAP_SSE2
+                if (hasAlpha)
+                {
+                    // One pixel per vector, alpha lanes are scaled together after the lookups
+                    const __m128 alphaScale = _mm_set1_ps(1.0f / 255.0f);
+                    for (; i + 16 <= _count; i += 16)
+                    {
+                        const __m128i alphaBytes = _mm_setr_epi32(_src[i + 3], _src[i + 7], _src[i + 11], _src[i + 15]);
+                        alignas(16) float alpha[4];
+                        _mm_store_ps(alpha, _mm_mul_ps(_mm_cvtepi32_ps(alphaBytes), alphaScale));
+                        for (int p = 0; p < 4; p++)
+                        {
+                            const uint8_t* src = _src + i + p * 4;
+                            _mm_storeu_ps(_dst + i + p * 4, _mm_setr_ps(decode[src[0]], decode[src[1]], decode[src[2]], alpha[p]));
+                        }
+                    }
+                }
+                else
+                {
+                    for (; i + 16 <= _count; i += 16)
+                    {
+                        for (int k = 0; k < 16; k += 4)
+                        {
+                            const uint8_t* src = _src + i + k;
+                            _mm_storeu_ps(_dst + i + k, _mm_setr_ps(decode[src[0]], decode[src[1]], decode[src[2]], decode[src[3]]));
+                        }
+                    }
+                }
+#endif
+                for (; i < _count; i++) {
+                    _dst[i] = (hasAlpha && (i & 3) == 3) ? float(_src[i]) * (1.0f / 255.0f) : decode[_src[i]];
+                }
+            }
+
+            // Linear float -> 8-bit sRGB for one row, with 4 components the alpha value is quantised without the curve
+            inline void encodeRowSrgb8(const float* _src, uint8_t* _dst, int _count, int _components)
+            {
+                const auto& encode = srgbEncodeTable();
+                const bool hasAlpha = _components == 4;
+                int i = 0;
+#if MARK_BITMAP_SSE2
+                if (hasAlpha)
+                {
+                    // RGBA rows line up with the 4 lanes, one pixel per vector, four pixels per iteration
+                    const __m128 scale = _mm_set1_ps(255.0f);
+                    const __m128 half = _mm_set1_ps(0.5f);
+                    for (; i + 16 <= _count; i += 16)
+                    {
+                        alignas(16) int32_t index[16];
+                        alignas(16) int32_t alpha[4];
+                        for (int p = 0; p < 4; p++) {
+                            _mm_store_si128(reinterpret_cast<__m128i*>(index + p * 4), srgbEncodeIndex4(_mm_loadu_ps(_src + i + p * 4)));
+                        }
+                        const __m128 alphas = _mm_setr_ps(_src[i + 3], _src[i + 7], _src[i + 11], _src[i + 15]);
+                        const __m128 quantised = _mm_min_ps(_mm_max_ps(_mm_add_ps(_mm_mul_ps(alphas, scale), half), _mm_setzero_ps()), scale);
+                        _mm_store_si128(reinterpret_cast<__m128i*>(alpha), _mm_cvttps_epi32(quantised));
+
+                        for (int p = 0; p < 4; p++)
+                        {
+                            uint8_t* dst = _dst + i + p * 4;
+                            dst[0] = encode[index[p * 4 + 0]];
+                            dst[1] = encode[index[p * 4 + 1]];
+                            dst[2] = encode[index[p * 4 + 2]];
+                            dst[3] = uint8_t(alpha[p]);
+                        }
+                    }
+                }
+                else
+                {
+                    for (; i + 4 <= _count; i += 4)
+                    {
+                        alignas(16) int32_t index[4];
+                        _mm_store_si128(reinterpret_cast<__m128i*>(index), srgbEncodeIndex4(_mm_loadu_ps(_src + i)));
+                        for (int k = 0; k < 4; k++) {
+                            _dst[i + k] = encode[index[k]];
+                        }
+                    }
+                }
+#endif
+                for (; i < _count; i++) {
+                    _dst[i] = (hasAlpha && (i & 3) == 3)
+                        ? uint8_t(std::clamp(_src[i] * 255.0f + 0.5f, 0.0f, 255.0f))
+                        : encodeSrgb8(_src[i]);
+                }
+            }
+        }
+
+        // Format / component conversion. Missing components are filled with 0, missing alpha with 1
+        template<BitmapFormat SrcFormat, int SrcComponents, bool SrcReadOnly, BitmapFormat DstFormat, int DstComponents>
+        void convert(const BitmapView<SrcFormat, SrcComponents, SrcReadOnly>& _src, const BitmapView<DstFormat, DstComponents>& _dst)
+        {
+            using SrcTraits = BitmapFormatTraits<SrcFormat>;
+            using DstTraits = BitmapFormatTraits<DstFormat>;
+            using DstComponent = typename BitmapFormatTraits<DstFormat>::Type;
+
+            const int width = std::min(_src.m_width, _dst.m_width);
+            const int height = std::min(_src.m_height, _dst.m_height);
+            const size_t rowCount = size_t(width) * SrcComponents;
+
+            for (int y = 0; y < height; y++)
+            {
+                const auto* src = _src.row(y);
+                auto* dst = _dst.row(y);
+
+                if constexpr (SrcComponents == DstComponents && SrcFormat == DstFormat)
+                {
+                    std::memcpy(dst, src, rowCount * sizeof(*src));
+                }
+                else if constexpr (SrcComponents == DstComponents && SrcFormat == BitmapFormat_UnsignedByte)
+                {
+                    Detail::convertRowU8ToF32(src, dst, rowCount);
+                }
+                else if constexpr (SrcComponents == DstComponents && SrcFormat == BitmapFormat_Float)
+                {
+                    Detail::convertRowF32ToU8(src, dst, rowCount);
+                }
+                else
+                {
+                    for (int x = 0; x < width; x++)
+                    {
+                        for (int c = 0; c < DstComponents; c++)
+                        {
+                            float value = (c == 3) ? 1.0f : 0.0f;
+                            if (c < SrcComponents) {
+                                value = float(src[x * SrcComponents + c]) / SrcTraits::c_max;
+                            }
+                            value *= DstTraits::c_max;
+                            if constexpr (DstFormat == BitmapFormat_UnsignedByte) {
+                                value = std::clamp(value + 0.5f, 0.0f, 255.0f);
+                            }
+                            dst[x * DstComponents + c] = DstComponent(value);
+                        }
+                    }
+                }
+            }
+        }
+
+        // 8-bit sRGB -> linear float, alpha (4th component) is copied unconverted
+        template<int Components, bool SrcReadOnly>
+        void srgbToLinear(const BitmapView<BitmapFormat_UnsignedByte, Components, SrcReadOnly>& _src, const BitmapView<BitmapFormat_Float, Components>& _dst)
+        {
+            const int width = std::min(_src.m_width, _dst.m_width);
+            const int height = std::min(_src.m_height, _dst.m_height);
+            for (int y = 0; y < height; y++)
+            {
+                Detail::decodeRowSrgb8(_src.row(y), _dst.row(y), width * Components, Components);
+            }
+        }
+
+        // Linear float -> 8-bit sRGB, alpha (4th component) is quantised without the curve
+        template<int Components, bool SrcReadOnly>
+        void linearToSrgb(const BitmapView<BitmapFormat_Float, Components, SrcReadOnly>& _src, const BitmapView<BitmapFormat_UnsignedByte, Components>& _dst)
+        {
+            const int width = std::min(_src.m_width, _dst.m_width);
+            const int height = std::min(_src.m_height, _dst.m_height);
+            for (int y = 0; y < height; y++)
+            {
+                Detail::encodeRowSrgb8(_src.row(y), _dst.row(y), width * Components, Components);
+            }
+        }
+
+        // Halves the view with a 2x2 box filter. _srgb averages colour in linear space (8-bit only)
+        template<BitmapFormat Format, int Components, bool SrcReadOnly>
+        void downsample2x(const BitmapView<Format, Components, SrcReadOnly>& _src, const BitmapView<Format, Components>& _dst, bool _srgb = false)
+        {
+            const int width = std::min(_dst.m_width, _src.m_width / 2);
+            const int height = std::min(_dst.m_height, _src.m_height / 2);
+
+            for (int y = 0; y < height; y++)
+            {
+                const auto* row0 = _src.row(y * 2);
+                const auto* row1 = _src.row(y * 2 + 1);
+                auto* dst = _dst.row(y);
+
+                if constexpr (Format == BitmapFormat_UnsignedByte && Components == 4)
+                {
+                    if (_srgb) {
+                        Detail::downsampleRowSrgbRGBA8(row0, row1, dst, width);
+                    }
+                    else {
+                        Detail::downsampleRowRGBA8(row0, row1, dst, width);
+                    }
+                    continue;
+                }
+
+                for (int x = 0; x < width; x++)
+                {
+                    for (int c = 0; c < Components; c++)
+                    {
+                        const int i0 = x * 2 * Components + c;
+                        const int i1 = i0 + Components;
+                        if constexpr (Format == BitmapFormat_UnsignedByte)
+                        {
+                            if (_srgb && !(Components == 4 && c == 3))
+                            {
+                                const auto& table = Detail::srgbDecodeTable();
+                                const float sum = table[row0[i0]] + table[row0[i1]] + table[row1[i0]] + table[row1[i1]];
+                                dst[x * Components + c] = Detail::encodeSrgb8(sum * 0.25f);
+                                continue;
+                            }
+                            dst[x * Components + c] = uint8_t((row0[i0] + row0[i1] + row1[i0] + row1[i1] + 2) >> 2);
+                        }
+                        else
+                        {
+                            dst[x * Components + c] = (row0[i0] + row0[i1] + row1[i0] + row1[i1]) * 0.25f;
+                        }
+                    }
+                }
+            }
+        }
+
+        // Bilinear fetch at texel coordinates (texel centres on integers), clamped at the edges
+        // RGBA8 results are truncated, matching the original cubemap conversion
+        template<BitmapFormat Format, int Components, bool SrcReadOnly>
+        inline void sampleBilinear(const BitmapView<Format, Components, SrcReadOnly>& _src, float _u, float _v, typename BitmapView<Format, Components>::Component* _out)
+        {
+            const int maxW = _src.m_width - 1;
+            const int maxH = _src.m_height - 1;
+            const int u1 = std::clamp(int(std::floor(_u)), 0, maxW);
+            const int v1 = std::clamp(int(std::floor(_v)), 0, maxH);
+            const int u2 = std::min(u1 + 1, maxW);
+            const int v2 = std::min(v1 + 1, maxH);
+            const float s = _u - float(u1);
+            const float t = _v - float(v1);
+
+            const float w11 = (1.0f - s) * (1.0f - t);
+            const float w21 = s * (1.0f - t);
+            const float w12 = (1.0f - s) * t;
+            const float w22 = s * t;
+
+            const auto* p11 = _src.pixel(u1, v1);
+            const auto* p21 = _src.pixel(u2, v1);
+            const auto* p12 = _src.pixel(u1, v2);
+            const auto* p22 = _src.pixel(u2, v2);
+
+#if MARK_BITMAP_SSE2
+            if constexpr (Format == BitmapFormat_UnsignedByte && Components == 4)
+            {
+                const __m128i zero = _mm_setzero_si128();
+                auto load = [&](const uint8_t* _p)
+                {
+                    int packed;
+                    std::memcpy(&packed, _p, 4);
+                    const __m128i v = _mm_unpacklo_epi8(_mm_cvtsi32_si128(packed), zero);
+                    return _mm_cvtepi32_ps(_mm_unpacklo_epi16(v, zero));
+                };
+
+                __m128 value = _mm_mul_ps(load(p11), _mm_set1_ps(w11));
+                value = _mm_add_ps(value, _mm_mul_ps(load(p21), _mm_set1_ps(w21)));
+                value = _mm_add_ps(value, _mm_mul_ps(load(p12), _mm_set1_ps(w12)));
+                value = _mm_add_ps(value, _mm_mul_ps(load(p22), _mm_set1_ps(w22)));
+                value = _mm_min_ps(value, _mm_set1_ps(255.0f));
+
+                __m128i packed = _mm_cvttps_epi32(value);
+                packed = _mm_packs_epi32(packed, packed);
+                packed = _mm_packus_epi16(packed, packed);
+                const int result = _mm_cvtsi128_si32(packed);
+                std::memcpy(_out, &result, 4);
+                return;
+            }
+#endif
+            for (int c = 0; c < Components; c++)
+            {
+                const float value = p11[c] * w11 + p21[c] * w21 + p12[c] * w12 + p22[c] * w22;
+                if constexpr (Format == BitmapFormat_UnsignedByte) {
+                    _out[c] = uint8_t(std::min(value, 255.0f));
+                }
+                else {
+                    _out[c] = value;
+                }
+            }
+        }
+    }
+}
@@ -2,13 +2,17 @@
 #include "Platform/imguiHandler.h"
 #include "Engine/SettingsHandler.h"
 #include "Platform/Window.h"
+#include "Renderer/Vulkan/Mark_GraphicsPipelineCache.h"
 
 namespace Mark
 {
-    void EngineStats::initialize(Platform::Window& _mainWindowRef)
+    static double toMiB(size_t _bytes) { return static_cast<double>(_bytes) / (1024.0 * 1024.0); }
+
+    void EngineStats::initialize(Platform::Window& _mainWindowRef, RendererVK::VulkanGraphicsPipelineCache* _pipelineCache)
     {
         m_markSettings = &Settings::MarkSettings::Get();
         m_mainWindowRef = &_mainWindowRef;
+        m_pipelineCache = _pipelineCache;
         m_fpsUpdateInterval = m_markSettings->getFpsUpdateInterval();
 
         reset();
@@ -31,6 +35,77 @@ namespace Mark
             ImGui::Text("FPS: %.1f", m_displayFps);
         else
             ImGui::TextDisabled("FPS: recomputing...");
+
+        drawPipelineCacheGUI();
+        drawMeshMemoryGUI();
+        drawGPUFrameGUI();
+    }
+
+    void EngineStats::drawPipelineCacheGUI() const
+    {
+        if (!m_pipelineCache || !ImGui::CollapsingHeader("Graphics Pipeline Cache"))
+            return;
+
+        const RendererVK::GraphicsPipelineCacheStats stats = m_pipelineCache->stats();
+        const uint64_t acquires = stats.hits + stats.misses;
+
+        ImGui::Text("Entries: %zu (%zu awaiting destroy)", stats.entries, stats.retired);
+        ImGui::Text("Hits: %llu  Misses: %llu", static_cast<unsigned long long>(stats.hits), static_cast<unsigned long long>(stats.misses));
+        if (acquires > 0)
+            ImGui::Text("Hit rate: %.1f%%", 100.0 * static_cast<double>(stats.hits) / static_cast<double>(acquires));
+        else
+            ImGui::TextDisabled("Hit rate: -");
+        ImGui::Text("Creation: %.2f ms total (%.2f ms avg)", stats.creationMs, stats.misses ? stats.creationMs / static_cast<double>(stats.misses) : 0.0);
+        ImGui::Text("Evicted: %llu  Failed: %llu", static_cast<unsigned long long>(stats.evictions), static_cast<unsigned long long>(stats.failures));
+    }
+
+    void EngineStats::drawMeshMemoryGUI() const
+    {
+        if (!m_mainWindowRef || !ImGui::CollapsingHeader("Mesh CPU Memory"))
+            return;
+
+        const RendererVK::MeshCPUMemoryStats stats = m_mainWindowRef->vkHandler().meshes().cpuMemoryStats();
+
+        ImGui::Text("Meshes: %u (kept %u, dropped %u, compressed %u)", stats.meshes, stats.kept, stats.dropped, stats.compressed);
+        ImGui::Text("Resident: %.2f MiB of %.2f MiB", toMiB(stats.residentBytes), toMiB(stats.fullCopyBytes));
+        if (stats.fullCopyBytes > 0)
+            ImGui::Text("Saved: %.2f MiB (%.1f%%)", toMiB(stats.savedBytes()), 100.0 * static_cast<double>(stats.savedBytes()) / static_cast<double>(stats.fullCopyBytes));
+        else
+            ImGui::TextDisabled("Saved: -");
+    }
+
+    void EngineStats::drawGPUFrameGUI() const
+    {
+        if (!m_mainWindowRef || !ImGui::CollapsingHeader("GPU Frame"))
+            return;
+
+        const RendererVK::VulkanGPUFrameStats& stats = m_mainWindowRef->vkHandler().gpuFrameStats();
+        ImGui::Text("Early-Z ordering: %s  Depth pre-pass: %s",
+            m_markSettings->orderForEarlyZ() ? "on" : "off", m_markSettings->depthPrepass() ? "on" : "off");
+
+        if (!stats.timingsSupported())
+            ImGui::TextDisabled("Scene GPU time: unsupported on this queue");
+        else if (stats.hasTimings())
+            ImGui::Text("Scene GPU time: %.3f ms", stats.sceneGPUMs());
+        else
+            ImGui::TextDisabled("Scene GPU time: -");
+
+        if (!stats.statisticsSupported()) {
+            ImGui::TextDisabled("Fragment invocations: unsupported on this device");
+            return;
+        }
+        if (!stats.hasStatistics()) {
+            ImGui::TextDisabled("Fragment invocations: -");
+            return;
+        }
+
+        // Invocations per framebuffer pixel, 1.0 would be every pixel shaded exactly once
+        int width = 0, height = 0;
+        m_mainWindowRef->frameBufferSize(width, height);
+        const double pixels = static_cast<double>(width) * static_cast<double>(height);
+        ImGui::Text("Fragment invocations: %llu", static_cast<unsigned long long>(stats.fragmentInvocations()));
+        if (pixels > 0.0)
+            ImGui::Text("Shaded per pixel: %.2f", static_cast<double>(stats.fragmentInvocations()) / pixels);
     }
 
     void EngineStats::reset()
@@ -5,17 +5,19 @@ namespace Mark
 {
     namespace Settings { struct MarkSettings; }
     namespace Platform { struct Window; }
+    namespace RendererVK { struct VulkanGraphicsPipelineCache; }
     struct EngineStats 
     {
         EngineStats() = default;
 
-        void initialize(Platform::Window& _mainWindowRef);
+        void initialize(Platform::Window& _mainWindowRef, RendererVK::VulkanGraphicsPipelineCache* _pipelineCache = nullptr);
         void reset();
         void update(double _deltaTime);
 
     private:
         Settings::MarkSettings* m_markSettings{ nullptr };
         Platform::Window* m_mainWindowRef{ nullptr };
+        RendererVK::VulkanGraphicsPipelineCache* m_pipelineCache{ nullptr };
 
         float m_fpsUpdateInterval; // Held and updated through engine settings
         double m_accumTime = 0.0;
@@ -32,6 +34,9 @@ namespace Mark
 
         // For GUI
         void drawGUI() const;
+        void drawPipelineCacheGUI() const;
+        void drawMeshMemoryGUI() const;
+        void drawGPUFrameGUI() const;
         bool m_guiWindowOpen{ true };
     };
 }
\ No newline at end of file
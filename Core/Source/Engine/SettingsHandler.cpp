@@ -170,5 +170,35 @@ namespace Mark::Settings
                 m_requestSwapchainRebuild = true;
             }
         }
+
+        ImGui::Text("Generate skybox cubemaps on GPU:");
+        ImGui::SameLine();
+        ImGui::Checkbox("##GPUCubemapToggle", &m_generateCubemapsOnGPU);
+
+        ImGui::Text("Order draws for early depth rejection:");
+        ImGui::SameLine();
+        const bool prevEarlyZ = m_orderForEarlyZ;
+        if (ImGui::Checkbox("##EarlyZOrderToggle", &m_orderForEarlyZ))
+        {
+            if (prevEarlyZ != m_orderForEarlyZ) {
+                m_requestSwapchainRebuild = true;
+            }
+        }
+        if (ImGui::IsItemHovered()) {
+            ImGui::SetTooltip("Front-to-back opaque buckets and skybox last. Compare fragment invocations in Engine Stats.");
+        }
+
+        ImGui::Text("Depth pre-pass:");
+        ImGui::SameLine();
+        const bool prevPrepass = m_depthPrepass;
+        if (ImGui::Checkbox("##DepthPrepassToggle", &m_depthPrepass))
+        {
+            if (prevPrepass != m_depthPrepass) {
+                m_requestSwapchainRebuild = true;
+            }
+        }
+        if (ImGui::IsItemHovered()) {
+            ImGui::SetTooltip("Lays down opaque depth first so opaque fragments shade once. Compare GPU scene time in Engine Stats.");
+        }
     }
 }
\ No newline at end of file
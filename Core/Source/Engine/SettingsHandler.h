@@ -29,6 +29,9 @@ namespace Mark::Settings
         bool isInPerformanceMode() const { return m_runInPerformanceMode; }
         bool requestSwapchainRebuild() const { return m_requestSwapchainRebuild; } 
         void acknowledgeSwapchainRebuildRequest() { m_requestSwapchainRebuild = false; }
+        bool generateCubemapsOnGPU() const { return m_generateCubemapsOnGPU; }
+        bool orderForEarlyZ() const { return m_orderForEarlyZ; }
+        bool depthPrepass() const { return m_depthPrepass; }
 
     private:
         // Private constructor to prevent instantiation outside of Get()
@@ -81,5 +84,13 @@ namespace Mark::Settings
         bool m_requestSwapchainRebuild{ false };
         // Changes from Mailbox to Immediate presentation mode
         bool m_runInPerformanceMode{ false }; 
+        // Build skybox cubemaps with the compute path, CPU conversion is the fallback. Applies to newly loaded skyboxes
+        bool m_generateCubemapsOnGPU{ true };
+        // Buckets opaque draws front-to-back and draws the skybox after them. Off restores submission order with the
+        // skybox first, for comparing fragment invocations. Changes the recorded command buffers so it requests a rebuild
+        bool m_orderForEarlyZ{ true };
+        // Depth-only pass over the opaque draws first, the opaque pass then tests EQUAL without writing depth
+        // so each pixel is shaded once. Pays off with heavy fragment shaders. Changes pipelines, so it requests a rebuild
+        bool m_depthPrepass{ false };
     };
 }
\ No newline at end of file
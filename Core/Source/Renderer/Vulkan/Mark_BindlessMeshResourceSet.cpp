@@ -1,123 +1,236 @@
 #include "Mark_BindlessMeshResourceSet.h"
 
 #include "Mark_VulkanCore.h"
-#include "Mark_SwapChain.h"
+#include "Mark_PipelineDescription.h"
 #include "Mark_UniformBuffer.h"
-#include "Mark_ModelHandler.h" 
+#include "Mark_MeshPool.h"
 
 #include "Utils/VulkanUtils.h"
 #include "Utils/Mark_Utils.h"
 
 #include <algorithm>
+#include <chrono>
 
 namespace Mark::RendererVK
 {
     static inline uint32_t safeMin(uint32_t _a, uint32_t _b) { return (_a < _b) ? _a : _b; }
     static inline uint32_t safeMax(uint32_t _a, uint32_t _b) { return (_a > _b) ? _a : _b; }
 
-    uint32_t VulkanBindlessMeshResourceSet::growPow2Capacity(uint32_t _r, uint32_t _maxCap, uint32_t _initialCap)
+    static VkDeviceAddress bufferAddress(VkDevice _device, VkBuffer _buffer)
     {
-        _r = safeMax(1u, _r);
-        _maxCap = safeMax(1u, _maxCap);
-
-        uint32_t cap = safeMax(1u, _initialCap);
-        cap = safeMin(cap, _maxCap);
-        while (cap < _r && cap < _maxCap) cap <<= 1u;
-        if (cap < _r) cap = _r;
-        cap = safeMin(cap, _maxCap);
-        return safeMax(1u, cap);
+        const VkBufferDeviceAddressInfo addressInfo = {
+            .sType = VK_STRUCTURE_TYPE_BUFFER_DEVICE_ADDRESS_INFO,
+            .buffer = _buffer
+        };
+        return vkGetBufferDeviceAddress(_device, &addressInfo);
     }
 
-    void VulkanBindlessMeshResourceSet::initialize(std::weak_ptr<VulkanCore> _coreRef, const VulkanSwapChain& _swapchain, const VulkanUniformBuffer& _ubo,
-        const std::vector<std::shared_ptr<MeshHandler>>* _meshes, const char* _debugName)
+    // Byte offsets of each binding's infos in the packed update template data
+    // [vertex infos][index infos][UBO infos][image infos], each array tightly strided
+    struct PackedDescriptorLayout
+    {
+        size_t vertices{ 0 };
+        size_t indices{ 0 };
+        size_t ubos{ 0 };
+        size_t images{ 0 };
+        size_t size{ 0 };
+    };
+
+    static PackedDescriptorLayout packedDescriptorLayout(uint32_t _meshSlots, uint32_t _textureSlots)
+    {
+        PackedDescriptorLayout layout;
+        layout.vertices = 0;
+        layout.indices = layout.vertices + _meshSlots * sizeof(VkDescriptorBufferInfo);
+        layout.ubos = layout.indices + _meshSlots * sizeof(VkDescriptorBufferInfo);
+        layout.images = layout.ubos + VulkanBindlessMeshResourceSet::FRAME_SLOTS * sizeof(VkDescriptorBufferInfo);
+        layout.size = layout.images + _textureSlots * sizeof(VkDescriptorImageInfo);
+        return layout;
+    }
+
+    // One entry per binding, bindings with no slots are left out
+    static void packedDescriptorEntries(std::vector<VkDescriptorUpdateTemplateEntry>& _entries, const PackedDescriptorLayout& _layout,
+        uint32_t _meshSlots, uint32_t _textureSlots)
+    {
+        _entries.clear();
+        if (_meshSlots > 0)
+        {
+            _entries.push_back({ BindlessBinding::verticesSSBO, 0, _meshSlots, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, _layout.vertices, sizeof(VkDescriptorBufferInfo) });
+            _entries.push_back({ BindlessBinding::indicesSSBO, 0, _meshSlots, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, _layout.indices, sizeof(VkDescriptorBufferInfo) });
+        }
+        _entries.push_back({ BindlessBinding::UBO, 0, VulkanBindlessMeshResourceSet::FRAME_SLOTS, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, _layout.ubos, sizeof(VkDescriptorBufferInfo) });
+        if (_textureSlots > 0) {
+            _entries.push_back({ BindlessBinding::texture, 0, _textureSlots, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, _layout.images, sizeof(VkDescriptorImageInfo) });
+        }
+    }
+
+    void VulkanBindlessMeshResourceSet::initialize(std::weak_ptr<VulkanCore> _coreRef, VulkanCommandBuffers* _commandBuffersRef,
+        const VulkanUniformBuffer& _ubo, const MeshPool* _meshes, const char* _debugName)
     {
         m_vulkanCoreRef = _coreRef;
         auto VkCore = m_vulkanCoreRef.lock();
         if (!VkCore) MARK_FATAL(Utils::Category::Vulkan, "VulkanBindlessMeshResourceSet::initialize - VulkanCore expired");
 
+        if (_ubo.bufferCount() < FRAME_SLOTS) {
+            MARK_FATAL(Utils::Category::Vulkan, "VulkanBindlessMeshResourceSet::initialize - UBO has %u buffers, %u frame slots required",
+                _ubo.bufferCount(), FRAME_SLOTS);
+        }
+
         m_device = VkCore->device();
         m_debugName = (_debugName && _debugName[0]) ? _debugName : "UnamedBindlessMesh";
+        m_useDescriptorBuffer = VkCore->descriptorBufferCaps().enabled;
 
-        const uint32_t numImages = (uint32_t)_swapchain.numImages();
-        const uint32_t meshHint = _meshes ? (uint32_t)_meshes->size() : 0u;
+        const uint32_t meshHint = _meshes ? _meshes->size() : 0u;
 
         configureFromCaps(VkCore->bindlessCaps(), meshHint);
         ensureLayoutCreated();
-        recreatePoolAndSets(numImages);
-        updateAllDescriptors(numImages, _ubo, _meshes);
+        createDescriptorStorage();
+
+        // Slot 0 always holds a real image, so a draw without a texture never samples an unwritten descriptor
+        m_fallbackTexture = new TextureHandler(_coreRef, _commandBuffersRef);
+        TextureHandler::generateTextures({ m_fallbackTexture }, { MARK_FALLBACK_TEXTURE });
+
+        updateAllDescriptors(_ubo, _meshes);
     }
 
     void VulkanBindlessMeshResourceSet::destroy(VkDevice _device)
     {
+        m_descriptorBuffer.destroy(_device);
         m_set.destroy(_device);
+        if (m_fallbackTexture) {
+            m_fallbackTexture->destroyTextureHandler(_device);
+            delete m_fallbackTexture;
+            m_fallbackTexture = nullptr;
+        }
+        m_useDescriptorBuffer = false;
         m_device = VK_NULL_HANDLE;
         m_debugName.clear();
         m_maxMeshesLayout = 0;
         m_maxTexturesLayout = 0;
         m_textureDescriptorCount = 1;
         m_meshCountUsed = 0;
+        m_templateData = {};
+        m_templateEntries.clear();
+        m_templateMeshSlots = 0;
+        m_templateTextureSlots = 0;
+        m_slotMeshes = {};
+        m_slotTextures = {};
     }
 
-    void VulkanBindlessMeshResourceSet::recreateForSwapchain(const VulkanSwapChain& _swapchain, const VulkanUniformBuffer& _ubo,
-        const std::vector<std::shared_ptr<MeshHandler>>* _meshes)
+    bool VulkanBindlessMeshResourceSet::writeMeshSlot(uint32_t _meshSlot, uint32_t _textureSlot, const MeshHandler& _mesh)
     {
-        auto VkCore = m_vulkanCoreRef.lock();
-        if (!VkCore) MARK_FATAL(Utils::Category::Vulkan, "VulkanBindlessMeshResourceSet::recreateForSwapchain - core expired");
+        if (_meshSlot >= m_maxMeshesLayout) {
+            return false;
+        }
 
-        const uint32_t numImages = (uint32_t)_swapchain.numImages();
-        const uint32_t meshHint = _meshes ? (uint32_t)_meshes->size() : 0u;
+        TextureHandler* texture = (_textureSlot != UINT32_MAX) ? _mesh.texture() : nullptr;
+        if (texture && _textureSlot >= m_textureDescriptorCount) {
+            return false;
+        }
 
-        configureFromCaps(VkCore->bindlessCaps(), meshHint);
-        ensureLayoutCreated();
+        if (_meshSlot + 1u > m_meshCountUsed) {
+            m_meshCountUsed = _meshSlot + 1u;
+        }
 
-        m_set.destroyPoolAndSets(m_device);
-        recreatePoolAndSets(numImages);
-        updateAllDescriptors(numImages, _ubo, _meshes);
-    }
+        if (!_mesh.hasVertexBuffer() || !_mesh.hasIndexBuffer())
+            return true;
 
-    void VulkanBindlessMeshResourceSet::rebuildAll(const VulkanSwapChain& _swapchain, const VulkanUniformBuffer& _ubo,
-        const std::vector<std::shared_ptr<MeshHandler>>& _meshes)
-    {
-        updateAllDescriptors((uint32_t)_swapchain.numImages(), _ubo, &_meshes);
-    }
+        if (m_useDescriptorBuffer)
+        {
+            // Written in place, there is no set update at all
+            m_descriptorBuffer.writeBuffer(BindlessBinding::verticesSSBO, _meshSlot, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+                bufferAddress(m_device, _mesh.vertexBuffer()), _mesh.vertexBufferRange());
+            m_descriptorBuffer.writeBuffer(BindlessBinding::indicesSSBO, _meshSlot, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+                bufferAddress(m_device, _mesh.indexBuffer()), _mesh.indexBufferRange());
+
+            if (texture) {
+                m_descriptorBuffer.writeCombinedImageSampler(BindlessBinding::texture, _textureSlot,
+                    { texture->sampler(), texture->imageView(), VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL });
+            }
+            return true;
+        }
 
-    bool VulkanBindlessMeshResourceSet::tryWriteMeshSlot(const VulkanSwapChain& _swapchain, const VulkanUniformBuffer& _ubo, uint32_t _meshIndex, const MeshHandler& _mesh)
-    {
-        const uint32_t numImages = (uint32_t)_swapchain.numImages();
+        const VkDescriptorSet set = m_set.set(0);
+        const VkDescriptorBufferInfo vb{ _mesh.vertexBuffer(), 0, VK_WHOLE_SIZE };
+        const VkDescriptorBufferInfo ib{ _mesh.indexBuffer(), 0, VK_WHOLE_SIZE };
 
-        if (_meshIndex >= m_maxMeshesLayout) {
-            return false;
+        VkDescriptorImageInfo imgInfo{};
+        VkWriteDescriptorSet writes[3] = {
+            { VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET, nullptr, set, BindlessBinding::verticesSSBO, _meshSlot, 1,
+                VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, nullptr, &vb, nullptr },
+            { VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET, nullptr, set, BindlessBinding::indicesSSBO, _meshSlot, 1,
+                VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, nullptr, &ib, nullptr },
+            {}
+        };
+        uint32_t writeCount = 2;
+
+        if (texture)
+        {
+            imgInfo = { texture->sampler(), texture->imageView(), VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL };
+            writes[writeCount++] = {
+                .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+                .dstSet = set,
+                .dstBinding = BindlessBinding::texture,
+                .dstArrayElement = _textureSlot,
+                .descriptorCount = 1,
+                .descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+                .pImageInfo = &imgInfo
+            };
         }
 
-        const uint32_t texPerMesh = safeMax(1u, m_settings.numAttachableTextures);
-        const uint32_t firstTexIdx = _meshIndex * texPerMesh;
+        // Slot is unused by any pending draw, update-after-bind makes this legal without waiting on the GPU
+        vkUpdateDescriptorSets(m_device, writeCount, writes, 0, nullptr);
+        return true;
+    }
 
-        if (firstTexIdx >= m_textureDescriptorCount) {
+    bool VulkanBindlessMeshResourceSet::writeTextureSlot(uint32_t _textureSlot, const TextureHandler& _texture)
+    {
+        if (_textureSlot >= m_textureDescriptorCount) {
             return false;
         }
 
-        if (_meshIndex + 1u > m_meshCountUsed) {
-            m_meshCountUsed = _meshIndex + 1u;
+        const VkDescriptorImageInfo imgInfo{ _texture.sampler(), _texture.imageView(), VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL };
+        if (m_useDescriptorBuffer) {
+            m_descriptorBuffer.writeCombinedImageSampler(BindlessBinding::texture, _textureSlot, imgInfo);
+            return true;
         }
 
-        updateMeshSlotDescriptors(numImages, _meshIndex, _mesh, _ubo);
-
+        const VkWriteDescriptorSet write = {
+            .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+            .dstSet = m_set.set(0),
+            .dstBinding = BindlessBinding::texture,
+            .dstArrayElement = _textureSlot,
+            .descriptorCount = 1,
+            .descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+            .pImageInfo = &imgInfo
+        };
+        vkUpdateDescriptorSets(m_device, 1, &write, 0, nullptr);
         return true;
     }
 
-    void VulkanBindlessMeshResourceSet::bind(VkCommandBuffer _cmd, VkPipelineLayout _layout, uint32_t _imageIndex) const
+    void VulkanBindlessMeshResourceSet::bind(VkCommandBuffer _cmd, VkPipelineLayout _layout, uint32_t _frameSlot) const
     {
-        VkDescriptorSet set = m_set.set(_imageIndex);
-        if (set == VK_NULL_HANDLE) {
-            MARK_FATAL(Utils::Category::Vulkan, "BindlessMeshResourceSet bind: imageIndex out of range");
+        if (!valid()) {
+            MARK_FATAL(Utils::Category::Vulkan, "BindlessMeshResourceSet bind: descriptors not allocated");
+        }
+        if (_frameSlot >= FRAME_SLOTS) {
+            MARK_FATAL(Utils::Category::Vulkan, "BindlessMeshResourceSet bind: frame slot %u out of range (max %u)", _frameSlot, FRAME_SLOTS);
         }
 
-        vkCmdBindDescriptorSets(_cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, _layout, 0, 1, &set, 0, nullptr);
+        if (m_useDescriptorBuffer) {
+            m_descriptorBuffer.bind(_cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, _layout);
+        }
+        else {
+            VkDescriptorSet set = m_set.set(0);
+            vkCmdBindDescriptorSets(_cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, _layout, 0, 1, &set, 0, nullptr);
+        }
+
+        const PipelineFramePushConstants pushConstants{ .frameSlot = _frameSlot };
+        vkCmdPushConstants(_cmd, _layout, PIPELINE_FRAME_PUSH_CONSTANT_RANGE.stageFlags, 0, sizeof(pushConstants), &pushConstants);
     }
 
     void VulkanBindlessMeshResourceSet::configureFromCaps(const BindlessCaps& _caps, uint32_t _meshCountHint)
     {
-        m_maxTexturesLayout = safeMin(m_settings.numAttachableTextures, _caps.maxTextureDescriptors);
+        m_maxTexturesLayout = safeMin(m_settings.maxTextures, _caps.maxTextureDescriptors);
         if (m_maxTexturesLayout == 0) {
             m_maxTexturesLayout = 1;
         }
@@ -126,6 +239,10 @@ namespace Mark::RendererVK
             m_maxMeshesLayout = 1;
         }
 
+        // Both slot spaces have to fit in a packed BindlessDrawId
+        m_maxMeshesLayout = safeMin(m_maxMeshesLayout, BindlessDrawId::maxSlots);
+        m_maxTexturesLayout = safeMin(m_maxTexturesLayout, BindlessDrawId::maxSlots);
+
         const uint32_t texPerMesh = safeMax(1u, m_settings.numAttachableTextures);
         const uint32_t maxMeshesByTex = (m_maxTexturesLayout / texPerMesh);
         if (maxMeshesByTex == 0) {
@@ -138,209 +255,286 @@ namespace Mark::RendererVK
 
         m_meshCountUsed = safeMin(_meshCountHint, m_maxMeshesLayout);
 
-        uint32_t requiredTextures = 1;
-        if (_meshCountHint > 0) {
-            requiredTextures = safeMin(_meshCountHint * texPerMesh, m_maxTexturesLayout);
-        }
-
-        const uint32_t initCap = safeMin(m_settings.initialTextureCapacity, m_maxTexturesLayout);
-        m_textureDescriptorCount = growPow2Capacity(requiredTextures, m_maxTexturesLayout, initCap);
+        // The set is never reallocated, so the whole texture range is taken up front
+        m_textureDescriptorCount = m_maxTexturesLayout;
     }
 
     void VulkanBindlessMeshResourceSet::ensureLayoutCreated()
     {
         if (m_set.hasLayout()) return;
 
+        // Arrays written while frames are in flight. Slots a pending draw never reads may change under it.
+        // Descriptor buffers already behave that way and reject the update-after-bind and variable count flags
+        const VkDescriptorBindingFlags updateAfterBindFlags = m_useDescriptorBuffer ? VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT :
+            (VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT | VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT | VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT);
+        const VkDescriptorBindingFlags variableCountFlag = m_useDescriptorBuffer ? 0 : VK_DESCRIPTOR_BINDING_VARIABLE_DESCRIPTOR_COUNT_BIT;
+        const VkDescriptorSetLayoutCreateFlags layoutFlags = m_useDescriptorBuffer ?
+            VK_DESCRIPTOR_SET_LAYOUT_CREATE_DESCRIPTOR_BUFFER_BIT_EXT : VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT;
+
         std::vector<VkDescriptorSetLayoutBinding> bindings;
         std::vector<VkDescriptorBindingFlags> flags;
         bindings.reserve(4); flags.reserve(4);
 
         bindings.push_back({ BindlessBinding::verticesSSBO, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, m_maxMeshesLayout, VK_SHADER_STAGE_VERTEX_BIT, nullptr });
-        flags.push_back(VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT);
+        flags.push_back(updateAfterBindFlags);
 
         bindings.push_back({ BindlessBinding::indicesSSBO, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, m_maxMeshesLayout, VK_SHADER_STAGE_VERTEX_BIT, nullptr });
-        flags.push_back(VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT);
+        flags.push_back(updateAfterBindFlags);
 
-        bindings.push_back({ BindlessBinding::UBO, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1, VK_SHADER_STAGE_VERTEX_BIT, nullptr });
+        // Written once at initialize, so it stays a plain binding
+        bindings.push_back({ BindlessBinding::UBO, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, FRAME_SLOTS, VK_SHADER_STAGE_VERTEX_BIT, nullptr });
         flags.push_back(0);
 
         bindings.push_back({ BindlessBinding::texture, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, m_maxTexturesLayout, VK_SHADER_STAGE_FRAGMENT_BIT, nullptr });
-        flags.push_back(VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT | VK_DESCRIPTOR_BINDING_VARIABLE_DESCRIPTOR_COUNT_BIT);
+        flags.push_back(updateAfterBindFlags | variableCountFlag);
+
+        m_set.createLayout(m_device, bindings, flags, layoutFlags, ("BindlessMesh." + m_debugName + ".Set0").c_str());
 
-        m_set.createLayout(m_device, bindings, flags, 0, ("BindlessMesh." + m_debugName + ".Set0").c_str());
+        // Pipelines recorded against this layout last session can start compiling now
+        if (auto VkCore = m_vulkanCoreRef.lock()) {
+            VkCore->pipelineManifest().prewarm(m_set.layout(), m_set.layoutHash());
+        }
     }
 
-    void VulkanBindlessMeshResourceSet::recreatePoolAndSets(uint32_t _numImages)
+    void VulkanBindlessMeshResourceSet::createDescriptorStorage()
     {
+        if (m_useDescriptorBuffer)
+        {
+            auto VkCore = m_vulkanCoreRef.lock();
+            if (!VkCore) MARK_FATAL(Utils::Category::Vulkan, "VulkanBindlessMeshResourceSet::createDescriptorStorage - VulkanCore expired");
+
+            m_descriptorBuffer.create(VkCore, m_set.layout(), BindlessBinding::texture + 1u, ("BindlessMesh." + m_debugName).c_str());
+            return;
+        }
+
         std::vector<VkDescriptorPoolSize> sizes;
-        sizes.push_back({ VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, _numImages * m_maxMeshesLayout * 2u });
-        sizes.push_back({ VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,  _numImages });
-        sizes.push_back({ VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, _numImages * m_textureDescriptorCount });
+        sizes.push_back({ VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, m_maxMeshesLayout * 2u });
+        sizes.push_back({ VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, FRAME_SLOTS });
+        sizes.push_back({ VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, m_textureDescriptorCount });
 
-        m_set.createPool(m_device, sizes, _numImages, 0, ("BindlessMesh." + m_debugName).c_str());
-        m_set.allocateSetsVariableCount(m_device, _numImages, m_textureDescriptorCount, ("BindlessMesh." + m_debugName).c_str());
+        m_set.createPool(m_device, sizes, 1u, VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT, ("BindlessMesh." + m_debugName).c_str());
+        m_set.allocateSetsVariableCount(m_device, 1u, m_textureDescriptorCount, ("BindlessMesh." + m_debugName).c_str());
     }
 
-    void VulkanBindlessMeshResourceSet::updateAllDescriptors(uint32_t _numImages, const VulkanUniformBuffer& _ubo,
-        const std::vector<std::shared_ptr<MeshHandler>>* _meshes)
+    void VulkanBindlessMeshResourceSet::updateAllDescriptors(const VulkanUniformBuffer& _ubo, const MeshPool* _meshes)
     {
-        std::vector<VkDescriptorBufferInfo> uboInfos(_numImages);
-        for (uint32_t img = 0; img < _numImages; img++) {
-            uboInfos[img] = _ubo.descriptorInfo(img);
-        }
-
-        if (!_meshes || _meshes->empty())
+        if (m_useDescriptorBuffer)
         {
-            std::vector<VkWriteDescriptorSet> writes;
-            writes.reserve(_numImages);
-            for (uint32_t img = 0; img < _numImages; img++)
-            {
-                VkDescriptorSet set = m_set.set(img);
-                writes.push_back({ VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET, nullptr, set, BindlessBinding::UBO, 0, 1,
-                    VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, nullptr, &uboInfos[img], nullptr });
+            for (uint32_t slot = 0; slot < FRAME_SLOTS; slot++) {
+                const VkDescriptorBufferInfo info = _ubo.descriptorInfo(slot);
+                m_descriptorBuffer.writeBuffer(BindlessBinding::UBO, slot, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+                    bufferAddress(m_device, info.buffer) + info.offset, info.range);
+            }
+            writeTextureSlot(FALLBACK_TEXTURE_SLOT, *m_fallbackTexture);
+
+            if (_meshes) {
+                for (uint32_t i = 0; i < _meshes->size(); i++) {
+                    if (_meshes->meshSlots()[i] != UINT32_MAX) {
+                        writeMeshSlot(_meshes->meshSlots()[i], _meshes->textureSlots()[i], _meshes->mesh(i));
+                    }
+                }
             }
-            vkUpdateDescriptorSets(m_device, (uint32_t)writes.size(), writes.data(), 0, nullptr);
             return;
         }
 
-        m_meshCountUsed = safeMin((uint32_t)_meshes->size(), m_maxMeshesLayout);
-
-        std::vector<VkDescriptorBufferInfo> vbInfos(m_meshCountUsed);
-        std::vector<VkDescriptorBufferInfo> ibInfos(m_meshCountUsed);
-        std::vector<uint8_t> hasMesh(m_meshCountUsed, 0);
-
-        const uint32_t texPerMesh = safeMax(1u, m_settings.numAttachableTextures);
-        const uint32_t texturesUsed = safeMin(m_meshCountUsed * texPerMesh, m_textureDescriptorCount);
-
-        std::vector<VkDescriptorImageInfo> imgInfos(texturesUsed);
-        std::vector<uint8_t> hasTex(texturesUsed, 0);
-
-        for (uint32_t m = 0; m < m_meshCountUsed; m++)
+        // Slot -> resource lookups over the used slot ranges, mesh order in _meshes does not matter
+        uint32_t meshSlotsEnd = 0;
+        uint32_t textureSlotsEnd = FALLBACK_TEXTURE_SLOT + 1u;
+        if (_meshes)
         {
-            const auto mesh = _meshes->at(m);
-            if (!mesh) continue;
-
-            if (mesh->hasVertexBuffer() && mesh->hasIndexBuffer())
-            {
-                vbInfos[m] = { mesh->vertexBuffer(), 0, VK_WHOLE_SIZE };
-                ibInfos[m] = { mesh->indexBuffer(), 0, VK_WHOLE_SIZE };
-                hasMesh[m] = 1;
+            for (const uint32_t meshSlot : _meshes->meshSlots()) {
+                if (meshSlot < m_maxMeshesLayout) {
+                    meshSlotsEnd = safeMax(meshSlotsEnd, meshSlot + 1u);
+                }
             }
-
-            const uint32_t texIndex = m * texPerMesh;
-            if (texIndex < texturesUsed)
-            {
-                TextureHandler* t = mesh->texture();
-                if (t)
-                {
-                    VkDescriptorImageInfo info{ t->sampler(), t->imageView(), VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL };
-                    imgInfos[texIndex] = info;
-                    hasTex[texIndex] = 1;
+            for (const uint32_t textureSlot : _meshes->textureSlots()) {
+                if (textureSlot < m_textureDescriptorCount) {
+                    textureSlotsEnd = safeMax(textureSlotsEnd, textureSlot + 1u);
                 }
             }
         }
 
-        std::vector<VkWriteDescriptorSet> writes;
-        writes.reserve(_numImages * (1u + m_meshCountUsed * 2u + texturesUsed));
-
-        for (uint32_t img = 0; img < _numImages; img++)
+        m_slotMeshes.assign(meshSlotsEnd, nullptr);
+        m_slotTextures.assign(textureSlotsEnd, nullptr);
+        m_slotTextures[FALLBACK_TEXTURE_SLOT] = m_fallbackTexture;
+        if (_meshes)
         {
-            VkDescriptorSet set = m_set.set(img);
-
-            writes.push_back({ VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET, nullptr, set, BindlessBinding::UBO, 0, 1,
-                VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, nullptr, &uboInfos[img], nullptr });
-
-            for (uint32_t m = 0; m < m_meshCountUsed; m++)
+            for (uint32_t i = 0; i < _meshes->size(); i++)
             {
-                if (!hasMesh[m]) continue;
-
-                writes.push_back({ VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET, nullptr, set, BindlessBinding::verticesSSBO, m, 1,
-                    VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, nullptr, &vbInfos[m], nullptr });
-
-                writes.push_back({ VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET, nullptr, set, BindlessBinding::indicesSSBO, m, 1,
-                    VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, nullptr, &ibInfos[m], nullptr });
+                const MeshHandler& mesh = _meshes->mesh(i);
+                const uint32_t meshSlot = _meshes->meshSlots()[i];
+                if (meshSlot < meshSlotsEnd && mesh.hasVertexBuffer() && mesh.hasIndexBuffer()) {
+                    m_slotMeshes[meshSlot] = &mesh;
+                }
+                const uint32_t textureSlot = _meshes->textureSlots()[i];
+                if (textureSlot < textureSlotsEnd) {
+                    m_slotTextures[textureSlot] = mesh.texture();
+                }
             }
+        }
+        m_meshCountUsed = meshSlotsEnd;
 
-            for (uint32_t t = 0; t < texturesUsed; t++)
-            {
-                if (!hasTex[t]) continue;
-
-                VkWriteDescriptorSet writeSet = { 
-                    .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
-                    .dstSet = set,
-                    .dstBinding = BindlessBinding::texture,
-                    .dstArrayElement = t,
-                    .descriptorCount = 1,
-                    .descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
-                    .pImageInfo = &imgInfos[t]
-                };
-
-                writes.push_back(writeSet);
-            }
+        // The template writes each binding's used range in one go, so empty slots repeat the first valid descriptor
+        // No draw reads those slots. A binding with nothing valid is left out of the template entirely
+        uint32_t firstMesh = UINT32_MAX;
+        for (uint32_t m = 0; m < meshSlotsEnd && firstMesh == UINT32_MAX; m++) {
+            if (m_slotMeshes[m]) firstMesh = m;
+        }
+        uint32_t firstTexture = UINT32_MAX;
+        for (uint32_t t = 0; t < textureSlotsEnd && firstTexture == UINT32_MAX; t++) {
+            if (m_slotTextures[t]) firstTexture = t;
         }
 
-        vkUpdateDescriptorSets(m_device, (uint32_t)writes.size(), writes.data(), 0, nullptr);
-    }
+        const uint32_t meshSlots = (firstMesh != UINT32_MAX) ? meshSlotsEnd : 0u;
+        const uint32_t textureSlots = (firstTexture != UINT32_MAX) ? textureSlotsEnd : 0u;
 
-    void VulkanBindlessMeshResourceSet::updateMeshSlotDescriptors(uint32_t _numImages, uint32_t _meshIndex,
-        const MeshHandler& _mesh, const VulkanUniformBuffer& _ubo)
-    {
-        if (!_mesh.hasVertexBuffer() || !_mesh.hasIndexBuffer())
-            return;
+        const PackedDescriptorLayout packed = packedDescriptorLayout(meshSlots, textureSlots);
+        if (m_templateData.size() < packed.size) {
+            m_templateData.resize(packed.size);
+        }
 
-        VkDescriptorBufferInfo vb{ _mesh.vertexBuffer(), 0, VK_WHOLE_SIZE };
-        VkDescriptorBufferInfo ib{ _mesh.indexBuffer(), 0, VK_WHOLE_SIZE };
+        auto* vbInfos = reinterpret_cast<VkDescriptorBufferInfo*>(m_templateData.data() + packed.vertices);
+        auto* ibInfos = reinterpret_cast<VkDescriptorBufferInfo*>(m_templateData.data() + packed.indices);
+        auto* uboInfos = reinterpret_cast<VkDescriptorBufferInfo*>(m_templateData.data() + packed.ubos);
+        auto* imgInfos = reinterpret_cast<VkDescriptorImageInfo*>(m_templateData.data() + packed.images);
 
-        std::vector<VkDescriptorBufferInfo> uboInfos(_numImages);
-        for (uint32_t img = 0; img < _numImages; img++) {
-            uboInfos[img] = _ubo.descriptorInfo(img);
-        }
+        for (uint32_t m = 0; m < meshSlots; m++)
+        {
+            const MeshHandler* mesh = m_slotMeshes[m] ? m_slotMeshes[m] : m_slotMeshes[firstMesh];
 
-        const uint32_t texPerMesh = safeMax(1u, m_settings.numAttachableTextures);
-        const uint32_t texIndex = _meshIndex * texPerMesh;
+            vbInfos[m] = { mesh->vertexBuffer(), 0, VK_WHOLE_SIZE };
+            ibInfos[m] = { mesh->indexBuffer(), 0, VK_WHOLE_SIZE };
+        }
 
-        TextureHandler* t = _mesh.texture();
-        VkDescriptorImageInfo imgInfo{};
-        bool writeTex = false;
+        for (uint32_t slot = 0; slot < FRAME_SLOTS; slot++) {
+            uboInfos[slot] = _ubo.descriptorInfo(slot);
+        }
 
-        if (t)
+        for (uint32_t t = 0; t < textureSlots; t++)
         {
-            imgInfo = { t->sampler(), t->imageView(), VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL };
-            writeTex = true;
-        }
+            TextureHandler* texture = m_slotTextures[t] ? m_slotTextures[t] : m_slotTextures[firstTexture];
 
-        std::vector<VkWriteDescriptorSet> writes;
-        writes.reserve(_numImages * (3u + (writeTex ? 1u : 0u)));
+            imgInfos[t] = { texture->sampler(), texture->imageView(), VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL };
+        }
 
-        for (uint32_t img = 0; img < _numImages; img++)
+        if (!m_set.hasUpdateTemplate() || meshSlots != m_templateMeshSlots || textureSlots != m_templateTextureSlots)
         {
-            VkDescriptorSet set = m_set.set(img);
+            packedDescriptorEntries(m_templateEntries, packed, meshSlots, textureSlots);
+            m_set.createUpdateTemplate(m_device, m_templateEntries, ("BindlessMesh." + m_debugName).c_str());
+            m_templateMeshSlots = meshSlots;
+            m_templateTextureSlots = textureSlots;
+        }
 
-            writes.push_back({ VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET, nullptr, set, BindlessBinding::UBO, 0, 1,
-                VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, nullptr, &uboInfos[img], nullptr });
+        m_set.updateSetWithTemplate(m_device, 0, m_templateData.data());
+    }
 
-            writes.push_back({ VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET, nullptr, set, BindlessBinding::verticesSSBO, _meshIndex, 1,
-                VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, nullptr, &vb, nullptr });
+    void VulkanBindlessMeshResourceSet::benchmarkDescriptorRewrite(std::weak_ptr<VulkanCore> _vulkanCoreRef, VulkanCommandBuffers* _commandBuffersRef,
+        const VulkanUniformBuffer& _ubo, const char* _texturePath, uint32_t _count)
+    {
+        auto VkCore = _vulkanCoreRef.lock();
+        if (!VkCore) MARK_FATAL(Utils::Category::Vulkan, "VulkanBindlessMeshResourceSet::benchmarkDescriptorRewrite - VulkanCore expired");
+        VkDevice device = VkCore->device();
+
+        // The engine layout is capped by BindlessCaps, so the benchmark uses its own plain layout sized to _count
+        const VkPhysicalDeviceLimits& limits = VkCore->physicalDevices().selected().m_properties.limits;
+        const uint32_t slots = std::min({ _count,
+            limits.maxPerStageDescriptorStorageBuffers / 2u, limits.maxDescriptorSetStorageBuffers / 2u,
+            (limits.maxPerStageResources > FRAME_SLOTS) ? (limits.maxPerStageResources - FRAME_SLOTS) / 2u : 0u,
+            limits.maxPerStageDescriptorSamplers, limits.maxPerStageDescriptorSampledImages,
+            limits.maxDescriptorSetSamplers, limits.maxDescriptorSetSampledImages });
+        if (slots == 0) {
+            MARK_WARN(Utils::Category::Vulkan, "Descriptor rewrite benchmark skipped, device limits allow no slots");
+            return;
+        }
 
-            writes.push_back({ VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET, nullptr, set, BindlessBinding::indicesSSBO, _meshIndex, 1,
-                VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, nullptr, &ib, nullptr });
+        TextureHandler texture(_vulkanCoreRef, _commandBuffersRef);
+        TextureHandler::generateTextures({ &texture }, { _texturePath });
+        BufferAndMemory storage(VkCore, 256, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, "DescriptorRewriteBenchmark.SSBO");
+
+        VulkanDescriptorSetBundle bundle;
+        bundle.createLayout(device, {
+                { BindlessBinding::verticesSSBO, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, slots, VK_SHADER_STAGE_VERTEX_BIT, nullptr },
+                { BindlessBinding::indicesSSBO, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, slots, VK_SHADER_STAGE_VERTEX_BIT, nullptr },
+                { BindlessBinding::UBO, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, FRAME_SLOTS, VK_SHADER_STAGE_VERTEX_BIT, nullptr },
+                { BindlessBinding::texture, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, slots, VK_SHADER_STAGE_FRAGMENT_BIT, nullptr }
+            }, {}, 0, "DescriptorRewriteBenchmark");
+        bundle.createPool(device, {
+                { VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, slots * 2u },
+                { VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, FRAME_SLOTS },
+                { VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, slots }
+            }, 1u, 0, "DescriptorRewriteBenchmark");
+        bundle.allocateSets(device, 1u, "DescriptorRewriteBenchmark");
+
+        const VkDescriptorSet set = bundle.set(0);
+        const VkDescriptorBufferInfo storageInfo{ storage.m_buffer, 0, VK_WHOLE_SIZE };
+        const VkDescriptorImageInfo imageInfo{ texture.sampler(), texture.imageView(), VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL };
+        constexpr uint32_t iterations = 16;
+
+        // Per-descriptor writes with fresh info and write arrays on every rewrite
+        auto writesStart = std::chrono::steady_clock::now();
+        for (uint32_t i = 0; i < iterations; i++)
+        {
+            std::vector<VkDescriptorBufferInfo> uboInfos(FRAME_SLOTS);
+            for (uint32_t slot = 0; slot < FRAME_SLOTS; slot++) {
+                uboInfos[slot] = _ubo.descriptorInfo(slot);
+            }
+            std::vector<VkDescriptorBufferInfo> vbInfos(slots, storageInfo);
+            std::vector<VkDescriptorBufferInfo> ibInfos(slots, storageInfo);
+            std::vector<VkDescriptorImageInfo> imgInfos(slots, imageInfo);
 
-            if (writeTex)
+            std::vector<VkWriteDescriptorSet> writes;
+            writes.reserve(1u + slots * 3u);
+            writes.push_back({ VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET, nullptr, set, BindlessBinding::UBO, 0, FRAME_SLOTS,
+                VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, nullptr, uboInfos.data(), nullptr });
+            for (uint32_t m = 0; m < slots; m++)
             {
-                VkWriteDescriptorSet writeSet = {
-                    .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
-                    .dstSet = set,
-                    .dstBinding = BindlessBinding::texture,
-                    .dstArrayElement = texIndex,
-                    .descriptorCount = 1,
-                    .descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
-                    .pImageInfo = &imgInfo
-                };
-
-                writes.push_back(writeSet);
+                writes.push_back({ VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET, nullptr, set, BindlessBinding::verticesSSBO, m, 1,
+                    VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, nullptr, &vbInfos[m], nullptr });
+                writes.push_back({ VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET, nullptr, set, BindlessBinding::indicesSSBO, m, 1,
+                    VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, nullptr, &ibInfos[m], nullptr });
+                writes.push_back({ VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET, nullptr, set, BindlessBinding::texture, m, 1,
+                    VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, &imgInfos[m], nullptr, nullptr });
             }
+            vkUpdateDescriptorSets(device, (uint32_t)writes.size(), writes.data(), 0, nullptr);
         }
+        double writesMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - writesStart).count() / iterations;
 
-        vkUpdateDescriptorSets(m_device, (uint32_t)writes.size(), writes.data(), 0, nullptr);
+        // Same rewrite packed into reused storage and applied through one template call
+        const PackedDescriptorLayout packed = packedDescriptorLayout(slots, slots);
+        std::vector<VkDescriptorUpdateTemplateEntry> entries;
+        packedDescriptorEntries(entries, packed, slots, slots);
+        bundle.createUpdateTemplate(device, entries, "DescriptorRewriteBenchmark");
+        std::vector<std::byte> data(packed.size);
+
+        auto templateStart = std::chrono::steady_clock::now();
+        for (uint32_t i = 0; i < iterations; i++)
+        {
+            auto* vbInfos = reinterpret_cast<VkDescriptorBufferInfo*>(data.data() + packed.vertices);
+            auto* ibInfos = reinterpret_cast<VkDescriptorBufferInfo*>(data.data() + packed.indices);
+            auto* uboInfos = reinterpret_cast<VkDescriptorBufferInfo*>(data.data() + packed.ubos);
+            auto* imgInfos = reinterpret_cast<VkDescriptorImageInfo*>(data.data() + packed.images);
+
+            for (uint32_t m = 0; m < slots; m++) {
+                vbInfos[m] = storageInfo;
+                ibInfos[m] = storageInfo;
+                imgInfos[m] = imageInfo;
+            }
+            for (uint32_t slot = 0; slot < FRAME_SLOTS; slot++) {
+                uboInfos[slot] = _ubo.descriptorInfo(slot);
+            }
+            bundle.updateSetWithTemplate(device, 0, data.data());
+        }
+        double templateMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - templateStart).count() / iterations;
+
+        bundle.destroy(device);
+        storage.destroy(device);
+        texture.destroyTextureHandler(device);
+
+        const auto level = Utils::Level::Info;
+        const auto category = Utils::Category::Vulkan;
+        MARK_SCOPE(category, level, "Descriptor rewrite benchmark (%u of %u requested mesh + texture slots, avg of %u rewrites):", slots, _count, iterations);
+        MARK_IN_SCOPE(category, level, "vkUpdateDescriptorSets:            %.3f ms", writesMs);
+        MARK_IN_SCOPE(category, level, "vkUpdateDescriptorSetWithTemplate: %.3f ms", templateMs);
+        MARK_IN_SCOPE(category, level, "Speedup: %.2fx", templateMs > 0.0 ? writesMs / templateMs : 0.0);
     }
 } // namespace Mark::RendererVK
\ No newline at end of file
@@ -1,25 +1,39 @@
 #pragma once
 #include "Mark_DescriptorSetBundle.h"
+#include "Mark_DescriptorBuffer.h"
 
 #include <Volk/volk.h>
 #include <cstdint>
 #include <string>
 #include <vector>
 #include <memory>
+#include <cstddef>
+
+// Set to 1 to time a full rewrite of MARK_DESCRIPTOR_TEMPLATE_BENCHMARK_COUNT mesh + texture slots
+// through per-descriptor vkUpdateDescriptorSets writes and through the update template at startup
+#ifndef MARK_DESCRIPTOR_TEMPLATE_BENCHMARK
+    #define MARK_DESCRIPTOR_TEMPLATE_BENCHMARK 0
+#endif
+#ifndef MARK_DESCRIPTOR_TEMPLATE_BENCHMARK_COUNT
+    #define MARK_DESCRIPTOR_TEMPLATE_BENCHMARK_COUNT 8192
+#endif
 
 namespace Mark::RendererVK
 {
     struct VulkanCore;
-    struct VulkanSwapChain;
+    struct VulkanCommandBuffers;
     struct VulkanUniformBuffer;
     struct MeshHandler;
+    struct MeshPool;
     struct TextureHandler;
     struct BindlessCaps;
 
-    //  binding 0: vertices SSBO array
-    //  binding 1: indices SSBO array
-    //  binding 2: global/per-image UBO
-    //  binding 3: bindless textures (has variable descriptor count)
+    //  binding 0: vertices SSBO array (update-after-bind)
+    //  binding 1: indices SSBO array (update-after-bind)
+    //  binding 2: UBO slot array, one per frame slot, picked by PipelineFramePushConstants::frameSlot
+    //  binding 3: bindless textures (update-after-bind, has variable descriptor count)
+    // With VK_EXT_descriptor_buffer the same layout lives in a VulkanDescriptorBuffer instead of a pooled set,
+    // written in place with no update-after-bind or variable count flags
     namespace BindlessBinding
     {
         constexpr uint32_t verticesSSBO = 0;
@@ -28,6 +42,15 @@ namespace Mark::RendererVK
         constexpr uint32_t texture = 3;
     }
 
+    // firstInstance of every indirect draw packs the mesh slot (low bits) and texture slot (high bits)
+    // TriangleTest.vert unpacks it from gl_InstanceIndex, so the two slot spaces are allocated independently
+    namespace BindlessDrawId
+    {
+        constexpr uint32_t slotBits = 16;
+        constexpr uint32_t maxSlots = 1u << slotBits;
+        constexpr uint32_t encode(uint32_t _meshSlot, uint32_t _textureSlot) { return _meshSlot | (_textureSlot << slotBits); }
+    }
+
     struct VulkanBindlessMeshResourceSet
     {
         VulkanBindlessMeshResourceSet() = default;
@@ -41,36 +64,38 @@ namespace Mark::RendererVK
             // Keeps the texture array to a sensible max for the engine
             const uint32_t maxTextures = 8192u;
 
-            // Initial capacity for command buffers to bind (Avoids immediate full rebuild)
-            const uint32_t initialTextureCapacity = 64u;
-
             // Number of possible textures that the engine can handle per mesh
             const uint32_t numAttachableTextures = 1u;
         };
 
-        void initialize(std::weak_ptr<VulkanCore> _core, const VulkanSwapChain& _swapchain, const VulkanUniformBuffer& _ubo,
-            const std::vector<std::shared_ptr<MeshHandler>>* _meshes, // Optional (can be null)
+        // Max UBO slots in binding 2, swapchains with more images than this are rejected
+        static constexpr uint32_t FRAME_SLOTS = 8u;
+
+        // Texture slot holding MARK_FALLBACK_TEXTURE from initialize on, meshes without a texture draw with it
+        // The texture slot allocator must never hand it out
+        static constexpr uint32_t FALLBACK_TEXTURE_SLOT = 0u;
+
+        // The UBO must hold FRAME_SLOTS buffers, its descriptors are written once here and never again
+        // _commandBuffersRef needs its copy command buffer already, it uploads the fallback texture
+        void initialize(std::weak_ptr<VulkanCore> _core, VulkanCommandBuffers* _commandBuffersRef, const VulkanUniformBuffer& _ubo,
+            const MeshPool* _meshes, // Optional (can be null)
             const char* _debugName
         );
 
         void destroy(VkDevice _device);
 
-        // Recreate pool + sets when swapchain image count changes
-        void recreateForSwapchain(const VulkanSwapChain& _swapchain, const VulkanUniformBuffer& _ubo,
-            const std::vector<std::shared_ptr<MeshHandler>>* _meshes // Optional (can be null)
-        );
+        // Writes one mesh slot (and its texture slot, UINT32_MAX for none) in a single vkUpdateDescriptorSets call
+        // Safe while frames using the set are in flight as long as no pending draw reads those slots
+        // Returns false if either slot is past the layout capacity
+        bool writeMeshSlot(uint32_t _meshSlot, uint32_t _textureSlot, const MeshHandler& _mesh);
+        // Same for a single texture slot, used when only the texture moves
+        bool writeTextureSlot(uint32_t _textureSlot, const TextureHandler& _texture);
 
-        // Full rewrite of all descriptors (UBO + mesh slots + textures)
-        void rebuildAll(const VulkanSwapChain& _swapchain, const VulkanUniformBuffer& _ubo,
-            const std::vector<std::shared_ptr<MeshHandler>>& _meshes
-        );
-
-        // Updates a single mesh slot across all swapchain-image sets
-        // Returns false if capacity exceeded and a full recreate is required
-        bool tryWriteMeshSlot(const VulkanSwapChain& _swapchain, const VulkanUniformBuffer& _ubo, uint32_t _meshIndex, const MeshHandler& _mesh);
+        // Bind set 0 and push the frame slot the recorded commands read their UBO from
+        void bind(VkCommandBuffer _cmd, VkPipelineLayout _layout, uint32_t _frameSlot) const;
 
-        // Bind set 0 for the given swapchain image index.
-        void bind(VkCommandBuffer _cmd, VkPipelineLayout _layout, uint32_t _imageIndex) const;
+        // Pipelines using this layout must set PipelineDesc::descriptorBuffer to match
+        bool usesDescriptorBuffer() const noexcept { return m_useDescriptorBuffer; }
 
         VkDescriptorSetLayout layout() const noexcept { return m_set.layout(); }
         uint64_t layoutHash() const noexcept { return m_set.layoutHash(); }
@@ -79,9 +104,13 @@ namespace Mark::RendererVK
         uint32_t maxMeshesLayout() const noexcept { return m_maxMeshesLayout; }
         uint32_t maxTexturesLayout() const noexcept { return m_maxTexturesLayout; }
         uint32_t textureCapacity()  const noexcept { return m_textureDescriptorCount; }
-        uint32_t meshCountUsed()    const noexcept { return m_meshCountUsed; }
+        uint32_t meshCountUsed()    const noexcept { return m_meshCountUsed; } // End of the written mesh slot range
 
-        bool valid() const noexcept { return m_set.hasLayout() && m_set.hasSets(); }
+        bool valid() const noexcept { return m_set.hasLayout() && (m_useDescriptorBuffer ? m_descriptorBuffer.valid() : m_set.hasSets()); }
+
+        // Rewrites _count mesh + texture slots of a standalone set (clamped to device limits) with writes and with a template, logs both timings
+        static void benchmarkDescriptorRewrite(std::weak_ptr<VulkanCore> _vulkanCoreRef, VulkanCommandBuffers* _commandBuffersRef,
+            const VulkanUniformBuffer& _ubo, const char* _texturePath, uint32_t _count);
 
     private:
         std::weak_ptr<VulkanCore> m_vulkanCoreRef;
@@ -89,24 +118,32 @@ namespace Mark::RendererVK
         std::string m_debugName;
         const Settings m_settings;
 
-        VulkanDescriptorSetBundle m_set;
+        VulkanDescriptorSetBundle m_set; // Layout always, pool + set only without descriptor buffers
+        VulkanDescriptorBuffer m_descriptorBuffer;
+        bool m_useDescriptorBuffer{ false };
+
+        TextureHandler* m_fallbackTexture{ nullptr }; // Written to FALLBACK_TEXTURE_SLOT
 
         // Layout config / capacity
         uint32_t m_maxMeshesLayout{ 0 };        // DescriptorCount for bindings 0/1
         uint32_t m_maxTexturesLayout{ 0 };      // Layout maximum for binding 3
-        uint32_t m_textureDescriptorCount{ 1 }; // Allocated variable descriptor count capacity for binding 3
-        uint32_t m_meshCountUsed{ 0 };          // Used mesh count (clamped to maxMeshesLayout)
+        uint32_t m_textureDescriptorCount{ 1 }; // Allocated variable descriptor count for binding 3, full layout max
+        uint32_t m_meshCountUsed{ 0 };          // End of the used mesh slot range (clamped to maxMeshesLayout)
+
+        // Update template state for the pool path, the template is only recreated when the covered slot counts change
+        std::vector<std::byte> m_templateData;  // Packed descriptor infos, grows but is never freed between rewrites
+        std::vector<VkDescriptorUpdateTemplateEntry> m_templateEntries;
+        uint32_t m_templateMeshSlots{ 0 };      // Mesh slots the current template covers
+        uint32_t m_templateTextureSlots{ 0 };   // Texture slots the current template covers
+        std::vector<const MeshHandler*> m_slotMeshes;   // Mesh slot -> mesh, rebuilt per rewrite
+        std::vector<TextureHandler*> m_slotTextures;    // Texture slot -> texture, rebuilt per rewrite
 
         void configureFromCaps(const BindlessCaps& _caps, uint32_t _meshCountHint);
         void ensureLayoutCreated();
-        void recreatePoolAndSets(uint32_t _numImages);
-
-        void updateAllDescriptors(uint32_t _numImages,
-            const VulkanUniformBuffer& _ubo,
-            const std::vector<std::shared_ptr<MeshHandler>>* _meshes);
-
-        void updateMeshSlotDescriptors(uint32_t _numImages,uint32_t _meshIndex, const MeshHandler& _mesh, const VulkanUniformBuffer& _ubo);
+        void createDescriptorStorage();
 
-        static uint32_t growPow2Capacity(uint32_t _required, uint32_t _maxCap, uint32_t _initialCap);
+        // Full rewrite (UBO slots + mesh slots + textures), initialize only: the UBO binding isn't update-after-bind
+        // so this can't run while recorded frames are in flight. Runtime changes go through the per-slot writes
+        void updateAllDescriptors(const VulkanUniformBuffer& _ubo, const MeshPool* _meshes);
     };
 } // namespace Mark::RendererVK
\ No newline at end of file
@@ -29,14 +29,20 @@ namespace Mark::RendererVK
         MARK_DEBUG(Utils::Category::Vulkan, "Buffer requires %d bytes", memRequirements.size);
 
         m_allocationSize = memRequirements.size;
+        m_size = _size;
 
         // Get memory type index
         uint32_t memoryTypeIndex = _vulkanCoreRef->getMemoryTypeIndex(memRequirements.memoryTypeBits, _propertyFlags);
         MARK_DEBUG(Utils::Category::Vulkan, "Buffer memory type index: %d", memoryTypeIndex);
 
-        // Allocate memory for the buffer
+        // Allocate memory for the buffer, device addressable buffers need the matching allocation flag
+        VkMemoryAllocateFlagsInfo allocFlagsInfo = {
+            .sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_FLAGS_INFO,
+            .flags = VK_MEMORY_ALLOCATE_DEVICE_ADDRESS_BIT
+        };
         VkMemoryAllocateInfo memoryAllocInfo = {
             .sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
+            .pNext = (_usageFlags & VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT) ? &allocFlagsInfo : nullptr,
             .allocationSize = memRequirements.size,
             .memoryTypeIndex = memoryTypeIndex
         };
@@ -70,6 +76,28 @@ namespace Mark::RendererVK
         vkUnmapMemory(_device, m_memory);
     }
 
+    void* BufferAndMemory::map(VkDevice _device)
+    {
+        void* mem = nullptr;
+        VkResult res = vkMapMemory(_device, m_memory, 0, VK_WHOLE_SIZE, 0, &mem);
+        CHECK_VK_RESULT(res, "Map Buffer Memory");
+        return mem;
+    }
+
+    void BufferAndMemory::unmap(VkDevice _device)
+    {
+        vkUnmapMemory(_device, m_memory);
+    }
+
+    VkDeviceAddress BufferAndMemory::deviceAddress(VkDevice _device) const
+    {
+        const VkBufferDeviceAddressInfo addressInfo = {
+            .sType = VK_STRUCTURE_TYPE_BUFFER_DEVICE_ADDRESS_INFO,
+            .buffer = m_buffer
+        };
+        return vkGetBufferDeviceAddress(_device, &addressInfo);
+    }
+
     void BufferAndMemory::destroy(VkDevice _device)
     {
         if (m_buffer)
@@ -83,5 +111,6 @@ namespace Mark::RendererVK
             m_memory = VK_NULL_HANDLE;
         }
         m_allocationSize = 0;
+        m_size = 0;
     }
 } // namespace Mark::RendererVK
\ No newline at end of file
@@ -14,10 +14,18 @@ namespace Mark::RendererVK
         VkBuffer m_buffer{ VK_NULL_HANDLE };
         VkDeviceMemory m_memory{ VK_NULL_HANDLE };
         VkDeviceSize m_allocationSize{ 0 };
+        VkDeviceSize m_size{ 0 }; // Requested size, the allocation can be larger
 
         void update(VkDevice _device, const void* _data, size_t _size);
         void updateRange(VkDevice _device, const void* _data, size_t _size, VkDeviceSize _offset);
 
+        // Maps the whole allocation, for callers that write or read the memory in place
+        void* map(VkDevice _device);
+        void unmap(VkDevice _device);
+
+        // Buffer must have been created with VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT
+        VkDeviceAddress deviceAddress(VkDevice _device) const;
+
         void destroy(VkDevice _device);
     };
 } // namespace Mark::RendererVK
\ No newline at end of file
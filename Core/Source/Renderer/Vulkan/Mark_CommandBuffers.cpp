@@ -1,14 +1,17 @@
 #include "Mark_CommandBuffers.h"
 #include "Mark_VulkanCore.h"
 #include "Mark_Skybox.h"
+#include "Mark_GPUFrameStats.h"
+#include "Engine/SettingsHandler.h"
 #include "Utils/VulkanUtils.h"
 #include "Utils/Mark_Utils.h"
+#include <algorithm>
 #include <array>
 
 namespace Mark::RendererVK
 {
-    VulkanCommandBuffers::VulkanCommandBuffers(std::weak_ptr<VulkanCore> _vulkanCoreRef, VulkanSwapChain& _swapChainRef, VulkanGraphicsPipeline& _opaqueGraphicsPipelineRef, VulkanGraphicsPipeline& _transparentGraphicsPipelineRef, VulkanBindlessMeshResourceSet& _bindlessSetRef, VulkanSkybox& _skyboxRef) :
-        m_vulkanCoreRef(_vulkanCoreRef), m_swapChainRef(_swapChainRef), m_opaqueGraphicsPipelineRef(_opaqueGraphicsPipelineRef), m_transparentGraphicsPipelineRef(_transparentGraphicsPipelineRef), m_bindlessSetRef(_bindlessSetRef), m_skybox(_skyboxRef)
+    VulkanCommandBuffers::VulkanCommandBuffers(std::weak_ptr<VulkanCore> _vulkanCoreRef, VulkanSwapChain& _swapChainRef, VulkanGraphicsPipeline& _opaqueGraphicsPipelineRef, VulkanGraphicsPipeline& _transparentGraphicsPipelineRef, VulkanGraphicsPipeline& _depthPrepassGraphicsPipelineRef, VulkanBindlessMeshResourceSet& _bindlessSetRef, VulkanSkybox& _skyboxRef, VulkanGPUFrameStats& _gpuFrameStatsRef) :
+        m_vulkanCoreRef(_vulkanCoreRef), m_swapChainRef(_swapChainRef), m_opaqueGraphicsPipelineRef(_opaqueGraphicsPipelineRef), m_transparentGraphicsPipelineRef(_transparentGraphicsPipelineRef), m_depthPrepassGraphicsPipelineRef(_depthPrepassGraphicsPipelineRef), m_bindlessSetRef(_bindlessSetRef), m_skybox(_skyboxRef), m_gpuFrameStatsRef(_gpuFrameStatsRef)
     {}
 
     void VulkanCommandBuffers::destroyCommandBuffers()
@@ -103,31 +106,74 @@ namespace Mark::RendererVK
         recordCommanBuffersInternal(_clearColour, m_commandBuffers.withoutGUI, true);
 
         recordCommanBuffersInternal(_clearColour, m_commandBuffers.withGUI, false);
+
+        m_dirtyImages = 0;
+        MARK_INFO(Utils::Category::Vulkan, "Vulkan Command Buffers Recorded");
+    }
+
+    void VulkanCommandBuffers::markImagesDirty()
+    {
+        const size_t imageCount = std::max(m_commandBuffers.withoutGUI.size(), m_commandBuffers.withGUI.size());
+        m_dirtyImages = imageCount >= 32 ? ~0u : (1u << imageCount) - 1;
+    }
+
+    void VulkanCommandBuffers::recordImageIfDirty(uint32_t _imageIndex, VkClearColorValue _clearColour)
+    {
+        const uint32_t bit = 1u << _imageIndex;
+        if (!(m_dirtyImages & bit)) return;
+        m_dirtyImages &= ~bit;
+
+        if (_imageIndex < m_commandBuffers.withoutGUI.size()) {
+            recordImageCommandBuffer(_clearColour, m_commandBuffers.withoutGUI[_imageIndex], _imageIndex, true);
+        }
+        if (_imageIndex < m_commandBuffers.withGUI.size()) {
+            recordImageCommandBuffer(_clearColour, m_commandBuffers.withGUI[_imageIndex], _imageIndex, false);
+        }
+        MARK_DEBUG(Utils::Category::Vulkan, "Vulkan Command Buffers Re-recorded For Image %u", _imageIndex);
     }
 
     void VulkanCommandBuffers::recordCommanBuffersInternal(VkClearColorValue _clearColour, const std::vector<VkCommandBuffer>& _commandBuffers, bool _withSecondBarrier)
     {
-        for (uint32_t i = 0; i < _commandBuffers.size(); i++)
-        {
-            VkCommandBuffer commandBuffer = _commandBuffers[i];
+        for (uint32_t i = 0; i < _commandBuffers.size(); i++) {
+            recordImageCommandBuffer(_clearColour, _commandBuffers[i], i, _withSecondBarrier);
+        }
+    }
 
-            beginCommandBuffer(commandBuffer, VK_COMMAND_BUFFER_USAGE_SIMULTANEOUS_USE_BIT);
+    void VulkanCommandBuffers::recordImageCommandBuffer(VkClearColorValue _clearColour, VkCommandBuffer _commandBuffer, uint32_t _imageIndex, bool _withSecondBarrier)
+    {
+        // Baked into the recorded order, toggling it goes through a swapchain rebuild which re-records
+        const bool skyboxLast = Settings::MarkSettings::Get().orderForEarlyZ();
+        const bool depthPrepass = Settings::MarkSettings::Get().depthPrepass();
 
-            VkClearValue clearColourValue = { .color = _clearColour };
-            VkClearValue pDepthClearValue = { .depthStencil = { 1.0f, 0 } };
-            beginDynamicRendering(commandBuffer, i, &clearColourValue, &pDepthClearValue);
+        beginCommandBuffer(_commandBuffer, VK_COMMAND_BUFFER_USAGE_SIMULTANEOUS_USE_BIT);
+        m_gpuFrameStatsRef.recordReset(_commandBuffer, _imageIndex);
 
-            setViewportAndScissor(commandBuffer, m_swapChainRef.extent());
+        VkClearValue clearColourValue = { .color = _clearColour };
+        VkClearValue pDepthClearValue = { .depthStencil = { 1.0f, 0 } };
+        beginDynamicRendering(_commandBuffer, _imageIndex, &clearColourValue, &pDepthClearValue);
 
-            m_skybox.recordCommandBuffer(commandBuffer, i);
+        setViewportAndScissor(_commandBuffer, m_swapChainRef.extent());
 
-            recordOpaquePass(commandBuffer, i);
-            recordTransparentPass(commandBuffer, i);
+        m_gpuFrameStatsRef.beginScene(_commandBuffer, _imageIndex);
 
-            endDynamicRendering(commandBuffer, i, _withSecondBarrier);
+        if (depthPrepass) {
+            recordDepthPrepass(_commandBuffer, _imageIndex);
         }
 
-        MARK_INFO(Utils::Category::Vulkan, "Vulkan Command Buffers Recorded");
+        // With the skybox after opaque geometry its LESS_OR_EQUAL test against the cleared 1.0 depth
+        // only passes where nothing was drawn, so it no longer shades pixels that get covered later
+        if (!skyboxLast) {
+            m_skybox.recordCommandBuffer(_commandBuffer, _imageIndex);
+        }
+        recordOpaquePass(_commandBuffer, _imageIndex);
+        if (skyboxLast) {
+            m_skybox.recordCommandBuffer(_commandBuffer, _imageIndex);
+        }
+        recordTransparentPass(_commandBuffer, _imageIndex);
+
+        m_gpuFrameStatsRef.endScene(_commandBuffer, _imageIndex);
+
+        endDynamicRendering(_commandBuffer, _imageIndex, _withSecondBarrier);
     }
 
     void VulkanCommandBuffers::setOpaqueIndirectDrawBuffers(VkBuffer _indirectCmdBuffer, VkBuffer _indirectCountBuffer, uint32_t _maxDrawCount)
@@ -285,19 +331,47 @@ namespace Mark::RendererVK
         vkCmdSetScissor(_cmdBuffer, 0, 1, &scissor);
     }
 
+    void VulkanCommandBuffers::recordDepthPrepass(VkCommandBuffer _cmdBuffer, uint32_t _imageIndex)
+    {
+        if (!vkCmdDrawIndirectCountKHR || m_opaqueIndirectCmdBuffer == VK_NULL_HANDLE || m_opaqueIndirectCountBuffer == VK_NULL_HANDLE || m_opaqueMaxDrawCount == 0) {
+            return;
+        }
+
+        if (!m_depthPrepassGraphicsPipelineRef.bindPipeline(_cmdBuffer)) {
+            return;
+        }
+        m_bindlessSetRef.bind(_cmdBuffer, m_depthPrepassGraphicsPipelineRef.pipelineLayout(), _imageIndex);
+
+        // Same commands and count as the opaque pass, both read this image's region
+        const VkDeviceSize cmdOffset = static_cast<VkDeviceSize>(_imageIndex) * m_opaqueMaxDrawCount * sizeof(VkDrawIndirectCommand);
+        const VkDeviceSize countOffset = static_cast<VkDeviceSize>(_imageIndex) * sizeof(uint32_t);
+        vkCmdDrawIndirectCountKHR(
+            _cmdBuffer,
+            m_opaqueIndirectCmdBuffer, cmdOffset,
+            m_opaqueIndirectCountBuffer, countOffset,
+            m_opaqueMaxDrawCount,
+            sizeof(VkDrawIndirectCommand)
+        );
+    }
+
     void VulkanCommandBuffers::recordOpaquePass(VkCommandBuffer _cmdBuffer, uint32_t _imageIndex)
     {
         if (!vkCmdDrawIndirectCountKHR || m_opaqueIndirectCmdBuffer == VK_NULL_HANDLE || m_opaqueIndirectCountBuffer == VK_NULL_HANDLE || m_opaqueMaxDrawCount == 0) {
             return;
         }
 
-        m_opaqueGraphicsPipelineRef.bindPipeline(_cmdBuffer);
+        if (!m_opaqueGraphicsPipelineRef.bindPipeline(_cmdBuffer)) {
+            return; // Pipeline still compiling in the background
+        }
+        // Image index doubles as the frame slot, renderToWindow writes that UBO before submitting
         m_bindlessSetRef.bind(_cmdBuffer, m_opaqueGraphicsPipelineRef.pipelineLayout(), _imageIndex);
 
+        const VkDeviceSize cmdOffset = static_cast<VkDeviceSize>(_imageIndex) * m_opaqueMaxDrawCount * sizeof(VkDrawIndirectCommand);
+        const VkDeviceSize countOffset = static_cast<VkDeviceSize>(_imageIndex) * sizeof(uint32_t);
         vkCmdDrawIndirectCountKHR(
             _cmdBuffer,
-            m_opaqueIndirectCmdBuffer, 0,
-            m_opaqueIndirectCountBuffer, 0,
+            m_opaqueIndirectCmdBuffer, cmdOffset,
+            m_opaqueIndirectCountBuffer, countOffset,
             m_opaqueMaxDrawCount,
             sizeof(VkDrawIndirectCommand)
         );
@@ -309,13 +383,17 @@ namespace Mark::RendererVK
             return;
         }
 
-        m_transparentGraphicsPipelineRef.bindPipeline(_cmdBuffer);
+        if (!m_transparentGraphicsPipelineRef.bindPipeline(_cmdBuffer)) {
+            return; // Pipeline still compiling in the background
+        }
         m_bindlessSetRef.bind(_cmdBuffer, m_transparentGraphicsPipelineRef.pipelineLayout(), _imageIndex);
 
+        const VkDeviceSize cmdOffset = static_cast<VkDeviceSize>(_imageIndex) * m_transparentMaxDrawCount * sizeof(VkDrawIndirectCommand);
+        const VkDeviceSize countOffset = static_cast<VkDeviceSize>(_imageIndex) * sizeof(uint32_t);
         vkCmdDrawIndirectCountKHR(
             _cmdBuffer,
-            m_transparentIndirectCmdBuffer, 0,
-            m_transparentIndirectCountBuffer, 0,
+            m_transparentIndirectCmdBuffer, cmdOffset,
+            m_transparentIndirectCountBuffer, countOffset,
             m_transparentMaxDrawCount,
             sizeof(VkDrawIndirectCommand)
         );
@@ -8,14 +8,17 @@ namespace Mark::RendererVK
 {
     struct VulkanCore;
     struct VulkanSkybox;
+    struct VulkanGPUFrameStats;
     struct VulkanCommandBuffers
     {
         VulkanCommandBuffers(std::weak_ptr<VulkanCore> _vulkanCoreRef, 
             VulkanSwapChain& _swapChainRef, 
             VulkanGraphicsPipeline& _opaqueGraphicsPipelineRef,
             VulkanGraphicsPipeline& _transparentGraphicsPipelineRef,
+            VulkanGraphicsPipeline& _depthPrepassGraphicsPipelineRef,
             VulkanBindlessMeshResourceSet& _bindlessSetRef,
-            VulkanSkybox& _skyboxRef);
+            VulkanSkybox& _skyboxRef,
+            VulkanGPUFrameStats& _gpuFrameStatsRef);
         ~VulkanCommandBuffers() = default;
         void destroyCommandBuffers();
         VulkanCommandBuffers(const VulkanCommandBuffers&) = delete;
@@ -27,8 +30,15 @@ namespace Mark::RendererVK
         void createCommandBuffers(uint32_t _numImages, std::vector<VkCommandBuffer>& _commandBuffers);
         void createCopyCommandBuffer();
         void recordCommandBuffers(VkClearColorValue _clearColour);
+        // Re-records every image's buffers lazily: each one is redone by recordImageIfDirty once its image is acquired
+        // again, when its previous submission has retired, so nothing waits on the queue
+        void markImagesDirty();
+        // Call after the acquire's fence wait for _imageIndex, before submitting its buffers
+        void recordImageIfDirty(uint32_t _imageIndex, VkClearColorValue _clearColour);
 
         // Must be set before recording command buffers.
+        // Both buffers hold one region per frame slot, _maxDrawCount commands and one uint32 count each,
+        // and the buffer recorded for an image reads the region of its image index
         void setOpaqueIndirectDrawBuffers(VkBuffer _indirectCmdBuffer, VkBuffer _indirectCountBuffer, uint32_t _maxDrawCount);
         void setTransparentIndirectDrawBuffers(VkBuffer _indirectCmdBuffer, VkBuffer _indirectCountBuffer, uint32_t _maxDrawCount);
 
@@ -59,9 +69,11 @@ namespace Mark::RendererVK
         VulkanSwapChain& m_swapChainRef;
         VulkanGraphicsPipeline& m_opaqueGraphicsPipelineRef;
         VulkanGraphicsPipeline& m_transparentGraphicsPipelineRef;
+        VulkanGraphicsPipeline& m_depthPrepassGraphicsPipelineRef;
         VulkanBindlessMeshResourceSet& m_bindlessSetRef;
 
         VulkanSkybox& m_skybox;
+        VulkanGPUFrameStats& m_gpuFrameStatsRef;
 
         VkCommandPool m_commandPool{ VK_NULL_HANDLE };
         struct {
@@ -69,6 +81,7 @@ namespace Mark::RendererVK
             std::vector<VkCommandBuffer> withoutGUI;
         } m_commandBuffers;
         VkCommandBuffer m_copyCommandBuffer{ VK_NULL_HANDLE };
+        uint32_t m_dirtyImages{ 0 }; // Bit per image index, swapchains are capped at FRAME_SLOTS images
 
         // Indirect draw buffers
         VkBuffer m_opaqueIndirectCmdBuffer{ VK_NULL_HANDLE };
@@ -81,9 +94,12 @@ namespace Mark::RendererVK
 
         void setViewportAndScissor(VkCommandBuffer _cmdBuffer, const VkExtent2D& _extent);
 
+        // Depth only, draws the opaque indirect list so the opaque pass can follow with an EQUAL test
+        void recordDepthPrepass(VkCommandBuffer _cmdBuffer, uint32_t _imageIndex);
         void recordOpaquePass(VkCommandBuffer _cmdBuffer, uint32_t _imageIndex);
         void recordTransparentPass(VkCommandBuffer _cmdBuffer, uint32_t _imageIndex);
 
         void recordCommanBuffersInternal(VkClearColorValue _clearColour, const std::vector<VkCommandBuffer>& _commandBuffers, bool _withSecondBarrier);
+        void recordImageCommandBuffer(VkClearColorValue _clearColour, VkCommandBuffer _commandBuffer, uint32_t _imageIndex, bool _withSecondBarrier);
     };
 } // namespace Mark::RendererVK
\ No newline at end of file
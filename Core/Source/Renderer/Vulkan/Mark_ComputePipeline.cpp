@@ -4,6 +4,8 @@
 #include "Utils/VulkanUtils.h"
 #include "Utils/Mark_Utils.h"
 
+#include <chrono>
+
 namespace Mark::RendererVK
 {
     void VulkanComputePipeline::initialize(std::weak_ptr<VulkanCore> _vulkanCoreRef, const char* _debugName, uint32_t _setsPerFrame, const char* _shaderpath)
@@ -29,7 +31,7 @@ namespace Mark::RendererVK
             return;
         }
 
-        createComputePipeline(m_computeShaderModule);
+        createComputePipeline(m_computeShaderModule, &_vulkanCoreRef.lock()->pipelineDiskCache());
 
         MARK_INFO(Utils::Category::Vulkan, "Compute Pipeline Initialized");
     }
@@ -135,7 +137,7 @@ namespace Mark::RendererVK
         MARK_VK_NAME(m_device, VK_OBJECT_TYPE_PIPELINE_LAYOUT, m_pipelineLayout, ("ComputePipeline." + m_debugName + ".PipelineLayout").c_str());
     }
 
-    void VulkanComputePipeline::createComputePipeline(VkShaderModule _shaderModule)
+    void VulkanComputePipeline::createComputePipeline(VkShaderModule _shaderModule, VulkanPipelineDiskCache* _diskCache)
     {
         VkPipelineShaderStageCreateInfo shaderStageInfo = {
             .sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
@@ -157,8 +159,13 @@ namespace Mark::RendererVK
             .basePipelineIndex = -1
         };
 
-        VkResult res = vkCreateComputePipelines(m_device, VK_NULL_HANDLE, 1, &pipelineCreateInfo, nullptr, &m_pipeline);
+        const auto createStart = std::chrono::steady_clock::now();
+        VkResult res = vkCreateComputePipelines(m_device, _diskCache ? _diskCache->handle() : VK_NULL_HANDLE, 1, &pipelineCreateInfo, nullptr, &m_pipeline);
         CHECK_VK_RESULT(res, "Create Compute Pipeline");
+        const double createMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - createStart).count();
+        if (_diskCache) {
+            _diskCache->recordPipelineCreation(createMs);
+        }
 
         MARK_VK_NAME(m_device, VK_OBJECT_TYPE_PIPELINE, m_pipeline, ("ComputePipeline." + m_debugName + ".Pipeline").c_str());
     }
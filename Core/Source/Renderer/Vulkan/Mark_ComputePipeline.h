@@ -7,6 +7,7 @@
 namespace Mark::RendererVK
 {
     struct VulkanCore;
+    struct VulkanPipelineDiskCache;
     struct VulkanComputePipeline
     {
         VulkanComputePipeline() = default;
@@ -22,6 +23,9 @@ namespace Mark::RendererVK
 
         void allocateDescriptorSets(uint32_t _descCount, std::vector<VkDescriptorSet>& _descSets);
 
+        // False when the shader failed to load and no pipeline was created
+        bool isValid() const { return m_pipeline != VK_NULL_HANDLE; }
+
     protected:
 
         // Derived provides its descriptor bindings and pool sizing
@@ -45,7 +49,7 @@ namespace Mark::RendererVK
         VkDescriptorSetLayout m_descriptorSetLayout{ VK_NULL_HANDLE };
 
         void createPipelineLayout();
-        void createComputePipeline(VkShaderModule _shaderModule);
+        void createComputePipeline(VkShaderModule _shaderModule, VulkanPipelineDiskCache* _diskCache);
         void createDescriptorPool();
     };
 }
\ No newline at end of file
@@ -0,0 +1,171 @@
+#include "Mark_CubemapCache.h"
+#include "Mark_PipelineKey.h"
+
+#include "Utils/Mark_Utils.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <vector>
+
+namespace Mark::RendererVK
+{
+    namespace
+    {
+        constexpr uint32_t CUBEMAP_CACHE_MAGIC = 0x4255434Du; // "MCUB"
+        constexpr uint32_t CUBEMAP_CACHE_VERSION = 1;
+        constexpr uint32_t CUBEMAP_CACHE_FACES = 6;
+        constexpr size_t CUBEMAP_HASH_CHUNK = 1 << 16;
+
+        struct CubemapCacheHeader
+        {
+            uint32_t magic;
+            uint32_t version;
+            uint64_t sourceHash;
+            uint32_t faceSize;
+            uint32_t mipLevels;
+            uint32_t format;
+            uint32_t reserved;
+            uint64_t payloadSize;
+        };
+    }
+
+    bool VulkanCubemapCache::makeKey(const char* _sourcePath, uint32_t _faceSize, uint32_t _mipLevels, VkFormat _format, CubemapCacheKey& _outKey)
+    {
+        std::ifstream file(_sourcePath, std::ios::binary);
+        if (!file) {
+            return false;
+        }
+
+        uint64_t hash = 1469598103934665603ull;
+        std::vector<uint8_t> chunk(CUBEMAP_HASH_CHUNK);
+        while (file)
+        {
+            file.read(reinterpret_cast<char*>(chunk.data()), static_cast<std::streamsize>(chunk.size()));
+            const std::streamsize got = file.gcount();
+            if (got <= 0) break;
+            HashMixBytes(hash, chunk.data(), static_cast<size_t>(got));
+        }
+
+        _outKey = CubemapCacheKey{
+            .sourceHash = hash,
+            .faceSize = _faceSize,
+            .mipLevels = _mipLevels,
+            .format = _format
+        };
+        return true;
+    }
+
+    std::filesystem::path VulkanCubemapCache::pathForKey(const CubemapCacheKey& _key)
+    {
+        char name[96];
+        std::snprintf(name, sizeof(name), "Cubemap_%016llx_%u_m%u_f%u.mcube",
+            static_cast<unsigned long long>(_key.sourceHash), _key.faceSize, _key.mipLevels, static_cast<uint32_t>(_key.format));
+        return std::filesystem::path(MARK_CACHE_DIR) / "Cubemaps" / name;
+    }
+
+    uint64_t VulkanCubemapCache::mipOffset(uint32_t _faceSize, uint32_t _mipLevel, uint32_t _bytesPerPixel)
+    {
+        uint64_t offset = 0;
+        for (uint32_t mip = 0; mip < _mipLevel; mip++)
+        {
+            const uint64_t size = std::max(1u, _faceSize >> mip);
+            offset += size * size * _bytesPerPixel * CUBEMAP_CACHE_FACES;
+        }
+        return offset;
+    }
+
+    uint64_t VulkanCubemapCache::payloadSize(uint32_t _faceSize, uint32_t _mipLevels, uint32_t _bytesPerPixel)
+    {
+        return mipOffset(_faceSize, _mipLevels, _bytesPerPixel);
+    }
+
+    bool VulkanCubemapCache::openForRead(const CubemapCacheKey& _key, std::ifstream& _outFile, uint64_t& _outPayloadSize)
+    {
+        const std::filesystem::path path = pathForKey(_key);
+        std::error_code ec;
+        if (!std::filesystem::exists(path, ec)) {
+            return false;
+        }
+
+        _outFile.open(path, std::ios::binary);
+        if (!_outFile) {
+            return false;
+        }
+
+        CubemapCacheHeader header{};
+        _outFile.read(reinterpret_cast<char*>(&header), sizeof(header));
+        const uint64_t fileSize = static_cast<uint64_t>(std::filesystem::file_size(path, ec));
+
+        const bool valid = _outFile.gcount() == sizeof(header) &&
+            header.magic == CUBEMAP_CACHE_MAGIC &&
+            header.version == CUBEMAP_CACHE_VERSION &&
+            header.sourceHash == _key.sourceHash &&
+            header.faceSize == _key.faceSize &&
+            header.mipLevels == _key.mipLevels &&
+            header.format == static_cast<uint32_t>(_key.format) &&
+            !ec && fileSize == sizeof(header) + header.payloadSize;
+
+        if (!valid)
+        {
+            MARK_WARN(Utils::Category::System, "Cubemap cache entry invalid, regenerating: %s", Utils::ShortPathForLog(path.string()).c_str());
+            _outFile.close();
+            std::filesystem::remove(path, ec);
+            return false;
+        }
+
+        _outPayloadSize = header.payloadSize;
+        return true;
+    }
+
+    bool VulkanCubemapCache::store(const CubemapCacheKey& _key, const void* _payload, uint64_t _payloadSize)
+    {
+        const std::filesystem::path path = pathForKey(_key);
+        std::filesystem::path tmpPath = path;
+        tmpPath += ".tmp";
+
+        std::error_code ec;
+        std::filesystem::create_directories(path.parent_path(), ec);
+        if (ec) {
+            MARK_WARN(Utils::Category::System, "Failed to create cubemap cache directory: %s", ec.message().c_str());
+            return false;
+        }
+
+        const CubemapCacheHeader header{
+            .magic = CUBEMAP_CACHE_MAGIC,
+            .version = CUBEMAP_CACHE_VERSION,
+            .sourceHash = _key.sourceHash,
+            .faceSize = _key.faceSize,
+            .mipLevels = _key.mipLevels,
+            .format = static_cast<uint32_t>(_key.format),
+            .reserved = 0,
+            .payloadSize = _payloadSize
+        };
+
+        {
+            std::ofstream out(tmpPath, std::ios::binary | std::ios::trunc);
+            if (!out) {
+                MARK_WARN(Utils::Category::System, "Failed to open cubemap cache for writing: %s", Utils::ShortPathForLog(tmpPath.string()).c_str());
+                return false;
+            }
+            out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+            out.write(static_cast<const char*>(_payload), static_cast<std::streamsize>(_payloadSize));
+            if (!out) {
+                MARK_WARN(Utils::Category::System, "Failed to write cubemap cache: %s", Utils::ShortPathForLog(tmpPath.string()).c_str());
+                out.close();
+                std::filesystem::remove(tmpPath, ec);
+                return false;
+            }
+        }
+
+        std::filesystem::rename(tmpPath, path, ec);
+        if (ec)
+        {
+            MARK_WARN(Utils::Category::System, "Failed to finalise cubemap cache: %s", ec.message().c_str());
+            std::filesystem::remove(tmpPath, ec);
+            return false;
+        }
+
+        MARK_INFO(Utils::Category::System, "Cubemap cached to: %s", Utils::ShortPathForLog(path.string()).c_str());
+        return true;
+    }
+} // namespace Mark::RendererVK
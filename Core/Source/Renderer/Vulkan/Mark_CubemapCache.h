@@ -0,0 +1,36 @@
+#pragma once
+#include <Volk/volk.h>
+
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+
+namespace Mark::RendererVK
+{
+    // Identifies one processed cubemap on disk. Payload is mip-major, six faces per mip, tightly packed
+    struct CubemapCacheKey
+    {
+        uint64_t sourceHash{ 0 };
+        uint32_t faceSize{ 0 };
+        uint32_t mipLevels{ 1 };
+        VkFormat format{ VK_FORMAT_UNDEFINED };
+    };
+
+    struct VulkanCubemapCache
+    {
+        // Hashes the source file contents, returns false if the file can't be read
+        static bool makeKey(const char* _sourcePath, uint32_t _faceSize, uint32_t _mipLevels, VkFormat _format, CubemapCacheKey& _outKey);
+
+        // Opens the cache entry and validates its header. On success the stream is positioned at the payload
+        static bool openForRead(const CubemapCacheKey& _key, std::ifstream& _outFile, uint64_t& _outPayloadSize);
+
+        // Writes through a temp file and renames so a crash never leaves a half written entry
+        static bool store(const CubemapCacheKey& _key, const void* _payload, uint64_t _payloadSize);
+
+        static uint64_t payloadSize(uint32_t _faceSize, uint32_t _mipLevels, uint32_t _bytesPerPixel);
+        static uint64_t mipOffset(uint32_t _faceSize, uint32_t _mipLevel, uint32_t _bytesPerPixel);
+
+    private:
+        static std::filesystem::path pathForKey(const CubemapCacheKey& _key);
+    };
+} // namespace Mark::RendererVK
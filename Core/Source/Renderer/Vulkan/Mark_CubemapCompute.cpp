@@ -0,0 +1,132 @@
+#include "Mark_CubemapCompute.h"
+
+#include "Utils/VulkanUtils.h"
+#include "Utils/Mark_Utils.h"
+
+namespace Mark::RendererVK
+{
+    // Equirectangular -> cube faces
+
+    void VulkanEquirectToCubemapCompute::getDescriptorSetLayoutBindings(std::vector<VkDescriptorSetLayoutBinding>& _outBindings) const
+    {
+        _outBindings.push_back(VkDescriptorSetLayoutBinding{
+            .binding = EquirectToCubemapBinding::Source,
+            .descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+            .descriptorCount = 1,
+            .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+            .pImmutableSamplers = nullptr
+        });
+        _outBindings.push_back(VkDescriptorSetLayoutBinding{
+            .binding = EquirectToCubemapBinding::Faces,
+            .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,
+            .descriptorCount = 1,
+            .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+            .pImmutableSamplers = nullptr
+        });
+    }
+
+    void VulkanEquirectToCubemapCompute::getDescriptorPoolSizes(uint32_t _setCount, std::vector<VkDescriptorPoolSize>& _outSizes) const
+    {
+        _outSizes.push_back({ VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, _setCount });
+        _outSizes.push_back({ VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, _setCount });
+    }
+
+    void VulkanEquirectToCubemapCompute::writeDescriptorSet(VkDescriptorSet _set, VkSampler _sourceSampler, VkImageView _sourceView, VkImageView _facesStorageView)
+    {
+        VkDescriptorImageInfo sourceInfo = {
+            .sampler = _sourceSampler,
+            .imageView = _sourceView,
+            .imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
+        };
+        VkDescriptorImageInfo facesInfo = {
+            .sampler = VK_NULL_HANDLE,
+            .imageView = _facesStorageView,
+            .imageLayout = VK_IMAGE_LAYOUT_GENERAL
+        };
+
+        VkWriteDescriptorSet writes[2] = {
+            {
+                .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+                .dstSet = _set,
+                .dstBinding = EquirectToCubemapBinding::Source,
+                .dstArrayElement = 0,
+                .descriptorCount = 1,
+                .descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+                .pImageInfo = &sourceInfo
+            },
+            {
+                .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+                .dstSet = _set,
+                .dstBinding = EquirectToCubemapBinding::Faces,
+                .dstArrayElement = 0,
+                .descriptorCount = 1,
+                .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,
+                .pImageInfo = &facesInfo
+            }
+        };
+
+        vkUpdateDescriptorSets(m_device, ARRAY_COUNT(writes), writes, 0, nullptr);
+    }
+
+    // Cube mip downsample
+
+    void VulkanCubemapDownsampleCompute::getDescriptorSetLayoutBindings(std::vector<VkDescriptorSetLayoutBinding>& _outBindings) const
+    {
+        _outBindings.push_back(VkDescriptorSetLayoutBinding{
+            .binding = CubemapDownsampleBinding::Source,
+            .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,
+            .descriptorCount = 1,
+            .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+            .pImmutableSamplers = nullptr
+        });
+        _outBindings.push_back(VkDescriptorSetLayoutBinding{
+            .binding = CubemapDownsampleBinding::Destination,
+            .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,
+            .descriptorCount = 1,
+            .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+            .pImmutableSamplers = nullptr
+        });
+    }
+
+    void VulkanCubemapDownsampleCompute::getDescriptorPoolSizes(uint32_t _setCount, std::vector<VkDescriptorPoolSize>& _outSizes) const
+    {
+        _outSizes.push_back({ VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, _setCount * 2 });
+    }
+
+    void VulkanCubemapDownsampleCompute::writeDescriptorSet(VkDescriptorSet _set, VkImageView _sourceMipView, VkImageView _destinationMipView)
+    {
+        VkDescriptorImageInfo sourceInfo = {
+            .sampler = VK_NULL_HANDLE,
+            .imageView = _sourceMipView,
+            .imageLayout = VK_IMAGE_LAYOUT_GENERAL
+        };
+        VkDescriptorImageInfo destinationInfo = {
+            .sampler = VK_NULL_HANDLE,
+            .imageView = _destinationMipView,
+            .imageLayout = VK_IMAGE_LAYOUT_GENERAL
+        };
+
+        VkWriteDescriptorSet writes[2] = {
+            {
+                .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+                .dstSet = _set,
+                .dstBinding = CubemapDownsampleBinding::Source,
+                .dstArrayElement = 0,
+                .descriptorCount = 1,
+                .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,
+                .pImageInfo = &sourceInfo
+            },
+            {
+                .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+                .dstSet = _set,
+                .dstBinding = CubemapDownsampleBinding::Destination,
+                .dstArrayElement = 0,
+                .descriptorCount = 1,
+                .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,
+                .pImageInfo = &destinationInfo
+            }
+        };
+
+        vkUpdateDescriptorSets(m_device, ARRAY_COUNT(writes), writes, 0, nullptr);
+    }
+} // namespace Mark::RendererVK
@@ -0,0 +1,45 @@
+#pragma once
+#include "Mark_ComputePipeline.h"
+#include <Volk/volk.h>
+
+#include <cstdint>
+
+namespace Mark::RendererVK
+{
+    //  binding 0: sampler2D equirectangular source
+    //  binding 1: image2DArray cube faces (mip 0, storage view)
+    namespace EquirectToCubemapBinding
+    {
+        constexpr uint32_t Source = 0;
+        constexpr uint32_t Faces = 1;
+    }
+
+    //  binding 0: image2DArray previous mip (storage view)
+    //  binding 1: image2DArray next mip (storage view)
+    namespace CubemapDownsampleBinding
+    {
+        constexpr uint32_t Source = 0;
+        constexpr uint32_t Destination = 1;
+    }
+
+    // Both compute passes dispatch 8x8 tiles, one z slice per cube face
+    constexpr uint32_t CUBEMAP_COMPUTE_GROUP_SIZE = 8;
+
+    struct VulkanEquirectToCubemapCompute : VulkanComputePipeline
+    {
+        void writeDescriptorSet(VkDescriptorSet _set, VkSampler _sourceSampler, VkImageView _sourceView, VkImageView _facesStorageView);
+
+    protected:
+        void getDescriptorSetLayoutBindings(std::vector<VkDescriptorSetLayoutBinding>& _outBindings) const override;
+        void getDescriptorPoolSizes(uint32_t _setCount, std::vector<VkDescriptorPoolSize>& _outSizes) const override;
+    };
+
+    struct VulkanCubemapDownsampleCompute : VulkanComputePipeline
+    {
+        void writeDescriptorSet(VkDescriptorSet _set, VkImageView _sourceMipView, VkImageView _destinationMipView);
+
+    protected:
+        void getDescriptorSetLayoutBindings(std::vector<VkDescriptorSetLayoutBinding>& _outBindings) const override;
+        void getDescriptorPoolSizes(uint32_t _setCount, std::vector<VkDescriptorPoolSize>& _outSizes) const override;
+    };
+} // namespace Mark::RendererVK
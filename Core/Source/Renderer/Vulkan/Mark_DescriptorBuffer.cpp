@@ -0,0 +1,135 @@
+#include "Mark_DescriptorBuffer.h"
+#include "Mark_VulkanCore.h"
+
+#include "Utils/VulkanUtils.h"
+#include "Utils/Mark_Utils.h"
+
+#include <cstring>
+
+namespace Mark::RendererVK
+{
+    void VulkanDescriptorBuffer::create(std::shared_ptr<VulkanCore> _vulkanCore, VkDescriptorSetLayout _layout, uint32_t _bindingCount, const char* _debugName)
+    {
+        if (!_vulkanCore) {
+            MARK_FATAL(Utils::Category::Vulkan, "VulkanDescriptorBuffer::create called without a VulkanCore");
+        }
+
+        const DescriptorBufferCaps& caps = _vulkanCore->descriptorBufferCaps();
+        if (!caps.enabled) {
+            MARK_FATAL(Utils::Category::Vulkan, "VulkanDescriptorBuffer::create called but VK_EXT_descriptor_buffer is not enabled");
+        }
+
+        if (m_mapped) {
+            destroy(m_device);
+        }
+
+        m_device = _vulkanCore->device();
+        m_debugName = (_debugName && _debugName[0]) ? _debugName : "UnnamedDescriptorBuffer";
+        m_uniformBufferDescriptorSize = caps.uniformBufferDescriptorSize;
+        m_storageBufferDescriptorSize = caps.storageBufferDescriptorSize;
+        m_combinedImageSamplerDescriptorSize = caps.combinedImageSamplerDescriptorSize;
+
+        vkGetDescriptorSetLayoutSizeEXT(m_device, _layout, &m_layoutSize);
+        const VkDeviceSize alignment = caps.offsetAlignment ? caps.offsetAlignment : 1;
+        m_layoutSize = (m_layoutSize + alignment - 1) / alignment * alignment;
+
+        m_bindingOffsets.assign(_bindingCount, 0);
+        for (uint32_t b = 0; b < _bindingCount; b++) {
+            vkGetDescriptorSetLayoutBindingOffsetEXT(m_device, _layout, b, &m_bindingOffsets[b]);
+        }
+
+        m_buffer = BufferAndMemory(_vulkanCore, m_layoutSize,
+            VK_BUFFER_USAGE_RESOURCE_DESCRIPTOR_BUFFER_BIT_EXT | VK_BUFFER_USAGE_SAMPLER_DESCRIPTOR_BUFFER_BIT_EXT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+            "DescBuffer." + m_debugName);
+
+        m_mapped = static_cast<uint8_t*>(m_buffer.map(m_device));
+        std::memset(m_mapped, 0, static_cast<size_t>(m_layoutSize));
+        m_address = m_buffer.deviceAddress(m_device);
+
+        MARK_INFO(Utils::Category::Vulkan, "Descriptor buffer '%s' created (%llu bytes)", m_debugName.c_str(), static_cast<unsigned long long>(m_layoutSize));
+    }
+
+    void VulkanDescriptorBuffer::destroy(VkDevice _device)
+    {
+        if (m_mapped) {
+            m_buffer.unmap(_device);
+            m_mapped = nullptr;
+        }
+        m_buffer.destroy(_device);
+        m_device = VK_NULL_HANDLE;
+        m_address = 0;
+        m_layoutSize = 0;
+        m_bindingOffsets.clear();
+        m_debugName.clear();
+    }
+
+    void VulkanDescriptorBuffer::writeBuffer(uint32_t _binding, uint32_t _arrayElement, VkDescriptorType _type, VkDeviceAddress _address, VkDeviceSize _range)
+    {
+        const VkDescriptorAddressInfoEXT addressInfo = {
+            .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_ADDRESS_INFO_EXT,
+            .address = _address,
+            .range = _range,
+            .format = VK_FORMAT_UNDEFINED
+        };
+
+        VkDescriptorGetInfoEXT getInfo = {
+            .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_GET_INFO_EXT,
+            .type = _type
+        };
+
+        size_t descriptorSize = 0;
+        if (_type == VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER) {
+            getInfo.data.pUniformBuffer = &addressInfo;
+            descriptorSize = m_uniformBufferDescriptorSize;
+        }
+        else if (_type == VK_DESCRIPTOR_TYPE_STORAGE_BUFFER) {
+            getInfo.data.pStorageBuffer = &addressInfo;
+            descriptorSize = m_storageBufferDescriptorSize;
+        }
+        else {
+            MARK_FATAL(Utils::Category::Vulkan, "VulkanDescriptorBuffer::writeBuffer unsupported descriptor type %d", static_cast<int>(_type));
+        }
+
+        write(_binding, _arrayElement, descriptorSize, getInfo);
+    }
+
+    void VulkanDescriptorBuffer::writeCombinedImageSampler(uint32_t _binding, uint32_t _arrayElement, const VkDescriptorImageInfo& _imageInfo)
+    {
+        VkDescriptorGetInfoEXT getInfo = {
+            .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_GET_INFO_EXT,
+            .type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER
+        };
+        getInfo.data.pCombinedImageSampler = &_imageInfo;
+
+        write(_binding, _arrayElement, m_combinedImageSamplerDescriptorSize, getInfo);
+    }
+
+    void VulkanDescriptorBuffer::write(uint32_t _binding, uint32_t _arrayElement, size_t _descriptorSize, const VkDescriptorGetInfoEXT& _getInfo)
+    {
+        if (!m_mapped || _binding >= m_bindingOffsets.size()) {
+            MARK_FATAL(Utils::Category::Vulkan, "VulkanDescriptorBuffer '%s' write to binding %u out of range", m_debugName.c_str(), _binding);
+        }
+
+        const VkDeviceSize offset = m_bindingOffsets[_binding] + static_cast<VkDeviceSize>(_arrayElement) * _descriptorSize;
+        if (offset + _descriptorSize > m_layoutSize) {
+            MARK_FATAL(Utils::Category::Vulkan, "VulkanDescriptorBuffer '%s' write past the end (binding %u, element %u)", m_debugName.c_str(), _binding, _arrayElement);
+        }
+
+        vkGetDescriptorEXT(m_device, &_getInfo, _descriptorSize, m_mapped + offset);
+    }
+
+    void VulkanDescriptorBuffer::bind(VkCommandBuffer _cmd, VkPipelineBindPoint _bindPoint, VkPipelineLayout _layout) const
+    {
+        const VkDescriptorBufferBindingInfoEXT bindingInfo = {
+            .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_BUFFER_BINDING_INFO_EXT,
+            .address = m_address,
+            .usage = VK_BUFFER_USAGE_RESOURCE_DESCRIPTOR_BUFFER_BIT_EXT | VK_BUFFER_USAGE_SAMPLER_DESCRIPTOR_BUFFER_BIT_EXT
+        };
+        vkCmdBindDescriptorBuffersEXT(_cmd, 1, &bindingInfo);
+
+        const uint32_t bufferIndex = 0;
+        const VkDeviceSize offset = 0;
+        vkCmdSetDescriptorBufferOffsetsEXT(_cmd, _bindPoint, _layout, 0, 1, &bufferIndex, &offset);
+    }
+} // namespace Mark::RendererVK
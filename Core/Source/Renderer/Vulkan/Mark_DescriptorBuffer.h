@@ -0,0 +1,59 @@
+#pragma once
+#include "Mark_BufferAndMemoryHelper.h"
+
+#include <Volk/volk.h>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Set to 0 to keep bindless resources on descriptor pools/sets even when VK_EXT_descriptor_buffer is available
+#ifndef MARK_DESCRIPTOR_BUFFER
+    #define MARK_DESCRIPTOR_BUFFER 1
+#endif
+
+namespace Mark::RendererVK
+{
+    struct VulkanCore;
+
+    // Backs one descriptor set layout (created with VK_DESCRIPTOR_SET_LAYOUT_CREATE_DESCRIPTOR_BUFFER_BIT_EXT)
+    // with a persistently mapped host-visible buffer. Descriptors are written straight into it with
+    // vkGetDescriptorEXT and the whole buffer is bound by address, so there are no pools or set updates
+    struct VulkanDescriptorBuffer
+    {
+        VulkanDescriptorBuffer() = default;
+        ~VulkanDescriptorBuffer() = default;
+        VulkanDescriptorBuffer(const VulkanDescriptorBuffer&) = delete;
+        VulkanDescriptorBuffer& operator=(const VulkanDescriptorBuffer&) = delete;
+
+        // Sizes the buffer from the layout, _bindingCount covers bindings [0, _bindingCount)
+        void create(std::shared_ptr<VulkanCore> _vulkanCore, VkDescriptorSetLayout _layout, uint32_t _bindingCount, const char* _debugName);
+        void destroy(VkDevice _device);
+
+        // Uniform or storage buffer descriptor at binding[_arrayElement]
+        void writeBuffer(uint32_t _binding, uint32_t _arrayElement, VkDescriptorType _type, VkDeviceAddress _address, VkDeviceSize _range);
+        void writeCombinedImageSampler(uint32_t _binding, uint32_t _arrayElement, const VkDescriptorImageInfo& _imageInfo);
+
+        // Binds the buffer as descriptor buffer 0 and points set 0 of _layout at it
+        void bind(VkCommandBuffer _cmd, VkPipelineBindPoint _bindPoint, VkPipelineLayout _layout) const;
+
+        bool valid() const noexcept { return m_mapped != nullptr; }
+        VkDeviceSize size() const noexcept { return m_layoutSize; }
+
+    private:
+        void write(uint32_t _binding, uint32_t _arrayElement, size_t _descriptorSize, const VkDescriptorGetInfoEXT& _getInfo);
+
+        VkDevice m_device{ VK_NULL_HANDLE };
+        std::string m_debugName;
+
+        BufferAndMemory m_buffer;
+        uint8_t* m_mapped{ nullptr };
+        VkDeviceAddress m_address{ 0 };
+        VkDeviceSize m_layoutSize{ 0 };
+        std::vector<VkDeviceSize> m_bindingOffsets; // Indexed by binding
+
+        size_t m_uniformBufferDescriptorSize{ 0 };
+        size_t m_storageBufferDescriptorSize{ 0 };
+        size_t m_combinedImageSamplerDescriptorSize{ 0 };
+    };
+} // namespace Mark::RendererVK
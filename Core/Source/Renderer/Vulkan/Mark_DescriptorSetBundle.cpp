@@ -184,6 +184,57 @@ namespace Mark::RendererVK
         allocateSets(_device, _setCount, none, _debugSetPrefix);
     }
 
+    void VulkanDescriptorSetBundle::createUpdateTemplate(VkDevice _device, const std::vector<VkDescriptorUpdateTemplateEntry>& _entries, const char* _debugName)
+    {
+        if (_device == VK_NULL_HANDLE) {
+            MARK_FATAL(Utils::Category::Vulkan, "VulkanDescriptorSetBundle::createUpdateTemplate called with null device");
+        }
+        if (m_layout == VK_NULL_HANDLE) {
+            MARK_FATAL(Utils::Category::Vulkan, "VulkanDescriptorSetBundle::createUpdateTemplate called before createLayout");
+        }
+        if (_entries.empty()) {
+            MARK_FATAL(Utils::Category::Vulkan, "VulkanDescriptorSetBundle::createUpdateTemplate entries empty");
+        }
+
+        if (m_updateTemplate != VK_NULL_HANDLE) {
+            destroyUpdateTemplate(_device);
+        }
+
+        VkDescriptorUpdateTemplateCreateInfo templateInfo = {
+            .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_UPDATE_TEMPLATE_CREATE_INFO,
+            .descriptorUpdateEntryCount = static_cast<uint32_t>(_entries.size()),
+            .pDescriptorUpdateEntries = _entries.data(),
+            .templateType = VK_DESCRIPTOR_UPDATE_TEMPLATE_TYPE_DESCRIPTOR_SET,
+            .descriptorSetLayout = m_layout
+        };
+
+        VkResult res = vkCreateDescriptorUpdateTemplate(_device, &templateInfo, nullptr, &m_updateTemplate);
+        CHECK_VK_RESULT(res, "Create Descriptor Update Template");
+
+        const char* name = (_debugName && _debugName[0]) ? _debugName : m_debugName.c_str();
+        MARK_VK_NAME_F(_device, VK_OBJECT_TYPE_DESCRIPTOR_UPDATE_TEMPLATE, m_updateTemplate, "DescBundle.%s.UpdateTemplate", name);
+    }
+
+    void VulkanDescriptorSetBundle::destroyUpdateTemplate(VkDevice _device)
+    {
+        if (m_updateTemplate != VK_NULL_HANDLE) {
+            vkDestroyDescriptorUpdateTemplate(_device, m_updateTemplate, nullptr);
+            m_updateTemplate = VK_NULL_HANDLE;
+        }
+    }
+
+    void VulkanDescriptorSetBundle::updateSetWithTemplate(VkDevice _device, uint32_t _setIndex, const void* _data) const
+    {
+        if (m_updateTemplate == VK_NULL_HANDLE) {
+            MARK_FATAL(Utils::Category::Vulkan, "VulkanDescriptorSetBundle::updateSetWithTemplate called before createUpdateTemplate");
+        }
+        if (_setIndex >= m_sets.size()) {
+            MARK_FATAL(Utils::Category::Vulkan, "VulkanDescriptorSetBundle::updateSetWithTemplate set %u out of range (%zu sets)", _setIndex, m_sets.size());
+        }
+
+        vkUpdateDescriptorSetWithTemplate(_device, m_sets[_setIndex], m_updateTemplate, _data);
+    }
+
     void VulkanDescriptorSetBundle::destroyPoolAndSets(VkDevice _device)
     {
         if (m_pool != VK_NULL_HANDLE) {
@@ -195,6 +246,9 @@ namespace Mark::RendererVK
 
     void VulkanDescriptorSetBundle::destroyLayout(VkDevice _device)
     {
+        // The template is created against the layout, so it goes with it
+        destroyUpdateTemplate(_device);
+
         // Layout should not be destroyed while pipelines/layouts still reference it
         if (m_layout != VK_NULL_HANDLE) {
             vkDestroyDescriptorSetLayout(_device, m_layout, nullptr);
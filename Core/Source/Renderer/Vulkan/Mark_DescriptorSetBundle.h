@@ -11,9 +11,11 @@ namespace Mark::RendererVK
     //  - VkDescriptorSetLayout
     //  - VkDescriptorPool
     //  - N VkDescriptorSet
+    //  - Optional VkDescriptorUpdateTemplate for the layout
     //
     // It does Nnot know anything about resources such as MeshHandler/Textures/UBOs
-    // ResourceSet implementations should call vkUpdateDescriptorSets themselves
+    // ResourceSet implementations should call vkUpdateDescriptorSets themselves, or describe their
+    // packed descriptor data once with createUpdateTemplate and rewrite sets with updateSetWithTemplate
     struct VulkanDescriptorSetBundle
     {
         VulkanDescriptorSetBundle() = default;
@@ -45,9 +47,17 @@ namespace Mark::RendererVK
         // Convenience overload: allocate N sets without variable descriptor count
         void allocateSets(VkDevice _device, uint32_t _setCount, const char* _debugSetPrefix);
 
+        // Template entries are offsets/strides into the caller's packed data, replaces any previous template
+        // Requires the layout, and must be recreated whenever the entries change
+        void createUpdateTemplate(VkDevice _device, const std::vector<VkDescriptorUpdateTemplateEntry>& _entries, const char* _debugName);
+        void destroyUpdateTemplate(VkDevice _device);
+
+        // Rewrites every descriptor described by the template in one call, _data must match the template entries
+        void updateSetWithTemplate(VkDevice _device, uint32_t _setIndex, const void* _data) const;
+
         // Destroys pool and sets, but keeps the layout
         void destroyPoolAndSets(VkDevice _device);
-        // Destroys layout (and clears cached binding metadata)
+        // Destroys layout and update template (and clears cached binding metadata)
         void destroyLayout(VkDevice _device);
         // Destroys everything
         void destroy(VkDevice _device);
@@ -63,6 +73,7 @@ namespace Mark::RendererVK
         bool hasLayout() const noexcept { return m_layout != VK_NULL_HANDLE; }
         bool hasPool() const noexcept { return m_pool != VK_NULL_HANDLE; }
         bool hasSets() const noexcept { return !m_sets.empty(); }
+        bool hasUpdateTemplate() const noexcept { return m_updateTemplate != VK_NULL_HANDLE; }
 
         const std::vector<VkDescriptorSetLayoutBinding>& bindings() const noexcept { return m_bindings; }
         const std::vector<VkDescriptorBindingFlags>& bindingFlags() const noexcept { return m_bindingFlags; }
@@ -72,6 +83,7 @@ namespace Mark::RendererVK
         VkDescriptorSetLayout m_layout{ VK_NULL_HANDLE };
         VkDescriptorPool m_pool{ VK_NULL_HANDLE };
         std::vector<VkDescriptorSet> m_sets;
+        VkDescriptorUpdateTemplate m_updateTemplate{ VK_NULL_HANDLE };
 
         std::vector<VkDescriptorSetLayoutBinding> m_bindings;
         std::vector<VkDescriptorBindingFlags> m_bindingFlags;
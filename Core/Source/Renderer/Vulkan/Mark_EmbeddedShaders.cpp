@@ -0,0 +1,37 @@
+#include "Mark_EmbeddedShaders.h"
+
+#include <iterator>
+
+#if MARK_EMBEDDED_SHADERS
+    // Generated by Core/CMake/EmbedShaders.cmake, defines EMBEDDED_SHADERS[]
+    #include "MarkEmbeddedShaderTable.inl"
+#endif
+
+namespace Mark::RendererVK
+{
+#if MARK_EMBEDDED_SHADERS
+    const EmbeddedShader* findEmbeddedShader(std::string_view _name)
+    {
+        // A handful of entries, a linear scan beats hashing the name
+        for (const EmbeddedShader& shader : EMBEDDED_SHADERS)
+        {
+            if (shader.m_name == _name)
+                return &shader;
+        }
+        return nullptr;
+    }
+    size_t embeddedShaderCount()
+    {
+        return std::size(EMBEDDED_SHADERS);
+    }
+#else
+    const EmbeddedShader* findEmbeddedShader(std::string_view)
+    {
+        return nullptr;
+    }
+    size_t embeddedShaderCount()
+    {
+        return 0;
+    }
+#endif
+} // namespace Mark::RendererVK
@@ -0,0 +1,25 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+// Set to 1 by CMake when MARK_RUNTIME_SHADER_COMPILER is OFF and the engine shaders were compiled into Core
+#ifndef MARK_EMBEDDED_SHADERS
+    #define MARK_EMBEDDED_SHADERS 0
+#endif
+
+namespace Mark::RendererVK
+{
+    // Optimised SPIR-V compiled by the build, named by its source file (e.g. "SkyboxShader.vert")
+    // and, for define permutations, its sorted defines (e.g. "TriangleTest.vert:DEPTH_ONLY=1")
+    struct EmbeddedShader
+    {
+        std::string_view m_name;
+        const uint32_t* m_words;
+        size_t m_wordCount;
+    };
+
+    // nullptr when the shader wasn't part of the bundle
+    const EmbeddedShader* findEmbeddedShader(std::string_view _name);
+    size_t embeddedShaderCount();
+} // namespace Mark::RendererVK
@@ -0,0 +1,146 @@
+#include "Mark_GPUFrameStats.h"
+#include "Mark_VulkanCore.h"
+#include "Utils/Mark_Utils.h"
+#include "Utils/VulkanUtils.h"
+
+namespace Mark::RendererVK
+{
+    VulkanGPUFrameStats::VulkanGPUFrameStats(std::weak_ptr<VulkanCore> _vulkanCoreRef) :
+        m_vulkanCoreRef(_vulkanCoreRef)
+    {}
+
+    void VulkanGPUFrameStats::initialize(uint32_t _frameSlots)
+    {
+        auto VkCore = m_vulkanCoreRef.lock();
+        if (!VkCore) { MARK_FATAL(Utils::Category::Vulkan, "VulkanCore expired in VulkanGPUFrameStats::initialize"); }
+
+        m_submitted.assign(_frameSlots, 0);
+        m_hasStatistics = false;
+        m_hasTimings = false;
+
+        if (VkCore->pipelineStatisticsSupported())
+        {
+            VkQueryPoolCreateInfo poolInfo = {
+                .sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO,
+                .pNext = nullptr,
+                .flags = 0,
+                .queryType = VK_QUERY_TYPE_PIPELINE_STATISTICS,
+                .queryCount = _frameSlots,
+                .pipelineStatistics = VK_QUERY_PIPELINE_STATISTIC_FRAGMENT_SHADER_INVOCATIONS_BIT
+            };
+            VkResult res = vkCreateQueryPool(VkCore->device(), &poolInfo, nullptr, &m_statisticsPool);
+            CHECK_VK_RESULT(res, "Create pipeline statistics query pool");
+            MARK_VK_NAME(VkCore->device(), VK_OBJECT_TYPE_QUERY_POOL, m_statisticsPool, "GPUFrameStats.StatisticsPool");
+        }
+
+        // Timestamps need valid bits on the queue family the scene is submitted to
+        const VulkanPhysicalDevices::DeviceProperties& device = VkCore->physicalDevices().selected();
+        const uint32_t validBits = device.m_queueFamilyProperties[VkCore->graphicsQueueFamilyIndex()].timestampValidBits;
+        if (validBits > 0)
+        {
+            m_timestampPeriodNs = device.m_properties.limits.timestampPeriod;
+            m_timestampMask = (validBits >= 64) ? UINT64_MAX : ((1ull << validBits) - 1ull);
+
+            VkQueryPoolCreateInfo poolInfo = {
+                .sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO,
+                .pNext = nullptr,
+                .flags = 0,
+                .queryType = VK_QUERY_TYPE_TIMESTAMP,
+                .queryCount = _frameSlots * 2u
+            };
+            VkResult res = vkCreateQueryPool(VkCore->device(), &poolInfo, nullptr, &m_timestampPool);
+            CHECK_VK_RESULT(res, "Create timestamp query pool");
+            MARK_VK_NAME(VkCore->device(), VK_OBJECT_TYPE_QUERY_POOL, m_timestampPool, "GPUFrameStats.TimestampPool");
+        }
+    }
+
+    void VulkanGPUFrameStats::destroy(VkDevice _device)
+    {
+        if (m_statisticsPool != VK_NULL_HANDLE) {
+            vkDestroyQueryPool(_device, m_statisticsPool, nullptr);
+            m_statisticsPool = VK_NULL_HANDLE;
+        }
+        if (m_timestampPool != VK_NULL_HANDLE) {
+            vkDestroyQueryPool(_device, m_timestampPool, nullptr);
+            m_timestampPool = VK_NULL_HANDLE;
+        }
+        m_submitted.clear();
+        m_hasStatistics = false;
+        m_hasTimings = false;
+    }
+
+    void VulkanGPUFrameStats::recordReset(VkCommandBuffer _cmdBuffer, uint32_t _frameSlot) const
+    {
+        if (statisticsSupported()) {
+            vkCmdResetQueryPool(_cmdBuffer, m_statisticsPool, _frameSlot, 1);
+        }
+        if (timingsSupported()) {
+            vkCmdResetQueryPool(_cmdBuffer, m_timestampPool, _frameSlot * 2u, 2);
+        }
+    }
+
+    void VulkanGPUFrameStats::beginScene(VkCommandBuffer _cmdBuffer, uint32_t _frameSlot) const
+    {
+        if (timingsSupported()) {
+            vkCmdWriteTimestamp(_cmdBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, m_timestampPool, _frameSlot * 2u);
+        }
+        if (statisticsSupported()) {
+            vkCmdBeginQuery(_cmdBuffer, m_statisticsPool, _frameSlot, 0);
+        }
+    }
+
+    void VulkanGPUFrameStats::endScene(VkCommandBuffer _cmdBuffer, uint32_t _frameSlot) const
+    {
+        if (statisticsSupported()) {
+            vkCmdEndQuery(_cmdBuffer, m_statisticsPool, _frameSlot);
+        }
+        if (timingsSupported()) {
+            vkCmdWriteTimestamp(_cmdBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, m_timestampPool, _frameSlot * 2u + 1u);
+        }
+    }
+
+    void VulkanGPUFrameStats::collect(uint32_t _frameSlot)
+    {
+        if (_frameSlot >= m_submitted.size() || !m_submitted[_frameSlot]) return;
+
+        const VkDevice device = m_vulkanCoreRef.lock()->device();
+        collectStatistics(device, _frameSlot);
+        collectTimings(device, _frameSlot);
+    }
+
+    void VulkanGPUFrameStats::collectStatistics(VkDevice _device, uint32_t _frameSlot)
+    {
+        if (!statisticsSupported()) return;
+
+        // Value then availability, the slot's last submission retired before the acquire so this should not miss
+        uint64_t result[2] = { 0, 0 };
+        VkResult res = vkGetQueryPoolResults(_device, m_statisticsPool, _frameSlot, 1,
+            sizeof(result), result, sizeof(result), VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT);
+        if (res != VK_SUCCESS || result[1] == 0) return;
+
+        m_fragmentInvocations = result[0];
+        m_hasStatistics = true;
+    }
+
+    void VulkanGPUFrameStats::collectTimings(VkDevice _device, uint32_t _frameSlot)
+    {
+        if (!timingsSupported()) return;
+
+        // { begin, available, end, available }
+        uint64_t result[4] = { 0, 0, 0, 0 };
+        VkResult res = vkGetQueryPoolResults(_device, m_timestampPool, _frameSlot * 2u, 2,
+            sizeof(result), result, sizeof(uint64_t) * 2, VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT);
+        if (res != VK_SUCCESS || result[1] == 0 || result[3] == 0) return;
+
+        const uint64_t ticks = ((result[2] & m_timestampMask) - (result[0] & m_timestampMask)) & m_timestampMask;
+        m_sceneGPUMs = static_cast<double>(ticks) * static_cast<double>(m_timestampPeriodNs) / 1.0e6;
+        m_hasTimings = true;
+    }
+
+    void VulkanGPUFrameStats::markSubmitted(uint32_t _frameSlot)
+    {
+        if (_frameSlot < m_submitted.size()) {
+            m_submitted[_frameSlot] = 1;
+        }
+    }
+} // namespace Mark::RendererVK
@@ -0,0 +1,60 @@
+#pragma once
+#include <Volk/volk.h>
+#include <memory>
+#include <vector>
+
+namespace Mark::RendererVK
+{
+    struct VulkanCore;
+
+    // Per-frame GPU counters for a window, queries are indexed by frame slot (swapchain image index)
+    // Queries are recorded into the pre-recorded command buffers and read back without waiting once the slot's
+    // image is acquired again, so the numbers shown are from that image's previous frame
+    struct VulkanGPUFrameStats
+    {
+        VulkanGPUFrameStats(std::weak_ptr<VulkanCore> _vulkanCoreRef);
+        ~VulkanGPUFrameStats() = default;
+        VulkanGPUFrameStats(const VulkanGPUFrameStats&) = delete;
+        VulkanGPUFrameStats& operator=(const VulkanGPUFrameStats&) = delete;
+
+        // Each counter is skipped when the device can't provide it, its record calls are then no-ops
+        void initialize(uint32_t _frameSlots);
+        void destroy(VkDevice _device);
+
+        // Outside dynamic rendering, before beginScene
+        void recordReset(VkCommandBuffer _cmdBuffer, uint32_t _frameSlot) const;
+        // Bracket the scene draws, inside the same dynamic rendering instance
+        void beginScene(VkCommandBuffer _cmdBuffer, uint32_t _frameSlot) const;
+        void endScene(VkCommandBuffer _cmdBuffer, uint32_t _frameSlot) const;
+
+        // Call after acquiring the image whose index is _frameSlot and before submitting it again
+        void collect(uint32_t _frameSlot);
+        void markSubmitted(uint32_t _frameSlot);
+
+        bool statisticsSupported() const noexcept { return m_statisticsPool != VK_NULL_HANDLE; }
+        bool hasStatistics() const noexcept { return m_hasStatistics; }
+        uint64_t fragmentInvocations() const noexcept { return m_fragmentInvocations; } // Scene draws only, ImGui excluded
+
+        bool timingsSupported() const noexcept { return m_timestampPool != VK_NULL_HANDLE; }
+        bool hasTimings() const noexcept { return m_hasTimings; }
+        double sceneGPUMs() const noexcept { return m_sceneGPUMs; } // Scene draws only, ImGui excluded
+
+    private:
+        std::weak_ptr<VulkanCore> m_vulkanCoreRef;
+
+        VkQueryPool m_statisticsPool{ VK_NULL_HANDLE }; // One per frame slot
+        VkQueryPool m_timestampPool{ VK_NULL_HANDLE };  // Scene begin/end pair per frame slot
+        std::vector<uint8_t> m_submitted; // Reading a query that was never reset is invalid
+
+        float m_timestampPeriodNs{ 0.0f };
+        uint64_t m_timestampMask{ 0 }; // Only timestampValidBits of each value are meaningful
+
+        bool m_hasStatistics{ false };
+        uint64_t m_fragmentInvocations{ 0 };
+        bool m_hasTimings{ false };
+        double m_sceneGPUMs{ 0.0 };
+
+        void collectStatistics(VkDevice _device, uint32_t _frameSlot);
+        void collectTimings(VkDevice _device, uint32_t _frameSlot);
+    };
+} // namespace Mark::RendererVK
@@ -5,6 +5,8 @@
 #include "Utils/VulkanUtils.h"
 #include "Utils/Mark_Utils.h"
 
+#include <chrono>
+
 namespace Mark::RendererVK
 {
     static void validatePipelineDesc(const PipelineDesc& _desc)
@@ -12,8 +14,9 @@ namespace Mark::RendererVK
         if (_desc.device == VK_NULL_HANDLE) {
             MARK_FATAL(Utils::Category::Vulkan, "PipelineDesc.device is VK_NULL_HANDLE");
         }
-        if (_desc.vertexShader == VK_NULL_HANDLE || _desc.fragmentShader == VK_NULL_HANDLE) {
-            MARK_FATAL(Utils::Category::Vulkan, "PipelineDesc shaders not set (Shader module is VK_NULL_HANDLE)");
+        // A null fragment shader is allowed for depth-only pipelines
+        if (_desc.vertexShader == VK_NULL_HANDLE) {
+            MARK_FATAL(Utils::Category::Vulkan, "PipelineDesc vertex shader not set (Shader module is VK_NULL_HANDLE)");
         }
         if (_desc.renderTargetsDesc.colourFormats.empty()) {
             MARK_FATAL(Utils::Category::Vulkan, "PipelineDesc.renderTargetsDesc.colourFormats is empty. "
@@ -36,12 +39,443 @@ namespace Mark::RendererVK
     }
     
 
+    // Drops dynamic groups the device can't support so they get baked into the pipeline instead
+    static PipelineDesc resolveDynamicState(const PipelineDesc& _desc)
+    {
+        PipelineDesc resolved = _desc;
+        const PipelineDynamicStateCaps& caps = _desc.cache.dynamicStateCaps();
+        PipelineDynamicStateDesc& dyn = resolved.dynamicDesc;
+
+        if (!caps.depthAndCull) {
+            dyn.dynamicDepth = false;
+            dyn.dynamicCull = false;
+        }
+        if (dyn.dynamicBlend && !caps.blend) {
+            dyn.dynamicBlend = false;
+            MARK_DEBUG(Utils::Category::Vulkan, "Pipeline '%s': dynamic blend unsupported, baking blend state", _desc.debugName.c_str());
+        }
+        return resolved;
+    }
+
+    static void appendExtendedDynamicStates(const PipelineDynamicStateDesc& _dynamicDesc, std::vector<VkDynamicState>& _outStates)
+    {
+        if (_dynamicDesc.dynamicDepth) {
+            _outStates.push_back(VK_DYNAMIC_STATE_DEPTH_TEST_ENABLE);
+            _outStates.push_back(VK_DYNAMIC_STATE_DEPTH_WRITE_ENABLE);
+            _outStates.push_back(VK_DYNAMIC_STATE_DEPTH_COMPARE_OP);
+        }
+        if (_dynamicDesc.dynamicCull) {
+            _outStates.push_back(VK_DYNAMIC_STATE_CULL_MODE);
+            _outStates.push_back(VK_DYNAMIC_STATE_FRONT_FACE);
+        }
+        if (_dynamicDesc.dynamicBlend) {
+            _outStates.push_back(VK_DYNAMIC_STATE_COLOR_BLEND_ENABLE_EXT);
+            _outStates.push_back(VK_DYNAMIC_STATE_COLOR_BLEND_EQUATION_EXT);
+            _outStates.push_back(VK_DYNAMIC_STATE_COLOR_WRITE_MASK_EXT);
+        }
+    }
+
+    // Every create-info for one desc. Members point at each other so it stays where it was built
+    struct PipelineCreateState
+    {
+        explicit PipelineCreateState(const PipelineDesc& _pipelineDesc);
+        PipelineCreateState(const PipelineCreateState&) = delete;
+        PipelineCreateState& operator=(const PipelineCreateState&) = delete;
+
+        VkPipelineShaderStageCreateInfo shaderStages[2]{};
+        uint32_t stageCount{ 2 }; // 1 for depth-only pipelines without a fragment shader
+        std::vector<VkSpecializationMapEntry> specializationEntries[2];
+        std::vector<uint32_t> specializationData[2];
+        VkSpecializationInfo specializationInfo[2]{};
+        std::vector<VkDynamicState> dynamicStates;
+        VkPipelineDynamicStateCreateInfo dynamicStateInfo{};
+        VkPipelineVertexInputStateCreateInfo vertexInputInfo{};
+        VkPipelineInputAssemblyStateCreateInfo inputAssemblyInfo{};
+        VkPipelineRasterizationStateCreateInfo rasterizeInfo{};
+        VkViewport dummyViewport{ 0,0,1,1,0.f,1.f };
+        VkRect2D dummyScissor{ {0,0},{1,1} };
+        VkPipelineViewportStateCreateInfo viewportInfo{};
+        VkPipelineMultisampleStateCreateInfo multisampleInfo{};
+        VkPipelineDepthStencilStateCreateInfo depthStencilInfo{};
+        std::vector<VkPipelineColorBlendAttachmentState> blendAttachments;
+        VkPipelineColorBlendStateCreateInfo colorBlendInfo{};
+        VkPipelineRenderingCreateInfo renderingInfo{};
+        VkPipelineTessellationStateCreateInfo tessInfo{};
+        bool useTess{ false };
+    };
+
+    PipelineCreateState::PipelineCreateState(const PipelineDesc& _pipelineDesc)
+    {
+        // Shader stages
+        shaderStages[0] = {
+            .sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
+            .stage = VK_SHADER_STAGE_VERTEX_BIT,
+            .module = _pipelineDesc.vertexShader,
+            .pName = "main"
+        };
+        shaderStages[1] = {
+            .sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
+            .stage = VK_SHADER_STAGE_FRAGMENT_BIT,
+            .module = _pipelineDesc.fragmentShader,
+            .pName = "main"
+        };
+        stageCount = (_pipelineDesc.fragmentShader != VK_NULL_HANDLE) ? 2u : 1u;
+
+        // Specialization constants, each value packed at its index in the data block
+        const PipelineSpecializationDesc* specializations[2] = { &_pipelineDesc.vertexSpecialization, &_pipelineDesc.fragmentSpecialization };
+        for (uint32_t stage = 0; stage < 2; stage++)
+        {
+            const std::vector<PipelineSpecializationDesc::Constant>& constants = specializations[stage]->constants;
+            if (constants.empty()) continue;
+
+            specializationEntries[stage].reserve(constants.size());
+            specializationData[stage].reserve(constants.size());
+            for (const PipelineSpecializationDesc::Constant& c : constants)
+            {
+                specializationEntries[stage].push_back({
+                    .constantID = c.id,
+                    .offset = static_cast<uint32_t>(specializationData[stage].size() * sizeof(uint32_t)),
+                    .size = sizeof(uint32_t)
+                });
+                specializationData[stage].push_back(c.value);
+            }
+
+            specializationInfo[stage] = {
+                .mapEntryCount = static_cast<uint32_t>(specializationEntries[stage].size()),
+                .pMapEntries = specializationEntries[stage].data(),
+                .dataSize = specializationData[stage].size() * sizeof(uint32_t),
+                .pData = specializationData[stage].data()
+            };
+            shaderStages[stage].pSpecializationInfo = &specializationInfo[stage];
+        }
+
+        dynamicStates = _pipelineDesc.dynamicDesc.states;
+        appendExtendedDynamicStates(_pipelineDesc.dynamicDesc, dynamicStates);
+        dynamicStateInfo = { 
+            .sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO,
+            .dynamicStateCount = static_cast<uint32_t>(dynamicStates.size()),
+            .pDynamicStates = dynamicStates.empty() ? nullptr : dynamicStates.data()
+        };
+
+        vertexInputInfo = { 
+            .sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO 
+        };
+
+        inputAssemblyInfo = { 
+            .sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO,
+            .topology = _pipelineDesc.inputAssemblyDesc.topology,
+            .primitiveRestartEnable = _pipelineDesc.inputAssemblyDesc.primitiveRestartEnable ? VK_TRUE : VK_FALSE
+        };
+        
+        rasterizeInfo = { 
+            .sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO,
+            .depthClampEnable = _pipelineDesc.rasterDesc.depthClampEnable ? VK_TRUE : VK_FALSE,
+            .rasterizerDiscardEnable = _pipelineDesc.rasterDesc.rasterizerDiscardEnable ? VK_TRUE : VK_FALSE,
+            .polygonMode = _pipelineDesc.rasterDesc.polygonMode,
+            .cullMode = _pipelineDesc.rasterDesc.cullMode,
+            .frontFace = _pipelineDesc.rasterDesc.frontFace,
+            .depthBiasEnable = _pipelineDesc.rasterDesc.depthBiasEnable ? VK_TRUE : VK_FALSE,
+            .depthBiasConstantFactor = _pipelineDesc.rasterDesc.depthBiasConstantFactor,
+            .depthBiasClamp = _pipelineDesc.rasterDesc.depthBiasClamp,
+            .depthBiasSlopeFactor = _pipelineDesc.rasterDesc.depthBiasSlopeFactor,
+            .lineWidth = _pipelineDesc.rasterDesc.lineWidth
+        };
+        
+        // Viewport state with counts; values ignored when dynamic
+        viewportInfo = {
+            .sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO,
+            .viewportCount = 1,
+            .pViewports = &dummyViewport,
+            .scissorCount = 1,
+            .pScissors = &dummyScissor
+        };
+
+        const uint32_t sampleCount = static_cast<uint32_t>(_pipelineDesc.multisampleDesc.rasterizationSamples);
+        const uint32_t neededMaskCount = (sampleCount + 31u) / 32u;
+        if (neededMaskCount > static_cast<uint32_t>(_pipelineDesc.multisampleDesc.sampleMask.size())) {
+            MARK_FATAL(Utils::Category::Vulkan, "multisampleDesc.sampleMask only supports up to 64 samples");
+        }
+        multisampleInfo = {
+            .sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO,
+            .rasterizationSamples = _pipelineDesc.multisampleDesc.rasterizationSamples,
+            .sampleShadingEnable = _pipelineDesc.multisampleDesc.sampleShadingEnable ? VK_TRUE : VK_FALSE,
+            .minSampleShading = _pipelineDesc.multisampleDesc.minSampleShading,
+            .pSampleMask = _pipelineDesc.multisampleDesc.sampleMask.data(),
+            .alphaToCoverageEnable = _pipelineDesc.multisampleDesc.alphaToCoverageEnable ? VK_TRUE : VK_FALSE,
+            .alphaToOneEnable = _pipelineDesc.multisampleDesc.alphaToOneEnable ? VK_TRUE : VK_FALSE
+        };
+
+        depthStencilInfo = {
+            .sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO,
+            .depthTestEnable = _pipelineDesc.depthStencilDesc.depthTestEnable ? VK_TRUE : VK_FALSE,
+            .depthWriteEnable = _pipelineDesc.depthStencilDesc.depthWriteEnable ? VK_TRUE : VK_FALSE,
+            .depthCompareOp = _pipelineDesc.depthStencilDesc.depthCompareOp,
+            .depthBoundsTestEnable = _pipelineDesc.depthStencilDesc.depthBoundsTestEnable ? VK_TRUE : VK_FALSE,
+            .stencilTestEnable = _pipelineDesc.depthStencilDesc.stencilTestEnable ? VK_TRUE : VK_FALSE,
+            .front = _pipelineDesc.depthStencilDesc.front,
+            .back = _pipelineDesc.depthStencilDesc.back,
+            .minDepthBounds = _pipelineDesc.depthStencilDesc.minDepthBounds,
+            .maxDepthBounds = _pipelineDesc.depthStencilDesc.maxDepthBounds
+        };
+
+        // Blend attachments must match colour attachment count
+        const uint32_t colourCount = static_cast<uint32_t>(_pipelineDesc.renderTargetsDesc.colourFormats.size());
+        std::vector<PipelineBlendAttachmentDesc> blendIn = _pipelineDesc.blendDesc.attachments;
+        if (blendIn.empty()) {
+            blendIn.resize(colourCount); // Defaults are opaque as enable=false by default
+        }
+        else if (blendIn.size() == 1 && colourCount > 1) {
+            blendIn.resize(colourCount, blendIn[0]);
+        }
+        else if (blendIn.size() != colourCount) {
+            MARK_FATAL(Utils::Category::Vulkan, "PipelineDesc.blendDesc.attachments size must be 0, 1, or equal to renderTargetsDesc.colourFormats size.");
+        }
+        
+        blendAttachments.reserve(blendIn.size());
+        for (const auto& attachment : blendIn)
+        {
+            VkPipelineColorBlendAttachmentState out = {
+                .blendEnable = attachment.enable ? VK_TRUE : VK_FALSE,
+                .srcColorBlendFactor = attachment.srcColour,
+                .dstColorBlendFactor = attachment.dstColour,
+                .colorBlendOp = attachment.colourOp,
+                .srcAlphaBlendFactor = attachment.srcAlpha,
+                .dstAlphaBlendFactor = attachment.dstAlpha,
+                .alphaBlendOp = attachment.alphaOp,
+                .colorWriteMask = attachment.colorWriteMask
+            };
+
+            blendAttachments.push_back(out);
+        }
+
+        colorBlendInfo = {
+            .sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO,
+            .logicOpEnable = _pipelineDesc.blendDesc.logicOpEnable ? VK_TRUE : VK_FALSE,
+            .logicOp = _pipelineDesc.blendDesc.logicOp,
+            .attachmentCount = static_cast<uint32_t>(blendAttachments.size()),
+            .pAttachments = blendAttachments.data()
+        };
+        colorBlendInfo.blendConstants[0] = _pipelineDesc.blendDesc.blendConstants[0];
+        colorBlendInfo.blendConstants[1] = _pipelineDesc.blendDesc.blendConstants[1];
+        colorBlendInfo.blendConstants[2] = _pipelineDesc.blendDesc.blendConstants[2];
+        colorBlendInfo.blendConstants[3] = _pipelineDesc.blendDesc.blendConstants[3];
+
+
+        renderingInfo = {
+            .sType = VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO,
+            .pNext = nullptr,
+            .viewMask = _pipelineDesc.renderTargetsDesc.viewMask,
+            .colorAttachmentCount = static_cast<uint32_t>(_pipelineDesc.renderTargetsDesc.colourFormats.size()),
+            .pColorAttachmentFormats = _pipelineDesc.renderTargetsDesc.colourFormats.data(),
+            .depthAttachmentFormat = _pipelineDesc.renderTargetsDesc.depthFormat,
+            .stencilAttachmentFormat = _pipelineDesc.renderTargetsDesc.stencilFormat
+        };
+
+        tessInfo = {
+            .sType = VK_STRUCTURE_TYPE_PIPELINE_TESSELLATION_STATE_CREATE_INFO,
+            .patchControlPoints = _pipelineDesc.inputAssemblyDesc.patchControlPoints
+        };
+        useTess = (_pipelineDesc.inputAssemblyDesc.topology == VK_PRIMITIVE_TOPOLOGY_PATCH_LIST) &&
+                  (_pipelineDesc.inputAssemblyDesc.patchControlPoints > 0);
+    }
+
+    static VkPipeline createTimedPipeline(const PipelineDesc& _pipelineDesc, const VkGraphicsPipelineCreateInfo& _createInfo, const char* _what, bool _recordStats)
+    {
+        VulkanPipelineDiskCache* diskCache = _pipelineDesc.cache.diskCache();
+        const VkPipelineCache driverCache = diskCache ? diskCache->handle() : VK_NULL_HANDLE;
+
+        VkPipeline pipeline = VK_NULL_HANDLE;
+        const auto createStart = std::chrono::steady_clock::now();
+        VkResult res = vkCreateGraphicsPipelines(_pipelineDesc.device, driverCache, 1, &_createInfo, nullptr, &pipeline);
+        CHECK_VK_RESULT(res, "Create Graphics Pipeline");
+        const double createMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - createStart).count();
+        if (diskCache && _recordStats) {
+            diskCache->recordPipelineCreation(createMs);
+        }
+        else if (diskCache) {
+            diskCache->noteCacheWrite();
+        }
+        MARK_DEBUG(Utils::Category::Vulkan, "Graphics pipeline '%s' %s in %.2f ms", _pipelineDesc.debugName.c_str(), _what, createMs);
+        return pipeline;
+    }
+
+    // Pipelines (and every library part they link) reading set 0 from a descriptor buffer carry this flag
+    static VkPipelineCreateFlags descriptorBufferFlags(const PipelineDesc& _pipelineDesc)
+    {
+        return _pipelineDesc.descriptorBuffer ? static_cast<VkPipelineCreateFlags>(VK_PIPELINE_CREATE_DESCRIPTOR_BUFFER_BIT_EXT) : 0u;
+    }
+
+    // Builds the layout + pipeline for one desc in a single vkCreateGraphicsPipelines call
+    static GraphicsPipelineCreateResult createMonolithicPipeline(const PipelineDesc& _pipelineDesc, VkDescriptorSetLayout _set0Layout)
+    {
+        VkPipelineLayout layout = VK_NULL_HANDLE;
+        VkPipelineLayoutCreateInfo pipelineLayoutInfo = { 
+            .sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
+            .setLayoutCount = 1u ,
+            .pSetLayouts = &_set0Layout,
+            .pushConstantRangeCount = 1u,
+            .pPushConstantRanges = &PIPELINE_FRAME_PUSH_CONSTANT_RANGE
+        };
+
+        VkResult res = vkCreatePipelineLayout(_pipelineDesc.device, &pipelineLayoutInfo, nullptr, &layout);
+        CHECK_VK_RESULT(res, "Failed to create pipeline layout");
+        MARK_VK_NAME(_pipelineDesc.device, VK_OBJECT_TYPE_PIPELINE_LAYOUT, layout, ("VulkanPipeline." + _pipelineDesc.debugName + ".PipeLayout").c_str());
+
+        const PipelineCreateState state(_pipelineDesc);
+        VkGraphicsPipelineCreateInfo pipelineCreateInfo = {
+            .sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO,
+            .pNext = &state.renderingInfo,
+            .flags = descriptorBufferFlags(_pipelineDesc),
+            .stageCount = state.stageCount,
+            .pStages = &state.shaderStages[0],
+            .pVertexInputState = &state.vertexInputInfo,
+            .pInputAssemblyState = &state.inputAssemblyInfo,
+            .pTessellationState = state.useTess ? &state.tessInfo : nullptr,
+            .pViewportState = &state.viewportInfo,
+            .pRasterizationState = &state.rasterizeInfo,
+            .pMultisampleState = &state.multisampleInfo,
+            .pDepthStencilState = &state.depthStencilInfo,
+            .pColorBlendState = &state.colorBlendInfo,
+            .pDynamicState = &state.dynamicStateInfo,
+            .layout = layout,
+            .renderPass = VK_NULL_HANDLE,
+            .subpass = 0,
+            .basePipelineHandle = VK_NULL_HANDLE,
+            .basePipelineIndex = -1
+        };
+
+        GraphicsPipelineCreateResult out{};
+        out.m_pipeline = createTimedPipeline(_pipelineDesc, pipelineCreateInfo, "created", true);
+        MARK_VK_NAME(_pipelineDesc.device, VK_OBJECT_TYPE_PIPELINE, out.m_pipeline, ("VulkanPipeline." + _pipelineDesc.debugName + ".GraphicsPipe").c_str());
+
+        out.m_layout = layout;
+        return out;
+    }
+
+    // One VK_EXT_graphics_pipeline_library subset, only the state that part consumes is passed in
+    static VkPipeline createLibraryPart(const PipelineDesc& _pipelineDesc, const PipelineCreateState& _state, PipelineLibraryPart _part, VkPipelineLayout _layout)
+    {
+        VkGraphicsPipelineLibraryCreateInfoEXT libraryInfo = {
+            .sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_LIBRARY_CREATE_INFO_EXT,
+            .pNext = &_state.renderingInfo
+        };
+        VkGraphicsPipelineCreateInfo createInfo = {
+            .sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO,
+            .pNext = &libraryInfo,
+            // Retained so the background optimised link can still see across parts
+            .flags = VK_PIPELINE_CREATE_LIBRARY_BIT_KHR | VK_PIPELINE_CREATE_RETAIN_LINK_TIME_OPTIMIZATION_INFO_BIT_EXT | descriptorBufferFlags(_pipelineDesc),
+            .pDynamicState = &_state.dynamicStateInfo,
+            .renderPass = VK_NULL_HANDLE,
+            .basePipelineHandle = VK_NULL_HANDLE,
+            .basePipelineIndex = -1
+        };
+
+        const char* partName = "";
+        switch (_part)
+        {
+        case PipelineLibraryPart::VertexInput:
+            libraryInfo.flags = VK_GRAPHICS_PIPELINE_LIBRARY_VERTEX_INPUT_INTERFACE_BIT_EXT;
+            createInfo.pVertexInputState = &_state.vertexInputInfo;
+            createInfo.pInputAssemblyState = &_state.inputAssemblyInfo;
+            partName = "VertexInput";
+            break;
+        case PipelineLibraryPart::PreRasterization:
+            libraryInfo.flags = VK_GRAPHICS_PIPELINE_LIBRARY_PRE_RASTERIZATION_SHADERS_BIT_EXT;
+            createInfo.stageCount = 1;
+            createInfo.pStages = &_state.shaderStages[0];
+            createInfo.pTessellationState = _state.useTess ? &_state.tessInfo : nullptr;
+            createInfo.pViewportState = &_state.viewportInfo;
+            createInfo.pRasterizationState = &_state.rasterizeInfo;
+            createInfo.layout = _layout;
+            partName = "PreRaster";
+            break;
+        case PipelineLibraryPart::FragmentShader:
+            libraryInfo.flags = VK_GRAPHICS_PIPELINE_LIBRARY_FRAGMENT_SHADER_BIT_EXT;
+            // Depth-only pipelines still need this part for the depth state, just without a stage
+            createInfo.stageCount = _state.stageCount - 1u;
+            createInfo.pStages = createInfo.stageCount ? &_state.shaderStages[1] : nullptr;
+            createInfo.pMultisampleState = &_state.multisampleInfo;
+            createInfo.pDepthStencilState = &_state.depthStencilInfo;
+            createInfo.layout = _layout;
+            partName = "FragmentShader";
+            break;
+        case PipelineLibraryPart::FragmentOutput:
+            libraryInfo.flags = VK_GRAPHICS_PIPELINE_LIBRARY_FRAGMENT_OUTPUT_INTERFACE_BIT_EXT;
+            createInfo.pMultisampleState = &_state.multisampleInfo;
+            createInfo.pColorBlendState = &_state.colorBlendInfo;
+            partName = "FragmentOutput";
+            break;
+        default:
+            return VK_NULL_HANDLE;
+        }
+
+        const std::string what = std::string("library part ") + partName + " compiled";
+        VkPipeline part = createTimedPipeline(_pipelineDesc, createInfo, what.c_str(), false);
+        MARK_VK_NAME(_pipelineDesc.device, VK_OBJECT_TYPE_PIPELINE, part, ("VulkanPipeline." + _pipelineDesc.debugName + ".Lib." + partName).c_str());
+        return part;
+    }
+
+    static VkPipeline linkLibraryParts(const PipelineDesc& _pipelineDesc, const VulkanPipelineLibraryCache::Parts& _parts, VkPipelineLayout _layout, bool _optimise)
+    {
+        VkPipelineLibraryCreateInfoKHR linkInfo = {
+            .sType = VK_STRUCTURE_TYPE_PIPELINE_LIBRARY_CREATE_INFO_KHR,
+            .libraryCount = static_cast<uint32_t>(_parts.size()),
+            .pLibraries = _parts.data()
+        };
+        VkGraphicsPipelineCreateInfo createInfo = {
+            .sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO,
+            .pNext = &linkInfo,
+            .flags = (_optimise ? static_cast<VkPipelineCreateFlags>(VK_PIPELINE_CREATE_LINK_TIME_OPTIMIZATION_BIT_EXT) : 0u) | descriptorBufferFlags(_pipelineDesc),
+            .layout = _layout,
+            .renderPass = VK_NULL_HANDLE,
+            .basePipelineHandle = VK_NULL_HANDLE,
+            .basePipelineIndex = -1
+        };
+
+        VkPipeline pipeline = createTimedPipeline(_pipelineDesc, createInfo, _optimise ? "optimised link" : "fast-linked", !_optimise);
+        MARK_VK_NAME(_pipelineDesc.device, VK_OBJECT_TYPE_PIPELINE, pipeline, ("VulkanPipeline." + _pipelineDesc.debugName + ".GraphicsPipe").c_str());
+        return pipeline;
+    }
+
+    // Parts come from the library cache (compiled on a miss), the full pipeline is a fast link of the four.
+    // The link-time optimised version is handed back as an upgrade and swapped in by the cache when it lands
+    static GraphicsPipelineCreateResult createLinkedPipeline(VulkanPipelineLibraryCache& _libraries, const PipelineDesc& _pipelineDesc, VkDescriptorSetLayout _set0Layout, uint64_t _set0LayoutHash)
+    {
+        const VkPipelineLayout layout = _libraries.acquireLayout(_set0Layout, _set0LayoutHash);
+        const PipelineCreateState state(_pipelineDesc);
+
+        VulkanPipelineLibraryCache::Parts parts{};
+        for (size_t i = 0; i < parts.size(); i++)
+        {
+            const PipelineLibraryPart part = static_cast<PipelineLibraryPart>(i);
+            parts[i] = _libraries.acquirePart(part, _pipelineDesc, _set0LayoutHash,
+                [&]() { return createLibraryPart(_pipelineDesc, state, part, layout); });
+        }
+
+        GraphicsPipelineCreateResult out{};
+        out.m_pipeline = linkLibraryParts(_pipelineDesc, parts, layout, false);
+        out.m_layout = layout;
+        out.m_ownsLayout = false;
+        out.m_upgrade = [desc = _pipelineDesc, parts, layout]() { return linkLibraryParts(desc, parts, layout, true); };
+        return out;
+    }
+
+    // Only touches its arguments so it can run on a compile worker
+    static GraphicsPipelineCreateResult createPipelineObjects(const PipelineDesc& _pipelineDesc, VkDescriptorSetLayout _set0Layout, uint64_t _set0LayoutHash)
+    {
+        if (VulkanPipelineLibraryCache* libraries = _pipelineDesc.cache.pipelineLibrary()) {
+            return createLinkedPipeline(*libraries, _pipelineDesc, _set0Layout, _set0LayoutHash);
+        }
+        return createMonolithicPipeline(_pipelineDesc, _set0Layout);
+    }
+
     void VulkanGraphicsPipeline::destroyGraphicsPipeline()
     {
         // Drop cache ref (decrements refcount inside the cache)
         m_cachedRef = {};
 
         m_pipelineLayout = VK_NULL_HANDLE;
+        m_fallback = nullptr;
 
         m_set0Layout = VK_NULL_HANDLE;
         m_set0LayoutHash = 0;
@@ -53,12 +487,108 @@ namespace Mark::RendererVK
         m_set0LayoutHash = _set0LayoutHash;
     }
 
-    void VulkanGraphicsPipeline::bindPipeline(VkCommandBuffer _cmdBuffer)
+    bool VulkanGraphicsPipeline::bindPipeline(VkCommandBuffer _cmdBuffer) const
+    {
+        if (m_cachedRef) {
+            vkCmdBindPipeline(_cmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_cachedRef.get());
+            applyDynamicState(_cmdBuffer);
+            return true;
+        }
+        // Still compiling, stand in with the fallback if there is one
+        if (m_fallback && m_fallback->isValid()) {
+            return m_fallback->bindPipeline(_cmdBuffer);
+        }
+        return false;
+    }
+
+    void VulkanGraphicsPipeline::captureDynamicState(const PipelineDesc& _pipelineDesc)
+    {
+        const PipelineDynamicStateDesc& dyn = _pipelineDesc.dynamicDesc;
+        DynamicRenderState& state = m_dynamicState;
+        state = {};
+
+        state.depth = dyn.dynamicDepth;
+        state.depthTestEnable = _pipelineDesc.depthStencilDesc.depthTestEnable ? VK_TRUE : VK_FALSE;
+        state.depthWriteEnable = _pipelineDesc.depthStencilDesc.depthWriteEnable ? VK_TRUE : VK_FALSE;
+        state.depthCompareOp = _pipelineDesc.depthStencilDesc.depthCompareOp;
+
+        state.cull = dyn.dynamicCull;
+        state.cullMode = _pipelineDesc.rasterDesc.cullMode;
+        state.frontFace = _pipelineDesc.rasterDesc.frontFace;
+
+        state.blend = dyn.dynamicBlend;
+        if (!state.blend) return;
+
+        // Same expansion rules as the baked path: empty = opaque defaults, one entry = broadcast
+        const size_t colourCount = _pipelineDesc.renderTargetsDesc.colourFormats.size();
+        std::vector<PipelineBlendAttachmentDesc> attachments = _pipelineDesc.blendDesc.attachments;
+        if (attachments.empty()) {
+            attachments.resize(colourCount);
+        }
+        else if (attachments.size() == 1 && colourCount > 1) {
+            attachments.resize(colourCount, attachments[0]);
+        }
+
+        for (const PipelineBlendAttachmentDesc& attachment : attachments)
+        {
+            state.blendEnables.push_back(attachment.enable ? VK_TRUE : VK_FALSE);
+            state.blendEquations.push_back(VkColorBlendEquationEXT{
+                .srcColorBlendFactor = attachment.srcColour,
+                .dstColorBlendFactor = attachment.dstColour,
+                .colorBlendOp = attachment.colourOp,
+                .srcAlphaBlendFactor = attachment.srcAlpha,
+                .dstAlphaBlendFactor = attachment.dstAlpha,
+                .alphaBlendOp = attachment.alphaOp
+            });
+            state.writeMasks.push_back(attachment.colorWriteMask);
+        }
+    }
+
+    void VulkanGraphicsPipeline::applyDynamicState(VkCommandBuffer _cmdBuffer) const
     {
-        vkCmdBindPipeline(_cmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_cachedRef.get());
+        const DynamicRenderState& state = m_dynamicState;
+        if (state.depth) {
+            vkCmdSetDepthTestEnable(_cmdBuffer, state.depthTestEnable);
+            vkCmdSetDepthWriteEnable(_cmdBuffer, state.depthWriteEnable);
+            vkCmdSetDepthCompareOp(_cmdBuffer, state.depthCompareOp);
+        }
+        if (state.cull) {
+            vkCmdSetCullMode(_cmdBuffer, state.cullMode);
+            vkCmdSetFrontFace(_cmdBuffer, state.frontFace);
+        }
+        if (state.blend && !state.blendEnables.empty()) {
+            const uint32_t count = static_cast<uint32_t>(state.blendEnables.size());
+            vkCmdSetColorBlendEnableEXT(_cmdBuffer, 0, count, state.blendEnables.data());
+            vkCmdSetColorBlendEquationEXT(_cmdBuffer, 0, count, state.blendEquations.data());
+            vkCmdSetColorWriteMaskEXT(_cmdBuffer, 0, count, state.writeMasks.data());
+        }
+    }
+
+    VkPipelineLayout VulkanGraphicsPipeline::pipelineLayout() const noexcept
+    {
+        if (m_pipelineLayout != VK_NULL_HANDLE) return m_pipelineLayout;
+        return m_fallback ? m_fallback->pipelineLayout() : VK_NULL_HANDLE;
+    }
+
+    bool VulkanGraphicsPipeline::poll()
+    {
+        const bool wasPending = m_cachedRef.isPending();
+        if (!m_cachedRef.refresh()) {
+            return false;
+        }
+
+        m_pipelineLayout = m_cachedRef.layout();
+        m_fallback = nullptr;
+        if (wasPending) {
+            MARK_INFO(Utils::Category::Vulkan, "Vulkan Graphics Pipeline Ready (async)");
+        }
+        else {
+            MARK_DEBUG(Utils::Category::Vulkan, "Vulkan Graphics Pipeline swapped to its optimised link");
+        }
+        return true;
     }
 
-    void VulkanGraphicsPipeline::createGraphicsPipeline(const PipelineDesc& _pipelineDesc)
+    VulkanGraphicsPipelineKey VulkanGraphicsPipeline::prepareKey(const PipelineDesc& _pipelineDesc)
     {
         if (m_set0Layout == VK_NULL_HANDLE || m_set0LayoutHash == 0) {
             MARK_FATAL(Utils::Category::Vulkan,
@@ -68,202 +598,58 @@ namespace Mark::RendererVK
 
         validatePipelineDesc(_pipelineDesc);
 
-        const auto samples = _pipelineDesc.multisampleDesc.rasterizationSamples;
+        if (VulkanPipelineManifest* manifest = _pipelineDesc.cache.manifest()) {
+            manifest->record(_pipelineDesc, m_set0LayoutHash);
+        }
+
+        captureDynamicState(_pipelineDesc);
+        return _pipelineDesc.cache.makeKey(_pipelineDesc, m_set0LayoutHash);
+    }
+
+    void VulkanGraphicsPipeline::prewarm(const PipelineDesc& _pipelineDesc, VkDescriptorSetLayout _set0Layout, uint64_t _set0LayoutHash)
+    {
+        const PipelineDesc resolved = resolveDynamicState(_pipelineDesc);
+        validatePipelineDesc(resolved);
+
+        const VulkanGraphicsPipelineKey key = resolved.cache.makeKey(resolved, _set0LayoutHash);
+
+        // No ref is taken, the entry stays in the cache at zero refs until the real acquire
+        resolved.cache.prewarm(
+            key,
+            [desc = resolved, _set0Layout, _set0LayoutHash](const VulkanGraphicsPipelineKey&) { return createPipelineObjects(desc, _set0Layout, _set0LayoutHash); });
+    }
+
+    void VulkanGraphicsPipeline::createGraphicsPipelineAsync(const PipelineDesc& _requestedDesc, const VulkanGraphicsPipeline* _fallback)
+    {
+        const PipelineDesc _pipelineDesc = resolveDynamicState(_requestedDesc);
+        VulkanGraphicsPipelineKey key = prepareKey(_pipelineDesc);
 
-        VulkanGraphicsPipelineKey key = VulkanGraphicsPipelineKey::Make(_pipelineDesc, m_set0LayoutHash);
+        // Creator runs after this returns so it owns copies of everything it reads
+        m_cachedRef = _pipelineDesc.cache.acquireAsync(
+            key,
+            [desc = _pipelineDesc, set0Layout = m_set0Layout, set0LayoutHash = m_set0LayoutHash](const VulkanGraphicsPipelineKey&) { return createPipelineObjects(desc, set0Layout, set0LayoutHash); });
 
-        // Acquire from the device graphics-pipeline cache with a creation lambda
+        if (!m_cachedRef && !m_cachedRef.isPending()) {
+            MARK_FATAL(Utils::Category::Vulkan, "Failed to create/acquire graphics pipeline");
+        }
+
+        m_pipelineLayout = m_cachedRef.layout();
+        m_fallback = m_cachedRef.isPending() ? _fallback : nullptr;
+        if (m_cachedRef.isPending()) {
+            MARK_INFO(Utils::Category::Vulkan, "Vulkan Graphics Pipeline '%s' compiling in background (%s)",
+                _pipelineDesc.debugName.c_str(), m_fallback ? "fallback bound" : "draws skipped");
+        }
+    }
+
+    void VulkanGraphicsPipeline::createGraphicsPipeline(const PipelineDesc& _requestedDesc)
+    {
+        const PipelineDesc _pipelineDesc = resolveDynamicState(_requestedDesc);
+        VulkanGraphicsPipelineKey key = prepareKey(_pipelineDesc);
+
+        // Acquire from the device graphics-pipeline cache, compiling on this thread on a miss
         m_cachedRef = _pipelineDesc.cache.acquire(
             key,
-            [&](const VulkanGraphicsPipelineKey& _key)->GraphicsPipelineCreateResult
-            {
-                VkPipelineLayout layout = VK_NULL_HANDLE;
-                VkPipelineLayoutCreateInfo pipelineLayoutInfo = { 
-                    .sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
-                    .setLayoutCount = 1u ,
-                    .pSetLayouts = &m_set0Layout
-                };
-
-                VkResult res = vkCreatePipelineLayout(_pipelineDesc.device, &pipelineLayoutInfo, nullptr, &layout);
-                CHECK_VK_RESULT(res, "Failed to create pipeline layout");
-                MARK_VK_NAME(_pipelineDesc.device, VK_OBJECT_TYPE_PIPELINE_LAYOUT, layout, ("VulkanPipeline." + _pipelineDesc.debugName + ".PipeLayout").c_str());
-
-                // Shader stages
-                VkPipelineShaderStageCreateInfo shaderStageCreateInfo[2] = {
-                    {
-                        .sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
-                        .stage = VK_SHADER_STAGE_VERTEX_BIT,
-                        .module = _pipelineDesc.vertexShader,
-                        .pName = "main"
-                    },
-                    {
-                        .sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
-                        .stage = VK_SHADER_STAGE_FRAGMENT_BIT,
-                        .module = _pipelineDesc.fragmentShader,
-                        .pName = "main"
-                    }
-                };
-
-                const auto& dynStatesVec = _pipelineDesc.dynamicDesc.states;
-                VkPipelineDynamicStateCreateInfo dynamicStateCreateInfo = { 
-                    .sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO,
-                    .dynamicStateCount = static_cast<uint32_t>(dynStatesVec.size()),
-                    .pDynamicStates = dynStatesVec.empty() ? nullptr : dynStatesVec.data()
-                };
-
-                VkPipelineVertexInputStateCreateInfo vertexInputCreateInfo = { 
-                    .sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO 
-                };
-
-                VkPipelineInputAssemblyStateCreateInfo inputAssemblyCreateInfo = { 
-                    .sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO,
-                    .topology = _pipelineDesc.inputAssemblyDesc.topology,
-                    .primitiveRestartEnable = _pipelineDesc.inputAssemblyDesc.primitiveRestartEnable ? VK_TRUE : VK_FALSE
-                };
-                
-                VkPipelineRasterizationStateCreateInfo rasterizeCreateInfo = { 
-                    .sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO,
-                    .depthClampEnable = _pipelineDesc.rasterDesc.depthClampEnable ? VK_TRUE : VK_FALSE,
-                    .rasterizerDiscardEnable = _pipelineDesc.rasterDesc.rasterizerDiscardEnable ? VK_TRUE : VK_FALSE,
-                    .polygonMode = _pipelineDesc.rasterDesc.polygonMode,
-                    .cullMode = _pipelineDesc.rasterDesc.cullMode,
-                    .frontFace = _pipelineDesc.rasterDesc.frontFace,
-                    .depthBiasEnable = _pipelineDesc.rasterDesc.depthBiasEnable ? VK_TRUE : VK_FALSE,
-                    .depthBiasConstantFactor = _pipelineDesc.rasterDesc.depthBiasConstantFactor,
-                    .depthBiasClamp = _pipelineDesc.rasterDesc.depthBiasClamp,
-                    .depthBiasSlopeFactor = _pipelineDesc.rasterDesc.depthBiasSlopeFactor,
-                    .lineWidth = _pipelineDesc.rasterDesc.lineWidth
-                };
-                
-                // Viewport state with counts; values ignored when dynamic
-                VkViewport dummyViewport{ 0,0,1,1,0.f,1.f };
-                VkRect2D dummyScissor{ {0,0},{1,1} };
-                VkPipelineViewportStateCreateInfo viewportCreateInfo = {
-                    .sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO,
-                    .viewportCount = 1,
-                    .pViewports = &dummyViewport,
-                    .scissorCount = 1,
-                    .pScissors = &dummyScissor
-                };
-
-                const uint32_t sampleCount = static_cast<uint32_t>(_pipelineDesc.multisampleDesc.rasterizationSamples);
-                const uint32_t neededMaskCount = (sampleCount + 31u) / 32u;
-                if (neededMaskCount > static_cast<uint32_t>(_pipelineDesc.multisampleDesc.sampleMask.size())) {
-                    MARK_FATAL(Utils::Category::Vulkan, "multisampleDesc.sampleMask only supports up to 64 samples");
-                }
-                VkPipelineMultisampleStateCreateInfo multisampleInfo = {
-                    .sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO,
-                    .rasterizationSamples = _pipelineDesc.multisampleDesc.rasterizationSamples,
-                    .sampleShadingEnable = _pipelineDesc.multisampleDesc.sampleShadingEnable ? VK_TRUE : VK_FALSE,
-                    .minSampleShading = _pipelineDesc.multisampleDesc.minSampleShading,
-                    .pSampleMask = _pipelineDesc.multisampleDesc.sampleMask.data(),
-                    .alphaToCoverageEnable = _pipelineDesc.multisampleDesc.alphaToCoverageEnable ? VK_TRUE : VK_FALSE,
-                    .alphaToOneEnable = _pipelineDesc.multisampleDesc.alphaToOneEnable ? VK_TRUE : VK_FALSE
-                };
-
-                VkPipelineDepthStencilStateCreateInfo depthStencilCreateInfo = {
-                    .sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO,
-                    .depthTestEnable = _pipelineDesc.depthStencilDesc.depthTestEnable ? VK_TRUE : VK_FALSE,
-                    .depthWriteEnable = _pipelineDesc.depthStencilDesc.depthWriteEnable ? VK_TRUE : VK_FALSE,
-                    .depthCompareOp = _pipelineDesc.depthStencilDesc.depthCompareOp,
-                    .depthBoundsTestEnable = _pipelineDesc.depthStencilDesc.depthBoundsTestEnable ? VK_TRUE : VK_FALSE,
-                    .stencilTestEnable = _pipelineDesc.depthStencilDesc.stencilTestEnable ? VK_TRUE : VK_FALSE,
-                    .front = _pipelineDesc.depthStencilDesc.front,
-                    .back = _pipelineDesc.depthStencilDesc.back,
-                    .minDepthBounds = _pipelineDesc.depthStencilDesc.minDepthBounds,
-                    .maxDepthBounds = _pipelineDesc.depthStencilDesc.maxDepthBounds
-                };
-
-                // Blend attachments must match colour attachment count
-                const uint32_t colourCount = static_cast<uint32_t>(_pipelineDesc.renderTargetsDesc.colourFormats.size());
-                std::vector<PipelineBlendAttachmentDesc> blendIn = _pipelineDesc.blendDesc.attachments;
-                if (blendIn.empty()) {
-                    blendIn.resize(colourCount); // Defaults are opaque as enable=false by default
-                }
-                else if (blendIn.size() == 1 && colourCount > 1) {
-                    blendIn.resize(colourCount, blendIn[0]);
-                }
-                else if (blendIn.size() != colourCount) {
-                    MARK_FATAL(Utils::Category::Vulkan, "PipelineDesc.blendDesc.attachments size must be 0, 1, or equal to renderTargetsDesc.colourFormats size.");
-                }
-                
-                std::vector<VkPipelineColorBlendAttachmentState> blendAttachments;
-                blendAttachments.reserve(blendIn.size());
-                for (const auto& attachment : blendIn)
-                {
-                    VkPipelineColorBlendAttachmentState out = {
-                        .blendEnable = attachment.enable ? VK_TRUE : VK_FALSE,
-                        .srcColorBlendFactor = attachment.srcColour,
-                        .dstColorBlendFactor = attachment.dstColour,
-                        .colorBlendOp = attachment.colourOp,
-                        .srcAlphaBlendFactor = attachment.srcAlpha,
-                        .dstAlphaBlendFactor = attachment.dstAlpha,
-                        .alphaBlendOp = attachment.alphaOp,
-                        .colorWriteMask = attachment.colorWriteMask
-                    };
-
-                    blendAttachments.push_back(out);
-                }
-
-                VkPipelineColorBlendStateCreateInfo colorBlendCreateInfo = {
-                    .sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO,
-                    .logicOpEnable = _pipelineDesc.blendDesc.logicOpEnable ? VK_TRUE : VK_FALSE,
-                    .logicOp = _pipelineDesc.blendDesc.logicOp,
-                    .attachmentCount = static_cast<uint32_t>(blendAttachments.size()),
-                    .pAttachments = blendAttachments.data()
-                };
-                colorBlendCreateInfo.blendConstants[0] = _pipelineDesc.blendDesc.blendConstants[0];
-                colorBlendCreateInfo.blendConstants[1] = _pipelineDesc.blendDesc.blendConstants[1];
-                colorBlendCreateInfo.blendConstants[2] = _pipelineDesc.blendDesc.blendConstants[2];
-                colorBlendCreateInfo.blendConstants[3] = _pipelineDesc.blendDesc.blendConstants[3];
-
-
-                VkPipelineRenderingCreateInfo renderingInfo{
-                    .sType = VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO,
-                    .pNext = nullptr,
-                    .viewMask = _pipelineDesc.renderTargetsDesc.viewMask,
-                    .colorAttachmentCount = static_cast<uint32_t>(_pipelineDesc.renderTargetsDesc.colourFormats.size()),
-                    .pColorAttachmentFormats = _pipelineDesc.renderTargetsDesc.colourFormats.data(),
-                    .depthAttachmentFormat = _pipelineDesc.renderTargetsDesc.depthFormat,
-                    .stencilAttachmentFormat = _pipelineDesc.renderTargetsDesc.stencilFormat
-                };
-
-                VkPipelineTessellationStateCreateInfo tessInfo = {
-                    .sType = VK_STRUCTURE_TYPE_PIPELINE_TESSELLATION_STATE_CREATE_INFO,
-                    .patchControlPoints = _pipelineDesc.inputAssemblyDesc.patchControlPoints
-                };
-                const bool useTess = (_pipelineDesc.inputAssemblyDesc.topology == VK_PRIMITIVE_TOPOLOGY_PATCH_LIST) &&
-                                     (_pipelineDesc.inputAssemblyDesc.patchControlPoints > 0);
-
-                VkGraphicsPipelineCreateInfo pipelineCreateInfo = {
-                    .sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO,
-                    .pNext = &renderingInfo,
-                    .stageCount = ARRAY_COUNT(shaderStageCreateInfo),
-                    .pStages = &shaderStageCreateInfo[0],
-                    .pVertexInputState = &vertexInputCreateInfo,
-                    .pInputAssemblyState = &inputAssemblyCreateInfo,
-                    .pTessellationState = useTess ? &tessInfo : nullptr,
-                    .pViewportState = &viewportCreateInfo,
-                    .pRasterizationState = &rasterizeCreateInfo,
-                    .pMultisampleState = &multisampleInfo,
-                    .pDepthStencilState = &depthStencilCreateInfo,
-                    .pColorBlendState = &colorBlendCreateInfo,
-                    .pDynamicState = &dynamicStateCreateInfo,
-                    .layout = layout,
-                    .renderPass = VK_NULL_HANDLE,
-                    .subpass = 0,
-                    .basePipelineHandle = VK_NULL_HANDLE,
-                    .basePipelineIndex = -1
-                };
-
-                GraphicsPipelineCreateResult out{};
-                res = vkCreateGraphicsPipelines(_pipelineDesc.device, VK_NULL_HANDLE, 1, &pipelineCreateInfo, nullptr, &out.m_pipeline);
-                CHECK_VK_RESULT(res, "Create Graphics Pipeline");
-                MARK_VK_NAME(_pipelineDesc.device, VK_OBJECT_TYPE_PIPELINE, out.m_pipeline, ("VulkanPipeline." + _pipelineDesc.debugName + ".GraphicsPipe").c_str());
-
-                out.m_layout = layout;
-                return out;
-            });
+            [&](const VulkanGraphicsPipelineKey&) { return createPipelineObjects(_pipelineDesc, m_set0Layout, m_set0LayoutHash); });
 
         if (!m_cachedRef) {
             MARK_FATAL(Utils::Category::Vulkan, "Failed to create/acquire graphics pipeline");
@@ -271,6 +657,7 @@ namespace Mark::RendererVK
 
         // Keep convenience handle for existing callers
         m_pipelineLayout = m_cachedRef.layout();
+        m_fallback = nullptr;
         MARK_INFO(Utils::Category::Vulkan, "Vulkan Graphics Pipeline Created");
     }
 } // namespace Mark::RendererVK
\ No newline at end of file
@@ -11,19 +11,56 @@ namespace Mark::RendererVK
         VulkanGraphicsPipeline& operator=(const VulkanGraphicsPipeline&) = delete;
 
         void createGraphicsPipeline(const PipelineDesc& _pipelineDesc);
+        // Queues the compile on the cache workers and returns immediately. Until poll() reports ready the
+        // fallback is bound in its place, or draws are skipped when there is none. Fallback must share set 0
+        void createGraphicsPipelineAsync(const PipelineDesc& _pipelineDesc, const VulkanGraphicsPipeline* _fallback = nullptr);
         void destroyGraphicsPipeline();
 
-        void bindPipeline(VkCommandBuffer _cmdBuffer);
+        // Queues a background compile with no owner so a later acquire of the same key finds it ready
+        static void prewarm(const PipelineDesc& _pipelineDesc, VkDescriptorSetLayout _set0Layout, uint64_t _set0LayoutHash);
+
+        // Returns false when nothing could be bound, callers skip their draws
+        // Dynamic state groups the desc marked are emitted right after the bind
+        bool bindPipeline(VkCommandBuffer _cmdBuffer) const;
+
+        // True on the call where the bound handle changes (pending compile finished, or a fast-linked
+        // pipeline got its optimised link). Pre-recorded command buffers need re-recording
+        bool poll();
+        bool isPending() const noexcept { return m_cachedRef.isPending(); }
 
         // Provided by a resource set
         void setResourceLayout(VkDescriptorSetLayout _set0Layout, uint64_t _set0LayoutHash);
 
-        VkPipelineLayout pipelineLayout() const noexcept { return m_pipelineLayout; }
+        VkPipelineLayout pipelineLayout() const noexcept;
         bool isValid() const noexcept { return m_cachedRef.get() != VK_NULL_HANDLE; }
 
     private:
+        // Values for the dynamic groups, so pipelines sharing one VkPipeline still render with their own state
+        struct DynamicRenderState
+        {
+            bool depth{ false };
+            VkBool32 depthTestEnable{ VK_TRUE };
+            VkBool32 depthWriteEnable{ VK_TRUE };
+            VkCompareOp depthCompareOp{ VK_COMPARE_OP_LESS };
+
+            bool cull{ false };
+            VkCullModeFlags cullMode{ VK_CULL_MODE_BACK_BIT };
+            VkFrontFace frontFace{ VK_FRONT_FACE_CLOCKWISE };
+
+            bool blend{ false };
+            std::vector<VkBool32> blendEnables;
+            std::vector<VkColorBlendEquationEXT> blendEquations;
+            std::vector<VkColorComponentFlags> writeMasks;
+        };
+
+        VulkanGraphicsPipelineKey prepareKey(const PipelineDesc& _pipelineDesc);
+        void captureDynamicState(const PipelineDesc& _pipelineDesc);
+        void applyDynamicState(VkCommandBuffer _cmdBuffer) const;
+
         VulkanGraphicsPipelineRef m_cachedRef{};
         VkPipelineLayout m_pipelineLayout{ VK_NULL_HANDLE };
+        const VulkanGraphicsPipeline* m_fallback{ nullptr };
+        DynamicRenderState m_dynamicState{};
 
         // External resource layout (set 0) provided by VulkanBindlessResourceSet
         VkDescriptorSetLayout m_set0Layout{ VK_NULL_HANDLE };
@@ -1,20 +1,25 @@
 #include "Mark_GraphicsPipelineCache.h"
+#include "Mark_Shader.h"
 #include "Utils/Mark_Utils.h"
 
+#include <algorithm>
+#include <chrono>
+
 namespace Mark::RendererVK
 {
     // ---------- VulkanGraphicsPipelineRef ----------
     VulkanGraphicsPipelineRef& VulkanGraphicsPipelineRef::operator=(VulkanGraphicsPipelineRef&& _rhs) noexcept
     {
         if (this == &_rhs) return *this;
-        // release current
-        if (m_cache && m_pipeline)
+        // release current, pending refs hold a count too
+        if (m_cache)
             m_cache->release(m_key);
 
         m_cache = _rhs.m_cache;   
         m_key = _rhs.m_key;
         m_pipeline = _rhs.m_pipeline; 
         m_layout = _rhs.m_layout;  
+        m_final = _rhs.m_final;
 
         _rhs.m_cache = nullptr;
         _rhs.m_pipeline = VK_NULL_HANDLE;
@@ -24,89 +29,491 @@ namespace Mark::RendererVK
 
     VulkanGraphicsPipelineRef::~VulkanGraphicsPipelineRef()
     {
-        if (m_cache && m_pipeline)
+        if (m_cache)
             m_cache->release(m_key);
         m_cache = nullptr;
         m_pipeline = VK_NULL_HANDLE;
         m_layout = VK_NULL_HANDLE;
     }
 
+    bool VulkanGraphicsPipelineRef::poll()
+    {
+        if (m_pipeline != VK_NULL_HANDLE) return true;
+        if (!m_cache) return false;
+        return m_cache->tryResolve(m_key, m_pipeline, m_layout, m_final);
+    }
+
+    bool VulkanGraphicsPipelineRef::refresh()
+    {
+        if (!m_cache || m_final) return false;
+
+        VkPipeline pipeline = VK_NULL_HANDLE;
+        VkPipelineLayout layout = VK_NULL_HANDLE;
+        if (!m_cache->tryResolve(m_key, pipeline, layout, m_final) || pipeline == m_pipeline) {
+            return false;
+        }
+
+        m_pipeline = pipeline;
+        m_layout = layout;
+        return true;
+    }
+
     // ---------- VulkanGraphicsPipelineCache ----------
+    namespace
+    {
+        double elapsedMs(std::chrono::steady_clock::time_point _start)
+        {
+            return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - _start).count();
+        }
+    }
+
+    VulkanGraphicsPipelineKey VulkanGraphicsPipelineCache::makeKey(const PipelineDesc& _desc, uint64_t _setLayoutHash)
+    {
+        PackedPipelineState packed;
+        PackPipelineState(_desc, _setLayoutHash, packed);
+        return m_keys.intern(packed);
+    }
+
+    VulkanGraphicsPipelineCache::Entry* VulkanGraphicsPipelineCache::findLocked(const VulkanGraphicsPipelineKey& _key)
+    {
+        if (_key.m_id >= m_entries.size()) return nullptr;
+        Entry& e = m_entries[_key.m_id];
+        return e.m_state == EntryState::Empty ? nullptr : &e;
+    }
+
+    VulkanGraphicsPipelineCache::Entry& VulkanGraphicsPipelineCache::emplaceLocked(const VulkanGraphicsPipelineKey& _key)
+    {
+        if (_key.m_id >= m_entries.size()) {
+            m_entries.resize(static_cast<size_t>(_key.m_id) + 1);
+        }
+        Entry& e = m_entries[_key.m_id];
+        e = Entry{ .m_refCount = 1, .m_state = EntryState::Pending };
+        m_liveCount++;
+        return e;
+    }
+
+    void VulkanGraphicsPipelineCache::reserveLocked(const VulkanGraphicsPipelineKey& _key)
+    {
+        if (Entry* failed = findLocked(_key))
+        {
+            // Retry in place, refs still holding the failed entry keep their count and pick up this compile's result
+            failed->m_state = EntryState::Pending;
+            failed->m_refCount++;
+        }
+        else {
+            emplaceLocked(_key);
+        }
+        m_pendingCount++;
+        m_stats.misses++;
+    }
+
     VulkanGraphicsPipelineRef VulkanGraphicsPipelineCache::acquire(const VulkanGraphicsPipelineKey& _key, const CreateFn& _creator)
     {
-        std::lock_guard<std::mutex> lk(m_mutex);
+        if (!_key.isValid()) return VulkanGraphicsPipelineRef{};
+        std::unique_lock<std::mutex> lk(m_mutex);
+
+        // Someone else is compiling this key, share their result instead of compiling twice
+        m_resolvedCv.wait(lk, [&] {
+            const Entry* pending = findLocked(_key);
+            return !pending || pending->m_state != EntryState::Pending;
+        });
 
-        auto it = m_map.find(_key);
-        if (it != m_map.end())
+        if (Entry* e = findLocked(_key); e && e->m_state == EntryState::Ready)
         {
-            it->second.m_refCount++;
-            MARK_INFO(Utils::Category::Vulkan, "Graphics-Pipeline-Cache reuse: refs=%u (entries=%zu)",
-                it->second.m_refCount, m_map.size());
-            return VulkanGraphicsPipelineRef(this, _key, it->second.m_pipeline, it->second.m_layout);
+            e->m_refCount++;
+            e->m_lastUsedFrame = m_frame;
+            e->m_prewarmed = false;
+            m_stats.hits++;
+            MARK_DEBUG(Utils::Category::Vulkan, "Graphics-Pipeline-Cache reuse: refs=%u (entries=%zu)",
+                e->m_refCount, m_liveCount);
+            return VulkanGraphicsPipelineRef(this, _key, e->m_pipeline, e->m_layout);
         }
 
+        // Reserve the key so concurrent callers wait on this compile, then create without the lock
+        reserveLocked(_key);
+        lk.unlock();
+
+        const auto start = std::chrono::steady_clock::now();
         GraphicsPipelineCreateResult cr = _creator(_key);
-        if (!cr.m_pipeline || !cr.m_layout)
+        const double ms = elapsedMs(start);
+
+        lk.lock();
+        m_stats.creationMs += ms;
+        resolveLocked(_key, std::move(cr));
+        // Never reuse an entry reference from before the unlock, look it up again
+        Entry* e = findLocked(_key);
+        if (!e) return VulkanGraphicsPipelineRef{};
+        if (e->m_state != EntryState::Ready) {
+            dropRefLocked(*e);
+            return VulkanGraphicsPipelineRef{};
+        }
+
+        MARK_INFO(Utils::Category::Vulkan, "Graphics Pipeline Cached: entries=%zu", m_liveCount);
+        return VulkanGraphicsPipelineRef(this, _key, e->m_pipeline, e->m_layout);
+    }
+
+    VulkanGraphicsPipelineRef VulkanGraphicsPipelineCache::acquireAsync(const VulkanGraphicsPipelineKey& _key, CreateFn _creator)
+    {
+        if (!_key.isValid()) return VulkanGraphicsPipelineRef{};
+        {
+            std::lock_guard<std::mutex> lk(m_mutex);
+
+            if (Entry* e = findLocked(_key); e && e->m_state != EntryState::Failed)
+            {
+                // Ready or already in flight, either way no new compile. Pending handles are null until poll()
+                e->m_refCount++;
+                e->m_lastUsedFrame = m_frame;
+                e->m_prewarmed = false;
+                m_stats.hits++;
+                return VulkanGraphicsPipelineRef(this, _key, e->m_pipeline, e->m_layout);
+            }
+
+            reserveLocked(_key);
+        }
+
+        queueCompile(_key, std::move(_creator));
+        return VulkanGraphicsPipelineRef(this, _key, VK_NULL_HANDLE, VK_NULL_HANDLE);
+    }
+
+    void VulkanGraphicsPipelineCache::prewarm(const VulkanGraphicsPipelineKey& _key, CreateFn _creator)
+    {
+        if (!_key.isValid()) return;
+        {
+            std::lock_guard<std::mutex> lk(m_mutex);
+
+            // Already live or in flight, nothing to warm
+            if (Entry* e = findLocked(_key); e && e->m_state != EntryState::Failed) return;
+
+            reserveLocked(_key);
+            Entry& e = *findLocked(_key);
+            e.m_refCount--; // Nobody holds it yet
+            e.m_prewarmed = true;
+        }
+
+        queueCompile(_key, std::move(_creator));
+    }
+
+    void VulkanGraphicsPipelineCache::queueCompile(const VulkanGraphicsPipelineKey& _key, CreateFn _creator)
+    {
+        queueJob([this, _key, creator = std::move(_creator)]()
+        {
+            const auto start = std::chrono::steady_clock::now();
+            GraphicsPipelineCreateResult cr = creator(_key);
+            const double ms = elapsedMs(start);
+
+            std::lock_guard<std::mutex> lk(m_mutex);
+            m_stats.creationMs += ms;
+            resolveLocked(_key, std::move(cr));
+        });
+
+        MARK_DEBUG(Utils::Category::Vulkan, "Graphics pipeline compile queued (pending=%u)", pendingCount());
+    }
+
+    void VulkanGraphicsPipelineCache::resolveLocked(const VulkanGraphicsPipelineKey& _key, GraphicsPipelineCreateResult _result)
+    {
+        Entry* found = findLocked(_key);
+        if (!found) return;
+
+        Entry& e = *found;
+        if (!_result.m_pipeline || !_result.m_layout)
         {
             MARK_ERROR(Utils::Category::Vulkan, "Pipeline creator returned null handles");
-            return VulkanGraphicsPipelineRef{};
+            if (_result.m_pipeline) vkDestroyPipeline(m_device, _result.m_pipeline, nullptr);
+            if (_result.m_layout && _result.m_ownsLayout) vkDestroyPipelineLayout(m_device, _result.m_layout, nullptr);
+            m_stats.failures++;
+
+            // Erased once unreferenced so the next acquire compiles again. Refs already handed out keep it (and stay pending)
+            // until they go, an acquire in the meantime retries it in place
+            e.m_state = EntryState::Failed;
+            if (e.m_refCount == 0) {
+                eraseLocked(e);
+            }
+        }
+        else
+        {
+            e.m_pipeline = _result.m_pipeline;
+            e.m_layout = _result.m_layout;
+            e.m_ownsLayout = _result.m_ownsLayout;
+            e.m_state = EntryState::Ready;
+            if (_result.m_upgrade) {
+                queueUpgradeLocked(_key, std::move(_result.m_upgrade));
+            }
+        }
+
+        m_pendingCount--;
+        m_resolvedCv.notify_all();
+    }
+
+    void VulkanGraphicsPipelineCache::queueUpgradeLocked(const VulkanGraphicsPipelineKey& _key, std::function<VkPipeline()> _upgrade)
+    {
+        findLocked(_key)->m_upgradePending = true;
+        m_pendingCount++;
+
+        queueJob([this, _key, upgrade = std::move(_upgrade)]()
+        {
+            VkPipeline optimised = upgrade();
+
+            std::lock_guard<std::mutex> lk(m_mutex);
+            Entry* found = findLocked(_key);
+            if (!found)
+            {
+                // Purged while the link was running
+                if (optimised) vkDestroyPipeline(m_device, optimised, nullptr);
+            }
+            else
+            {
+                Entry& e = *found;
+                e.m_upgradePending = false;
+                if (optimised)
+                {
+                    if (e.m_superseded) vkDestroyPipeline(m_device, e.m_superseded, nullptr);
+                    e.m_superseded = e.m_pipeline;
+                    e.m_pipeline = optimised;
+                }
+            }
+
+            m_pendingCount--;
+            m_resolvedCv.notify_all();
+        });
+    }
+
+    void VulkanGraphicsPipelineCache::queueJob(std::function<void()> _job)
+    {
+        {
+            std::lock_guard<std::mutex> jobLk(m_jobMutex);
+            startWorkersLocked();
+            m_jobs.emplace_back(std::move(_job));
         }
+        m_jobCv.notify_one();
+    }
 
-        Entry e;
-        e.m_pipeline = cr.m_pipeline;
-        e.m_layout = cr.m_layout;
-        e.m_refCount = 1;
-        auto [insIt, _] = m_map.emplace(_key, e);
+    bool VulkanGraphicsPipelineCache::tryResolve(const VulkanGraphicsPipelineKey& _key, VkPipeline& _outPipeline, VkPipelineLayout& _outLayout, bool& _outFinal)
+    {
+        std::lock_guard<std::mutex> lk(m_mutex);
+        const Entry* e = findLocked(_key);
+        if (!e || e->m_state != EntryState::Ready) {
+            return false;
+        }
+
+        _outPipeline = e->m_pipeline;
+        _outLayout = e->m_layout;
+        _outFinal = !e->m_upgradePending;
+        return true;
+    }
+
+    void VulkanGraphicsPipelineCache::waitForPending()
+    {
+        std::unique_lock<std::mutex> lk(m_mutex);
+        m_resolvedCv.wait(lk, [&] { return m_pendingCount == 0; });
+    }
+
+    void VulkanGraphicsPipelineCache::startWorkersLocked()
+    {
+        if (!m_workers.empty()) return;
 
-        MARK_INFO(Utils::Category::Vulkan, "Graphics Pipeline Cached: entries=%zu", m_map.size());
-        return VulkanGraphicsPipelineRef(this, _key, insIt->second.m_pipeline, insIt->second.m_layout);
+        // Leave the frame thread and the rest of the engine some headroom
+        const uint32_t hw = std::max(1u, std::thread::hardware_concurrency());
+        const uint32_t count = std::clamp(hw / 2, 1u, 4u);
+
+        m_stopWorkers = false;
+        m_workers.reserve(count);
+        for (uint32_t i = 0; i < count; i++) {
+            m_workers.emplace_back([this] { workerLoop(); });
+        }
+        MARK_INFO(Utils::Category::Vulkan, "Graphics pipeline compile workers started: %u", count);
+    }
+
+    void VulkanGraphicsPipelineCache::workerLoop()
+    {
+        for (;;)
+        {
+            std::function<void()> job;
+            {
+                std::unique_lock<std::mutex> jobLk(m_jobMutex);
+                m_jobCv.wait(jobLk, [&] { return m_stopWorkers || !m_jobs.empty(); });
+                // Drain the queue before exiting so no pending entry is left unresolved
+                if (m_jobs.empty()) return;
+                job = std::move(m_jobs.front());
+                m_jobs.pop_front();
+            }
+            job();
+        }
+    }
+
+    void VulkanGraphicsPipelineCache::stopWorkers()
+    {
+        {
+            std::lock_guard<std::mutex> jobLk(m_jobMutex);
+            m_stopWorkers = true;
+        }
+        m_jobCv.notify_all();
+
+        for (auto& worker : m_workers) {
+            if (worker.joinable()) worker.join();
+        }
+        m_workers.clear();
     }
 
     void VulkanGraphicsPipelineCache::release(const VulkanGraphicsPipelineKey& _key)
     {
         std::lock_guard<std::mutex> lk(m_mutex);
-        auto it = m_map.find(_key);
-        if (it == m_map.end()) return;
+        Entry* e = findLocked(_key);
+        if (!e) return;
 
-        if (it->second.m_refCount == 0)
+        if (e->m_refCount == 0)
         {
             MARK_WARN(Utils::Category::Vulkan, "Graphics pipeline cache: release on zero refCount");
             return;
         }
 
-        it->second.m_refCount--;
+        dropRefLocked(*e);
+    }
+
+    void VulkanGraphicsPipelineCache::dropRefLocked(Entry& _entry)
+    {
+        if (--_entry.m_refCount != 0) return;
+
+        if (_entry.m_state == EntryState::Failed) {
+            eraseLocked(_entry);
+        }
+        else {
+            _entry.m_lastUsedFrame = m_frame;
+        }
+    }
+
+    void VulkanGraphicsPipelineCache::eraseLocked(Entry& _entry)
+    {
+        // A failed entry owns no handles
+        _entry = {};
+        m_liveCount--;
     }
 
     void VulkanGraphicsPipelineCache::destroyAll()
     {
+        // Workers may still be writing into the entries
+        stopWorkers();
+
         std::lock_guard<std::mutex> lk(m_mutex);
-        for (auto& [k, e] : m_map)
+        for (Entry& e : m_entries) {
+            if (e.m_state != EntryState::Empty) destroyEntry(e);
+        }
+        m_entries.clear();
+        m_liveCount = 0;
+
+        // Caller has idled the device, nothing retired can still be in flight
+        for (const RetiredEntry& r : m_retired)
         {
-            if (e.m_pipeline)
-                vkDestroyPipeline(m_device, e.m_pipeline, nullptr);
-            if (e.m_layout)
-                vkDestroyPipelineLayout(m_device, e.m_layout, nullptr);
+            if (r.m_pipeline) vkDestroyPipeline(m_device, r.m_pipeline, nullptr);
+            if (r.m_superseded) vkDestroyPipeline(m_device, r.m_superseded, nullptr);
+            if (r.m_layout) vkDestroyPipelineLayout(m_device, r.m_layout, nullptr);
         }
-        m_map.clear();
+        m_retired.clear();
+
+        // Linked pipelines are gone, the part libraries and shared layouts can follow
+        m_libraries.destroy();
+    }
+
+    void VulkanGraphicsPipelineCache::destroyEntry(Entry& _entry)
+    {
+        if (_entry.m_pipeline)
+            vkDestroyPipeline(m_device, _entry.m_pipeline, nullptr);
+        if (_entry.m_superseded)
+            vkDestroyPipeline(m_device, _entry.m_superseded, nullptr);
+        if (_entry.m_layout && _entry.m_ownsLayout)
+            vkDestroyPipelineLayout(m_device, _entry.m_layout, nullptr);
+        _entry = {};
+    }
+
+    void VulkanGraphicsPipelineCache::retireLocked(Entry& _entry)
+    {
+        m_retired.push_back(RetiredEntry{
+            .m_pipeline = _entry.m_pipeline,
+            .m_superseded = _entry.m_superseded,
+            .m_layout = _entry.m_ownsLayout ? _entry.m_layout : VK_NULL_HANDLE,
+            .m_destroyFrame = m_frame + m_policy.retireFrames
+        });
+        _entry = {};
+        m_liveCount--;
+        m_stats.evictions++;
+    }
+
+    bool VulkanGraphicsPipelineCache::isEvictableLocked(const Entry& _entry) const
+    {
+        // Pending entries have a worker writing into them, upgrading ones will swap their pipeline
+        return _entry.m_refCount == 0 && !_entry.m_upgradePending &&
+            (_entry.m_state == EntryState::Ready || _entry.m_state == EntryState::Failed);
     }
 
     void VulkanGraphicsPipelineCache::purgeUnused()
     {
         std::lock_guard<std::mutex> lk(m_mutex);
-        for (auto it = m_map.begin(); it != m_map.end(); )
+        for (Entry& e : m_entries)
         {
-            if (it->second.m_refCount == 0)
+            if (isEvictableLocked(e)) {
+                retireLocked(e);
+            }
+        }
+    }
+
+    void VulkanGraphicsPipelineCache::enablePipelineLibrary(bool _fastLinking, VulkanShaderCache* _shaderCache)
+    {
+        m_libraries.create(m_device, _fastLinking, _shaderCache);
+        if (_shaderCache) {
+            _shaderCache->setModuleDestroyedCallback([this](uint64_t _identity) { m_libraries.releaseShader(_identity); });
+        }
+    }
+
+    void VulkanGraphicsPipelineCache::update()
+    {
+        std::lock_guard<std::mutex> lk(m_mutex);
+        m_frame++;
+
+        // Compile and upgrade jobs hold part handles until they link, none are running while nothing is pending
+        if (m_pendingCount == 0) {
+            m_libraries.destroyRetiredParts();
+        }
+
+        while (!m_retired.empty() && m_retired.front().m_destroyFrame <= m_frame)
+        {
+            const RetiredEntry& r = m_retired.front();
+            if (r.m_pipeline) vkDestroyPipeline(m_device, r.m_pipeline, nullptr);
+            if (r.m_superseded) vkDestroyPipeline(m_device, r.m_superseded, nullptr);
+            if (r.m_layout) vkDestroyPipelineLayout(m_device, r.m_layout, nullptr);
+            m_retired.pop_front();
+        }
+
+        if (m_policy.idleFrames != 0 && m_frame > m_policy.idleFrames)
+        {
+            const uint64_t idleBefore = m_frame - m_policy.idleFrames;
+            for (Entry& e : m_entries)
             {
-                if (it->second.m_pipeline)
-                    vkDestroyPipeline(m_device, it->second.m_pipeline, nullptr);
-                if (it->second.m_layout)
-                    vkDestroyPipelineLayout(m_device, it->second.m_layout, nullptr);
-                it = m_map.erase(it);
+                if (isEvictableLocked(e) && !e.m_prewarmed && e.m_lastUsedFrame <= idleBefore) {
+                    retireLocked(e);
+                }
             }
-            else
+        }
+
+        // Over budget, oldest unreferenced first. Referenced and prewarmed entries stay even if that keeps us over
+        while (m_liveCount > m_policy.maxEntries)
+        {
+            Entry* oldest = nullptr;
+            for (Entry& e : m_entries)
             {
-                ++it;
+                if (isEvictableLocked(e) && !e.m_prewarmed && (!oldest || e.m_lastUsedFrame < oldest->m_lastUsedFrame)) {
+                    oldest = &e;
+                }
             }
+            if (!oldest) break;
+            retireLocked(*oldest);
         }
     }
-} // namespace Mark::RendererVK
\ No newline at end of file
+
+    GraphicsPipelineCacheStats VulkanGraphicsPipelineCache::stats() const
+    {
+        std::lock_guard<std::mutex> lk(m_mutex);
+        GraphicsPipelineCacheStats out = m_stats;
+        out.entries = m_liveCount;
+        out.retired = m_retired.size();
+        return out;
+    }
+} // namespace Mark::RendererVK
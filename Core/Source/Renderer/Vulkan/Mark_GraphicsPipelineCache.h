@@ -1,212 +1,30 @@
 #pragma once
 #include "Mark_PipelineDescription.h"
+#include "Mark_PipelineDiskCache.h"
+#include "Mark_PipelineManifest.h"
+#include "Mark_PipelineLibrary.h"
+#include "Mark_PipelineKey.h"
 
 #include <volk.h>
-#include <unordered_map>
 #include <functional>
 #include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <deque>
 #include <cstdint>
 #include <vector>
-#include <algorithm>
-#include <bit>
 
 namespace Mark::RendererVK
 {
-    struct PipelineStateHash128
-    {
-        uint64_t a{ 0 };
-        uint64_t b{ 0 };
-        bool operator==(const PipelineStateHash128& o) const noexcept {return a == o.a && b == o.b; }
-    };
-
-    // FNV-1a mixing into 64-bit state
-    static inline void HashMix64(uint64_t& h, uint64_t v) noexcept
-    {
-        constexpr uint64_t kPrime = 1099511628211ull; // FNV-1a constant
-        h ^= v;
-        h *= kPrime;
-    }
-
-    static inline uint64_t HashFloat(float f) noexcept
-    {
-        return static_cast<uint64_t>(std::bit_cast<uint32_t>(f)); // Hash bit-pattern
-    }
-
-    static inline void HashStencilOpState(uint64_t& h, const VkStencilOpState& s) noexcept
-    {
-        HashMix64(h, static_cast<uint64_t>(s.failOp));
-        HashMix64(h, static_cast<uint64_t>(s.passOp));
-        HashMix64(h, static_cast<uint64_t>(s.depthFailOp));
-        HashMix64(h, static_cast<uint64_t>(s.compareOp));
-        HashMix64(h, static_cast<uint64_t>(s.compareMask));
-        HashMix64(h, static_cast<uint64_t>(s.writeMask));
-        HashMix64(h, static_cast<uint64_t>(s.reference));
-    }
-
-    // Builds a normalized 128-bit hash from PipelineDesc contents
-    static inline PipelineStateHash128 HashPipelineDescState(const PipelineDesc& d)
-    {
-        // Two different seeds to produce two independent 64-bit hashes.
-        uint64_t ha = 1469598103934665603ull;
-        uint64_t hb = 1099511628211ull ^ 0x9E3779B97F4A7C15ull;
-
-        auto mixA = [&](uint64_t v) { HashMix64(ha, v); };
-        auto mixB = [&](uint64_t v) { HashMix64(hb, v ^ 0xD6E8FEB86659FD93ull); };
-        auto mix = [&](uint64_t v) { mixA(v); mixB(v); };
-
-        // Shaders
-        mix(static_cast<uint64_t>(reinterpret_cast<uintptr_t>(d.vertexShader)));
-        mix(static_cast<uint64_t>(reinterpret_cast<uintptr_t>(d.fragmentShader)));
-
-        // Render target formats
-        mix(static_cast<uint64_t>(d.renderTargetsDesc.viewMask));
-        mix(static_cast<uint64_t>(d.renderTargetsDesc.depthFormat));
-        mix(static_cast<uint64_t>(d.renderTargetsDesc.stencilFormat));
-
-        mix(static_cast<uint64_t>(d.renderTargetsDesc.colourFormats.size()));
-        for (VkFormat f : d.renderTargetsDesc.colourFormats) {
-            mix(static_cast<uint64_t>(f));
-        }
-
-        const uint32_t colourCount = static_cast<uint32_t>(d.renderTargetsDesc.colourFormats.size());
-
-        // Input assembly + tess
-        mix(static_cast<uint64_t>(d.inputAssemblyDesc.topology));
-        mix(static_cast<uint64_t>(d.inputAssemblyDesc.primitiveRestartEnable ? 1u : 0u));
-        mix(static_cast<uint64_t>(d.inputAssemblyDesc.patchControlPoints));
-
-        // Raster
-        mix(static_cast<uint64_t>(d.rasterDesc.polygonMode));
-        mix(static_cast<uint64_t>(d.rasterDesc.cullMode));
-        mix(static_cast<uint64_t>(d.rasterDesc.frontFace));
-        mix(static_cast<uint64_t>(d.rasterDesc.depthClampEnable ? 1u : 0u));
-        mix(static_cast<uint64_t>(d.rasterDesc.rasterizerDiscardEnable ? 1u : 0u));
-
-        mix(static_cast<uint64_t>(d.rasterDesc.depthBiasEnable ? 1u : 0u));
-        mix(HashFloat(d.rasterDesc.depthBiasConstantFactor));
-        mix(HashFloat(d.rasterDesc.depthBiasClamp));
-        mix(HashFloat(d.rasterDesc.depthBiasSlopeFactor));
-        mix(HashFloat(d.rasterDesc.lineWidth));
-
-        // Multisample
-        mix(static_cast<uint64_t>(d.multisampleDesc.rasterizationSamples));
-        mix(static_cast<uint64_t>(d.multisampleDesc.sampleShadingEnable ? 1u : 0u));
-        mix(HashFloat(d.multisampleDesc.minSampleShading));
-        mix(static_cast<uint64_t>(d.multisampleDesc.alphaToCoverageEnable ? 1u : 0u));
-        mix(static_cast<uint64_t>(d.multisampleDesc.alphaToOneEnable ? 1u : 0u));
-
-        // Sample mask array contents
-        mix(static_cast<uint64_t>(d.multisampleDesc.sampleMask.size()));
-        for (auto m : d.multisampleDesc.sampleMask) {
-            mix(static_cast<uint64_t>(m));
-        }
-
-        // Depth/stencil
-        mix(static_cast<uint64_t>(d.depthStencilDesc.depthTestEnable ? 1u : 0u));
-        mix(static_cast<uint64_t>(d.depthStencilDesc.depthWriteEnable ? 1u : 0u));
-        mix(static_cast<uint64_t>(d.depthStencilDesc.depthCompareOp));
-        mix(static_cast<uint64_t>(d.depthStencilDesc.depthBoundsTestEnable ? 1u : 0u));
-        mix(HashFloat(d.depthStencilDesc.minDepthBounds));
-        mix(HashFloat(d.depthStencilDesc.maxDepthBounds));
-        mix(static_cast<uint64_t>(d.depthStencilDesc.stencilTestEnable ? 1u : 0u));
-        HashStencilOpState(ha, d.depthStencilDesc.front);
-        HashStencilOpState(hb, d.depthStencilDesc.front);
-        HashStencilOpState(ha, d.depthStencilDesc.back);
-        HashStencilOpState(hb, d.depthStencilDesc.back);
-
-        // Blending
-        mix(static_cast<uint64_t>(d.blendDesc.logicOpEnable ? 1u : 0u));
-        mix(static_cast<uint64_t>(d.blendDesc.logicOp));
-        mix(HashFloat(d.blendDesc.blendConstants[0]));
-        mix(HashFloat(d.blendDesc.blendConstants[1]));
-        mix(HashFloat(d.blendDesc.blendConstants[2]));
-        mix(HashFloat(d.blendDesc.blendConstants[3]));
-
-        std::vector<PipelineBlendAttachmentDesc> blendAtt = d.blendDesc.attachments;
-        if (blendAtt.empty()) {
-            blendAtt.resize(colourCount);
-        }
-        else if (blendAtt.size() == 1 && colourCount > 1) {
-            blendAtt.resize(colourCount, blendAtt[0]);
-        }
-        else if (colourCount != 0 && blendAtt.size() != colourCount) {
-            mix(static_cast<uint64_t>(0xBADB1EADu));
-        }
-
-        mix(static_cast<uint64_t>(blendAtt.size()));
-        for (const auto& a : blendAtt)
-        {
-            mix(static_cast<uint64_t>(a.enable ? 1u : 0u));
-            mix(static_cast<uint64_t>(a.srcColour));
-            mix(static_cast<uint64_t>(a.dstColour));
-            mix(static_cast<uint64_t>(a.colourOp));
-            mix(static_cast<uint64_t>(a.srcAlpha));
-            mix(static_cast<uint64_t>(a.dstAlpha));
-            mix(static_cast<uint64_t>(a.alphaOp));
-            mix(static_cast<uint64_t>(a.colorWriteMask));
-        }
-
-        // Dynamic states
-        std::vector<VkDynamicState> dyn = d.dynamicDesc.states;
-        std::sort(dyn.begin(), dyn.end());
-        mix(static_cast<uint64_t>(dyn.size()));
-        for (auto s : dyn) {
-            mix(static_cast<uint64_t>(s));
-        }
-
-        return PipelineStateHash128{ ha, hb };
-    }
-
-    
-
-    struct VulkanGraphicsPipelineKey
-    {
-        VkShaderModule m_vertShader{ VK_NULL_HANDLE };
-        VkShaderModule m_fragShader{ VK_NULL_HANDLE };
-        uint64_t m_setLayoutHash{ 0 };
-        PipelineStateHash128 m_stateHash{};
-
-        bool operator==(const VulkanGraphicsPipelineKey& _o) const noexcept
-        {
-            return m_vertShader == _o.m_vertShader
-                && m_fragShader == _o.m_fragShader
-                && m_setLayoutHash == _o.m_setLayoutHash
-                && m_stateHash == _o.m_stateHash;
-        }
-
-        static VulkanGraphicsPipelineKey Make(const PipelineDesc& _desc, uint64_t _setLayoutHash)
-        {
-            VulkanGraphicsPipelineKey k;
-            k.m_vertShader = _desc.vertexShader;
-            k.m_fragShader = _desc.fragmentShader;
-            k.m_setLayoutHash = _setLayoutHash;
-            // Hashes all states from desc
-            k.m_stateHash = HashPipelineDescState(_desc);
-            return k;
-        }
-    };
-
-    struct VulkanGraphicsPipelineKeyHash
-    {
-        size_t operator()(const VulkanGraphicsPipelineKey& _key) const noexcept
-        {
-            // Combines the two 64-bit hashes and key identity bits
-            uint64_t h = 1469598103934665603ull;
-            HashMix64(h, static_cast<uint64_t>(reinterpret_cast<uintptr_t>(_key.m_vertShader)));
-            HashMix64(h, static_cast<uint64_t>(reinterpret_cast<uintptr_t>(_key.m_fragShader)));
-            HashMix64(h, _key.m_setLayoutHash);
-            HashMix64(h, _key.m_stateHash.a);
-            HashMix64(h, _key.m_stateHash.b);
-            return static_cast<size_t>(h);
-        }
-    };
-
     struct VulkanGraphicsPipelineCache;
 
     struct GraphicsPipelineCreateResult
     {
         VkPipeline m_pipeline{ VK_NULL_HANDLE };
         VkPipelineLayout m_layout{ VK_NULL_HANDLE };
+        bool m_ownsLayout{ true }; // False for layouts shared through the pipeline library cache
+        // Optional background replacement (link-time optimised version of a fast-linked pipeline)
+        std::function<VkPipeline()> m_upgrade;
     };
 
     struct VulkanGraphicsPipelineRef
@@ -227,48 +45,173 @@ namespace Mark::RendererVK
         VkPipelineLayout layout() const noexcept { return m_layout; }
         explicit operator bool() const noexcept { return m_pipeline != VK_NULL_HANDLE; }
 
+        // True while an async compile for this key is still running
+        bool isPending() const noexcept { return m_cache && m_pipeline == VK_NULL_HANDLE; }
+        // Picks up the handles once the worker has finished, returns true when ready
+        bool poll();
+        // Picks up newer handles for this key (pending compile finished or optimised link swapped in).
+        // Returns true when they changed, command buffers recorded with the old handle should be re-recorded
+        bool refresh();
+
     private:
         VulkanGraphicsPipelineCache* m_cache{ nullptr };
         VulkanGraphicsPipelineKey m_key{};
         VkPipeline m_pipeline{ VK_NULL_HANDLE };
         VkPipelineLayout m_layout{ VK_NULL_HANDLE };
+        bool m_final{ false }; // No further handle changes expected, refresh() stops asking the cache
+    };
+
+    // When unreferenced entries are destroyed. Entries with live refs are never evicted, nor are prewarmed
+    // entries that haven't been acquired yet (the manifest can warm more pipelines than maxEntries)
+    struct GraphicsPipelineEvictionPolicy
+    {
+        uint32_t maxEntries{ 256 };            // Least recently used unreferenced entries go first past this
+        uint32_t idleFrames{ 3600 };           // Unreferenced this many frames -> evicted. 0 disables idle eviction
+        uint32_t retireFrames{ 4 };            // Evicted handles wait this long before vkDestroy, > WindowToVulkanHandler::FRAMES_IN_FLIGHT
+    };
+
+    struct GraphicsPipelineCacheStats
+    {
+        uint64_t hits{ 0 };                    // Acquires served by an existing or in-flight entry
+        uint64_t misses{ 0 };                  // Acquires that started a compile
+        uint64_t failures{ 0 };
+        uint64_t evictions{ 0 };
+        double creationMs{ 0.0 };              // Total creator time across misses
+        size_t entries{ 0 };
+        size_t retired{ 0 };                   // Evicted, waiting on the deferred destroy
     };
 
     struct VulkanGraphicsPipelineCache
     {
         using CreateFn = std::function<GraphicsPipelineCreateResult(const VulkanGraphicsPipelineKey&)>;
 
-        explicit VulkanGraphicsPipelineCache(VkDevice device) : m_device(device) {}
+        VulkanGraphicsPipelineCache(VkDevice device, VulkanPipelineDiskCache* diskCache, VulkanPipelineManifest* manifest) :
+            m_device(device), m_diskCache(diskCache), m_manifest(manifest) {}
         ~VulkanGraphicsPipelineCache() { destroyAll(); }
 
         VulkanGraphicsPipelineCache(const VulkanGraphicsPipelineCache&) = delete;
         VulkanGraphicsPipelineCache& operator=(const VulkanGraphicsPipelineCache&) = delete;
 
+        // Interns the desc's packed state, equal state always maps to the same key
+        VulkanGraphicsPipelineKey makeKey(const PipelineDesc& desc, uint64_t setLayoutHash);
+
         // Acquire or create. Increments refcount and returns RAII wrapper.
+        // Creation runs outside the lock, callers racing on the same key wait for the first one
         VulkanGraphicsPipelineRef acquire(const VulkanGraphicsPipelineKey& key, const CreateFn& creator);
 
+        // Non-blocking acquire. Returns a pending ref straight away and compiles on the worker pool.
+        // In-flight requests for the same key share one compile. Creator must own everything it captures
+        VulkanGraphicsPipelineRef acquireAsync(const VulkanGraphicsPipelineKey& key, CreateFn creator);
+        // Compiles on the worker pool without taking a ref. The entry is kept out of eviction until its first acquire
+        void prewarm(const VulkanGraphicsPipelineKey& key, CreateFn creator);
+
+        // Blocks until every queued/in-flight async compile has finished
+        void waitForPending();
+        uint32_t pendingCount() const { std::lock_guard<std::mutex> lk(m_mutex); return m_pendingCount; }
+
         // Manual release
         void release(const VulkanGraphicsPipelineKey& key);
 
         // Destroy everything
         void destroyAll();
 
-        // Destroy only entries that aren't referenced
+        // Retire every entry that isn't referenced, destroyed once policy.retireFrames have passed
         void purgeUnused();
 
-        size_t size() const { std::lock_guard<std::mutex> lk(m_mutex); return m_map.size(); }
+        // Call once per frame. Destroys retired handles that are old enough, then applies the eviction policy
+        void update();
+        void setEvictionPolicy(const GraphicsPipelineEvictionPolicy& policy) { std::lock_guard<std::mutex> lk(m_mutex); m_policy = policy; }
+
+        size_t size() const { std::lock_guard<std::mutex> lk(m_mutex); return m_liveCount; }
+        GraphicsPipelineCacheStats stats() const;
+
+        // Driver-level cache creators pass to vkCreateGraphicsPipelines
+        VulkanPipelineDiskCache* diskCache() const noexcept { return m_diskCache; }
+        // Session record of acquired descriptions, replayed on the next launch
+        VulkanPipelineManifest* manifest() const noexcept { return m_manifest; }
+
+        // Dynamic state groups the device supports, descs asking for more are baked instead
+        void setDynamicStateCaps(const PipelineDynamicStateCaps& caps) noexcept { m_dynamicStateCaps = caps; }
+        const PipelineDynamicStateCaps& dynamicStateCaps() const noexcept { return m_dynamicStateCaps; }
+
+        // Part libraries for VK_EXT_graphics_pipeline_library, null when the device doesn't support it.
+        // Parts follow the shader cache: a rebuilt or invalidated module drops the parts compiled from it
+        void enablePipelineLibrary(bool fastLinking, VulkanShaderCache* shaderCache);
+        VulkanPipelineLibraryCache* pipelineLibrary() noexcept { return m_libraries.isEnabled() ? &m_libraries : nullptr; }
 
     private:
+        enum class EntryState : uint8_t { Empty, Pending, Ready, Failed };
+
         struct Entry
         {
             VkPipeline m_pipeline{ VK_NULL_HANDLE };
             VkPipelineLayout m_layout{ VK_NULL_HANDLE };
             uint32_t m_refCount{ 0 };
+            EntryState m_state{ EntryState::Empty };
+            bool m_ownsLayout{ true };
+            bool m_upgradePending{ false };
+            // Fast-linked pipeline replaced by its optimised link. Kept until the entry goes, recorded command buffers may still use it
+            VkPipeline m_superseded{ VK_NULL_HANDLE };
+            uint64_t m_lastUsedFrame{ 0 }; // Last acquire or release, idle time counts from here
+            bool m_prewarmed{ false }; // Queued by prewarm and not acquired since, exempt from idle/LRU eviction
+        };
+
+        // Handles of an evicted entry, destroyed at m_frame >= m_destroyFrame
+        struct RetiredEntry
+        {
+            VkPipeline m_pipeline{ VK_NULL_HANDLE };
+            VkPipeline m_superseded{ VK_NULL_HANDLE };
+            VkPipelineLayout m_layout{ VK_NULL_HANDLE };
+            uint64_t m_destroyFrame{ 0 };
         };
 
+        // Null when the key has no entry. Pointers are invalidated by emplaceLocked. Caller holds m_mutex
+        Entry* findLocked(const VulkanGraphicsPipelineKey& key);
+        Entry& emplaceLocked(const VulkanGraphicsPipelineKey& key);
+        // Marks the key Pending with a ref for the caller, reviving a Failed entry or emplacing a new one. Caller holds m_mutex
+        void reserveLocked(const VulkanGraphicsPipelineKey& key);
+        // Stores the creator result against the key and wakes any waiters. Failed results are erased once unreferenced. Caller holds m_mutex
+        void resolveLocked(const VulkanGraphicsPipelineKey& key, GraphicsPipelineCreateResult result);
+        // Drops one ref, erasing a Failed entry on its last one. Caller holds m_mutex
+        void dropRefLocked(Entry& entry);
+        void eraseLocked(Entry& entry);
+        bool tryResolve(const VulkanGraphicsPipelineKey& key, VkPipeline& outPipeline, VkPipelineLayout& outLayout, bool& outFinal);
+        // Runs the upgrade on a worker and swaps the entry's pipeline when it lands. Caller holds m_mutex
+        void queueUpgradeLocked(const VulkanGraphicsPipelineKey& key, std::function<VkPipeline()> upgrade);
+        // Runs the creator on a worker and resolves the key reserved by the caller
+        void queueCompile(const VulkanGraphicsPipelineKey& key, CreateFn creator);
+        void queueJob(std::function<void()> job);
+        void destroyEntry(Entry& entry);
+        // Moves the entry's handles to the retire queue and frees its slot. Caller holds m_mutex
+        void retireLocked(Entry& entry);
+        bool isEvictableLocked(const Entry& entry) const;
+
+        void startWorkersLocked();
+        void stopWorkers();
+        void workerLoop();
+
         VkDevice m_device{ VK_NULL_HANDLE };
-        std::unordered_map<VulkanGraphicsPipelineKey, Entry, VulkanGraphicsPipelineKeyHash> m_map;
+        VulkanPipelineDiskCache* m_diskCache{ nullptr };
+        VulkanPipelineManifest* m_manifest{ nullptr };
+        PipelineDynamicStateCaps m_dynamicStateCaps{};
+        VulkanPipelineLibraryCache m_libraries;
+        PipelineKeyInterner m_keys;
+        std::vector<Entry> m_entries; // Indexed by key id
+        size_t m_liveCount{ 0 };
+        GraphicsPipelineEvictionPolicy m_policy{};
+        std::deque<RetiredEntry> m_retired; // In m_destroyFrame order
+        uint64_t m_frame{ 0 };
+        GraphicsPipelineCacheStats m_stats{}; // entries/retired filled in by stats()
         mutable std::mutex m_mutex;
+        std::condition_variable m_resolvedCv;
+        uint32_t m_pendingCount{ 0 };
+
+        // Async compile workers, started on the first acquireAsync
+        std::vector<std::thread> m_workers;
+        std::deque<std::function<void()>> m_jobs;
+        std::mutex m_jobMutex;
+        std::condition_variable m_jobCv;
+        bool m_stopWorkers{ false };
 
         friend struct VulkanGraphicsPipelineRef;
     };
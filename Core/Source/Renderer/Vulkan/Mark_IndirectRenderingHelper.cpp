@@ -1,11 +1,14 @@
 #include "Mark_IndirectRenderingHelper.h"
 #include "Mark_VulkanCore.h"
 #include "Mark_CommandBuffers.h"
-#include "Mark_ModelHandler.h"
+#include "Mark_BindlessMeshResourceSet.h"
+#include "Mark_MeshPool.h"
 
 #include "Utils/Mark_Utils.h"
 
 #include <algorithm>
+#include <cfloat>
+#include <cstring>
 
 namespace Mark::RendererVK
 {
@@ -23,23 +26,6 @@ namespace Mark::RendererVK
         destroyIndirectDrawBuffers(_device);
     }
 
-    void VulkanIndirectRenderingHelper::setMeshVisible(const std::vector<std::shared_ptr<MeshHandler>>& _meshesToDraw, uint32_t _meshIndex, bool _visible, const glm::vec3* _cameraPosition)
-    {
-        const size_t numMeshesToDraw = _meshesToDraw.size();
-        if (_meshIndex >= numMeshesToDraw) return;
-
-        auto VkCore = m_vulkanCoreRef.lock();
-        if (VkCore) {
-            VkCore->graphicsQueue().waitIdle();
-        }
-
-        if (m_meshVisible.size() < numMeshesToDraw)
-            m_meshVisible.resize(numMeshesToDraw, 1);
-
-        m_meshVisible[_meshIndex] = _visible ? 1 : 0;
-        rebuildDrawCommands(_meshesToDraw, _cameraPosition);
-    }
-
     void VulkanIndirectRenderingHelper::createIndirectDrawBuffers()
     {
         auto VkCore = m_vulkanCoreRef.lock();
@@ -51,9 +37,11 @@ namespace Mark::RendererVK
         m_maxDraws = (maxIndirect > 0) ? std::min(maxMeshes, maxIndirect) : maxMeshes;
         if (m_maxDraws == 0) m_maxDraws = 1;
 
-        const VkDeviceSize cmdBytes = sizeof(VkDrawIndirectCommand) * static_cast<VkDeviceSize>(m_maxDraws);
+        // Every frame slot gets its own region so a rebuild never touches memory an in-flight frame reads
+        const uint32_t frameSlots = VulkanBindlessMeshResourceSet::FRAME_SLOTS;
+        const VkDeviceSize cmdBytes = sizeof(VkDrawIndirectCommand) * static_cast<VkDeviceSize>(m_maxDraws) * frameSlots;
 
-        // Host-visible, coherent updates (1024 draws = 16KB)
+        // Host-visible, coherent updates (1024 draws = 16KB per frame slot)
         m_indirectCmdBuffer = BufferAndMemory(
             VkCore,
             cmdBytes,
@@ -64,7 +52,7 @@ namespace Mark::RendererVK
 
         m_indirectCountBuffer = BufferAndMemory(
             VkCore,
-            sizeof(uint32_t),
+            sizeof(uint32_t) * frameSlots,
             VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT,
             VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
             "WinToVulk.IndirectCountBuffer"
@@ -72,11 +60,21 @@ namespace Mark::RendererVK
 
         m_drawsCPU.assign(m_maxDraws, VkDrawIndirectCommand{ 0, 0, 0, 0 });
         m_drawCount = 0;
-        m_meshVisible.clear();
-
-        // Upload initial empty contents
-        m_indirectCmdBuffer.update(VkCore->device(), m_drawsCPU.data(), sizeof(VkDrawIndirectCommand) * static_cast<size_t>(m_maxDraws));
-        m_indirectCountBuffer.update(VkCore->device(), &m_drawCount, sizeof(uint32_t));
+        m_drawsVersion = 0;
+        m_frameSlotVersions.assign(frameSlots, 0);
+
+        // Scratch sized for every mesh the bindless set can hold, so rebuilds never allocate
+        m_drawMeshIndicesCPU.reserve(maxMeshes);
+        m_sortedCandidates.reserve(maxMeshes);
+        m_sortedCandidateSet.reserve(maxMeshes);
+        m_candidateDepths.reserve(maxMeshes);
+        m_bucketedMeshIndices.reserve(maxMeshes);
+
+        // Mapped for the buffers' lifetime, coherent memory so writes need no flush
+        m_mappedDraws = static_cast<VkDrawIndirectCommand*>(m_indirectCmdBuffer.map(VkCore->device()));
+        m_mappedCount = static_cast<uint32_t*>(m_indirectCountBuffer.map(VkCore->device()));
+        std::memset(m_mappedDraws, 0, static_cast<size_t>(cmdBytes));
+        std::memset(m_mappedCount, 0, sizeof(uint32_t) * frameSlots);
 
         // Let the command buffer know what to use
         if (m_drawPass == IndirectDrawPass::Opaque) {
@@ -89,120 +87,214 @@ namespace Mark::RendererVK
 
     void VulkanIndirectRenderingHelper::destroyIndirectDrawBuffers(VkDevice _device)
     {
+        if (m_mappedDraws) {
+            m_indirectCmdBuffer.unmap(_device);
+            m_mappedDraws = nullptr;
+        }
+        if (m_mappedCount) {
+            m_indirectCountBuffer.unmap(_device);
+            m_mappedCount = nullptr;
+        }
         m_indirectCmdBuffer.destroy(_device);
         m_indirectCountBuffer.destroy(_device);
         m_drawsCPU.clear();
-        m_meshVisible.clear();
+        m_frameSlotVersions.clear();
+        m_drawMeshIndicesCPU = {};
+        m_sortedCandidates = {};
+        m_sortedCandidateSet = {};
+        m_candidateDepths = {};
+        m_bucketedMeshIndices = {};
         m_maxDraws = 0;
         m_drawCount = 0;
     }
 
-    bool VulkanIndirectRenderingHelper::meshBelongsInThisPass(const MeshHandler& _mesh) const
+    bool VulkanIndirectRenderingHelper::renderTypeBelongsInThisPass(RenderType _type) const
     {
         switch (m_drawPass)
         {
-        case IndirectDrawPass::Opaque:      return _mesh.isOpaque();
-        case IndirectDrawPass::Transparent: return _mesh.isTransparent();
+        case IndirectDrawPass::Opaque:      return isOpaqueRenderType(_type);
+        case IndirectDrawPass::Transparent: return _type == RenderType::Transparent;
         default: return false;
         }
     }
 
-    void VulkanIndirectRenderingHelper::rebuildDrawCommands(const std::vector<std::shared_ptr<MeshHandler>>& _meshesToDraw, const glm::vec3* _cameraPosition)
+    void VulkanIndirectRenderingHelper::rebuildDrawCommands(const MeshPool& _meshes, const glm::vec3* _cameraPosition)
     {
-        const size_t numMeshes = _meshesToDraw.size();
-        if (m_meshVisible.size() < numMeshes) {
-            m_meshVisible.resize(numMeshes, 1);
-        }
+        const uint32_t numMeshes = _meshes.size();
+        const std::vector<uint32_t>& indexCounts = _meshes.indexCounts();
+        const std::vector<MeshBounds>& bounds = _meshes.bounds();
+        const std::vector<RenderType>& renderTypes = _meshes.renderTypes();
+        const std::vector<glm::vec3>& sortPositions = _meshes.sortPositions();
+        const std::vector<uint32_t>& meshSlots = _meshes.meshSlots();
+        const std::vector<uint32_t>& textureSlots = _meshes.textureSlots();
+        const std::vector<uint8_t>& visible = _meshes.visible();
 
         m_drawMeshIndicesCPU.clear();
-        std::fill(m_drawsCPU.begin(), m_drawsCPU.end(), VkDrawIndirectCommand{ 0, 0, 0, 0 });
-
-        struct TransparentCandidate
-        {
-            uint32_t meshIndex;
-            float distanceSq;
-        };
-
-        std::vector<TransparentCandidate> transparentCandidates;
 
         for (uint32_t meshIndex = 0; meshIndex < numMeshes; meshIndex++)
         {
-            const auto& mesh = _meshesToDraw[meshIndex];
-            const bool visible = (meshIndex < m_meshVisible.size()) ? (m_meshVisible[meshIndex] != 0) : true;
-
-            if (!visible || !mesh) {
+            if (!visible[meshIndex] || meshSlots[meshIndex] == UINT32_MAX) {
                 continue;
             }
-            if (!meshBelongsInThisPass(*mesh)) {
+            if (!renderTypeBelongsInThisPass(renderTypes[meshIndex])) {
                 continue;
             }
-            if (mesh->indexCount() == 0) {
+            if (indexCounts[meshIndex] == 0) {
                 continue;
             }
 
-            if (m_drawPass == IndirectDrawPass::Transparent && _cameraPosition != nullptr)
-            {
-                const glm::vec3 delta = mesh->sortPosition() - *_cameraPosition;
-                transparentCandidates.push_back({meshIndex, glm::dot(delta, delta)});
-            }
-            else {
-                m_drawMeshIndicesCPU.push_back(meshIndex);
-            }
+            m_drawMeshIndicesCPU.push_back(meshIndex);
         }
 
-        if (m_drawPass == IndirectDrawPass::Transparent && _cameraPosition != nullptr)
+        if (_cameraPosition != nullptr)
         {
-            std::sort(transparentCandidates.begin(), transparentCandidates.end(),
-                [](const TransparentCandidate& _a, const TransparentCandidate& _b)
-                {
-                    return _a.distanceSq > _b.distanceSq; // Back-to-front sorting
-                });
-
-            for (const auto& candidate : transparentCandidates) {
-                m_drawMeshIndicesCPU.push_back(candidate.meshIndex);
+            if (m_drawPass == IndirectDrawPass::Transparent) {
+                sortBackToFront(sortPositions, *_cameraPosition);
+            }
+            else {
+                bucketFrontToBack(bounds, *_cameraPosition);
             }
         }
 
-        m_drawCount = std::min(static_cast<uint32_t>(m_drawMeshIndicesCPU.size()), m_maxDraws);
+        const uint32_t drawCount = std::min(static_cast<uint32_t>(m_drawMeshIndicesCPU.size()), m_maxDraws);
         if (m_drawMeshIndicesCPU.size() > m_maxDraws) {
             MARK_WARN(Utils::Category::Vulkan, "Filtered mesh count (%zu) exceeds indirect capacity (%u). Extra meshes will not be drawn.", m_drawMeshIndicesCPU.size(), m_maxDraws);
 
         }
 
-        for (uint32_t drawSlot = 0; drawSlot < m_drawCount; drawSlot++)
+        // Only [0, drawCount) is written, anything past it is stale but never read
+        bool changed = (drawCount != m_drawCount);
+        for (uint32_t drawSlot = 0; drawSlot < drawCount; drawSlot++)
         {
             const uint32_t meshIndex = m_drawMeshIndicesCPU[drawSlot];
-            const uint32_t indexCount = _meshesToDraw[meshIndex]->indexCount();
 
-            m_drawsCPU[drawSlot] = VkDrawIndirectCommand{
-                .vertexCount = indexCount,
+            // Meshes without a texture sample the fallback texture
+            const uint32_t textureSlot = textureSlots[meshIndex] != UINT32_MAX ? textureSlots[meshIndex] : VulkanBindlessMeshResourceSet::FALLBACK_TEXTURE_SLOT;
+
+            const VkDrawIndirectCommand command{
+                .vertexCount = indexCounts[meshIndex],
                 .instanceCount = 1,
                 .firstVertex = 0,
-                .firstInstance = meshIndex
+                .firstInstance = BindlessDrawId::encode(meshSlots[meshIndex], textureSlot)
             };
+            VkDrawIndirectCommand& current = m_drawsCPU[drawSlot];
+            if (std::memcmp(&current, &command, sizeof(VkDrawIndirectCommand)) != 0) {
+                current = command;
+                changed = true;
+            }
         }
+        m_drawCount = drawCount;
 
-        uploadAllDrawCommands();
-        uploadDrawCount();
+        // Per-frame view dependent rebuilds of a still camera leave the slots alone
+        if (changed) {
+            m_drawsVersion++;
+        }
     }
 
-    void VulkanIndirectRenderingHelper::uploadAllDrawCommands()
+    void VulkanIndirectRenderingHelper::bucketFrontToBack(const std::vector<MeshBounds>& _bounds, const glm::vec3& _cameraPosition)
     {
-        auto VkCore = m_vulkanCoreRef.lock();
-        if (!VkCore) return;
+        const size_t count = m_drawMeshIndicesCPU.size();
+        if (count < 2) return;
+
+        // Nearest point of the bounds rather than the centre, a large mesh the camera stands in or next to
+        // (floors, walls) is the best occluder there is and should land in the first bucket
+        m_candidateDepths.clear();
+        float nearest = FLT_MAX;
+        float farthest = 0.0f;
+        for (const uint32_t meshIndex : m_drawMeshIndicesCPU)
+        {
+            const MeshBounds& meshBounds = _bounds[meshIndex];
+            const glm::vec3 delta = glm::clamp(_cameraPosition, meshBounds.m_min, meshBounds.m_max) - _cameraPosition;
+            const float depth = glm::length(delta);
+            m_candidateDepths.push_back(depth);
+            nearest = std::min(nearest, depth);
+            farthest = std::max(farthest, depth);
+        }
 
-        m_indirectCmdBuffer.update(
-            VkCore->device(),
-            m_drawsCPU.data(),
-            sizeof(VkDrawIndirectCommand) * static_cast<size_t>(m_maxDraws)
-        );
+        // Buckets span this frame's depth range, all in bucket 0 when everything is equally far
+        const float range = farthest - nearest;
+        const float toBucket = range > 0.0f ? static_cast<float>(OPAQUE_DEPTH_BUCKETS) / range : 0.0f;
+        auto bucketOf = [&](float _depth) {
+            return std::min(static_cast<uint32_t>((_depth - nearest) * toBucket), OPAQUE_DEPTH_BUCKETS - 1u);
+        };
+
+        // Counting sort: histogram, exclusive prefix sum, stable scatter
+        m_bucketOffsets.fill(0);
+        for (const float depth : m_candidateDepths) {
+            m_bucketOffsets[bucketOf(depth)]++;
+        }
+        uint32_t offset = 0;
+        for (uint32_t& bucket : m_bucketOffsets)
+        {
+            const uint32_t bucketCount = bucket;
+            bucket = offset;
+            offset += bucketCount;
+        }
+
+        m_bucketedMeshIndices.resize(count);
+        for (size_t i = 0; i < count; i++) {
+            m_bucketedMeshIndices[m_bucketOffsets[bucketOf(m_candidateDepths[i])]++] = m_drawMeshIndicesCPU[i];
+        }
+        // Both keep their reserved capacity through the swap
+        m_drawMeshIndicesCPU.swap(m_bucketedMeshIndices);
     }
 
-    void VulkanIndirectRenderingHelper::uploadDrawCount()
+    void VulkanIndirectRenderingHelper::sortBackToFront(const std::vector<glm::vec3>& _sortPositions, const glm::vec3& _cameraPosition)
     {
-        auto VkCore = m_vulkanCoreRef.lock();
-        if (!VkCore) return;
+        // Same candidates as last time, so last frame's order is nearly sorted for a smoothly moving camera
+        const bool coherent = (m_drawMeshIndicesCPU == m_sortedCandidateSet);
+        if (!coherent)
+        {
+            m_sortedCandidateSet.assign(m_drawMeshIndicesCPU.begin(), m_drawMeshIndicesCPU.end());
+            m_sortedCandidates.clear();
+            for (const uint32_t meshIndex : m_drawMeshIndicesCPU) {
+                m_sortedCandidates.push_back({ meshIndex, 0.0f });
+            }
+        }
+
+        for (TransparentCandidate& candidate : m_sortedCandidates)
+        {
+            const glm::vec3 delta = _sortPositions[candidate.meshIndex] - _cameraPosition;
+            candidate.distanceSq = glm::dot(delta, delta);
+        }
+
+        if (coherent)
+        {
+            // Insertion sort, close to linear when only a few neighbours swapped since the last frame
+            for (size_t i = 1; i < m_sortedCandidates.size(); i++)
+            {
+                const TransparentCandidate candidate = m_sortedCandidates[i];
+                size_t j = i;
+                while (j > 0 && m_sortedCandidates[j - 1].distanceSq < candidate.distanceSq)
+                {
+                    m_sortedCandidates[j] = m_sortedCandidates[j - 1];
+                    j--;
+                }
+                m_sortedCandidates[j] = candidate;
+            }
+        }
+        else
+        {
+            std::sort(m_sortedCandidates.begin(), m_sortedCandidates.end(),
+                [](const TransparentCandidate& _a, const TransparentCandidate& _b)
+                {
+                    return _a.distanceSq > _b.distanceSq; // Back-to-front sorting
+                });
+        }
+
+        for (size_t i = 0; i < m_sortedCandidates.size(); i++) {
+            m_drawMeshIndicesCPU[i] = m_sortedCandidates[i].meshIndex;
+        }
+    }
+
+    void VulkanIndirectRenderingHelper::uploadForFrameSlot(uint32_t _frameSlot)
+    {
+        if (!m_mappedDraws || !m_mappedCount || _frameSlot >= m_frameSlotVersions.size()) return;
+        if (m_frameSlotVersions[_frameSlot] == m_drawsVersion) return;
 
-        m_indirectCountBuffer.update(VkCore->device(), &m_drawCount, sizeof(uint32_t));
+        // Only the first m_drawCount commands, the GPU never reads past the count
+        std::memcpy(m_mappedDraws + static_cast<size_t>(_frameSlot) * m_maxDraws, m_drawsCPU.data(), sizeof(VkDrawIndirectCommand) * static_cast<size_t>(m_drawCount));
+        m_mappedCount[_frameSlot] = m_drawCount;
+        m_frameSlotVersions[_frameSlot] = m_drawsVersion;
     }
 }
\ No newline at end of file
@@ -3,6 +3,7 @@
 
 #include <Volk/volk.h>
 #include <glm/glm.hpp>
+#include <array>
 #include <memory>
 #include <vector>
 
@@ -10,7 +11,9 @@ namespace Mark::RendererVK
 {
     struct VulkanCore;
     struct VulkanCommandBuffers;
-    struct MeshHandler;
+    struct MeshPool;
+    struct MeshBounds;
+    enum class RenderType : uint8_t;
     enum class IndirectDrawPass : uint8_t
     {
         Opaque,
@@ -26,8 +29,15 @@ namespace Mark::RendererVK
         void initialize();
         void destroy(VkDevice _device);
 
-        void rebuildDrawCommands(const std::vector<std::shared_ptr<MeshHandler>>& _meshesToDraw, const glm::vec3* _renderingCameraPosition = nullptr);
-        void setMeshVisible(const std::vector<std::shared_ptr<MeshHandler>>& _meshesToDraw, uint32_t _meshIndex, bool _visible, const glm::vec3* _renderingCameraPosition = nullptr);
+        // Only reads the pool's hot arrays, never the MeshHandlers. Allocation free, all scratch is reserved up front
+        // With a camera position, opaque draws are bucketed front-to-back so near occluders fill depth first, and
+        // transparent back-to-front order is carried between calls and re-sorted incrementally while the mesh set is unchanged
+        // CPU side only, frame slots are marked stale when the commands changed and pick them up in uploadForFrameSlot
+        void rebuildDrawCommands(const MeshPool& _meshes, const glm::vec3* _renderingCameraPosition = nullptr);
+
+        // Copies the current commands into the frame slot's region if it is stale. Call after acquiring the image
+        // whose index is _frameSlot, its previous submission has then retired so the write can't race the GPU
+        void uploadForFrameSlot(uint32_t _frameSlot);
 
         const VkBuffer indirectCmdBuffer() const { return m_indirectCmdBuffer.m_buffer; }
         const VkBuffer indirectCountBuffer() const { return m_indirectCountBuffer.m_buffer; }
@@ -38,19 +48,41 @@ namespace Mark::RendererVK
         VulkanCommandBuffers& m_vulkanCommandBuffersRef;
         IndirectDrawPass m_drawPass;
 
-        BufferAndMemory m_indirectCmdBuffer;   // VkDrawIndirectCommand[]
-        BufferAndMemory m_indirectCountBuffer; // uint32 drawCount
+        // One region per frame slot (swapchain image index, as for the UBO), persistently mapped
+        BufferAndMemory m_indirectCmdBuffer;   // VkDrawIndirectCommand[m_maxDraws] per frame slot
+        BufferAndMemory m_indirectCountBuffer; // uint32 drawCount per frame slot
+        VkDrawIndirectCommand* m_mappedDraws{ nullptr };
+        uint32_t* m_mappedCount{ nullptr };
         std::vector<VkDrawIndirectCommand> m_drawsCPU;
-        std::vector<uint8_t> m_meshVisible; // 1 = visible, 0 = culled/removed
-        std::vector<uint32_t> m_drawMeshIndicesCPU;
+        std::vector<uint32_t> m_drawMeshIndicesCPU; // Dense mesh indices drawn this rebuild
         uint32_t m_maxDraws{ 0 };
         uint32_t m_drawCount{ 0 };
 
+        // A frame slot is up to date when its version matches the version of the last rebuild
+        uint64_t m_drawsVersion{ 0 };
+        std::vector<uint64_t> m_frameSlotVersions;
+
+        struct TransparentCandidate
+        {
+            uint32_t meshIndex;
+            float distanceSq;
+        };
+        std::vector<TransparentCandidate> m_sortedCandidates; // Back-to-front, kept between rebuilds
+        std::vector<uint32_t> m_sortedCandidateSet;           // Candidates m_sortedCandidates was built from, in dense order
+
+        // Coarse is enough for early-Z, and a counting sort over a fixed bucket count stays linear
+        static constexpr uint32_t OPAQUE_DEPTH_BUCKETS = 64;
+        std::vector<float> m_candidateDepths;          // Camera to nearest point of the bounds, per m_drawMeshIndicesCPU entry
+        std::vector<uint32_t> m_bucketedMeshIndices;   // Scatter target, swapped with m_drawMeshIndicesCPU
+        std::array<uint32_t, OPAQUE_DEPTH_BUCKETS> m_bucketOffsets{};
+
         void createIndirectDrawBuffers();
         void destroyIndirectDrawBuffers(VkDevice _device);
 
-        bool meshBelongsInThisPass(const MeshHandler& _mesh) const;
-        void uploadAllDrawCommands();
-        void uploadDrawCount();
+        bool renderTypeBelongsInThisPass(RenderType _type) const;
+        // Reorders m_drawMeshIndicesCPU back-to-front from _cameraPosition
+        void sortBackToFront(const std::vector<glm::vec3>& _sortPositions, const glm::vec3& _cameraPosition);
+        // Stable reorder of m_drawMeshIndicesCPU into depth buckets, nearest first. Order within a bucket is submission order
+        void bucketFrontToBack(const std::vector<MeshBounds>& _bounds, const glm::vec3& _cameraPosition);
     };
 }
\ No newline at end of file
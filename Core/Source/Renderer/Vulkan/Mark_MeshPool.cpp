@@ -0,0 +1,139 @@
+#include "Mark_MeshPool.h"
+
+namespace Mark::RendererVK
+{
+    void MeshPool::reset(uint32_t _capacity)
+    {
+        m_handles.reset(_capacity);
+        m_denseIndices.assign(_capacity, UINT32_MAX);
+
+        m_indexCounts.clear();
+        m_bounds.clear();
+        m_renderTypes.clear();
+        m_sortPositions.clear();
+        m_meshSlots.clear();
+        m_textureSlots.clear();
+        m_visible.clear();
+
+        m_handleIndices.clear();
+        m_handleGenerations.clear();
+        m_meshSlotGenerations.clear();
+        m_textureSlotGenerations.clear();
+        m_meshes.clear();
+    }
+
+    MeshHandle MeshPool::add(std::shared_ptr<MeshHandler> _mesh, Utils::SlotHandle _meshSlot, Utils::SlotHandle _textureSlot)
+    {
+        if (!_mesh) return {};
+
+        const MeshHandle handle = m_handles.allocate();
+        if (!handle.valid()) return {};
+
+        m_denseIndices[handle.index] = size();
+
+        m_indexCounts.push_back(_mesh->indexCount());
+        m_bounds.push_back(_mesh->bounds());
+        m_renderTypes.push_back(RenderType::Opaque);
+        m_sortPositions.push_back(glm::vec3(0.0f));
+        m_meshSlots.push_back(_meshSlot.index);
+        m_textureSlots.push_back(_textureSlot.index);
+        m_visible.push_back(1);
+
+        m_handleIndices.push_back(handle.index);
+        m_handleGenerations.push_back(handle.generation);
+        m_meshSlotGenerations.push_back(_meshSlot.generation);
+        m_textureSlotGenerations.push_back(_textureSlot.generation);
+        m_meshes.push_back(std::move(_mesh));
+
+        return handle;
+    }
+
+    std::shared_ptr<MeshHandler> MeshPool::remove(MeshHandle _handle)
+    {
+        const uint32_t dense = denseIndex(_handle);
+        if (dense == UINT32_MAX) return nullptr;
+
+        std::shared_ptr<MeshHandler> mesh = std::move(m_meshes[dense]);
+
+        const uint32_t last = size() - 1u;
+        if (dense != last) {
+            moveDense(last, dense);
+        }
+        popDense();
+
+        m_denseIndices[_handle.index] = UINT32_MAX;
+        m_handles.release(_handle);
+        return mesh;
+    }
+
+    uint32_t MeshPool::denseIndex(MeshHandle _handle) const noexcept
+    {
+        return m_handles.alive(_handle) ? m_denseIndices[_handle.index] : UINT32_MAX;
+    }
+
+    MeshCPUMemoryStats MeshPool::cpuMemoryStats() const
+    {
+        MeshCPUMemoryStats stats{};
+        for (const auto& mesh : m_meshes)
+        {
+            stats.meshes++;
+            switch (mesh->cpuResidency())
+            {
+            case MeshCPUResidency::Keep:            stats.kept++; break;
+            case MeshCPUResidency::DropAfterUpload: stats.dropped++; break;
+            case MeshCPUResidency::Compressed:      stats.compressed++; break;
+            }
+            stats.residentBytes += mesh->cpuResidentBytes();
+            stats.fullCopyBytes += mesh->cpuFullCopyBytes();
+        }
+        return stats;
+    }
+
+    void MeshPool::setMeshSlot(uint32_t _dense, Utils::SlotHandle _slot) noexcept
+    {
+        m_meshSlots[_dense] = _slot.index;
+        m_meshSlotGenerations[_dense] = _slot.generation;
+    }
+
+    void MeshPool::setTextureSlot(uint32_t _dense, Utils::SlotHandle _slot) noexcept
+    {
+        m_textureSlots[_dense] = _slot.index;
+        m_textureSlotGenerations[_dense] = _slot.generation;
+    }
+
+    void MeshPool::moveDense(uint32_t _from, uint32_t _to)
+    {
+        m_indexCounts[_to] = m_indexCounts[_from];
+        m_bounds[_to] = m_bounds[_from];
+        m_renderTypes[_to] = m_renderTypes[_from];
+        m_sortPositions[_to] = m_sortPositions[_from];
+        m_meshSlots[_to] = m_meshSlots[_from];
+        m_textureSlots[_to] = m_textureSlots[_from];
+        m_visible[_to] = m_visible[_from];
+
+        m_handleIndices[_to] = m_handleIndices[_from];
+        m_handleGenerations[_to] = m_handleGenerations[_from];
+        m_meshSlotGenerations[_to] = m_meshSlotGenerations[_from];
+        m_textureSlotGenerations[_to] = m_textureSlotGenerations[_from];
+        m_meshes[_to] = std::move(m_meshes[_from]);
+
+        m_denseIndices[m_handleIndices[_to]] = _to;
+    }
+
+    void MeshPool::popDense()
+    {
+        m_indexCounts.pop_back();
+        m_bounds.pop_back();
+        m_renderTypes.pop_back();
+        m_sortPositions.pop_back();
+        m_meshSlots.pop_back();
+        m_textureSlots.pop_back();
+        m_visible.pop_back();
+
+        m_handleIndices.pop_back();
+        m_handleGenerations.pop_back();
+        m_meshSlotGenerations.pop_back();
+        m_textureSlotGenerations.pop_back();
+        m_meshes.pop_back();
+    }
+} // namespace Mark::RendererVK
\ No newline at end of file
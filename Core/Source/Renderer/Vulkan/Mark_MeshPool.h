@@ -0,0 +1,102 @@
+#pragma once
+#include "Mark_ModelHandler.h"
+#include "Utils/Mark_SlotAllocator.h"
+
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace Mark::RendererVK
+{
+    // Stable reference to a pooled mesh, stale once the mesh is removed even if the index gets reused
+    using MeshHandle = Utils::SlotHandle;
+
+    // RAM held by the pooled meshes' geometry against what full CPU copies of every mesh would take
+    struct MeshCPUMemoryStats
+    {
+        uint32_t meshes{ 0 };
+        uint32_t kept{ 0 };
+        uint32_t dropped{ 0 };
+        uint32_t compressed{ 0 };
+        size_t residentBytes{ 0 };
+        size_t fullCopyBytes{ 0 };
+
+        size_t savedBytes() const noexcept { return fullCopyBytes > residentBytes ? fullCopyBytes - residentBytes : 0; }
+    };
+
+    // Owns the meshes drawn by a window. Per-frame render data lives in dense SoA arrays indexed 0..size()
+    // so draw rebuilds stream through memory, the MeshHandler (buffers, CPU copies, texture) is only touched cold
+    // Removal swaps the last mesh into the hole, dense indices are not stable across add/remove, handles are
+    struct MeshPool
+    {
+        MeshPool() = default;
+        ~MeshPool() = default;
+        MeshPool(const MeshPool&) = delete;
+        MeshPool& operator=(const MeshPool&) = delete;
+
+        // Drops every mesh, _capacity bounds the number of live handles
+        void reset(uint32_t _capacity);
+
+        // Invalid handle when the pool is full
+        MeshHandle add(std::shared_ptr<MeshHandler> _mesh, Utils::SlotHandle _meshSlot, Utils::SlotHandle _textureSlot);
+        // Returns the mesh so the caller decides when its GPU resources go, null for stale handles
+        std::shared_ptr<MeshHandler> remove(MeshHandle _handle);
+
+        bool contains(MeshHandle _handle) const noexcept { return denseIndex(_handle) != UINT32_MAX; }
+        uint32_t denseIndex(MeshHandle _handle) const noexcept; // UINT32_MAX when stale
+        MeshHandle handle(uint32_t _dense) const noexcept { return { m_handleIndices[_dense], m_handleGenerations[_dense] }; }
+
+        uint32_t size() const noexcept { return static_cast<uint32_t>(m_meshes.size()); }
+        bool empty() const noexcept { return m_meshes.empty(); }
+
+        // Hot data, one entry per dense index
+        const std::vector<uint32_t>& indexCounts() const noexcept { return m_indexCounts; }
+        const std::vector<MeshBounds>& bounds() const noexcept { return m_bounds; }
+        const std::vector<RenderType>& renderTypes() const noexcept { return m_renderTypes; }
+        const std::vector<glm::vec3>& sortPositions() const noexcept { return m_sortPositions; }
+        const std::vector<uint32_t>& meshSlots() const noexcept { return m_meshSlots; }       // Bindless mesh slot index
+        const std::vector<uint32_t>& textureSlots() const noexcept { return m_textureSlots; } // UINT32_MAX without a texture
+        const std::vector<uint8_t>& visible() const noexcept { return m_visible; }
+
+        // Full slot handles for release, the generation is not needed per frame so it stays out of the hot arrays
+        Utils::SlotHandle meshSlotHandle(uint32_t _dense) const noexcept { return { m_meshSlots[_dense], m_meshSlotGenerations[_dense] }; }
+        Utils::SlotHandle textureSlotHandle(uint32_t _dense) const noexcept { return { m_textureSlots[_dense], m_textureSlotGenerations[_dense] }; }
+
+        void setRenderType(uint32_t _dense, RenderType _type) noexcept { m_renderTypes[_dense] = _type; }
+        void setSortPosition(uint32_t _dense, const glm::vec3& _position) noexcept { m_sortPositions[_dense] = _position; }
+        void setVisible(uint32_t _dense, bool _visible) noexcept { m_visible[_dense] = _visible ? 1 : 0; }
+        void setMeshSlot(uint32_t _dense, Utils::SlotHandle _slot) noexcept;
+        void setTextureSlot(uint32_t _dense, Utils::SlotHandle _slot) noexcept;
+
+        // Cold data
+        MeshHandler& mesh(uint32_t _dense) const noexcept { return *m_meshes[_dense]; }
+
+        // Walks every MeshHandler, meant for stats display rather than per-frame use
+        MeshCPUMemoryStats cpuMemoryStats() const;
+
+    private:
+        Utils::GenerationalSlotAllocator m_handles;
+        std::vector<uint32_t> m_denseIndices; // Handle index -> dense index
+
+        // Dense hot arrays
+        std::vector<uint32_t> m_indexCounts;
+        std::vector<MeshBounds> m_bounds;
+        std::vector<RenderType> m_renderTypes; // TEMP: To be moved to material/mesh descriptor when those are implemented
+        std::vector<glm::vec3> m_sortPositions; // TEMP: used for transparent sorting until proper transform/material instances exist
+        std::vector<uint32_t> m_meshSlots;
+        std::vector<uint32_t> m_textureSlots;
+        std::vector<uint8_t> m_visible;
+
+        // Dense cold arrays
+        std::vector<uint32_t> m_handleIndices;
+        std::vector<uint32_t> m_handleGenerations;
+        std::vector<uint32_t> m_meshSlotGenerations;
+        std::vector<uint32_t> m_textureSlotGenerations;
+        std::vector<std::shared_ptr<MeshHandler>> m_meshes;
+
+        // Moves dense entry _from over _to in every array and fixes up the handle -> dense lookup
+        void moveDense(uint32_t _from, uint32_t _to);
+        void popDense();
+    };
+} // namespace Mark::RendererVK
\ No newline at end of file
@@ -3,8 +3,15 @@
 #include "Mark_TextureHandler.h"
 
 #include <glm/glm.hpp>
+#include <cstdint>
+#include <string>
 #include <vector>
 
+// CPU copy policy for meshes added without one, see MeshCPUResidency (0 Keep, 1 DropAfterUpload, 2 Compressed)
+#ifndef MARK_MESH_CPU_RESIDENCY_DEFAULT
+    #define MARK_MESH_CPU_RESIDENCY_DEFAULT 0
+#endif
+
 namespace Mark::RendererVK
 {
     struct VulkanCore;
@@ -31,44 +38,66 @@ namespace Mark::RendererVK
         Masked,
         Transparent
     };
+    constexpr bool isOpaqueRenderType(RenderType _type) noexcept { return _type == RenderType::Opaque || _type == RenderType::Masked; }
+
+    // What stays in RAM once the mesh is on the GPU
+    enum class MeshCPUResidency : uint8_t
+    {
+        Keep,            // Full vertex/index vectors for the mesh's whole life
+        DropAfterUpload, // Nothing, the geometry can only come back by reloading the mesh
+        Compressed       // Lossless compressed copy, expanded again by restoreCPUData()
+    };
+
+    // Object space AABB, computed when the mesh is loaded so it survives the CPU copy being dropped
+    struct MeshBounds
+    {
+        glm::vec3 m_min{ 0.0f, 0.0f, 0.0f };
+        glm::vec3 m_max{ 0.0f, 0.0f, 0.0f };
+    };
     struct MeshHandler
     {
         MeshHandler(std::weak_ptr<VulkanCore> _vulkanCore, VulkanCommandBuffers& _commandBuffersRef);
         ~MeshHandler();
         void destroyGPUBuffer(VkDevice _device);
 
-        // CPU side data (can be streamed from disk in future)
-        size_t vertexBufferSize() const { return sizeof(VertexData) * m_vertices.size(); }
-        size_t indexBufferSize()  const { return sizeof(uint32_t) * m_indices.size(); }
+        // CPU side data (can be streamed from disk in future), sizes stay valid after the CPU copy is released
+        size_t vertexBufferSize() const { return sizeof(VertexData) * m_vertexCount; }
+        size_t indexBufferSize()  const { return sizeof(uint32_t) * m_indexCount; }
+
+        // Vertex and index accessors, the counts always reflect the loaded mesh
+        uint32_t vertexCount() const noexcept { return m_vertexCount; }
+        uint32_t indexCount() const noexcept { return m_indexCount; }
+        const MeshBounds& bounds() const noexcept { return m_bounds; }
 
-        // Vertex and index accessors
-        uint32_t vertexCount() const noexcept { return static_cast<uint32_t>(m_vertices.size()); }
-        uint32_t indexCount() const noexcept { return static_cast<uint32_t>(m_indices.size()); }
+        // vertices()/indices() are empty unless hasCPUData(), a Compressed mesh can get them back with restoreCPUData()
+        MeshCPUResidency cpuResidency() const noexcept { return m_cpuResidency; }
+        bool hasCPUData() const noexcept { return m_vertexCount == 0 || !m_vertices.empty(); }
+        bool hasCompressedCPUData() const noexcept { return !m_compressedVertices.empty(); }
         const std::vector<VertexData>& vertices() const noexcept { return m_vertices; }
         const std::vector<uint32_t>& indices() const noexcept { return m_indices; }
 
+        // Expands the compressed copy back into vertices()/indices(), false if there is nothing to restore from
+        bool restoreCPUData();
+
+        // RAM held for this mesh's geometry now, and what the full CPU copy would take
+        size_t cpuResidentBytes() const noexcept;
+        size_t cpuFullCopyBytes() const noexcept { return vertexBufferSize() + indexBufferSize(); }
+
         // GPU side buffer and memory created via VulkanCore's VulkanVertexBuffer
         bool hasVertexBuffer() const { return m_vertexBuffer.m_buffer != VK_NULL_HANDLE; }
         VkBuffer vertexBuffer() const { return m_vertexBuffer.m_buffer; }
         VkDeviceSize vertexBufferAllocSize() const { return m_vertexBuffer.m_allocationSize; }
+        VkDeviceSize vertexBufferRange() const { return m_vertexBuffer.m_size; }
 
         bool hasIndexBuffer() const { return m_indexBuffer.m_buffer != VK_NULL_HANDLE; }
         VkBuffer indexBuffer() const { return m_indexBuffer.m_buffer; }
         VkDeviceSize indexBufferAllocSize() const { return m_indexBuffer.m_allocationSize; }
+        VkDeviceSize indexBufferRange() const { return m_indexBuffer.m_size; }
 
         // Texture handling
         TextureHandler* texture() const { return m_texture; }
 
-        // Render type handling (TEMP: To be moved to material/mesh descriptor when those are implemented)
-        RenderType renderType() const noexcept { return m_renderType; }
-        void setRenderType(RenderType _type) noexcept { m_renderType = _type; }
-        bool isTransparent() const noexcept { return m_renderType == RenderType::Transparent; }
-        bool isMasked() const noexcept { return m_renderType == RenderType::Masked; }
-        bool isOpaque() const noexcept { return m_renderType == RenderType::Opaque || m_renderType == RenderType::Masked; }
-    
-        // TEMP: used for transparent sorting until proper transform/material instances exist
-        const glm::vec3& sortPosition() const noexcept { return m_sortPosition; }
-        void setSortPosition(const glm::vec3 & _position) noexcept { m_sortPosition = _position; }
+        // Render type, sort position, visibility and bindless slots are per-frame data kept in MeshPool
 
     private:
         std::weak_ptr<VulkanCore> m_vulkanCore;
@@ -78,17 +107,24 @@ namespace Mark::RendererVK
 
         std::vector<VertexData> m_vertices;
         std::vector<uint32_t> m_indices{};
+        uint32_t m_vertexCount{ 0 };
+        uint32_t m_indexCount{ 0 };
+        MeshBounds m_bounds;
         TextureHandler* m_texture{ nullptr };
+        std::string m_texturePath; // Loaded by loadTextures so meshes added together share one texture batch
 
-        // TEMP: To be moved to material/mesh descriptor when those are implemented
-        RenderType m_renderType{ RenderType::Opaque };
-        glm::vec3 m_sortPosition{ 0.0f, 0.0f, 0.0f };
+        MeshCPUResidency m_cpuResidency{ static_cast<MeshCPUResidency>(MARK_MESH_CPU_RESIDENCY_DEFAULT) };
+        std::vector<uint8_t> m_compressedVertices; // Zigzag delta per component, split into zero-run coded byte planes
+        std::vector<uint8_t> m_compressedIndices;  // Zigzag delta against the previous index, varint packed
 
         bool m_usingFallBack{ false };
 
-        // Call device uploader to create GPU buffer from CPU data
+        // Call device uploader to create GPU buffer from CPU data, then applies m_cpuResidency
         friend struct WindowToVulkanHandler;
         void uploadToGPU();
+        void applyCPUResidency();
         void loadFromOBJ(const char* _meshPath, bool _flipV = true);
+        // Decodes the textures of every mesh in one TextureHandler::generateTextures batch
+        static void loadTextures(const std::vector<MeshHandler*>& _meshes);
     };
 } // namespace Mark::RendererVK
\ No newline at end of file
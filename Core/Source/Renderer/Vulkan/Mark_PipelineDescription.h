@@ -3,6 +3,8 @@
 #include <vector>
 #include <string>
 #include <array>
+#include <algorithm>
+#include <bit>
 
 namespace Mark::RendererVK
 {
@@ -108,6 +110,19 @@ namespace Mark::RendererVK
             VK_DYNAMIC_STATE_VIEWPORT,
             VK_DYNAMIC_STATE_SCISSOR
         };
+
+        // Extended dynamic state groups. Marked groups are set at bind time and left out of the pipeline hash,
+        // so descs differing only in these share one compiled pipeline
+        bool dynamicDepth{ false };                    // OPTIONAL: depth test/write/compare op (core 1.3)
+        bool dynamicCull{ false };                     // OPTIONAL: cull mode + front face (core 1.3)
+        bool dynamicBlend{ false };                    // OPTIONAL: blend enable/equation/write mask. Needs VK_EXT_extended_dynamic_state3, baked when missing
+    };
+
+    // What the device can make dynamic, filled by VulkanCore at device creation
+    struct PipelineDynamicStateCaps
+    {
+        bool depthAndCull{ false };
+        bool blend{ false };
     };
 
     struct PipelineRenderTargetDesc
@@ -122,6 +137,40 @@ namespace Mark::RendererVK
         uint32_t viewMask{ 0 };                        // OPTIONAL: Multiview
     };
 
+    // Specialization constants for one shader stage, resolved when the pipeline is created so the driver
+    // can fold them and strip dead branches. Ids match layout(constant_id = N), every value is 32-bit
+    struct PipelineSpecializationDesc
+    {
+        struct Constant
+        {
+            uint32_t id{ 0 };
+            uint32_t value{ 0 };
+        };
+        std::vector<Constant> constants{};             // Sorted by id, fill through the setters
+
+        void set(uint32_t _id, uint32_t _value)
+        {
+            auto it = std::lower_bound(constants.begin(), constants.end(), _id, [](const Constant& _c, uint32_t _i) { return _c.id < _i; });
+            if (it != constants.end() && it->id == _id) it->value = _value;
+            else constants.insert(it, Constant{ _id, _value });
+        }
+        void setBool(uint32_t _id, bool _value) { set(_id, _value ? VK_TRUE : VK_FALSE); }
+        void setInt(uint32_t _id, int32_t _value) { set(_id, std::bit_cast<uint32_t>(_value)); }
+        void setFloat(uint32_t _id, float _value) { set(_id, std::bit_cast<uint32_t>(_value)); }
+    };
+
+    // Push constant block every graphics pipeline layout carries. Pre-recorded command buffers bake their
+    // frame slot in here so one descriptor set can serve every swapchain image
+    struct PipelineFramePushConstants
+    {
+        uint32_t frameSlot{ 0 }; // Index into the UBO slot array
+    };
+    inline constexpr VkPushConstantRange PIPELINE_FRAME_PUSH_CONSTANT_RANGE = {
+        .stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT,
+        .offset = 0,
+        .size = sizeof(PipelineFramePushConstants)
+    };
+
     struct VulkanGraphicsPipelineCache; // Forward declaration
     struct PipelineDesc
     {
@@ -132,6 +181,8 @@ namespace Mark::RendererVK
 
         std::string debugName{ "Unnamed" };
 
+        bool descriptorBuffer{ false }; // OPTIONAL: Set 0 is bound from a VK_EXT_descriptor_buffer instead of a descriptor set
+
         PipelineRenderTargetDesc   renderTargetsDesc{};
         PipelineInputAssemblyDesc  inputAssemblyDesc{};
         PipelineRasterDesc         rasterDesc{};
@@ -139,5 +190,9 @@ namespace Mark::RendererVK
         PipelineDepthStencilDesc   depthStencilDesc{};
         PipelineBlendDesc          blendDesc{};
         PipelineDynamicStateDesc   dynamicDesc{};
+
+        // OPTIONAL: Per-stage specialization. Compile-time variants are chosen through the shader cache defines instead
+        PipelineSpecializationDesc vertexSpecialization{};
+        PipelineSpecializationDesc fragmentSpecialization{};
     };
 }
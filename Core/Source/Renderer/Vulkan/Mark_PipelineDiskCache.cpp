@@ -0,0 +1,208 @@
+#include "Mark_PipelineDiskCache.h"
+
+#include "Utils/VulkanUtils.h"
+#include "Utils/Mark_Utils.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <vector>
+
+namespace Mark::RendererVK
+{
+    namespace
+    {
+        constexpr double PIPELINE_CACHE_SAVE_INTERVAL = 30.0; // Seconds
+    }
+
+    void VulkanPipelineDiskCache::create(VkDevice _device, const VkPhysicalDeviceProperties& _deviceProperties)
+    {
+        m_device = _device;
+        m_deviceProperties = _deviceProperties;
+
+        // One file per GPU so switching devices doesn't thrash a shared blob
+        char name[64];
+        std::snprintf(name, sizeof(name), "PipelineCache_%04x_%04x.bin", _deviceProperties.vendorID, _deviceProperties.deviceID);
+        m_path = std::filesystem::path(MARK_CACHE_DIR) / name;
+
+        std::vector<uint8_t> initialData;
+#if MARK_PIPELINE_DISK_CACHE
+        std::ifstream file(m_path, std::ios::binary | std::ios::ate);
+        if (file)
+        {
+            const std::streamsize size = file.tellg();
+            file.seekg(0);
+            initialData.resize(static_cast<size_t>(std::max<std::streamsize>(size, 0)));
+            if (!file.read(reinterpret_cast<char*>(initialData.data()), size) || !validateHeader(initialData.data(), initialData.size()))
+            {
+                MARK_WARN(Utils::Category::Vulkan, "Pipeline cache on disk is stale or invalid, starting empty: %s", Utils::ShortPathForLog(m_path.string()).c_str());
+                initialData.clear();
+            }
+        }
+#endif
+
+        VkPipelineCacheCreateInfo createInfo = {
+            .sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO,
+            .pNext = nullptr,
+            .flags = 0,
+            .initialDataSize = initialData.size(),
+            .pInitialData = initialData.empty() ? nullptr : initialData.data()
+        };
+
+        VkResult res = vkCreatePipelineCache(m_device, &createInfo, nullptr, &m_pipelineCache);
+        if (res != VK_SUCCESS && !initialData.empty())
+        {
+            // Driver rejected the blob despite a matching header, fall back to an empty cache
+            MARK_WARN(Utils::Category::Vulkan, "Driver rejected pipeline cache data, starting empty");
+            createInfo.initialDataSize = 0;
+            createInfo.pInitialData = nullptr;
+            initialData.clear();
+            res = vkCreatePipelineCache(m_device, &createInfo, nullptr, &m_pipelineCache);
+        }
+        CHECK_VK_RESULT(res, "Create Pipeline Cache");
+        MARK_VK_NAME(m_device, VK_OBJECT_TYPE_PIPELINE_CACHE, m_pipelineCache, "VulkanCore.PipelineCache");
+
+        m_loadedFromDisk = !initialData.empty();
+        m_loadedSize = initialData.size();
+        m_lastSavedSize = initialData.size();
+        m_lastSavedHash = HashBytes128(initialData.data(), initialData.size());
+
+        if (m_loadedFromDisk) {
+            MARK_INFO(Utils::Category::Vulkan, "Pipeline cache loaded (%zu KB) from: %s", m_loadedSize / 1024, Utils::ShortPathForLog(m_path.string()).c_str());
+        }
+        else {
+            MARK_INFO(Utils::Category::Vulkan, "Pipeline cache created empty");
+        }
+    }
+
+    void VulkanPipelineDiskCache::destroy()
+    {
+        if (m_pipelineCache == VK_NULL_HANDLE) return;
+
+        if (m_saveThread.joinable()) {
+            m_saveThread.join();
+        }
+        save();
+        logCreationStats();
+
+        vkDestroyPipelineCache(m_device, m_pipelineCache, nullptr);
+        m_pipelineCache = VK_NULL_HANDLE;
+        MARK_INFO(Utils::Category::Vulkan, "Pipeline Cache Destroyed");
+    }
+
+    bool VulkanPipelineDiskCache::validateHeader(const uint8_t* _data, size_t _size) const
+    {
+        VkPipelineCacheHeaderVersionOne header{};
+        if (_size < sizeof(header)) return false;
+        std::memcpy(&header, _data, sizeof(header));
+
+        return header.headerSize >= sizeof(header) &&
+            header.headerVersion == VK_PIPELINE_CACHE_HEADER_VERSION_ONE &&
+            header.vendorID == m_deviceProperties.vendorID &&
+            header.deviceID == m_deviceProperties.deviceID &&
+            std::memcmp(header.pipelineCacheUUID, m_deviceProperties.pipelineCacheUUID, VK_UUID_SIZE) == 0;
+    }
+
+    bool VulkanPipelineDiskCache::save()
+    {
+#if MARK_PIPELINE_DISK_CACHE
+        std::lock_guard<std::mutex> lk(m_saveMutex);
+        if (m_pipelineCache == VK_NULL_HANDLE) return false;
+
+        size_t size = 0;
+        VkResult res = vkGetPipelineCacheData(m_device, m_pipelineCache, &size, nullptr);
+        if (res != VK_SUCCESS || size == 0) {
+            return false;
+        }
+
+        std::vector<uint8_t> data(size);
+        res = vkGetPipelineCacheData(m_device, m_pipelineCache, &size, data.data());
+        if (res != VK_SUCCESS) {
+            MARK_WARN(Utils::Category::Vulkan, "Failed to read pipeline cache data (%d)", res);
+            return false;
+        }
+
+        const PipelineStateHash128 hash = HashBytes128(data.data(), size);
+        if (size == m_lastSavedSize && hash == m_lastSavedHash) {
+            return false;
+        }
+
+        std::error_code ec;
+        std::filesystem::create_directories(m_path.parent_path(), ec);
+
+        std::filesystem::path tmpPath = m_path;
+        tmpPath += ".tmp";
+        {
+            std::ofstream out(tmpPath, std::ios::binary | std::ios::trunc);
+            if (!out || !out.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(size)))
+            {
+                MARK_WARN(Utils::Category::Vulkan, "Failed to write pipeline cache: %s", Utils::ShortPathForLog(tmpPath.string()).c_str());
+                return false;
+            }
+        }
+
+        std::filesystem::rename(tmpPath, m_path, ec);
+        if (ec)
+        {
+            MARK_WARN(Utils::Category::Vulkan, "Failed to finalise pipeline cache: %s", ec.message().c_str());
+            std::filesystem::remove(tmpPath, ec);
+            return false;
+        }
+
+        m_lastSavedSize = size;
+        m_lastSavedHash = hash;
+        MARK_DEBUG(Utils::Category::Vulkan, "Pipeline cache saved (%zu KB)", size / 1024);
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    void VulkanPipelineDiskCache::update(double _deltaTime)
+    {
+        m_timeSinceSave += _deltaTime;
+        if (m_timeSinceSave < PIPELINE_CACHE_SAVE_INTERVAL) return;
+
+        m_timeSinceSave = 0.0;
+
+        // Nothing new since the last save, or the last one is still writing
+        const uint64_t writes = m_cacheWrites.load(std::memory_order_relaxed);
+        if (writes == m_cacheWritesAtSave || m_saveInFlight.load(std::memory_order_acquire)) return;
+
+        if (m_saveThread.joinable()) {
+            m_saveThread.join();
+        }
+        m_cacheWritesAtSave = writes;
+        m_saveInFlight.store(true, std::memory_order_relaxed);
+        m_saveThread = std::thread([this]
+        {
+            save();
+            m_saveInFlight.store(false, std::memory_order_release);
+        });
+    }
+
+    void VulkanPipelineDiskCache::recordPipelineCreation(double _milliseconds)
+    {
+        m_pipelinesCreated.fetch_add(1, std::memory_order_relaxed);
+        noteCacheWrite();
+        m_creationMicroseconds.fetch_add(static_cast<uint64_t>(_milliseconds * 1000.0), std::memory_order_relaxed);
+    }
+
+    void VulkanPipelineDiskCache::logCreationStats() const
+    {
+        const uint32_t created = m_pipelinesCreated.load(std::memory_order_relaxed);
+        const double totalMs = m_creationMicroseconds.load(std::memory_order_relaxed) / 1000.0;
+        size_t lastSavedSize = 0;
+        {
+            std::lock_guard<std::mutex> lk(m_saveMutex);
+            lastSavedSize = m_lastSavedSize;
+        }
+
+        const auto level = Utils::Level::Info;
+        const auto category = Utils::Category::Vulkan;
+        MARK_SCOPE(category, level, "Pipeline creation (%s):", m_loadedFromDisk ? "warm disk cache" : "cold, no disk cache");
+        MARK_IN_SCOPE(category, level, "%u pipelines in %.2f ms (%.2f ms avg)", created, totalMs, created ? totalMs / created : 0.0);
+        MARK_IN_SCOPE(category, level, "Loaded %zu KB, last saved %zu KB", m_loadedSize / 1024, lastSavedSize / 1024);
+    }
+} // namespace Mark::RendererVK
@@ -0,0 +1,70 @@
+#pragma once
+#include "Mark_PipelineKey.h"
+
+#include <Volk/volk.h>
+
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <thread>
+
+// Set to 0 to skip loading/saving the driver pipeline cache (measures cold pipeline creation)
+#ifndef MARK_PIPELINE_DISK_CACHE
+    #define MARK_PIPELINE_DISK_CACHE 1
+#endif
+
+namespace Mark::RendererVK
+{
+    // Device-wide VkPipelineCache persisted under MARK_CACHE_DIR
+    // Every graphics and compute pipeline is created through handle() so the driver can skip recompiling
+    struct VulkanPipelineDiskCache
+    {
+        VulkanPipelineDiskCache() = default;
+        ~VulkanPipelineDiskCache() = default;
+        VulkanPipelineDiskCache(const VulkanPipelineDiskCache&) = delete;
+        VulkanPipelineDiskCache& operator=(const VulkanPipelineDiskCache&) = delete;
+
+        // Loads the blob for this device if its header matches, otherwise starts empty
+        void create(VkDevice _device, const VkPhysicalDeviceProperties& _deviceProperties);
+        // Waits for a background save, then saves and destroys the VkPipelineCache
+        void destroy();
+
+        // Writes through a temp file + rename. Skipped when the driver data is unchanged since the last load or save
+        bool save();
+        // Call once per frame. Every PIPELINE_CACHE_SAVE_INTERVAL seconds, if pipelines were created since the last save,
+        // hands save() to a background thread so the frame never waits on vkGetPipelineCacheData or the disk
+        void update(double _deltaTime);
+
+        VkPipelineCache handle() const noexcept { return m_pipelineCache; }
+
+        // Pipeline creation timing, fed by the graphics and compute pipeline paths. Also counts as a cache write
+        void recordPipelineCreation(double _milliseconds);
+        // Creations left out of the timing stats (library parts, optimised relinks) still add driver cache data
+        void noteCacheWrite() noexcept { m_cacheWrites.fetch_add(1, std::memory_order_relaxed); }
+        void logCreationStats() const;
+
+    private:
+        VkDevice m_device{ VK_NULL_HANDLE };
+        VkPipelineCache m_pipelineCache{ VK_NULL_HANDLE };
+        VkPhysicalDeviceProperties m_deviceProperties{};
+        std::filesystem::path m_path;
+
+        bool m_loadedFromDisk{ false };
+        size_t m_loadedSize{ 0 };
+        size_t m_lastSavedSize{ 0 };
+        PipelineStateHash128 m_lastSavedHash{}; // Entries can be replaced without the blob changing size
+        double m_timeSinceSave{ 0.0 };
+
+        std::atomic<uint64_t> m_cacheWrites{ 0 };
+        uint64_t m_cacheWritesAtSave{ 0 }; // Frame thread only
+        std::thread m_saveThread;
+        std::atomic<bool> m_saveInFlight{ false };
+
+        mutable std::mutex m_saveMutex;
+        std::atomic<uint32_t> m_pipelinesCreated{ 0 };
+        std::atomic<uint64_t> m_creationMicroseconds{ 0 };
+
+        bool validateHeader(const uint8_t* _data, size_t _size) const;
+    };
+} // namespace Mark::RendererVK
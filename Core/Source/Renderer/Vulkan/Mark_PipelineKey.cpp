@@ -0,0 +1,358 @@
+#include "Mark_PipelineKey.h"
+#include "Utils/Mark_Utils.h"
+
+#include <algorithm>
+#include <cstring>
+
+#if MARK_PIPELINE_KEY_BENCHMARK
+    #include <chrono>
+#endif
+
+namespace Mark::RendererVK
+{
+    namespace
+    {
+        constexpr size_t INTERNER_INITIAL_SLOTS = 256;
+
+        inline uint64_t fmix64(uint64_t _k) noexcept
+        {
+            _k ^= _k >> 33;
+            _k *= 0xff51afd7ed558ccdull;
+            _k ^= _k >> 33;
+            _k *= 0xc4ceb9fe1a85ec53ull;
+            _k ^= _k >> 33;
+            return _k;
+        }
+
+        inline uint32_t floatBits(float _f) noexcept
+        {
+            return std::bit_cast<uint32_t>(_f);
+        }
+    }
+
+    PipelineStateHash128 HashBytes128(const void* _data, size_t _size, uint64_t _seed) noexcept
+    {
+        constexpr uint64_t c1 = 0x87c37b91114253d5ull;
+        constexpr uint64_t c2 = 0x4cf5ad432745937full;
+
+        const uint8_t* bytes = static_cast<const uint8_t*>(_data);
+        const size_t blockCount = _size / 16;
+        uint64_t h1 = _seed;
+        uint64_t h2 = _seed;
+
+        for (size_t i = 0; i < blockCount; i++)
+        {
+            uint64_t k1, k2;
+            std::memcpy(&k1, bytes + i * 16, sizeof(k1));
+            std::memcpy(&k2, bytes + i * 16 + 8, sizeof(k2));
+
+            k1 *= c1; k1 = std::rotl(k1, 31); k1 *= c2; h1 ^= k1;
+            h1 = std::rotl(h1, 27); h1 += h2; h1 = h1 * 5 + 0x52dce729;
+
+            k2 *= c2; k2 = std::rotl(k2, 33); k2 *= c1; h2 ^= k2;
+            h2 = std::rotl(h2, 31); h2 += h1; h2 = h2 * 5 + 0x38495ab5;
+        }
+
+        // Tail, zero extended
+        const uint8_t* tail = bytes + blockCount * 16;
+        const size_t remaining = _size & 15;
+        uint64_t k1 = 0, k2 = 0;
+        if (remaining > 8)
+        {
+            std::memcpy(&k2, tail + 8, remaining - 8);
+            k2 *= c2; k2 = std::rotl(k2, 33); k2 *= c1; h2 ^= k2;
+        }
+        if (remaining > 0)
+        {
+            std::memcpy(&k1, tail, std::min<size_t>(remaining, 8));
+            k1 *= c1; k1 = std::rotl(k1, 31); k1 *= c2; h1 ^= k1;
+        }
+
+        h1 ^= _size;
+        h2 ^= _size;
+        h1 += h2;
+        h2 += h1;
+        h1 = fmix64(h1);
+        h2 = fmix64(h2);
+        h1 += h2;
+        h2 += h1;
+        return PipelineStateHash128{ h1, h2 };
+    }
+
+    void PackPipelineState(const PipelineDesc& _desc, uint64_t _setLayoutHash, PackedPipelineState& _out)
+    {
+        std::memset(&_out, 0, sizeof(_out));
+
+        auto setFlag = [&](PackedPipelineFlag _flag, bool _enabled) {
+            if (_enabled) _out.flags |= static_cast<uint32_t>(_flag);
+        };
+
+        // Shaders, define permutations are distinct modules so the handles cover them
+        _out.vertexShader = static_cast<uint64_t>(reinterpret_cast<uintptr_t>(_desc.vertexShader));
+        _out.fragmentShader = static_cast<uint64_t>(reinterpret_cast<uintptr_t>(_desc.fragmentShader));
+        _out.setLayoutHash = _setLayoutHash;
+        if (!_desc.vertexSpecialization.constants.empty() || !_desc.fragmentSpecialization.constants.empty())
+        {
+            uint64_t h = 1469598103934665603ull;
+            HashSpecialization(h, _desc.vertexSpecialization);
+            HashSpecialization(h, _desc.fragmentSpecialization);
+            _out.specializationHash = h;
+        }
+
+        // Render targets
+        const PipelineRenderTargetDesc& rt = _desc.renderTargetsDesc;
+        if (rt.colourFormats.size() > PackedPipelineState::MAX_COLOUR_ATTACHMENTS) {
+            MARK_FATAL(Utils::Category::Vulkan, "PipelineDesc has %zu colour attachments, the pipeline key supports %u",
+                rt.colourFormats.size(), PackedPipelineState::MAX_COLOUR_ATTACHMENTS);
+        }
+        _out.viewMask = rt.viewMask;
+        _out.depthFormat = static_cast<uint32_t>(rt.depthFormat);
+        _out.stencilFormat = static_cast<uint32_t>(rt.stencilFormat);
+        _out.colourCount = static_cast<uint32_t>(rt.colourFormats.size());
+        for (uint32_t i = 0; i < _out.colourCount; i++) {
+            _out.colourFormats[i] = static_cast<uint32_t>(rt.colourFormats[i]);
+        }
+
+        setFlag(PackedPipelineFlag::DescriptorBuffer, _desc.descriptorBuffer);
+
+        // Input assembly + tess
+        setFlag(PackedPipelineFlag::PrimitiveRestart, _desc.inputAssemblyDesc.primitiveRestartEnable);
+        _out.topology = static_cast<uint32_t>(_desc.inputAssemblyDesc.topology);
+        _out.patchControlPoints = _desc.inputAssemblyDesc.patchControlPoints;
+
+        // Dynamic groups, the state they cover stays zero below
+        const bool dynamicDepth = _desc.dynamicDesc.dynamicDepth;
+        const bool dynamicCull = _desc.dynamicDesc.dynamicCull;
+        const bool dynamicBlend = _desc.dynamicDesc.dynamicBlend;
+        setFlag(PackedPipelineFlag::DynamicDepth, dynamicDepth);
+        setFlag(PackedPipelineFlag::DynamicCull, dynamicCull);
+        setFlag(PackedPipelineFlag::DynamicBlend, dynamicBlend);
+
+        // Raster
+        const PipelineRasterDesc& r = _desc.rasterDesc;
+        _out.polygonMode = static_cast<uint32_t>(r.polygonMode);
+        if (!dynamicCull) {
+            _out.cullMode = static_cast<uint32_t>(r.cullMode);
+            _out.frontFace = static_cast<uint32_t>(r.frontFace);
+        }
+        setFlag(PackedPipelineFlag::DepthClamp, r.depthClampEnable);
+        setFlag(PackedPipelineFlag::RasterizerDiscard, r.rasterizerDiscardEnable);
+        setFlag(PackedPipelineFlag::DepthBias, r.depthBiasEnable);
+        _out.depthBiasConstantFactor = floatBits(r.depthBiasConstantFactor);
+        _out.depthBiasClamp = floatBits(r.depthBiasClamp);
+        _out.depthBiasSlopeFactor = floatBits(r.depthBiasSlopeFactor);
+        _out.lineWidth = floatBits(r.lineWidth);
+
+        // Multisample
+        const PipelineMultisampleDesc& ms = _desc.multisampleDesc;
+        _out.rasterizationSamples = static_cast<uint32_t>(ms.rasterizationSamples);
+        setFlag(PackedPipelineFlag::SampleShading, ms.sampleShadingEnable);
+        _out.minSampleShading = floatBits(ms.minSampleShading);
+        setFlag(PackedPipelineFlag::AlphaToCoverage, ms.alphaToCoverageEnable);
+        setFlag(PackedPipelineFlag::AlphaToOne, ms.alphaToOneEnable);
+        _out.sampleMask[0] = ms.sampleMask[0];
+        _out.sampleMask[1] = ms.sampleMask[1];
+
+        // Depth/stencil
+        const PipelineDepthStencilDesc& ds = _desc.depthStencilDesc;
+        if (!dynamicDepth) {
+            setFlag(PackedPipelineFlag::DepthTest, ds.depthTestEnable);
+            setFlag(PackedPipelineFlag::DepthWrite, ds.depthWriteEnable);
+            _out.depthCompareOp = static_cast<uint32_t>(ds.depthCompareOp);
+        }
+        setFlag(PackedPipelineFlag::DepthBoundsTest, ds.depthBoundsTestEnable);
+        _out.minDepthBounds = floatBits(ds.minDepthBounds);
+        _out.maxDepthBounds = floatBits(ds.maxDepthBounds);
+        setFlag(PackedPipelineFlag::StencilTest, ds.stencilTestEnable);
+        _out.front = ds.front;
+        _out.back = ds.back;
+
+        // Blending, attachments expanded to the colour count the same way pipeline creation does
+        const PipelineBlendDesc& b = _desc.blendDesc;
+        setFlag(PackedPipelineFlag::LogicOp, b.logicOpEnable);
+        _out.logicOp = static_cast<uint32_t>(b.logicOp);
+        for (uint32_t i = 0; i < 4; i++) {
+            _out.blendConstants[i] = floatBits(b.blendConstants[i]);
+        }
+
+        const size_t sourceCount = b.attachments.size();
+        uint32_t blendCount = _out.colourCount;
+        if (sourceCount > 1 && sourceCount != _out.colourCount)
+        {
+            setFlag(PackedPipelineFlag::BlendCountMismatch, _out.colourCount != 0);
+            blendCount = static_cast<uint32_t>(std::min<size_t>(sourceCount, PackedPipelineState::MAX_COLOUR_ATTACHMENTS));
+        }
+        else if (sourceCount == 1 && _out.colourCount == 0)
+        {
+            blendCount = 1;
+        }
+        _out.blendAttachmentCount = blendCount;
+
+        if (!dynamicBlend)
+        {
+            const PipelineBlendAttachmentDesc defaultAttachment{};
+            for (uint32_t i = 0; i < blendCount; i++)
+            {
+                const PipelineBlendAttachmentDesc& a = sourceCount == 0 ? defaultAttachment : sourceCount == 1 ? b.attachments[0] : b.attachments[i];
+                _out.blendAttachments[i] = PackedBlendAttachment{
+                    .enable = a.enable ? 1u : 0u,
+                    .srcColour = static_cast<uint32_t>(a.srcColour),
+                    .dstColour = static_cast<uint32_t>(a.dstColour),
+                    .colourOp = static_cast<uint32_t>(a.colourOp),
+                    .srcAlpha = static_cast<uint32_t>(a.srcAlpha),
+                    .dstAlpha = static_cast<uint32_t>(a.dstAlpha),
+                    .alphaOp = static_cast<uint32_t>(a.alphaOp),
+                    .colorWriteMask = static_cast<uint32_t>(a.colorWriteMask)
+                };
+            }
+        }
+
+        // Dynamic states, insertion sorted in place (a handful of entries)
+        const std::vector<VkDynamicState>& states = _desc.dynamicDesc.states;
+        if (states.size() > PackedPipelineState::MAX_DYNAMIC_STATES) {
+            MARK_FATAL(Utils::Category::Vulkan, "PipelineDesc has %zu dynamic states, the pipeline key supports %u",
+                states.size(), PackedPipelineState::MAX_DYNAMIC_STATES);
+        }
+        _out.dynamicStateCount = static_cast<uint32_t>(states.size());
+        for (uint32_t i = 0; i < _out.dynamicStateCount; i++)
+        {
+            const uint32_t value = static_cast<uint32_t>(states[i]);
+            uint32_t j = i;
+            for (; j > 0 && _out.dynamicStates[j - 1] > value; j--) {
+                _out.dynamicStates[j] = _out.dynamicStates[j - 1];
+            }
+            _out.dynamicStates[j] = value;
+        }
+    }
+
+    PipelineStateHash128 HashPipelineDescState(const PipelineDesc& _desc)
+    {
+        PackedPipelineState packed;
+        PackPipelineState(_desc, 0, packed);
+        return HashBytes128(&packed, sizeof(packed));
+    }
+
+    // ---------- PipelineKeyInterner ----------
+    size_t PipelineKeyInterner::probeLocked(const PackedPipelineState& _state, const PipelineStateHash128& _hash) const
+    {
+        const size_t mask = m_slots.size() - 1;
+        for (size_t i = static_cast<size_t>(_hash.a) & mask;; i = (i + 1) & mask)
+        {
+            const Slot& slot = m_slots[i];
+            if (slot.m_id == VulkanGraphicsPipelineKey::INVALID_ID) return i;
+            // Full compare on a hash match, ids must never alias different state
+            if (slot.m_hash == _hash && std::memcmp(&m_states[slot.m_id], &_state, sizeof(PackedPipelineState)) == 0) return i;
+        }
+    }
+
+    void PipelineKeyInterner::growLocked()
+    {
+        std::vector<Slot> old = std::move(m_slots);
+        m_slots.assign(old.empty() ? INTERNER_INITIAL_SLOTS : old.size() * 2, Slot{});
+
+        // Rehash from the stored hashes, states are unique so no compares are needed
+        const size_t mask = m_slots.size() - 1;
+        for (const Slot& slot : old)
+        {
+            if (slot.m_id == VulkanGraphicsPipelineKey::INVALID_ID) continue;
+            size_t i = static_cast<size_t>(slot.m_hash.a) & mask;
+            while (m_slots[i].m_id != VulkanGraphicsPipelineKey::INVALID_ID) {
+                i = (i + 1) & mask;
+            }
+            m_slots[i] = slot;
+        }
+    }
+
+    VulkanGraphicsPipelineKey PipelineKeyInterner::intern(const PackedPipelineState& _state)
+    {
+        const PipelineStateHash128 hash = HashBytes128(&_state, sizeof(_state));
+
+        std::lock_guard<std::mutex> lk(m_mutex);
+        if ((m_states.size() + 1) * 10 > m_slots.size() * 7) {
+            growLocked();
+        }
+
+        Slot& slot = m_slots[probeLocked(_state, hash)];
+        if (slot.m_id == VulkanGraphicsPipelineKey::INVALID_ID)
+        {
+            slot.m_hash = hash;
+            slot.m_id = static_cast<uint32_t>(m_states.size());
+            m_states.push_back(_state);
+        }
+        return VulkanGraphicsPipelineKey{ slot.m_id };
+    }
+
+    VulkanGraphicsPipelineKey PipelineKeyInterner::find(const PackedPipelineState& _state) const
+    {
+        const PipelineStateHash128 hash = HashBytes128(&_state, sizeof(_state));
+
+        std::lock_guard<std::mutex> lk(m_mutex);
+        if (m_slots.empty()) return VulkanGraphicsPipelineKey{};
+        return VulkanGraphicsPipelineKey{ m_slots[probeLocked(_state, hash)].m_id };
+    }
+
+#if MARK_PIPELINE_KEY_BENCHMARK
+    void BenchmarkPipelineKeys(VulkanGraphicsPipelineCache& _cache)
+    {
+        using Clock = std::chrono::steady_clock;
+        constexpr uint32_t VARIANTS = 4096;
+        constexpr uint32_t ROUNDS = 64;
+
+        // Spread over the fields real descs differ in
+        std::vector<PipelineDesc> descs;
+        descs.reserve(VARIANTS);
+        for (uint32_t i = 0; i < VARIANTS; i++)
+        {
+            PipelineDesc desc{ .cache = _cache };
+            desc.renderTargetsDesc.colourFormats = { (i & 1) ? VK_FORMAT_B8G8R8A8_SRGB : VK_FORMAT_B8G8R8A8_UNORM };
+            desc.renderTargetsDesc.depthFormat = VK_FORMAT_D32_SFLOAT;
+            desc.rasterDesc.cullMode = (i & 2) ? VK_CULL_MODE_NONE : VK_CULL_MODE_BACK_BIT;
+            desc.rasterDesc.depthBiasConstantFactor = static_cast<float>(i >> 2);
+            desc.depthStencilDesc.depthCompareOp = (i & 4) ? VK_COMPARE_OP_LESS_OR_EQUAL : VK_COMPARE_OP_LESS;
+            desc.blendDesc.attachments.resize(1);
+            desc.blendDesc.attachments[0].enable = (i & 8) != 0;
+            desc.dynamicDesc.dynamicDepth = (i & 16) != 0;
+            desc.fragmentSpecialization.set(0, i & 32);
+            descs.push_back(std::move(desc));
+        }
+
+        PipelineKeyInterner interner;
+        PackedPipelineState packed;
+        uint64_t sink = 0; // Keeps the optimiser from dropping the loops
+
+        auto nsPerOp = [](Clock::time_point _start, uint64_t _ops) {
+            return std::chrono::duration<double, std::nano>(Clock::now() - _start).count() / static_cast<double>(_ops);
+        };
+
+        Clock::time_point start = Clock::now();
+        for (uint32_t round = 0; round < ROUNDS; round++) {
+            for (const PipelineDesc& desc : descs) {
+                PackPipelineState(desc, 0x1234, packed);
+                sink += HashBytes128(&packed, sizeof(packed)).a;
+            }
+        }
+        const double packHashNs = nsPerOp(start, uint64_t(VARIANTS) * ROUNDS);
+
+        start = Clock::now();
+        for (const PipelineDesc& desc : descs) {
+            PackPipelineState(desc, 0x1234, packed);
+            sink += interner.intern(packed).m_id;
+        }
+        const double internNs = nsPerOp(start, VARIANTS);
+
+        start = Clock::now();
+        for (uint32_t round = 0; round < ROUNDS; round++) {
+            for (const PipelineDesc& desc : descs) {
+                PackPipelineState(desc, 0x1234, packed);
+                sink += interner.intern(packed).m_id;
+            }
+        }
+        const double hitNs = nsPerOp(start, uint64_t(VARIANTS) * ROUNDS);
+
+        MARK_INFO(Utils::Category::Vulkan,
+            "Pipeline key benchmark (%u descs, %zu unique, %zu B packed): pack+hash %.1f ns, first intern %.1f ns, repeat key %.1f ns (%.2f M keys/s) [%llu]",
+            VARIANTS, interner.size(), sizeof(PackedPipelineState), packHashNs, internNs, hitNs, 1000.0 / hitNs,
+            static_cast<unsigned long long>(sink & 0xF));
+    }
+#endif
+} // namespace Mark::RendererVK
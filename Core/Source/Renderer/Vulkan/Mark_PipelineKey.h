@@ -0,0 +1,204 @@
+#pragma once
+#include "Mark_PipelineDescription.h"
+
+#include <Volk/volk.h>
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <type_traits>
+#include <vector>
+
+// Set to 1 to log key creation and lookup throughput once the graphics pipeline cache exists
+#ifndef MARK_PIPELINE_KEY_BENCHMARK
+    #define MARK_PIPELINE_KEY_BENCHMARK 0
+#endif
+
+namespace Mark::RendererVK
+{
+    struct PipelineStateHash128
+    {
+        uint64_t a{ 0 };
+        uint64_t b{ 0 };
+        bool operator==(const PipelineStateHash128& o) const noexcept {return a == o.a && b == o.b; }
+    };
+
+    // FNV-1a mixing into 64-bit state
+    static inline void HashMix64(uint64_t& h, uint64_t v) noexcept
+    {
+        constexpr uint64_t kPrime = 1099511628211ull; // FNV-1a constant
+        h ^= v;
+        h *= kPrime;
+    }
+
+    static inline uint64_t HashFloat(float f) noexcept
+    {
+        return static_cast<uint64_t>(std::bit_cast<uint32_t>(f)); // Hash bit-pattern
+    }
+
+    static inline void HashStencilOpState(uint64_t& h, const VkStencilOpState& s) noexcept
+    {
+        HashMix64(h, static_cast<uint64_t>(s.failOp));
+        HashMix64(h, static_cast<uint64_t>(s.passOp));
+        HashMix64(h, static_cast<uint64_t>(s.depthFailOp));
+        HashMix64(h, static_cast<uint64_t>(s.compareOp));
+        HashMix64(h, static_cast<uint64_t>(s.compareMask));
+        HashMix64(h, static_cast<uint64_t>(s.writeMask));
+        HashMix64(h, static_cast<uint64_t>(s.reference));
+    }
+
+    static inline void HashSpecialization(uint64_t& h, const PipelineSpecializationDesc& s) noexcept
+    {
+        HashMix64(h, static_cast<uint64_t>(s.constants.size()));
+        for (const PipelineSpecializationDesc::Constant& c : s.constants) {
+            HashMix64(h, (static_cast<uint64_t>(c.id) << 32) | c.value);
+        }
+    }
+
+    // 128-bit MurmurHash3 (x64 variant), 16 bytes per step
+    PipelineStateHash128 HashBytes128(const void* _data, size_t _size, uint64_t _seed = 0) noexcept;
+
+    // Folds a byte range into a running 64-bit hash, for keys built from several pieces or a file read in chunks
+    static inline void HashMixBytes(uint64_t& h, const void* _data, size_t _size) noexcept
+    {
+        const PipelineStateHash128 bytes = HashBytes128(_data, _size, h);
+        HashMix64(h, bytes.a);
+        HashMix64(h, bytes.b);
+    }
+
+    enum class PackedPipelineFlag : uint32_t
+    {
+        PrimitiveRestart      = 1u << 0,
+        DynamicDepth          = 1u << 1,
+        DynamicCull           = 1u << 2,
+        DynamicBlend          = 1u << 3,
+        DepthClamp            = 1u << 4,
+        RasterizerDiscard     = 1u << 5,
+        DepthBias             = 1u << 6,
+        SampleShading         = 1u << 7,
+        AlphaToCoverage       = 1u << 8,
+        AlphaToOne            = 1u << 9,
+        DepthTest             = 1u << 10,
+        DepthWrite            = 1u << 11,
+        DepthBoundsTest       = 1u << 12,
+        StencilTest           = 1u << 13,
+        LogicOp               = 1u << 14,
+        BlendCountMismatch    = 1u << 15, // Rejected at creation, only kept so the key differs
+        DescriptorBuffer      = 1u << 16
+    };
+
+    struct PackedBlendAttachment
+    {
+        uint32_t enable;
+        uint32_t srcColour;
+        uint32_t dstColour;
+        uint32_t colourOp;
+        uint32_t srcAlpha;
+        uint32_t dstAlpha;
+        uint32_t alphaOp;
+        uint32_t colorWriteMask;
+    };
+
+    // Canonical fixed-size form of everything a PipelineDesc contributes to its pipeline.
+    // Built without allocating: blend attachments expanded to the colour count, dynamic states sorted,
+    // state owned by a dynamic group and unused slots zeroed. No padding, so equal state is equal bytes
+    struct PackedPipelineState
+    {
+        static constexpr uint32_t MAX_COLOUR_ATTACHMENTS = 8;
+        static constexpr uint32_t MAX_DYNAMIC_STATES = 16;
+
+        uint64_t vertexShader;
+        uint64_t fragmentShader;
+        uint64_t setLayoutHash;
+        uint64_t specializationHash;                   // Vertex + fragment constants
+
+        uint32_t viewMask;
+        uint32_t depthFormat;
+        uint32_t stencilFormat;
+        uint32_t colourCount;
+        uint32_t colourFormats[MAX_COLOUR_ATTACHMENTS];
+
+        uint32_t flags;                                // PackedPipelineFlag bits
+        uint32_t topology;
+        uint32_t patchControlPoints;
+
+        uint32_t polygonMode;
+        uint32_t cullMode;
+        uint32_t frontFace;
+        uint32_t depthBiasConstantFactor;              // Float bit patterns from here on
+        uint32_t depthBiasClamp;
+        uint32_t depthBiasSlopeFactor;
+        uint32_t lineWidth;
+
+        uint32_t rasterizationSamples;
+        uint32_t minSampleShading;
+        uint32_t sampleMask[2];
+
+        uint32_t depthCompareOp;
+        uint32_t minDepthBounds;
+        uint32_t maxDepthBounds;
+        VkStencilOpState front;
+        VkStencilOpState back;
+
+        uint32_t logicOp;
+        uint32_t blendConstants[4];
+        uint32_t blendAttachmentCount;
+        PackedBlendAttachment blendAttachments[MAX_COLOUR_ATTACHMENTS];
+
+        uint32_t dynamicStateCount;
+        uint32_t dynamicStates[MAX_DYNAMIC_STATES];
+    };
+    static_assert(std::has_unique_object_representations_v<PackedPipelineState>, "PackedPipelineState must not contain padding");
+
+    void PackPipelineState(const PipelineDesc& _desc, uint64_t _setLayoutHash, PackedPipelineState& _out);
+
+    // Hash of the packed state, shaders included unless the desc has them nulled
+    PipelineStateHash128 HashPipelineDescState(const PipelineDesc& _desc);
+
+    // Dense id of an interned PackedPipelineState, valid for the lifetime of the interner
+    struct VulkanGraphicsPipelineKey
+    {
+        static constexpr uint32_t INVALID_ID = UINT32_MAX;
+        uint32_t m_id{ INVALID_ID };
+
+        bool isValid() const noexcept { return m_id != INVALID_ID; }
+        bool operator==(const VulkanGraphicsPipelineKey& _o) const noexcept { return m_id == _o.m_id; }
+    };
+
+    // Packed state -> dense id, open addressing with linear probing on the 128-bit hash.
+    // Ids are never recycled so they can index flat arrays, a session only ever sees a few hundred descs
+    struct PipelineKeyInterner
+    {
+        PipelineKeyInterner() = default;
+        ~PipelineKeyInterner() = default;
+        PipelineKeyInterner(const PipelineKeyInterner&) = delete;
+        PipelineKeyInterner& operator=(const PipelineKeyInterner&) = delete;
+
+        VulkanGraphicsPipelineKey intern(const PackedPipelineState& _state);
+        // Invalid key when the state was never interned
+        VulkanGraphicsPipelineKey find(const PackedPipelineState& _state) const;
+
+        size_t size() const { std::lock_guard<std::mutex> lk(m_mutex); return m_states.size(); }
+
+    private:
+        struct Slot
+        {
+            PipelineStateHash128 m_hash{};
+            uint32_t m_id{ VulkanGraphicsPipelineKey::INVALID_ID };
+        };
+
+        // Index of the matching slot, or of the empty slot the state would go in
+        size_t probeLocked(const PackedPipelineState& _state, const PipelineStateHash128& _hash) const;
+        void growLocked();
+
+        std::vector<Slot> m_slots; // Power of two, kept under 70% full
+        std::vector<PackedPipelineState> m_states; // Indexed by id
+        mutable std::mutex m_mutex;
+    };
+
+#if MARK_PIPELINE_KEY_BENCHMARK
+    // Times packing, hashing, first-time interning and repeat lookups over a spread of descs
+    void BenchmarkPipelineKeys(VulkanGraphicsPipelineCache& _cache);
+#endif
+} // namespace Mark::RendererVK
@@ -0,0 +1,281 @@
+#include "Mark_PipelineLibrary.h"
+#include "Mark_GraphicsPipelineCache.h"
+#include "Mark_Shader.h"
+#include "Utils/Mark_Utils.h"
+#include "Utils/VulkanUtils.h"
+
+#include <algorithm>
+
+namespace Mark::RendererVK
+{
+    void VulkanPipelineLibraryCache::create(VkDevice _device, bool _fastLinking, const VulkanShaderCache* _shaderCache)
+    {
+        m_device = _device;
+        m_fastLinking = _fastLinking;
+        m_shaderCache = _shaderCache;
+        MARK_INFO(Utils::Category::Vulkan, "Graphics pipeline library enabled (fast linking=%s)", _fastLinking ? "yes" : "no");
+    }
+
+    void VulkanPipelineLibraryCache::destroy()
+    {
+        std::lock_guard<std::mutex> lk(m_mutex);
+        if (m_device == VK_NULL_HANDLE) return;
+
+        size_t destroyed = 0;
+        for (auto& parts : m_parts)
+        {
+            for (auto& [hash, library] : parts) {
+                vkDestroyPipeline(m_device, library.m_pipeline, nullptr);
+            }
+            destroyed += parts.size();
+            parts.clear();
+        }
+        for (VkPipeline library : m_retiredParts) {
+            vkDestroyPipeline(m_device, library, nullptr);
+        }
+        destroyed += m_retiredParts.size();
+        m_retiredParts.clear();
+        for (auto& [hash, layout] : m_layouts) {
+            vkDestroyPipelineLayout(m_device, layout, nullptr);
+        }
+        m_layouts.clear();
+
+        MARK_DEBUG(Utils::Category::Vulkan, "Graphics pipeline library destroyed (%zu parts)", destroyed);
+        m_device = VK_NULL_HANDLE;
+    }
+
+    uint64_t VulkanPipelineLibraryCache::hashPart(PipelineLibraryPart _part, const PipelineDesc& _desc, uint64_t _set0LayoutHash, uint64_t _shaderIdentity)
+    {
+        uint64_t h = 1469598103934665603ull;
+        auto mix = [&](uint64_t v) { HashMix64(h, v); };
+
+        mix(static_cast<uint64_t>(_part));
+        mix(static_cast<uint64_t>(_desc.descriptorBuffer ? 1u : 0u)); // Linked parts must all agree on it
+
+        // Every part gets the full dynamic list, states outside its subset are ignored by the driver
+        const PipelineDynamicStateDesc& dyn = _desc.dynamicDesc;
+        mix(static_cast<uint64_t>(dyn.dynamicDepth ? 1u : 0u));
+        mix(static_cast<uint64_t>(dyn.dynamicCull ? 1u : 0u));
+        mix(static_cast<uint64_t>(dyn.dynamicBlend ? 1u : 0u));
+        std::vector<VkDynamicState> states = dyn.states;
+        std::sort(states.begin(), states.end());
+        mix(static_cast<uint64_t>(states.size()));
+        for (VkDynamicState s : states) {
+            mix(static_cast<uint64_t>(s));
+        }
+
+        const PipelineRenderTargetDesc& rt = _desc.renderTargetsDesc;
+        const PipelineMultisampleDesc& ms = _desc.multisampleDesc;
+        auto mixMultisample = [&]()
+        {
+            mix(static_cast<uint64_t>(ms.rasterizationSamples));
+            mix(static_cast<uint64_t>(ms.sampleShadingEnable ? 1u : 0u));
+            mix(HashFloat(ms.minSampleShading));
+            mix(static_cast<uint64_t>(ms.alphaToCoverageEnable ? 1u : 0u));
+            mix(static_cast<uint64_t>(ms.alphaToOneEnable ? 1u : 0u));
+            for (auto m : ms.sampleMask) {
+                mix(static_cast<uint64_t>(m));
+            }
+        };
+
+        switch (_part)
+        {
+        case PipelineLibraryPart::VertexInput:
+            mix(static_cast<uint64_t>(_desc.inputAssemblyDesc.topology));
+            mix(static_cast<uint64_t>(_desc.inputAssemblyDesc.primitiveRestartEnable ? 1u : 0u));
+            break;
+
+        case PipelineLibraryPart::PreRasterization:
+        {
+            const PipelineRasterDesc& r = _desc.rasterDesc;
+            mix(_shaderIdentity);
+            HashSpecialization(h, _desc.vertexSpecialization);
+            mix(_set0LayoutHash);
+            mix(static_cast<uint64_t>(rt.viewMask));
+            mix(static_cast<uint64_t>(_desc.inputAssemblyDesc.topology == VK_PRIMITIVE_TOPOLOGY_PATCH_LIST ? 1u : 0u));
+            mix(static_cast<uint64_t>(_desc.inputAssemblyDesc.patchControlPoints));
+            mix(static_cast<uint64_t>(r.polygonMode));
+            if (!dyn.dynamicCull) {
+                mix(static_cast<uint64_t>(r.cullMode));
+                mix(static_cast<uint64_t>(r.frontFace));
+            }
+            mix(static_cast<uint64_t>(r.depthClampEnable ? 1u : 0u));
+            mix(static_cast<uint64_t>(r.rasterizerDiscardEnable ? 1u : 0u));
+            mix(static_cast<uint64_t>(r.depthBiasEnable ? 1u : 0u));
+            mix(HashFloat(r.depthBiasConstantFactor));
+            mix(HashFloat(r.depthBiasClamp));
+            mix(HashFloat(r.depthBiasSlopeFactor));
+            mix(HashFloat(r.lineWidth));
+            break;
+        }
+
+        case PipelineLibraryPart::FragmentShader:
+        {
+            const PipelineDepthStencilDesc& ds = _desc.depthStencilDesc;
+            mix(_shaderIdentity);
+            HashSpecialization(h, _desc.fragmentSpecialization);
+            mix(_set0LayoutHash);
+            mix(static_cast<uint64_t>(rt.viewMask));
+            mix(static_cast<uint64_t>(rt.depthFormat));
+            mix(static_cast<uint64_t>(rt.stencilFormat));
+            mixMultisample();
+            if (!dyn.dynamicDepth) {
+                mix(static_cast<uint64_t>(ds.depthTestEnable ? 1u : 0u));
+                mix(static_cast<uint64_t>(ds.depthWriteEnable ? 1u : 0u));
+                mix(static_cast<uint64_t>(ds.depthCompareOp));
+            }
+            mix(static_cast<uint64_t>(ds.depthBoundsTestEnable ? 1u : 0u));
+            mix(HashFloat(ds.minDepthBounds));
+            mix(HashFloat(ds.maxDepthBounds));
+            mix(static_cast<uint64_t>(ds.stencilTestEnable ? 1u : 0u));
+            HashStencilOpState(h, ds.front);
+            HashStencilOpState(h, ds.back);
+            break;
+        }
+
+        case PipelineLibraryPart::FragmentOutput:
+        {
+            const PipelineBlendDesc& b = _desc.blendDesc;
+            mix(static_cast<uint64_t>(rt.viewMask));
+            mix(static_cast<uint64_t>(rt.depthFormat));
+            mix(static_cast<uint64_t>(rt.stencilFormat));
+            mix(static_cast<uint64_t>(rt.colourFormats.size()));
+            for (VkFormat f : rt.colourFormats) {
+                mix(static_cast<uint64_t>(f));
+            }
+            mixMultisample();
+            mix(static_cast<uint64_t>(b.logicOpEnable ? 1u : 0u));
+            mix(static_cast<uint64_t>(b.logicOp));
+            for (float c : b.blendConstants) {
+                mix(HashFloat(c));
+            }
+            mix(static_cast<uint64_t>(b.attachments.size()));
+            if (!dyn.dynamicBlend)
+            {
+                for (const PipelineBlendAttachmentDesc& a : b.attachments)
+                {
+                    mix(static_cast<uint64_t>(a.enable ? 1u : 0u));
+                    mix(static_cast<uint64_t>(a.srcColour));
+                    mix(static_cast<uint64_t>(a.dstColour));
+                    mix(static_cast<uint64_t>(a.colourOp));
+                    mix(static_cast<uint64_t>(a.srcAlpha));
+                    mix(static_cast<uint64_t>(a.dstAlpha));
+                    mix(static_cast<uint64_t>(a.alphaOp));
+                    mix(static_cast<uint64_t>(a.colorWriteMask));
+                }
+            }
+            break;
+        }
+
+        default:
+            break;
+        }
+
+        return h;
+    }
+
+    uint64_t VulkanPipelineLibraryCache::shaderIdentity(PipelineLibraryPart _part, const PipelineDesc& _desc) const
+    {
+        VkShaderModule module = VK_NULL_HANDLE;
+        if (_part == PipelineLibraryPart::PreRasterization) module = _desc.vertexShader;
+        else if (_part == PipelineLibraryPart::FragmentShader) module = _desc.fragmentShader;
+        if (module == VK_NULL_HANDLE) return 0;
+
+        const uint64_t identity = m_shaderCache ? m_shaderCache->moduleIdentity(module) : 0;
+        return identity != 0 ? identity : static_cast<uint64_t>(reinterpret_cast<uintptr_t>(module));
+    }
+
+    VkPipeline VulkanPipelineLibraryCache::acquirePart(PipelineLibraryPart _part, const PipelineDesc& _desc, uint64_t _set0LayoutHash, const PartCreateFn& _creator)
+    {
+        const uint64_t identity = shaderIdentity(_part, _desc);
+        const uint64_t hash = hashPart(_part, _desc, _set0LayoutHash, identity);
+
+        auto& parts = m_parts[static_cast<size_t>(_part)];
+        {
+            std::lock_guard<std::mutex> lk(m_mutex);
+            auto it = parts.find(hash);
+            if (it != parts.end()) return it->second.m_pipeline;
+        }
+
+        // Part compiles are the expensive bit, run them unlocked so other workers aren't serialised behind one
+        VkPipeline created = _creator();
+        if (created == VK_NULL_HANDLE) return VK_NULL_HANDLE;
+
+        std::lock_guard<std::mutex> lk(m_mutex);
+        auto [it, inserted] = parts.emplace(hash, Part{ .m_pipeline = created, .m_shaderIdentity = identity });
+        if (!inserted) {
+            vkDestroyPipeline(m_device, created, nullptr);
+        }
+        return it->second.m_pipeline;
+    }
+
+    void VulkanPipelineLibraryCache::releaseShader(uint64_t _shaderIdentity)
+    {
+        std::lock_guard<std::mutex> lk(m_mutex);
+        if (m_device == VK_NULL_HANDLE) return;
+
+        size_t released = 0;
+        for (PipelineLibraryPart part : { PipelineLibraryPart::PreRasterization, PipelineLibraryPart::FragmentShader })
+        {
+            auto& parts = m_parts[static_cast<size_t>(part)];
+            for (auto it = parts.begin(); it != parts.end(); )
+            {
+                if (it->second.m_shaderIdentity == _shaderIdentity)
+                {
+                    m_retiredParts.push_back(it->second.m_pipeline);
+                    it = parts.erase(it);
+                    released++;
+                }
+                else
+                {
+                    ++it;
+                }
+            }
+        }
+        if (released) {
+            MARK_DEBUG(Utils::Category::Vulkan, "Graphics pipeline library released %zu parts of a destroyed shader", released);
+        }
+    }
+
+    void VulkanPipelineLibraryCache::destroyRetiredParts()
+    {
+        std::lock_guard<std::mutex> lk(m_mutex);
+        // Linked pipelines don't reference their libraries, only a link still in progress would
+        for (VkPipeline library : m_retiredParts) {
+            vkDestroyPipeline(m_device, library, nullptr);
+        }
+        m_retiredParts.clear();
+    }
+
+    VkPipelineLayout VulkanPipelineLibraryCache::acquireLayout(VkDescriptorSetLayout _set0Layout, uint64_t _set0LayoutHash)
+    {
+        std::lock_guard<std::mutex> lk(m_mutex);
+        auto it = m_layouts.find(_set0LayoutHash);
+        if (it != m_layouts.end()) return it->second;
+
+        VkPipelineLayout layout = VK_NULL_HANDLE;
+        VkPipelineLayoutCreateInfo layoutInfo = {
+            .sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
+            .setLayoutCount = 1u,
+            .pSetLayouts = &_set0Layout,
+            .pushConstantRangeCount = 1u,
+            .pPushConstantRanges = &PIPELINE_FRAME_PUSH_CONSTANT_RANGE
+        };
+        VkResult res = vkCreatePipelineLayout(m_device, &layoutInfo, nullptr, &layout);
+        CHECK_VK_RESULT(res, "Failed to create pipeline library layout");
+        MARK_VK_NAME(m_device, VK_OBJECT_TYPE_PIPELINE_LAYOUT, layout, "VulkanPipelineLibrary.PipeLayout");
+
+        m_layouts.emplace(_set0LayoutHash, layout);
+        return layout;
+    }
+
+    size_t VulkanPipelineLibraryCache::partCount() const
+    {
+        std::lock_guard<std::mutex> lk(m_mutex);
+        size_t count = 0;
+        for (const auto& parts : m_parts) {
+            count += parts.size();
+        }
+        return count;
+    }
+} // namespace Mark::RendererVK
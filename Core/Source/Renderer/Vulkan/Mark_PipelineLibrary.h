@@ -0,0 +1,88 @@
+#pragma once
+#include "Mark_PipelineDescription.h"
+
+#include <Volk/volk.h>
+
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+// Set to 0 to always create monolithic pipelines, even when VK_EXT_graphics_pipeline_library is available
+#ifndef MARK_PIPELINE_LIBRARY
+    #define MARK_PIPELINE_LIBRARY 1
+#endif
+
+namespace Mark::RendererVK
+{
+    struct VulkanShaderCache;
+
+    // The four VK_EXT_graphics_pipeline_library subsets a complete graphics pipeline is linked from
+    enum class PipelineLibraryPart : uint8_t
+    {
+        VertexInput,
+        PreRasterization,
+        FragmentShader,
+        FragmentOutput,
+        Count
+    };
+
+    // Part libraries and the shared pipeline layouts they are built against, each keyed by its own hash.
+    // N vertex x M fragment variants cost N + M part compiles, new combinations only pay for a link.
+    // Shader parts are keyed on the shader cache's content identity and dropped when that module is destroyed
+    struct VulkanPipelineLibraryCache
+    {
+        using PartCreateFn = std::function<VkPipeline()>;
+        using Parts = std::array<VkPipeline, static_cast<size_t>(PipelineLibraryPart::Count)>;
+
+        VulkanPipelineLibraryCache() = default;
+        ~VulkanPipelineLibraryCache() = default;
+        VulkanPipelineLibraryCache(const VulkanPipelineLibraryCache&) = delete;
+        VulkanPipelineLibraryCache& operator=(const VulkanPipelineLibraryCache&) = delete;
+
+        // _shaderCache resolves module identities, modules from elsewhere fall back to keying on the handle
+        void create(VkDevice _device, bool _fastLinking, const VulkanShaderCache* _shaderCache);
+        void destroy();
+
+        bool isEnabled() const noexcept { return m_device != VK_NULL_HANDLE; }
+        // False when the driver reports links as slow, still cheaper than a monolithic compile per combination
+        bool hasFastLinking() const noexcept { return m_fastLinking; }
+
+        // Hash of only the desc state that feeds the given part, _shaderIdentity stands in for the part's module
+        static uint64_t hashPart(PipelineLibraryPart _part, const PipelineDesc& _desc, uint64_t _set0LayoutHash, uint64_t _shaderIdentity);
+
+        // Returns the cached part or creates it outside the lock. Racing creators keep the first result
+        VkPipeline acquirePart(PipelineLibraryPart _part, const PipelineDesc& _desc, uint64_t _set0LayoutHash, const PartCreateFn& _creator);
+
+        // Drops the shader parts built from a destroyed module. They're destroyed by destroyRetiredParts once no
+        // compile or upgrade job can still be linking them
+        void releaseShader(uint64_t _shaderIdentity);
+        void destroyRetiredParts();
+
+        // Layout shared by every part and link for this set 0 layout, owned by the library cache
+        VkPipelineLayout acquireLayout(VkDescriptorSetLayout _set0Layout, uint64_t _set0LayoutHash);
+
+        size_t partCount() const;
+
+    private:
+        struct Part
+        {
+            VkPipeline m_pipeline{ VK_NULL_HANDLE };
+            uint64_t m_shaderIdentity{ 0 }; // 0 for parts without a shader stage
+        };
+
+        // Shader cache identity of the module the part compiles, its handle if the cache doesn't own it
+        uint64_t shaderIdentity(PipelineLibraryPart _part, const PipelineDesc& _desc) const;
+
+        VkDevice m_device{ VK_NULL_HANDLE };
+        bool m_fastLinking{ false };
+        const VulkanShaderCache* m_shaderCache{ nullptr };
+
+        mutable std::mutex m_mutex;
+        std::array<std::unordered_map<uint64_t, Part>, static_cast<size_t>(PipelineLibraryPart::Count)> m_parts;
+        std::unordered_map<uint64_t, VkPipelineLayout> m_layouts;
+        std::vector<VkPipeline> m_retiredParts;
+    };
+} // namespace Mark::RendererVK
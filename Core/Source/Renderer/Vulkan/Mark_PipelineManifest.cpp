@@ -0,0 +1,441 @@
+#include "Mark_PipelineManifest.h"
+#include "Mark_GraphicsPipeline.h"
+#include "Mark_Shader.h"
+
+#include "Utils/Mark_Utils.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <type_traits>
+
+namespace Mark::RendererVK
+{
+    namespace
+    {
+        constexpr uint32_t PIPELINE_MANIFEST_MAGIC = 0x4D4C504Du; // "MPLM"
+        constexpr uint32_t PIPELINE_MANIFEST_VERSION = 6;
+        constexpr size_t PIPELINE_MANIFEST_MAX_ENTRIES = 1024; // Oldest entries dropped past this
+
+        // Desc sub-structs are stored as raw bytes, any layout change invalidates the file
+        uint64_t layoutSignature()
+        {
+            uint64_t h = 1469598103934665603ull;
+            HashMix64(h, sizeof(PipelineInputAssemblyDesc));
+            HashMix64(h, sizeof(PipelineRasterDesc));
+            HashMix64(h, sizeof(PipelineMultisampleDesc));
+            HashMix64(h, sizeof(PipelineDepthStencilDesc));
+            HashMix64(h, sizeof(PipelineBlendAttachmentDesc));
+            HashMix64(h, sizeof(VkStencilOpState));
+            HashMix64(h, sizeof(PipelineSpecializationDesc::Constant));
+            return h;
+        }
+
+        void hashString(uint64_t& _hash, const std::string& _str)
+        {
+            HashMix64(_hash, _str.size());
+            for (unsigned char c : _str) {
+                HashMix64(_hash, c);
+            }
+        }
+
+        struct ManifestWriter
+        {
+            std::vector<uint8_t> m_data;
+
+            template<typename T>
+            void pod(const T& _value)
+            {
+                static_assert(std::is_trivially_copyable_v<T>);
+                const auto* bytes = reinterpret_cast<const uint8_t*>(&_value);
+                m_data.insert(m_data.end(), bytes, bytes + sizeof(T));
+            }
+
+            template<typename T>
+            void podVector(const std::vector<T>& _values)
+            {
+                static_assert(std::is_trivially_copyable_v<T>);
+                pod(static_cast<uint32_t>(_values.size()));
+                const auto* bytes = reinterpret_cast<const uint8_t*>(_values.data());
+                m_data.insert(m_data.end(), bytes, bytes + _values.size() * sizeof(T));
+            }
+
+            void string(const std::string& _str)
+            {
+                pod(static_cast<uint32_t>(_str.size()));
+                m_data.insert(m_data.end(), _str.begin(), _str.end());
+            }
+
+            void defines(const ShaderDefines& _defines)
+            {
+                pod(static_cast<uint32_t>(_defines.size()));
+                for (const ShaderDefine& define : _defines)
+                {
+                    string(define.m_name);
+                    string(define.m_value);
+                }
+            }
+        };
+
+        struct ManifestReader
+        {
+            const uint8_t* m_data{ nullptr };
+            size_t m_size{ 0 };
+            size_t m_offset{ 0 };
+
+            bool bytes(void* _out, size_t _count)
+            {
+                if (_count > m_size - m_offset) return false;
+                std::memcpy(_out, m_data + m_offset, _count);
+                m_offset += _count;
+                return true;
+            }
+
+            template<typename T>
+            bool pod(T& _out)
+            {
+                static_assert(std::is_trivially_copyable_v<T>);
+                return bytes(&_out, sizeof(T));
+            }
+
+            template<typename T>
+            bool podVector(std::vector<T>& _out)
+            {
+                uint32_t count = 0;
+                if (!pod(count) || count > (m_size - m_offset) / sizeof(T)) return false;
+                _out.resize(count);
+                return bytes(_out.data(), count * sizeof(T));
+            }
+
+            bool string(std::string& _out)
+            {
+                uint32_t length = 0;
+                if (!pod(length) || length > m_size - m_offset) return false;
+                _out.assign(reinterpret_cast<const char*>(m_data + m_offset), length);
+                m_offset += length;
+                return true;
+            }
+
+            bool defines(ShaderDefines& _out)
+            {
+                uint32_t count = 0;
+                if (!pod(count) || count > (m_size - m_offset) / (2 * sizeof(uint32_t))) return false;
+                _out.resize(count);
+                for (ShaderDefine& define : _out)
+                {
+                    if (!string(define.m_name) || !string(define.m_value)) return false;
+                }
+                return true;
+            }
+        };
+    }
+
+    void VulkanPipelineManifest::create(VkDevice _device, VulkanShaderCache* _shaderCache, VulkanGraphicsPipelineCache* _pipelineCache)
+    {
+        m_device = _device;
+        m_shaderCache = _shaderCache;
+        m_pipelineCache = _pipelineCache;
+        m_path = std::filesystem::path(MARK_CACHE_DIR) / "PipelineManifest.bin";
+
+#if MARK_PIPELINE_PREWARM
+        if (load()) {
+            MARK_INFO(Utils::Category::Vulkan, "Pipeline manifest loaded: %zu recorded pipeline(s)", m_entries.size());
+        }
+#endif
+    }
+
+    void VulkanPipelineManifest::destroy()
+    {
+        save();
+        m_entries.clear();
+        m_identities.clear();
+        m_shaderCache = nullptr;
+        m_pipelineCache = nullptr;
+    }
+
+    bool VulkanPipelineManifest::load()
+    {
+        std::ifstream file(m_path, std::ios::binary | std::ios::ate);
+        if (!file) return false;
+
+        const std::streamsize size = file.tellg();
+        file.seekg(0);
+        std::vector<uint8_t> data(static_cast<size_t>(std::max<std::streamsize>(size, 0)));
+        if (!file.read(reinterpret_cast<char*>(data.data()), size)) return false;
+
+        ManifestReader reader{ .m_data = data.data(), .m_size = data.size() };
+
+        uint32_t magic = 0, version = 0, count = 0;
+        uint64_t signature = 0;
+        if (!reader.pod(magic) || !reader.pod(version) || !reader.pod(signature) || !reader.pod(count) ||
+            magic != PIPELINE_MANIFEST_MAGIC || version != PIPELINE_MANIFEST_VERSION || signature != layoutSignature())
+        {
+            MARK_WARN(Utils::Category::Vulkan, "Pipeline manifest is stale, starting a new one: %s", Utils::ShortPathForLog(m_path.string()).c_str());
+            return false;
+        }
+
+        std::vector<Entry> entries;
+        entries.reserve(count);
+        for (uint32_t i = 0; i < count; i++)
+        {
+            Entry e;
+            const bool ok =
+                reader.pod(e.m_identity) && reader.pod(e.m_setLayoutHash) &&
+                reader.string(e.m_vertex.m_path) && reader.string(e.m_vertex.m_entry) && reader.pod(e.m_vertex.m_stage) && reader.defines(e.m_vertex.m_defines) &&
+                reader.string(e.m_fragment.m_path) && reader.string(e.m_fragment.m_entry) && reader.pod(e.m_fragment.m_stage) && reader.defines(e.m_fragment.m_defines) &&
+                reader.string(e.m_debugName) &&
+                reader.podVector(e.m_renderTargetsDesc.colourFormats) &&
+                reader.pod(e.m_renderTargetsDesc.depthFormat) &&
+                reader.pod(e.m_renderTargetsDesc.stencilFormat) &&
+                reader.pod(e.m_renderTargetsDesc.viewMask) &&
+                reader.pod(e.m_inputAssemblyDesc) &&
+                reader.pod(e.m_rasterDesc) &&
+                reader.pod(e.m_multisampleDesc) &&
+                reader.pod(e.m_depthStencilDesc) &&
+                reader.pod(e.m_blendDesc.logicOpEnable) &&
+                reader.pod(e.m_blendDesc.logicOp) &&
+                reader.pod(e.m_blendDesc.blendConstants) &&
+                reader.podVector(e.m_blendDesc.attachments) &&
+                reader.podVector(e.m_dynamicDesc.states) &&
+                reader.pod(e.m_dynamicDesc.dynamicDepth) &&
+                reader.pod(e.m_dynamicDesc.dynamicCull) &&
+                reader.pod(e.m_dynamicDesc.dynamicBlend) &&
+                reader.podVector(e.m_vertexSpecialization.constants) &&
+                reader.podVector(e.m_fragmentSpecialization.constants) &&
+                reader.pod(e.m_descriptorBuffer);
+
+            if (!ok)
+            {
+                MARK_WARN(Utils::Category::Vulkan, "Pipeline manifest truncated at entry %u, keeping the first %u", i, i);
+                break;
+            }
+
+            if (m_identities.insert(e.m_identity).second) {
+                entries.push_back(std::move(e));
+            }
+        }
+
+        m_entries = std::move(entries);
+        return true;
+    }
+
+    bool VulkanPipelineManifest::save()
+    {
+#if MARK_PIPELINE_PREWARM
+        if (!m_dirty) return false;
+
+        ManifestWriter writer;
+        writer.pod(PIPELINE_MANIFEST_MAGIC);
+        writer.pod(PIPELINE_MANIFEST_VERSION);
+        writer.pod(layoutSignature());
+
+        // Newest entries are at the back, keep those when over the cap
+        size_t kept = 0;
+        for (const Entry& e : m_entries) {
+            if (!e.m_stale) kept++;
+        }
+        size_t skip = kept > PIPELINE_MANIFEST_MAX_ENTRIES ? kept - PIPELINE_MANIFEST_MAX_ENTRIES : 0;
+        writer.pod(static_cast<uint32_t>(kept - skip));
+
+        for (const Entry& e : m_entries)
+        {
+            if (e.m_stale) continue;
+            if (skip > 0) { skip--; continue; }
+
+            writer.pod(e.m_identity);
+            writer.pod(e.m_setLayoutHash);
+            writer.string(e.m_vertex.m_path);
+            writer.string(e.m_vertex.m_entry);
+            writer.pod(e.m_vertex.m_stage);
+            writer.defines(e.m_vertex.m_defines);
+            writer.string(e.m_fragment.m_path);
+            writer.string(e.m_fragment.m_entry);
+            writer.pod(e.m_fragment.m_stage);
+            writer.defines(e.m_fragment.m_defines);
+            writer.string(e.m_debugName);
+            writer.podVector(e.m_renderTargetsDesc.colourFormats);
+            writer.pod(e.m_renderTargetsDesc.depthFormat);
+            writer.pod(e.m_renderTargetsDesc.stencilFormat);
+            writer.pod(e.m_renderTargetsDesc.viewMask);
+            writer.pod(e.m_inputAssemblyDesc);
+            writer.pod(e.m_rasterDesc);
+            writer.pod(e.m_multisampleDesc);
+            writer.pod(e.m_depthStencilDesc);
+            writer.pod(e.m_blendDesc.logicOpEnable);
+            writer.pod(e.m_blendDesc.logicOp);
+            writer.pod(e.m_blendDesc.blendConstants);
+            writer.podVector(e.m_blendDesc.attachments);
+            writer.podVector(e.m_dynamicDesc.states);
+            writer.pod(e.m_dynamicDesc.dynamicDepth);
+            writer.pod(e.m_dynamicDesc.dynamicCull);
+            writer.pod(e.m_dynamicDesc.dynamicBlend);
+            writer.podVector(e.m_vertexSpecialization.constants);
+            writer.podVector(e.m_fragmentSpecialization.constants);
+            writer.pod(e.m_descriptorBuffer);
+        }
+
+        std::error_code ec;
+        std::filesystem::create_directories(m_path.parent_path(), ec);
+
+        std::filesystem::path tmpPath = m_path;
+        tmpPath += ".tmp";
+        {
+            std::ofstream out(tmpPath, std::ios::binary | std::ios::trunc);
+            if (!out || !out.write(reinterpret_cast<const char*>(writer.m_data.data()), static_cast<std::streamsize>(writer.m_data.size())))
+            {
+                MARK_WARN(Utils::Category::Vulkan, "Failed to write pipeline manifest: %s", Utils::ShortPathForLog(tmpPath.string()).c_str());
+                return false;
+            }
+        }
+
+        std::filesystem::rename(tmpPath, m_path, ec);
+        if (ec)
+        {
+            MARK_WARN(Utils::Category::Vulkan, "Failed to finalise pipeline manifest: %s", ec.message().c_str());
+            std::filesystem::remove(tmpPath, ec);
+            return false;
+        }
+
+        m_dirty = false;
+        MARK_INFO(Utils::Category::Vulkan, "Pipeline manifest saved: %zu pipeline(s)", std::min(kept, PIPELINE_MANIFEST_MAX_ENTRIES));
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    void VulkanPipelineManifest::record(const PipelineDesc& _desc, uint64_t _setLayoutHash)
+    {
+#if MARK_PIPELINE_PREWARM
+        if (!m_shaderCache) return;
+
+        Entry e;
+        glslang_stage_t vertexStage{}, fragmentStage{};
+        // A depth-only pipeline has no fragment stage, its source stays empty
+        const bool hasFragment = _desc.fragmentShader != VK_NULL_HANDLE;
+        if (!m_shaderCache->findModuleSource(_desc.vertexShader, e.m_vertex.m_path, e.m_vertex.m_entry, vertexStage, e.m_vertex.m_defines) ||
+            (hasFragment && !m_shaderCache->findModuleSource(_desc.fragmentShader, e.m_fragment.m_path, e.m_fragment.m_entry, fragmentStage, e.m_fragment.m_defines)))
+        {
+            // Module wasn't created through the shader cache so there is nothing to reload it from
+            return;
+        }
+        e.m_vertex.m_stage = static_cast<uint32_t>(vertexStage);
+        e.m_fragment.m_stage = hasFragment ? static_cast<uint32_t>(fragmentStage) : 0u;
+
+        // Identity ignores the session's module handles, shaders are identified by source + defines instead
+        PipelineDesc stateOnly = _desc;
+        stateOnly.vertexShader = VK_NULL_HANDLE;
+        stateOnly.fragmentShader = VK_NULL_HANDLE;
+        const PipelineStateHash128 state = HashPipelineDescState(stateOnly);
+
+        uint64_t identity = 1469598103934665603ull;
+        HashMix64(identity, state.a);
+        HashMix64(identity, state.b);
+        HashMix64(identity, _setLayoutHash);
+        hashString(identity, e.m_vertex.m_path);
+        hashString(identity, e.m_vertex.m_entry);
+        hashString(identity, e.m_fragment.m_path);
+        hashString(identity, e.m_fragment.m_entry);
+        for (const ShaderSource* source : { &e.m_vertex, &e.m_fragment })
+        {
+            HashMix64(identity, source->m_defines.size());
+            for (const ShaderDefine& define : source->m_defines)
+            {
+                hashString(identity, define.m_name);
+                hashString(identity, define.m_value);
+            }
+        }
+
+        if (!m_identities.insert(identity).second) return;
+
+        e.m_identity = identity;
+        e.m_setLayoutHash = _setLayoutHash;
+        e.m_debugName = _desc.debugName;
+        e.m_renderTargetsDesc = _desc.renderTargetsDesc;
+        e.m_inputAssemblyDesc = _desc.inputAssemblyDesc;
+        e.m_rasterDesc = _desc.rasterDesc;
+        e.m_multisampleDesc = _desc.multisampleDesc;
+        e.m_depthStencilDesc = _desc.depthStencilDesc;
+        e.m_blendDesc = _desc.blendDesc;
+        e.m_dynamicDesc = _desc.dynamicDesc;
+        e.m_vertexSpecialization = _desc.vertexSpecialization;
+        e.m_fragmentSpecialization = _desc.fragmentSpecialization;
+        e.m_descriptorBuffer = _desc.descriptorBuffer;
+        e.m_prewarmed = true; // Already created this session
+
+        m_entries.push_back(std::move(e));
+        m_dirty = true;
+        MARK_DEBUG(Utils::Category::Vulkan, "Pipeline manifest recorded '%s' (%zu total)", _desc.debugName.c_str(), m_entries.size());
+#endif
+    }
+
+    VkShaderModule VulkanPipelineManifest::loadShader(const ShaderSource& _source) const
+    {
+        const bool isSpirv = _source.m_path.ends_with(".spv");
+#if !MARK_SHADER_RUNTIME_COMPILE
+        // GLSL sources don't ship in embedded builds, the bundle alone decides whether the entry is stale
+        if (!isSpirv) {
+            return m_shaderCache->getOrCreateFromGLSL(_source.m_path.c_str(), _source.m_defines, _source.m_entry.c_str());
+        }
+#endif
+        std::error_code ec;
+        if (!std::filesystem::exists(_source.m_path, ec)) {
+            return VK_NULL_HANDLE;
+        }
+
+        if (isSpirv) {
+            return m_shaderCache->getOrCreateFromSPV(_source.m_path.c_str(), static_cast<glslang_stage_t>(_source.m_stage));
+        }
+        return m_shaderCache->getOrCreateFromGLSL(_source.m_path.c_str(), _source.m_defines, _source.m_entry.c_str());
+    }
+
+    void VulkanPipelineManifest::prewarm(VkDescriptorSetLayout _set0Layout, uint64_t _set0LayoutHash)
+    {
+#if MARK_PIPELINE_PREWARM
+        if (!m_shaderCache || !m_pipelineCache || _set0Layout == VK_NULL_HANDLE) return;
+
+        uint32_t queued = 0;
+        for (Entry& e : m_entries)
+        {
+            if (e.m_prewarmed || e.m_stale || e.m_setLayoutHash != _set0LayoutHash) continue;
+            e.m_prewarmed = true;
+
+            // An empty fragment source is a depth-only pipeline, not a missing shader
+            const bool hasFragment = !e.m_fragment.m_path.empty();
+            const VkShaderModule vertexShader = loadShader(e.m_vertex);
+            const VkShaderModule fragmentShader = hasFragment ? loadShader(e.m_fragment) : VK_NULL_HANDLE;
+            if (vertexShader == VK_NULL_HANDLE || (hasFragment && fragmentShader == VK_NULL_HANDLE))
+            {
+                MARK_WARN(Utils::Category::Vulkan, "Pipeline manifest entry '%s' references missing shaders, dropping it", e.m_debugName.c_str());
+                e.m_stale = true;
+                m_dirty = true;
+                continue;
+            }
+
+            const PipelineDesc desc = {
+                .device = m_device,
+                .cache = *m_pipelineCache,
+                .vertexShader = vertexShader,
+                .fragmentShader = fragmentShader,
+                .debugName = e.m_debugName,
+                .descriptorBuffer = e.m_descriptorBuffer,
+                .renderTargetsDesc = e.m_renderTargetsDesc,
+                .inputAssemblyDesc = e.m_inputAssemblyDesc,
+                .rasterDesc = e.m_rasterDesc,
+                .multisampleDesc = e.m_multisampleDesc,
+                .depthStencilDesc = e.m_depthStencilDesc,
+                .blendDesc = e.m_blendDesc,
+                .dynamicDesc = e.m_dynamicDesc,
+                .vertexSpecialization = e.m_vertexSpecialization,
+                .fragmentSpecialization = e.m_fragmentSpecialization
+            };
+            VulkanGraphicsPipeline::prewarm(desc, _set0Layout, _set0LayoutHash);
+            queued++;
+        }
+
+        if (queued > 0) {
+            MARK_INFO(Utils::Category::Vulkan, "Pipeline prewarm: %u pipeline(s) queued from manifest", queued);
+        }
+#endif
+    }
+} // namespace Mark::RendererVK
@@ -0,0 +1,90 @@
+#pragma once
+#include "Mark_PipelineDescription.h"
+#include "Mark_Shader.h"
+
+#include <Volk/volk.h>
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+// Set to 0 to stop recording pipeline descriptions and replaying them on the next launch
+#ifndef MARK_PIPELINE_PREWARM
+    #define MARK_PIPELINE_PREWARM 1
+#endif
+
+namespace Mark::RendererVK
+{
+    struct VulkanShaderCache;
+    struct VulkanGraphicsPipelineCache;
+
+    // Records every graphics pipeline description acquired during a session to MARK_CACHE_DIR.
+    // On the next launch, entries are queued as async compiles as soon as their set 0 layout exists,
+    // so the first real acquire finds the pipeline ready (or already in flight) instead of compiling
+    struct VulkanPipelineManifest
+    {
+        VulkanPipelineManifest() = default;
+        ~VulkanPipelineManifest() = default;
+        VulkanPipelineManifest(const VulkanPipelineManifest&) = delete;
+        VulkanPipelineManifest& operator=(const VulkanPipelineManifest&) = delete;
+
+        // Loads the previous session's manifest, a stale or unreadable file is discarded
+        void create(VkDevice _device, VulkanShaderCache* _shaderCache, VulkanGraphicsPipelineCache* _pipelineCache);
+        // Saves if anything new was recorded
+        void destroy();
+        bool save();
+
+        // Called on every graphics pipeline creation. Duplicates are ignored
+        void record(const PipelineDesc& _desc, uint64_t _setLayoutHash);
+
+        // Queues background creation of recorded pipelines that use this set 0 layout
+        void prewarm(VkDescriptorSetLayout _set0Layout, uint64_t _set0LayoutHash);
+
+    private:
+        struct ShaderSource
+        {
+            std::string m_path;
+            std::string m_entry;
+            uint32_t m_stage{ 0 };
+            ShaderDefines m_defines;
+        };
+
+        // PipelineDesc minus the per-session handles
+        struct Entry
+        {
+            uint64_t m_identity{ 0 };
+            uint64_t m_setLayoutHash{ 0 };
+            ShaderSource m_vertex;
+            ShaderSource m_fragment; // Empty path for depth-only pipelines
+            std::string m_debugName;
+
+            PipelineRenderTargetDesc  m_renderTargetsDesc{};
+            PipelineInputAssemblyDesc m_inputAssemblyDesc{};
+            PipelineRasterDesc        m_rasterDesc{};
+            PipelineMultisampleDesc   m_multisampleDesc{};
+            PipelineDepthStencilDesc  m_depthStencilDesc{};
+            PipelineBlendDesc         m_blendDesc{};
+            PipelineDynamicStateDesc  m_dynamicDesc{};
+            PipelineSpecializationDesc m_vertexSpecialization{};
+            PipelineSpecializationDesc m_fragmentSpecialization{};
+            bool m_descriptorBuffer{ false };
+
+            bool m_prewarmed{ false };
+            bool m_stale{ false }; // Shader source gone, dropped on save
+        };
+
+        bool load();
+        VkShaderModule loadShader(const ShaderSource& _source) const;
+
+        VkDevice m_device{ VK_NULL_HANDLE };
+        VulkanShaderCache* m_shaderCache{ nullptr };
+        VulkanGraphicsPipelineCache* m_pipelineCache{ nullptr };
+        std::filesystem::path m_path;
+
+        std::vector<Entry> m_entries;
+        std::unordered_set<uint64_t> m_identities;
+        bool m_dirty{ false };
+    };
+} // namespace Mark::RendererVK
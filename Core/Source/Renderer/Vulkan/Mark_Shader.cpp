@@ -1,6 +1,9 @@
 ﻿#include "Mark_Shader.h"
+#include "Mark_EmbeddedShaders.h"
+#include "Mark_PipelineKey.h"
 #include "Utils/Mark_Utils.h"
 #include "Utils/VulkanUtils.h"
+#include "Utils/Mark_ParallelFor.h"
 
 #include <string>
 #include <cstring>
@@ -8,9 +11,14 @@
 #include <sstream>
 #include <iterator>
 #include <filesystem>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <thread>
 
 namespace Mark::RendererVK
 {
+#if MARK_SHADER_RUNTIME_COMPILE
     static bool readFileToString(const char* _fileName, std::string& _outString)
     {
         std::ifstream file(_fileName, std::ios::binary);
@@ -23,6 +31,7 @@ namespace Mark::RendererVK
         _outString.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
         return true;
     }
+#endif
     bool readSPIRVFileToWords(const char* _fileName, std::vector<uint32_t>& _outWords)
     {
         std::ifstream file(_fileName, std::ios::binary | std::ios::ate);
@@ -75,6 +84,7 @@ namespace Mark::RendererVK
         MARK_FATAL(Utils::Category::Shader, "Unknown shader stage for file: %s", _fileName);
         return GLSLANG_STAGE_VERTEX; // Default
     }
+#if MARK_SHADER_RUNTIME_COMPILE
     // Pretty logging for glslang shader failures (preprocess/parse)
     static void logGlslangShaderFailure(const char* _phase, const char* _fileName,
         const std::string& _source, glslang_shader_t* _shader)
@@ -112,21 +122,162 @@ namespace Mark::RendererVK
             MARK_ERROR(Utils::Category::Shader, "DebugLog: %s", dbg);
         }
     }
-    // Write compiled SPIR-V next to the source (simple cache).
-    static bool writeWordsToSpv(const std::filesystem::path& _outPath, const std::vector<uint32_t>& _words)
+    // ---------- Content hash + #include closure ----------
+    constexpr uint32_t SHADER_CACHE_MAGIC = 0x5650534Du; // "MSPV"
+    constexpr uint32_t SHADER_CACHE_VERSION = 2;
+    constexpr uint32_t SHADER_INCLUDE_MAX_DEPTH = 32;
+
+    struct ShaderCacheHeader
     {
-        std::ofstream file(_outPath, std::ios::binary | std::ios::trunc);
-        if (!file)
+        uint32_t magic;
+        uint32_t version;
+        uint64_t contentHash;
+        uint64_t wordCount;
+    };
+
+    // Length first so adjacent strings can't trade characters
+    static void hashString(uint64_t& _hash, const std::string& _str)
+    {
+        HashMix64(_hash, static_cast<uint64_t>(_str.size()));
+        HashMixBytes(_hash, _str.data(), _str.size());
+    }
+
+    // Everything that changes the compiler output without being in the source
+    static uint64_t compilerFingerprint()
+    {
+        static const uint64_t fingerprint = []()
         {
-            MARK_ERROR(Utils::Category::Shader, "Failed to open for write: %s", _outPath.string().c_str());
-            return false;
+            uint64_t h = 1469598103934665603ull;
+            glslang_version_t version{};
+            glslang_get_version(&version);
+            const uint32_t fields[] = {
+                SHADER_CACHE_VERSION,
+                static_cast<uint32_t>(version.major), static_cast<uint32_t>(version.minor), static_cast<uint32_t>(version.patch),
+                static_cast<uint32_t>(GLSLANG_TARGET_VULKAN_1_3), static_cast<uint32_t>(GLSLANG_TARGET_SPV_1_6)
+            };
+            HashMixBytes(h, fields, sizeof(fields));
+            hashString(h, version.flavor ? version.flavor : "");
+            return h;
+        }();
+        return fingerprint;
+    }
+
+    // Pulls the quoted/bracketed name out of an #include line, false for anything else
+    static bool parseIncludeLine(const std::string& _line, std::string& _outName)
+    {
+        size_t pos = _line.find_first_not_of(" \t");
+        if (pos == std::string::npos || _line[pos] != '#') return false;
+        pos = _line.find_first_not_of(" \t", pos + 1);
+        if (pos == std::string::npos || _line.compare(pos, 7, "include") != 0) return false;
+
+        pos = _line.find_first_of("\"<", pos + 7);
+        if (pos == std::string::npos) return false;
+        const char close = _line[pos] == '"' ? '"' : '>';
+        const size_t end = _line.find(close, pos + 1);
+        if (end == std::string::npos) return false;
+
+        _outName = _line.substr(pos + 1, end - pos - 1);
+        return !_outName.empty();
+    }
+
+    // Taken before the file is read, so an edit landing mid-hash leaves a stale stamp and forces a rehash next time
+    static void stampSource(const std::string& _path, std::vector<ShaderSourceStamp>& _stamps)
+    {
+        std::error_code ec;
+        ShaderSourceStamp stamp{ .m_path = _path };
+        stamp.m_writeTime = std::filesystem::last_write_time(_path, ec);
+        if (!ec) stamp.m_size = std::filesystem::file_size(_path, ec);
+        if (ec) stamp.m_path.clear(); // Never matches, the entry is rehashed on every request
+        _stamps.push_back(std::move(stamp));
+    }
+
+    static bool sourceStampsCurrent(const std::vector<ShaderSourceStamp>& _stamps)
+    {
+        for (const ShaderSourceStamp& stamp : _stamps)
+        {
+            if (stamp.m_path.empty()) return false;
+            std::error_code ec;
+            if (std::filesystem::last_write_time(stamp.m_path, ec) != stamp.m_writeTime || ec) return false;
+            if (std::filesystem::file_size(stamp.m_path, ec) != stamp.m_size || ec) return false;
         }
-        file.write(reinterpret_cast<const char*>(_words.data()), static_cast<std::streamsize>(_words.size() * sizeof(uint32_t)));
-        return static_cast<bool>(file);
+        return !_stamps.empty();
     }
 
-    static bool compileShader(VkDevice& _device, glslang_stage_t _stage, const char* _sourceCode, ShaderModuleInfo& _shaderModule)
+    // Folds the file and, depth first, every file it includes. Each file is hashed once and stamped before it's read
+    static bool hashIncludeClosure(const std::filesystem::path& _file, const std::string& _source, uint64_t& _hash,
+        std::vector<std::string>& _visited, std::vector<ShaderSourceStamp>& _stamps, uint32_t _depth)
     {
+        hashString(_hash, _file.filename().string());
+        hashString(_hash, _source);
+        if (_depth >= SHADER_INCLUDE_MAX_DEPTH) return true;
+
+        std::istringstream lines(_source);
+        std::string line, includeName;
+        while (std::getline(lines, line))
+        {
+            if (!parseIncludeLine(line, includeName)) continue;
+
+            std::error_code ec;
+            const std::filesystem::path includePath = std::filesystem::weakly_canonical(_file.parent_path() / includeName, ec);
+            const std::string includeKey = includePath.string();
+            if (std::find(_visited.begin(), _visited.end(), includeKey) != _visited.end()) continue;
+            _visited.push_back(includeKey);
+
+            stampSource(includeKey, _stamps);
+            std::string includeSource;
+            if (!readFileToString(includeKey.c_str(), includeSource)) {
+                return false;
+            }
+            if (!hashIncludeClosure(includePath, includeSource, _hash, _visited, _stamps, _depth + 1)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // ---------- glslang #include support ----------
+    struct ShaderIncludeResult
+    {
+        glsl_include_result_t m_result{};
+        std::string m_name;
+        std::string m_data;
+    };
+
+    static glsl_include_result_t* includeLocal(void* _ctx, const char* _headerName, const char* _includerName, size_t _depth)
+    {
+        if (_depth > SHADER_INCLUDE_MAX_DEPTH) return nullptr;
+
+        // The root shader has no includer name, resolve against its own directory
+        const std::filesystem::path& rootFile = *static_cast<const std::filesystem::path*>(_ctx);
+        const std::filesystem::path baseDir = (_includerName && *_includerName) ? std::filesystem::path(_includerName).parent_path() : rootFile.parent_path();
+
+        std::error_code ec;
+        auto* include = new ShaderIncludeResult();
+        include->m_name = std::filesystem::weakly_canonical(baseDir / _headerName, ec).string();
+        if (!readFileToString(include->m_name.c_str(), include->m_data)) {
+            include->m_name.clear(); // Empty header name tells glslang the include failed
+        }
+
+        include->m_result.header_name = include->m_name.c_str();
+        include->m_result.header_data = include->m_data.c_str();
+        include->m_result.header_length = include->m_data.size();
+        return &include->m_result;
+    }
+
+    static int freeIncludeResult(void*, glsl_include_result_t* _result)
+    {
+        // m_result is the first member, so the pointer handed to glslang is the allocation
+        delete reinterpret_cast<ShaderIncludeResult*>(_result);
+        return 0;
+    }
+
+    // GLSL -> SPIR-V only, no Vulkan calls, so any number of these can run at once
+    static bool compileGLSLToSpirv(glslang_stage_t _stage, const std::filesystem::path& _sourcePath, const std::string& _source,
+        const std::string& _preamble, std::vector<uint32_t>& _outWords)
+    {
+        const std::string fileName = Utils::ShortPathForLog(_sourcePath.string());
+        std::filesystem::path includeRoot = _sourcePath;
+
         glslang_input_t shaderInput = {
             .language = GLSLANG_SOURCE_GLSL,
             .stage = _stage,
@@ -134,29 +285,36 @@ namespace Mark::RendererVK
             .client_version = GLSLANG_TARGET_VULKAN_1_3,
             .target_language = GLSLANG_TARGET_SPV,
             .target_language_version = GLSLANG_TARGET_SPV_1_6,
-            .code = _sourceCode,
+            .code = _source.c_str(),
             .default_version = 450,
             .default_profile = GLSLANG_NO_PROFILE,
             .force_default_version_and_profile = false,
             .forward_compatible = false,
             .messages = GLSLANG_MSG_DEFAULT_BIT,
             .resource = glslang_default_resource(),
-            .callbacks = nullptr,
-            .callbacks_ctx = nullptr
+            .callbacks = {
+                .include_system = includeLocal,
+                .include_local = includeLocal,
+                .free_include_result = freeIncludeResult
+            },
+            .callbacks_ctx = &includeRoot
         };
 
         glslang_shader_t* shader = glslang_shader_create(&shaderInput);
+        if (!_preamble.empty()) {
+            glslang_shader_set_preamble(shader, _preamble.c_str());
+        }
 
         if (!glslang_shader_preprocess(shader, &shaderInput))
         {
-            logGlslangShaderFailure("Preprocess", "<memory>", _sourceCode, shader);
+            logGlslangShaderFailure("Preprocess", fileName.c_str(), _source, shader);
             glslang_shader_delete(shader);
             return false;
         }
 
         if (!glslang_shader_parse(shader, &shaderInput))
         {
-            logGlslangShaderFailure("Parse", "<memory>", _sourceCode, shader);
+            logGlslangShaderFailure("Parse", fileName.c_str(), _source, shader);
             glslang_shader_delete(shader);
             return false;
         }
@@ -166,7 +324,7 @@ namespace Mark::RendererVK
 
         if (!glslang_program_link(program, GLSLANG_MSG_SPV_RULES_BIT | GLSLANG_MSG_VULKAN_RULES_BIT))
         {
-            logGlslangProgramFailure("Link", "<memory>", program);
+            logGlslangProgramFailure("Link", fileName.c_str(), program);
             glslang_program_delete(program);
             glslang_shader_delete(shader);
             return false;
@@ -174,7 +332,9 @@ namespace Mark::RendererVK
 
         glslang_program_SPIRV_generate(program, _stage);
 
-        _shaderModule.initialize(program);
+        ShaderModuleInfo info;
+        info.initialize(program);
+        _outWords = std::move(info.m_SPIRV);
 
         const char* SPIRV_messages = glslang_program_SPIRV_get_messages(program);
 
@@ -184,166 +344,433 @@ namespace Mark::RendererVK
             MARK_WARN(Utils::Category::Shader, "%s", SPIRV_messages);
         }
 
-        VkShaderModuleCreateInfo shaderModuleCreateInfo = {
-            .sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO,
-            .pNext = nullptr,
-            .flags = 0,
-            .codeSize = _shaderModule.m_SPIRV.size() * sizeof(uint32_t),
-            .pCode = (const uint32_t*)_shaderModule.m_SPIRV.data()
-        };
-
-        VkResult res = vkCreateShaderModule(_device, &shaderModuleCreateInfo, nullptr, &_shaderModule.m_shaderModule);
-        CHECK_VK_RESULT(res, "Create Shader Module");
-        MARK_VK_NAME(_device, VK_OBJECT_TYPE_SHADER_MODULE, _shaderModule.m_shaderModule, "VulkShader.ShaderModule");
-
         glslang_program_delete(program);
         glslang_shader_delete(shader);
 
-        return _shaderModule.m_SPIRV.size() > 0 && _shaderModule.m_shaderModule != VK_NULL_HANDLE;
+        return !_outWords.empty();
     }
+#endif // MARK_SHADER_RUNTIME_COMPILE
+
+    // Sorted by name with repeated names collapsed, so equal permutations produce equal keys
+    static ShaderDefines normaliseDefines(const ShaderDefines& _defines)
+    {
+        ShaderDefines sorted = _defines;
+        std::stable_sort(sorted.begin(), sorted.end(), [](const ShaderDefine& _a, const ShaderDefine& _b) { return _a.m_name < _b.m_name; });
+
+        ShaderDefines unique;
+        unique.reserve(sorted.size());
+        for (ShaderDefine& define : sorted)
+        {
+            if (!unique.empty() && unique.back().m_name == define.m_name)
+                unique.back() = std::move(define);
+            else
+                unique.push_back(std::move(define));
+        }
+        return unique;
+    }
+
+#if MARK_SHADER_RUNTIME_COMPILE
+    static std::string makeDefinePreamble(const ShaderDefines& _defines)
+    {
+        std::string preamble;
+        for (const ShaderDefine& define : _defines) {
+            preamble += "#define " + define.m_name + " " + define.m_value + "\n";
+        }
+        return preamble;
+    }
+
+    // Set by Core/CMakeLists.txt from the same list the embedded build compiles, "File.vert:A=1,B|Other.frag:C"
+    #ifndef MARK_SHADER_PERMUTATIONS
+        #define MARK_SHADER_PERMUTATIONS ""
+    #endif
+
+    struct ShaderPermutation
+    {
+        std::string m_fileName;
+        ShaderDefines m_defines;
+    };
+
+    static std::vector<ShaderPermutation> enginePermutations()
+    {
+        std::vector<ShaderPermutation> permutations;
+        std::istringstream list(MARK_SHADER_PERMUTATIONS);
+        std::string entry;
+        while (std::getline(list, entry, '|'))
+        {
+            const size_t colon = entry.find(':');
+            if (colon == std::string::npos || colon == 0) continue;
+
+            ShaderPermutation permutation{ .m_fileName = entry.substr(0, colon) };
+            std::istringstream defines(entry.substr(colon + 1));
+            std::string define;
+            while (std::getline(defines, define, ','))
+            {
+                if (define.empty()) continue;
+                const size_t equals = define.find('=');
+                if (equals == std::string::npos)
+                    permutation.m_defines.push_back(ShaderDefine{ .m_name = define });
+                else
+                    permutation.m_defines.push_back(ShaderDefine{ .m_name = define.substr(0, equals), .m_value = define.substr(equals + 1) });
+            }
+            permutations.push_back(std::move(permutation));
+        }
+        return permutations;
+    }
+#endif
 
     // VulkanShaderCache implementation
     VulkanShaderCache::VulkanShaderCache(VkDevice& _device) :
         m_device(_device)
     {
+#if MARK_SHADER_RUNTIME_COMPILE
         glslang_initialize_process();
+#else
+        MARK_INFO(Utils::Category::Shader, "Runtime shader compiler disabled, %zu embedded shaders available", embeddedShaderCount());
+#endif
     }
     void VulkanShaderCache::destroy()
     {
         destroyAll();
+#if MARK_SHADER_RUNTIME_COMPILE
         glslang_finalize_process();
+#endif
     }
 
-    std::string VulkanShaderCache::makeSiblingSpvName(const std::filesystem::path& _glsl)
+    std::filesystem::path VulkanShaderCache::cachePathForHash(uint64_t _contentHash)
     {
-        return (_glsl.string() + ".spv");
+        char name[32];
+        std::snprintf(name, sizeof(name), "%016llx.spv", static_cast<unsigned long long>(_contentHash));
+        return std::filesystem::path(MARK_CACHE_DIR) / "Shaders" / name;
     }
 
-    bool VulkanShaderCache::tryLoadSiblingSpv(const std::filesystem::path& _glsl, std::vector<uint32_t>& _outWords, std::filesystem::file_time_type& _spvTime) const
+    bool VulkanShaderCache::loadCachedSpirv(uint64_t _contentHash, std::vector<uint32_t>& _outWords)
     {
-        const auto spvPath = makeSiblingSpvName(_glsl);
+#if MARK_SHADER_DISK_CACHE && MARK_SHADER_RUNTIME_COMPILE
+        const std::filesystem::path path = cachePathForHash(_contentHash);
+        std::ifstream file(path, std::ios::binary);
+        if (!file) return false;
+
         std::error_code ec;
-        if (!std::filesystem::exists(spvPath, ec)) return false;
-        if (!readSPIRVFileToWords(spvPath.c_str(), _outWords)) return false;
-        auto lwt = std::filesystem::last_write_time(spvPath, ec);
-        if (ec) 
+        const uintmax_t fileSize = std::filesystem::file_size(path, ec);
+        if (ec) return false;
+
+        // The word count is only trusted once the file is known to hold that many words
+        ShaderCacheHeader header{};
+        file.read(reinterpret_cast<char*>(&header), sizeof(header));
+        if (file.gcount() != sizeof(header) || header.magic != SHADER_CACHE_MAGIC ||
+            header.version != SHADER_CACHE_VERSION || header.contentHash != _contentHash || header.wordCount == 0 ||
+            static_cast<uintmax_t>(header.wordCount) > (fileSize - sizeof(header)) / sizeof(uint32_t))
         {
-            MARK_WARN(Utils::Category::Shader, "last_write_time failed for '%s': %s",
-                spvPath.c_str(), ec.message().c_str());
-            _spvTime = {};
+            MARK_WARN(Utils::Category::Shader, "SPIR-V cache entry invalid, recompiling: %s", Utils::ShortPathForLog(path.string()).c_str());
+            return false;
         }
-        else 
+
+        _outWords.resize(static_cast<size_t>(header.wordCount));
+        file.read(reinterpret_cast<char*>(_outWords.data()), static_cast<std::streamsize>(_outWords.size() * sizeof(uint32_t)));
+        if (file.gcount() != static_cast<std::streamsize>(_outWords.size() * sizeof(uint32_t)))
         {
-            _spvTime = lwt;
+            _outWords.clear();
+            return false;
         }
         return true;
+#else
+        (void)_contentHash; (void)_outWords;
+        return false;
+#endif
     }
 
-    VkShaderModule VulkanShaderCache::getOrCreateFromGLSL(const char* _glslPath, const char* _entry)
+    bool VulkanShaderCache::storeCachedSpirv(uint64_t _contentHash, const std::vector<uint32_t>& _words)
     {
-        std::filesystem::path path(_glslPath);
+#if MARK_SHADER_DISK_CACHE && MARK_SHADER_RUNTIME_COMPILE
+        const std::filesystem::path path = cachePathForHash(_contentHash);
         std::error_code ec;
-        auto abs = std::filesystem::weakly_canonical(path, ec);
-        const std::string absString = ec ? path.string() : abs.string();
-        const auto stage = shaderStageFromFileName(_glslPath);
+        std::filesystem::create_directories(path.parent_path(), ec);
+        if (ec) {
+            MARK_WARN(Utils::Category::Shader, "Failed to create shader cache directory: %s", ec.message().c_str());
+            return false;
+        }
+
+        // Per-thread temp name, two keys with identical content can finish together
+        std::filesystem::path tmpPath = path;
+        tmpPath += "." + std::to_string(std::hash<std::thread::id>{}(std::this_thread::get_id())) + ".tmp";
 
-        Key k{ absString, stage, _entry ? _entry : "main" };
-        if (auto it = m_map.find(k); it != m_map.end()) 
+        const ShaderCacheHeader header{
+            .magic = SHADER_CACHE_MAGIC,
+            .version = SHADER_CACHE_VERSION,
+            .contentHash = _contentHash,
+            .wordCount = _words.size()
+        };
         {
-            std::filesystem::file_time_type nowSrc{};
-            if (std::filesystem::exists(path, ec)) 
+            std::ofstream out(tmpPath, std::ios::binary | std::ios::trunc);
+            out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+            out.write(reinterpret_cast<const char*>(_words.data()), static_cast<std::streamsize>(_words.size() * sizeof(uint32_t)));
+            if (!out)
             {
-                auto tmp = std::filesystem::last_write_time(path, ec);
-                if (!ec) 
-                    nowSrc = tmp;
+                MARK_WARN(Utils::Category::Shader, "Failed to write SPIR-V cache: %s", Utils::ShortPathForLog(tmpPath.string()).c_str());
+                out.close();
+                std::filesystem::remove(tmpPath, ec);
+                return false;
             }
+        }
 
-            if (nowSrc == it->second.m_srcTime) 
-            {
-                return it->second.m_module; // up-to-date
-            }
-            // Drop and rebuild
-            vkDestroyShaderModule(m_device, it->second.m_module, nullptr);
-            m_map.erase(it);
+        std::filesystem::rename(tmpPath, path, ec);
+        if (ec)
+        {
+            std::filesystem::remove(tmpPath, ec);
+            return false;
         }
+        return true;
+#else
+        (void)_contentHash; (void)_words;
+        return false;
+#endif
+    }
 
-        // Try sibling .spv if it's up-to-date
-        std::filesystem::file_time_type srcTime{}, spvTime{};
-        if (std::filesystem::exists(path, ec)) 
-            srcTime = std::filesystem::last_write_time(path, ec);
+    VkShaderModule VulkanShaderCache::createModule(const uint32_t* _words, size_t _wordCount, const std::string& _debugPath) const
+    {
+        VkShaderModuleCreateInfo moduleCreateInfo = {
+            .sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO,
+            .pNext = nullptr,
+            .flags = 0,
+            .codeSize = _wordCount * sizeof(uint32_t),
+            .pCode = _words
+        };
 
-        std::vector<uint32_t> words;
-        if (tryLoadSiblingSpv(path, words, spvTime) && spvTime >= srcTime) 
-        {
-            // Use cached SPIR-V
-            VkShaderModuleCreateInfo moduleCreateInfo = { 
-                .sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO,
-                .pNext = nullptr,
-                .flags = 0,
-                .codeSize = words.size() * sizeof(uint32_t),
-                .pCode = words.data()
-            };
+        VkShaderModule module = VK_NULL_HANDLE;
+        VkResult res = vkCreateShaderModule(m_device, &moduleCreateInfo, nullptr, &module);
+        CHECK_VK_RESULT(res, "Create Shader Module");
+        MARK_VK_NAME(m_device, VK_OBJECT_TYPE_SHADER_MODULE, module, ("VulkShader." + std::filesystem::path(_debugPath).filename().string()).c_str());
+        return module;
+    }
 
-            Entry entry{};
+    VkShaderModule VulkanShaderCache::getOrCreateFromGLSL(const char* _glslPath, const char* _entry)
+    {
+        return getOrCreateFromGLSL(_glslPath, ShaderDefines{}, _entry);
+    }
 
-            VkResult res = vkCreateShaderModule(m_device, &moduleCreateInfo, nullptr, &entry.m_module);
-            CHECK_VK_RESULT(res, "Failed to create shader module");
+    VkShaderModule VulkanShaderCache::getOrCreateFromGLSL(const char* _glslPath, const ShaderDefines& _defines, const char* _entry)
+    {
+        std::filesystem::path path(_glslPath);
+        std::error_code ec;
+        auto abs = std::filesystem::weakly_canonical(path, ec);
 
-            entry.m_spirv = std::move(words);
-            entry.m_srcTime = srcTime;
-            entry.m_spvTime = spvTime;
-            m_map.emplace(k, std::move(entry));
+        const Key key{
+            .m_absPath = ec ? path.string() : abs.string(),
+            .m_stage = shaderStageFromFileName(_glslPath),
+            .m_entry = _entry ? _entry : "main",
+            .m_defines = normaliseDefines(_defines)
+        };
+        return getOrCreate(key);
+    }
 
-            const std::string spvName = makeSiblingSpvName(path);
-            const std::string pretty = Utils::ShortPathForLog(spvName);
-            MARK_INFO(Utils::Category::Shader, "Loaded cached SPIR-V: %s", pretty.c_str());
-            return m_map.find(k)->second.m_module;
+    VkShaderModule VulkanShaderCache::getOrCreateEmbedded(const Key& _key)
+    {
+        {
+            std::lock_guard<std::mutex> lk(m_mutex);
+            if (auto it = m_map.find(_key); it != m_map.end())
+                return it->second.m_module;
         }
 
-        // Compile from GLSL
-        std::string src;
-        if (!readFileToString(_glslPath, src))
+        // Permutations are embedded as "File.vert:A=1,B=2", the key's defines are already sorted by name
+        std::string name = std::filesystem::path(_key.m_absPath).filename().string();
+        for (size_t i = 0; i < _key.m_defines.size(); i++) {
+            name += (i == 0 ? ":" : ",") + _key.m_defines[i].m_name + "=" + _key.m_defines[i].m_value;
+        }
+        const EmbeddedShader* embedded = findEmbeddedShader(name);
+        if (!embedded)
         {
+            MARK_ERROR(Utils::Category::Shader, "Shader is not in the embedded SPIR-V bundle (permutations are listed in Core/CMakeLists.txt): %s", name.c_str());
             return VK_NULL_HANDLE;
         }
 
-        ShaderModuleInfo info;
-        if (!compileShader(m_device, stage, src.c_str(), info)) 
+        VkShaderModule module = createModule(embedded->m_words, embedded->m_wordCount, _key.m_absPath);
+        uint64_t contentHash = 1469598103934665603ull;
+        HashMixBytes(contentHash, embedded->m_words, embedded->m_wordCount * sizeof(uint32_t));
+
+        std::lock_guard<std::mutex> lk(m_mutex);
+        auto [it, inserted] = m_map.emplace(_key, Entry{ .m_module = module, .m_contentHash = contentHash, .m_pending = false });
+        if (!inserted)
         {
+            // Lost a race with another request for the same shader
+            vkDestroyShaderModule(m_device, module, nullptr);
+            return it->second.m_module;
+        }
+
+        MARK_INFO(Utils::Category::Shader, "Loaded embedded SPIR-V: %s", name.c_str());
+        return module;
+    }
+
+    VkShaderModule VulkanShaderCache::getOrCreate(const Key& _key)
+    {
+#if !MARK_SHADER_RUNTIME_COMPILE
+        return getOrCreateEmbedded(_key);
+#else
+        // Fast path: no file in the entry's closure changed size or write time since it was hashed
+        {
+            std::vector<ShaderSourceStamp> stamps;
+            uint64_t knownHash = 0;
+            {
+                std::lock_guard<std::mutex> lk(m_mutex);
+                if (auto it = m_map.find(_key); it != m_map.end() && !it->second.m_pending)
+                {
+                    stamps = it->second.m_sources;
+                    knownHash = it->second.m_contentHash;
+                }
+            }
+            if (sourceStampsCurrent(stamps))
+            {
+                std::lock_guard<std::mutex> lk(m_mutex);
+                if (auto it = m_map.find(_key); it != m_map.end() && !it->second.m_pending && it->second.m_contentHash == knownHash)
+                    return it->second.m_module;
+            }
+        }
+
+        // Hash source + includes before taking the lock, file IO shouldn't block other shaders
+        std::vector<ShaderSourceStamp> stamps;
+        stampSource(_key.m_absPath, stamps);
+        std::string src;
+        if (!readFileToString(_key.m_absPath.c_str(), src)) {
             return VK_NULL_HANDLE;
         }
 
-        // Write sibling cache and store entry
-        writeWordsToSpv(makeSiblingSpvName(path), info.m_SPIRV);
+        const std::string preamble = makeDefinePreamble(_key.m_defines);
+        uint64_t contentHash = compilerFingerprint();
+        {
+            const uint32_t stage = static_cast<uint32_t>(_key.m_stage);
+            HashMix64(contentHash, stage);
+            hashString(contentHash, _key.m_entry);
+            hashString(contentHash, preamble);
+            std::vector<std::string> visited{ _key.m_absPath };
+            if (!hashIncludeClosure(_key.m_absPath, src, contentHash, visited, stamps, 0)) {
+                return VK_NULL_HANDLE;
+            }
+        }
 
-        const std::string spvPath = makeSiblingSpvName(path);
-        auto lwt = std::filesystem::last_write_time(spvPath, ec);
-        if (ec)
+        std::string pretty = Utils::ShortPathForLog(_key.m_absPath);
+        for (const ShaderDefine& define : _key.m_defines) {
+            pretty += " " + define.m_name + "=" + define.m_value;
+        }
+        std::vector<uint64_t> destroyed;
         {
-            MARK_WARN(Utils::Category::Shader,
-                "last_write_time failed for '%s': %s",
-                spvPath.c_str(), ec.message().c_str()
-            );
-            spvTime = {};
+            std::unique_lock<std::mutex> lk(m_mutex);
+
+            // Another thread is producing this key, share its module
+            m_resolvedCv.wait(lk, [&] {
+                auto it = m_map.find(_key);
+                return it == m_map.end() || !it->second.m_pending;
+            });
+
+            if (auto it = m_map.find(_key); it != m_map.end())
+            {
+                if (it->second.m_contentHash == contentHash) {
+                    it->second.m_sources = std::move(stamps); // Touched but unchanged
+                    return it->second.m_module; // up-to-date
+                }
+                // Source or an include changed, drop and rebuild
+                MARK_INFO(Utils::Category::Shader, "Shader changed, rebuilding: %s", pretty.c_str());
+                destroyed.push_back(identityOf(it->first, it->second));
+                vkDestroyShaderModule(m_device, it->second.m_module, nullptr);
+                m_map.erase(it);
+            }
+
+            m_map.emplace(_key, Entry{ .m_contentHash = contentHash, .m_sources = std::move(stamps) });
         }
-        else 
+        notifyModulesDestroyed(destroyed);
+
+        std::vector<uint32_t> words;
+        const bool cached = loadCachedSpirv(contentHash, words);
+        if (!cached)
         {
-            spvTime = lwt;
+            if (compileGLSLToSpirv(_key.m_stage, _key.m_absPath, src, preamble, words)) {
+                storeCachedSpirv(contentHash, words);
+            }
+            else {
+                words.clear();
+            }
         }
 
-        auto lwt2 = std::filesystem::last_write_time(spvPath, ec);
-        Entry entry = {
-            .m_module = info.m_shaderModule,
-            .m_spirv = std::move(info.m_SPIRV),
-            .m_srcTime = srcTime,
-            .m_spvTime = ec ? std::filesystem::file_time_type{} : lwt2
-        };
-        m_map.emplace(k, std::move(entry));
+        const VkShaderModule module = words.empty() ? VK_NULL_HANDLE : createModule(words.data(), words.size(), _key.m_absPath);
+
+        std::lock_guard<std::mutex> lk(m_mutex);
+        auto it = m_map.find(_key);
+        if (module == VK_NULL_HANDLE)
+        {
+            // Failed compiles aren't cached, the next request retries
+            m_map.erase(it);
+        }
+        else
+        {
+            it->second.m_module = module;
+            it->second.m_spirv = std::move(words);
+            it->second.m_pending = false;
+            if (cached) {
+                MARK_INFO(Utils::Category::Shader, "Loaded cached SPIR-V: %s", pretty.c_str());
+            }
+            else {
+                MARK_INFO(Utils::Category::Shader, "Compiled GLSL -> SPIR-V: %s", pretty.c_str());
+            }
+        }
+        m_resolvedCv.notify_all();
+        return module;
+#endif
+    }
+
+    std::vector<VkShaderModule> VulkanShaderCache::getOrCreateBatchFromGLSL(const std::vector<ShaderCompileRequest>& _requests)
+    {
+        std::vector<VkShaderModule> modules(_requests.size(), VK_NULL_HANDLE);
+
+        const auto start = std::chrono::steady_clock::now();
+        Utils::parallelFor(_requests.size(), 1, [&](size_t _index)
+        {
+            const ShaderCompileRequest& request = _requests[_index];
+            modules[_index] = getOrCreateFromGLSL(request.m_glslPath.c_str(), request.m_defines, request.m_entry.c_str());
+        });
+        const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        const size_t failed = static_cast<size_t>(std::count(modules.begin(), modules.end(), VK_NULL_HANDLE));
+        MARK_INFO(Utils::Category::Shader, "Shader batch: %zu shaders in %.2f ms on %u threads (%zu failed)",
+            _requests.size(), ms, Utils::parallelForThreadCount(_requests.size(), 1), failed);
+        return modules;
+    }
+
+    size_t VulkanShaderCache::precompileDirectories(const std::vector<std::filesystem::path>& _directories)
+    {
+#if !MARK_SHADER_RUNTIME_COMPILE
+        // Nothing to compile, embedded modules are created on first request without touching disk
+        (void)_directories;
+        return 0;
+#else
+        static constexpr const char* STAGE_EXTENSIONS[] = { ".vert", ".frag", ".comp", ".geom", ".tesc", ".tese" };
+        static const std::vector<ShaderPermutation> permutations = enginePermutations();
+
+        std::vector<ShaderCompileRequest> requests;
+        for (const std::filesystem::path& dir : _directories)
+        {
+            std::error_code ec;
+            if (!std::filesystem::is_directory(dir, ec)) continue;
+
+            for (const auto& file : std::filesystem::recursive_directory_iterator(dir, ec))
+            {
+                if (!file.is_regular_file(ec)) continue;
+                const std::string ext = file.path().extension().string();
+                if (std::find(std::begin(STAGE_EXTENSIONS), std::end(STAGE_EXTENSIONS), ext) == std::end(STAGE_EXTENSIONS)) continue;
+
+                requests.push_back(ShaderCompileRequest{ .m_glslPath = file.path().string() });
+                const std::string fileName = file.path().filename().string();
+                for (const ShaderPermutation& permutation : permutations)
+                {
+                    if (permutation.m_fileName == fileName) {
+                        requests.push_back(ShaderCompileRequest{ .m_glslPath = file.path().string(), .m_defines = permutation.m_defines });
+                    }
+                }
+            }
+        }
 
-        const std::string pretty = Utils::ShortPathForLog(_glslPath);
-        MARK_INFO(Utils::Category::Shader, "Compiled GLSL -> SPIR-V: %s", pretty.c_str());
+        if (requests.empty()) return 0;
 
-        return m_map.find(k)->second.m_module;
+        const std::vector<VkShaderModule> modules = getOrCreateBatchFromGLSL(requests);
+        return static_cast<size_t>(std::count_if(modules.begin(), modules.end(), [](VkShaderModule _m) { return _m != VK_NULL_HANDLE; }));
+#endif
     }
 
     VkShaderModule VulkanShaderCache::getOrCreateFromSPV(const char* _spvPath, glslang_stage_t _stage)
@@ -353,57 +780,116 @@ namespace Mark::RendererVK
         auto abs = std::filesystem::weakly_canonical(path, ec);
         const std::string absString = ec ? path.string() : abs.string();
 
-        Key k{ absString, _stage, "main" };
-        if (auto it = m_map.find(k); it != m_map.end()) 
-            return it->second.m_module;
+        Key k{ absString, _stage, "main", {} };
+        {
+            std::lock_guard<std::mutex> lk(m_mutex);
+            if (auto it = m_map.find(k); it != m_map.end() && !it->second.m_pending)
+                return it->second.m_module;
+        }
 
         std::vector<uint32_t> words;
         if (!readSPIRVFileToWords(_spvPath, words)) 
             return VK_NULL_HANDLE;
 
-        VkShaderModuleCreateInfo moduleCreateInfo = { 
-            .sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO ,
-            .pNext = nullptr,
-            .flags = 0,
-            .codeSize = words.size() * sizeof(uint32_t),
-            .pCode = words.data(),
-        };
+        VkShaderModule module = createModule(words.data(), words.size(), absString);
+        uint64_t contentHash = 1469598103934665603ull;
+        HashMixBytes(contentHash, words.data(), words.size() * sizeof(uint32_t));
 
-        Entry entry{};
-
-        VkResult res = vkCreateShaderModule(m_device, &moduleCreateInfo, nullptr, &entry.m_module);
-        CHECK_VK_RESULT(res, "Failed to create shader module");
-
-        entry.m_spirv = std::move(words);
-        entry.m_spvTime = std::filesystem::last_write_time(path, ec);
-        m_map.emplace(k, std::move(entry));
+        std::lock_guard<std::mutex> lk(m_mutex);
+        auto [it, inserted] = m_map.emplace(k, Entry{ .m_module = module, .m_spirv = std::move(words), .m_contentHash = contentHash, .m_pending = false });
+        if (!inserted)
+        {
+            // Lost a race with another loader of the same file
+            vkDestroyShaderModule(m_device, module, nullptr);
+            return it->second.m_module;
+        }
 
         const std::string pretty = Utils::ShortPathForLog(_spvPath);
         MARK_INFO(Utils::Category::Shader, "Loaded SPIR-V: %s", pretty.c_str());
 
-        return m_map.find(k)->second.m_module;
+        return module;
     }
 
     void VulkanShaderCache::invalidatePath(const char* _path)
     {
-        std::vector<Key> toErase;
-        for (auto& [k, e] : m_map) 
+        std::vector<uint64_t> destroyed;
         {
-            if (k.m_absPath == _path)
+            std::lock_guard<std::mutex> lk(m_mutex);
+            for (auto it = m_map.begin(); it != m_map.end(); )
             {
-                vkDestroyShaderModule(m_device, e.m_module, nullptr);
-                toErase.push_back(k);
+                if (it->first.m_absPath == _path && !it->second.m_pending)
+                {
+                    destroyed.push_back(identityOf(it->first, it->second));
+                    vkDestroyShaderModule(m_device, it->second.m_module, nullptr);
+                    it = m_map.erase(it);
+                }
+                else
+                {
+                    ++it;
+                }
             }
         }
-        for (auto& k : toErase) 
-            m_map.erase(k);
+        notifyModulesDestroyed(destroyed);
+    }
+
+    bool VulkanShaderCache::findModuleSource(VkShaderModule _module, std::string& _outPath, std::string& _outEntry, glslang_stage_t& _outStage, ShaderDefines& _outDefines) const
+    {
+        if (_module == VK_NULL_HANDLE) return false;
+
+        std::lock_guard<std::mutex> lk(m_mutex);
+        for (const auto& [k, e] : m_map)
+        {
+            if (e.m_module != _module) continue;
+
+            _outPath = k.m_absPath;
+            _outEntry = k.m_entry;
+            _outStage = k.m_stage;
+            _outDefines = k.m_defines;
+            return true;
+        }
+        return false;
+    }
+
+    uint64_t VulkanShaderCache::moduleIdentity(VkShaderModule _module) const
+    {
+        if (_module == VK_NULL_HANDLE) return 0;
+
+        std::lock_guard<std::mutex> lk(m_mutex);
+        for (const auto& [k, e] : m_map)
+        {
+            if (e.m_module == _module) {
+                return identityOf(k, e);
+            }
+        }
+        return 0;
+    }
+
+    void VulkanShaderCache::setModuleDestroyedCallback(ModuleDestroyedFn _callback)
+    {
+        m_onModuleDestroyed = std::move(_callback);
+    }
+
+    uint64_t VulkanShaderCache::identityOf(const Key& _key, const Entry& _entry)
+    {
+        uint64_t identity = _entry.m_contentHash;
+        HashMixBytes(identity, _key.m_entry.data(), _key.m_entry.size());
+        return identity != 0 ? identity : 1;
+    }
+
+    void VulkanShaderCache::notifyModulesDestroyed(const std::vector<uint64_t>& _identities) const
+    {
+        if (!m_onModuleDestroyed) return;
+        for (uint64_t identity : _identities) {
+            m_onModuleDestroyed(identity);
+        }
     }
 
     void VulkanShaderCache::destroyAll()
     {
+        std::lock_guard<std::mutex> lk(m_mutex);
         for (auto& [k, e] : m_map) 
             if (e.m_module)
                 vkDestroyShaderModule(m_device, e.m_module, nullptr);
         m_map.clear();
     }
-} // namespace Mark::RendererVK
\ No newline at end of file
+} // namespace Mark::RendererVK
@@ -1,13 +1,40 @@
 #pragma once
+// Set to 0 by CMake when MARK_RUNTIME_SHADER_COMPILER is OFF, GLSL requests resolve from the embedded SPIR-V bundle
+#ifndef MARK_SHADER_RUNTIME_COMPILE
+    #define MARK_SHADER_RUNTIME_COMPILE 1
+#endif
+
 #include <volk.h>
-#include <glslang/Public/ShaderLang.h>
-#include <glslang/Public/resource_limits_c.h>
-#include <glslang/Include/glslang_c_interface.h>
+#if MARK_SHADER_RUNTIME_COMPILE
+    #include <glslang/Public/ShaderLang.h>
+    #include <glslang/Public/resource_limits_c.h>
+    #include <glslang/Include/glslang_c_interface.h>
+#endif
 
 #include <vector>
 #include <string>
 #include <unordered_map>
 #include <filesystem>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+
+// Set to 0 to always compile GLSL and skip the SPIR-V cache under MARK_CACHE_DIR
+#ifndef MARK_SHADER_DISK_CACHE
+    #define MARK_SHADER_DISK_CACHE 1
+#endif
+
+#if !MARK_SHADER_RUNTIME_COMPILE
+// glslang isn't available, same values as glslang_c_shader_types.h so persisted stages stay compatible
+typedef enum {
+    GLSLANG_STAGE_VERTEX,
+    GLSLANG_STAGE_TESSCONTROL,
+    GLSLANG_STAGE_TESSEVALUATION,
+    GLSLANG_STAGE_GEOMETRY,
+    GLSLANG_STAGE_FRAGMENT,
+    GLSLANG_STAGE_COMPUTE
+} glslang_stage_t;
+#endif
 
 namespace Mark::RendererVK
 {
@@ -18,29 +45,79 @@ namespace Mark::RendererVK
         std::vector<uint32_t> m_SPIRV;
         VkShaderModule m_shaderModule = VK_NULL_HANDLE;
 
+#if MARK_SHADER_RUNTIME_COMPILE
         void initialize(glslang_program_t* _program)
         {
             size_t programSize = glslang_program_SPIRV_get_size(_program);
             m_SPIRV.resize(programSize);
             glslang_program_SPIRV_get(_program, m_SPIRV.data());
         }
+#endif
+    };
+
+    // One "#define NAME VALUE" of a shader permutation
+    struct ShaderDefine
+    {
+        std::string m_name;
+        std::string m_value{ "1" };
+        bool operator==(const ShaderDefine&) const = default;
+    };
+    // Order doesn't matter, the cache sorts by name (a repeated name keeps the last value)
+    using ShaderDefines = std::vector<ShaderDefine>;
+
+    // Write time and size of a shader source or include when it was last hashed
+    struct ShaderSourceStamp
+    {
+        std::string m_path;
+        std::filesystem::file_time_type m_writeTime{};
+        uint64_t m_size{ 0 };
+    };
+
+    struct ShaderCompileRequest
+    {
+        std::string m_glslPath;
+        std::string m_entry{ "main" };
+        ShaderDefines m_defines{};
     };
 
-    // GLSL / SPIR-V -> VkShaderModule caching system
+    // GLSL / SPIR-V -> VkShaderModule caching system. Safe to call from any thread
+    // Compiled SPIR-V is stored under MARK_CACHE_DIR/Shaders, named by a hash of the source, its #include
+    // closure, defines, stage and compiler version, so edits to any of those miss and nothing else does
     struct VulkanShaderCache
     {
         explicit VulkanShaderCache(VkDevice& _device);
         ~VulkanShaderCache() = default;
+        VulkanShaderCache(const VulkanShaderCache&) = delete;
+        VulkanShaderCache& operator=(const VulkanShaderCache&) = delete;
         void destroy();
 
-        // Compile from GLSL if needed; otherwise use up-to-date sibling .spv (e.g., "file.vert.spv")
+        // Loads from the SPIR-V cache when the content hash matches, compiles otherwise.
+        // Callers racing on the same shader wait for the first compile
         VkShaderModule getOrCreateFromGLSL(const char* _glslPath, const char* _entry = "main");
+        // Compile-time permutation, the defines are injected ahead of the source and are part of the cache key,
+        // so each variant is compiled once and shares the content-hashed SPIR-V cache
+        VkShaderModule getOrCreateFromGLSL(const char* _glslPath, const ShaderDefines& _defines, const char* _entry = "main");
+        // Compiles the batch across threads, modules are returned in request order (null on failure)
+        std::vector<VkShaderModule> getOrCreateBatchFromGLSL(const std::vector<ShaderCompileRequest>& _requests);
+        // Batch compiles every GLSL stage file found in the directories, plus the define permutations the engine
+        // requests (MARK_ENGINE_SHADER_PERMUTATIONS in Core/CMakeLists.txt), returns how many loaded
+        size_t precompileDirectories(const std::vector<std::filesystem::path>& _directories);
         // Load directly from .spv
         VkShaderModule getOrCreateFromSPV(const char* _spvPath, glslang_stage_t _stage = GLSLANG_STAGE_VERTEX);
 
         // Invalidate one path (forces recompile on next request)
         void invalidatePath(const char* _path);
 
+        // Reverse lookup used to persist pipeline descriptions, false if the module isn't owned by this cache
+        bool findModuleSource(VkShaderModule _module, std::string& _outPath, std::string& _outEntry, glslang_stage_t& _outStage, ShaderDefines& _outDefines) const;
+
+        // Content hash + entry point of a module owned by this cache, 0 if it isn't one. Unlike the handle it
+        // survives a rebuild that produces the same shader, so pipeline library parts are keyed on it
+        uint64_t moduleIdentity(VkShaderModule _module) const;
+        // Called with a module's identity after a rebuild or invalidatePath destroys it (not on destroy()), never under the cache lock
+        using ModuleDestroyedFn = std::function<void(uint64_t _identity)>;
+        void setModuleDestroyedCallback(ModuleDestroyedFn _callback);
+
     private:
         void destroyAll();
 
@@ -49,9 +126,10 @@ namespace Mark::RendererVK
             std::string m_absPath;
             glslang_stage_t m_stage;
             std::string m_entry;
+            ShaderDefines m_defines; // Sorted by name
             bool operator==(const Key& _o) const noexcept
             {
-                return m_stage == _o.m_stage && m_entry == _o.m_entry && m_absPath == _o.m_absPath;
+                return m_stage == _o.m_stage && m_entry == _o.m_entry && m_absPath == _o.m_absPath && m_defines == _o.m_defines;
             }
         };
         struct KeyHasher
@@ -61,6 +139,11 @@ namespace Mark::RendererVK
                 size_t hash = std::hash<std::string>{}(_k.m_absPath);
                 hash ^= std::hash<int>{}(static_cast<int>(_k.m_stage)) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
                 hash ^= std::hash<std::string>{}(_k.m_entry) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+                for (const ShaderDefine& define : _k.m_defines)
+                {
+                    hash ^= std::hash<std::string>{}(define.m_name) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+                    hash ^= std::hash<std::string>{}(define.m_value) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+                }
                 return hash;
             }
         };
@@ -68,14 +151,27 @@ namespace Mark::RendererVK
         {
             VkShaderModule m_module{ VK_NULL_HANDLE };
             std::vector<uint32_t> m_spirv;
-            std::filesystem::file_time_type m_srcTime{};
-            std::filesystem::file_time_type m_spvTime{};
+            uint64_t m_contentHash{ 0 };
+            bool m_pending{ true }; // Reserved by the thread compiling it
+            std::vector<ShaderSourceStamp> m_sources; // Source + include closure, empty forces a rehash
         };
 
+        VkShaderModule getOrCreate(const Key& _key);
+        // Looks the source file name (plus defines for a permutation) up in the build-time SPIR-V bundle
+        VkShaderModule getOrCreateEmbedded(const Key& _key);
+        VkShaderModule createModule(const uint32_t* _words, size_t _wordCount, const std::string& _debugPath) const;
+        static uint64_t identityOf(const Key& _key, const Entry& _entry);
+        void notifyModulesDestroyed(const std::vector<uint64_t>& _identities) const;
+
+        // SPIR-V cache files under MARK_CACHE_DIR/Shaders
+        static std::filesystem::path cachePathForHash(uint64_t _contentHash);
+        static bool loadCachedSpirv(uint64_t _contentHash, std::vector<uint32_t>& _outWords);
+        static bool storeCachedSpirv(uint64_t _contentHash, const std::vector<uint32_t>& _words);
+
         VkDevice m_device;
         std::unordered_map<Key, Entry, KeyHasher> m_map;
-        bool tryLoadSiblingSpv(const std::filesystem::path& _glsl, std::vector<uint32_t>& _outWords,
-            std::filesystem::file_time_type& _spvTime) const;
-        static std::string makeSiblingSpvName(const std::filesystem::path& _glsl);
+        mutable std::mutex m_mutex;
+        std::condition_variable m_resolvedCv;
+        ModuleDestroyedFn m_onModuleDestroyed; // Set once during startup
     };
 } // namespace Mark::RendererVK
\ No newline at end of file
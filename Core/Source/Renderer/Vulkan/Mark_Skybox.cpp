@@ -19,14 +19,15 @@ namespace Mark::RendererVK
 
         m_uniformBuffer.createUniformBuffers(m_numImages);
 
-        m_cubmapTexture.generateCubemapTexture(_skyboxTexturePath);
-
         auto VkCore = m_vulkanCoreRef.lock();
         if (!VkCore) {
             MARK_FATAL(Utils::Category::Vulkan, "VulkanCore expired in VulkanSkybox::initialize");
         }
 
+        // Set layout first so a prewarmed sky pipeline compiles while the cubemap is generated
         m_resourceSet.initialize(m_vulkanCoreRef, _swapChain, m_uniformBuffer, "SkyboxSet0");
+
+        m_cubmapTexture.generateCubemapTexture(_skyboxTexturePath);
         m_resourceSet.setCubemap(m_cubmapTexture);
 
         std::filesystem::path vertexPath = std::filesystem::path(MARK_CORE_ASSETS) / "SkyboxShader.vert";
@@ -52,7 +53,8 @@ namespace Mark::RendererVK
 
         m_pipelineRef = new VulkanGraphicsPipeline();
         m_pipelineRef->setResourceLayout(m_resourceSet.layout(), m_resourceSet.layoutHash());
-        m_pipelineRef->createGraphicsPipeline(pipelineDesc);
+        // Sky is skipped for the first frames rather than stalling startup on its compile
+        m_pipelineRef->createGraphicsPipelineAsync(pipelineDesc);
     }
 
     void VulkanSkybox::destroy()
@@ -83,7 +85,7 @@ namespace Mark::RendererVK
     {
         if (!m_pipelineRef) return;
 
-        m_pipelineRef->bindPipeline(_cmdBuffer);
+        if (!m_pipelineRef->bindPipeline(_cmdBuffer)) return;
 
         m_resourceSet.bind(_cmdBuffer, m_pipelineRef->pipelineLayout(), _imageIndex);
 
@@ -125,7 +127,12 @@ namespace Mark::RendererVK
                 }
             };
             m_pipelineRef->setResourceLayout(m_resourceSet.layout(), m_resourceSet.layoutHash());
-            m_pipelineRef->createGraphicsPipeline(pipelineDesc);
+            m_pipelineRef->createGraphicsPipelineAsync(pipelineDesc);
         }
     }
+
+    bool VulkanSkybox::pollPipeline()
+    {
+        return m_pipelineRef && m_pipelineRef->poll();
+    }
 } // namespace Mark::RendererVK
\ No newline at end of file
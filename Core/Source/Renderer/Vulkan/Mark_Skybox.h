@@ -30,6 +30,9 @@ namespace Mark::RendererVK
 
         void recreateForSwapchain(const VulkanSwapChain& _swapChain);
 
+        // True when the background pipeline compile just finished
+        bool pollPipeline();
+
     private:
         std::weak_ptr<VulkanCore> m_vulkanCoreRef;
         VulkanCommandBuffers* m_commandBuffersRef{ nullptr };
@@ -44,6 +44,7 @@ namespace Mark::RendererVK
 
         std::vector<VkDescriptorBindingFlags> noFlags;
         m_set.createLayout(m_device, bindings, noFlags, 0, ("Skybox." + m_debugName + ".Set0").c_str());
+        VkCore->pipelineManifest().prewarm(m_set.layout(), m_set.layoutHash());
 
         // Pool
         std::vector<VkDescriptorPoolSize> sizes;
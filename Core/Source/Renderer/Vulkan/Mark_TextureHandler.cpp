@@ -2,19 +2,109 @@
 #include "Mark_VulkanCore.h"
 #include "Mark_BufferAndMemoryHelper.h"
 #include "Mark_CommandBuffers.h"
+#include "Mark_CubemapCompute.h"
 
+#include "Engine/BitmapView.h"
+#include "Engine/SettingsHandler.h"
+#include "Utils/Mark_ParallelFor.h"
 #include "Utils/Mark_Utils.h"
 #include "Utils/VulkanUtils.h"
 #include <vulkan/vk_enum_string_helper.h>
 
 #include <glm/gtc/constants.hpp>
 
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+
+namespace Mark::RendererVK
+{
+    namespace
+    {
+        // stb_image has no caller supplied output buffer, so batch decodes route its allocator through here instead.
+        // While a slot is armed on a thread, the first allocation of exactly the decoded RGBA8 size is served from the
+        // mapped staging memory. For PNG (8 and 16 bit, paletted, grey, interlaced) that's the image stb returns, JPEG
+        // asks for one spare byte and so never matches. Callers compare the returned pointer and copy when it differs
+        struct StagingDecodeSlot
+        {
+            uint8_t* m_memory = nullptr;
+            size_t m_size = 0;
+            bool m_served = false;
+        };
+        thread_local StagingDecodeSlot t_stagingDecodeSlot;
+
+        void* stagingDecodeMalloc(size_t _size)
+        {
+            StagingDecodeSlot& slot = t_stagingDecodeSlot;
+            if (slot.m_memory && !slot.m_served && _size == slot.m_size)
+            {
+                slot.m_served = true;
+                return slot.m_memory;
+            }
+            return std::malloc(_size);
+        }
+
+        void* stagingDecodeRealloc(void* _ptr, size_t _size)
+        {
+            StagingDecodeSlot& slot = t_stagingDecodeSlot;
+            if (!_ptr || _ptr != slot.m_memory)
+                return std::realloc(_ptr, _size);
+
+            // An intermediate buffer that happened to match the size is growing, move it to the heap
+            void* moved = std::malloc(_size);
+            if (moved)
+                std::memcpy(moved, _ptr, std::min(_size, slot.m_size));
+            return moved;
+        }
+
+        void stagingDecodeFree(void* _ptr)
+        {
+            if (_ptr && _ptr == t_stagingDecodeSlot.m_memory)
+                return;
+            std::free(_ptr);
+        }
+    }
+} // namespace Mark::RendererVK
+
 #define STB_IMAGE_IMPLEMENTATION
 #define STBI_MSC_SECURE_CRT
+#define STBI_MALLOC(_size) Mark::RendererVK::stagingDecodeMalloc(_size)
+#define STBI_REALLOC(_ptr, _size) Mark::RendererVK::stagingDecodeRealloc(_ptr, _size)
+#define STBI_FREE(_ptr) Mark::RendererVK::stagingDecodeFree(_ptr)
 #include "Include/stb/stb_image.h"
 
 namespace Mark::RendererVK
 {
+    static void recordImageBarrier(VkCommandBuffer _cmd, VkImage _image, uint32_t _baseMip, uint32_t _mipCount, uint32_t _layerCount,
+        VkImageLayout _oldLayout, VkImageLayout _newLayout, VkAccessFlags _srcAccess, VkAccessFlags _dstAccess,
+        VkPipelineStageFlags _srcStage, VkPipelineStageFlags _dstStage)
+    {
+        VkImageMemoryBarrier barrier{
+            .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+            .pNext = nullptr,
+            .srcAccessMask = _srcAccess,
+            .dstAccessMask = _dstAccess,
+            .oldLayout = _oldLayout,
+            .newLayout = _newLayout,
+            .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .image = _image,
+            .subresourceRange = {
+                .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+                .baseMipLevel = _baseMip,
+                .levelCount = _mipCount,
+                .baseArrayLayer = 0,
+                .layerCount = _layerCount,
+            }
+        };
+
+        vkCmdPipelineBarrier(_cmd, _srcStage, _dstStage, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+    }
+
     TextureHandler::TextureHandler(std::weak_ptr<VulkanCore> _vulkanCoreRef, VulkanCommandBuffers* _commandBuffersRef) :
         m_vulkanCoreRef(_vulkanCoreRef), m_commandBuffersRef(_commandBuffersRef)
     {
@@ -82,7 +172,218 @@ namespace Mark::RendererVK
         MARK_INFO(Utils::Category::Vulkan, "Texture Loaded To Vulkan From: %s", Utils::ShortPathForLog(_texturePath).c_str());
     }
 
+    namespace
+    {
+        // Upper bound on one batch's staging memory, larger requests are split into several submissions
+        constexpr VkDeviceSize TEXTURE_BATCH_STAGING_BUDGET = 64ull * 1024 * 1024;
+        constexpr VkDeviceSize TEXTURE_BATCH_ALIGNMENT = 16;
+        constexpr int TEXTURE_BATCH_CHANNELS = 4;
+
+        struct PendingTexture
+        {
+            int width = 0;
+            int height = 0;
+            VkDeviceSize offset = 0;
+            VkDeviceSize size = 0;
+            bool decoded = false;
+            bool inPlace = false;
+        };
+
+        // Decoding writes into the staging memory and PNG filtering reads the previous row back, which is slow on
+        // write-combined memory. Prefer a cached host type when the device has one
+        VkMemoryPropertyFlags batchStagingMemoryFlags(VulkanCore& _vulkanCore)
+        {
+            constexpr VkMemoryPropertyFlags required = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+            constexpr VkMemoryPropertyFlags cached = required | VK_MEMORY_PROPERTY_HOST_CACHED_BIT;
+
+            const VkPhysicalDeviceMemoryProperties& memProperties = _vulkanCore.physicalDevices().selected().m_memoryProperties;
+            for (uint32_t i = 0; i < memProperties.memoryTypeCount; i++)
+            {
+                if ((memProperties.memoryTypes[i].propertyFlags & cached) == cached)
+                    return cached;
+            }
+            return required;
+        }
+    }
+
+    void TextureHandler::generateTextures(const std::vector<TextureHandler*>& _textures, const std::vector<const char*>& _texturePaths)
+    {
+        const size_t count = std::min(_textures.size(), _texturePaths.size());
+        if (count == 0) return;
+
+        auto loadStart = std::chrono::steady_clock::now();
+
+        TextureHandler& first = *_textures[0];
+        auto VkCore = first.m_vulkanCoreRef.lock();
+        VkDevice device = VkCore->device();
+        const VkFormat format = VK_FORMAT_R8G8B8A8_UNORM;
+
+        // Headers only, cheap enough to do up front so the staging layout is known before decoding
+        std::vector<PendingTexture> pending(count);
+        VkDeviceSize largestTexture = 0;
+        VkDeviceSize totalSize = 0;
+        for (size_t i = 0; i < count; i++)
+        {
+            int channels = 0;
+            if (!stbi_info(_texturePaths[i], &pending[i].width, &pending[i].height, &channels)) {
+                pending[i].width = pending[i].height = 0;
+                continue;
+            }
+            pending[i].size = VkDeviceSize(pending[i].width) * pending[i].height * TEXTURE_BATCH_CHANNELS;
+            largestTexture = std::max(largestTexture, pending[i].size);
+            totalSize += (pending[i].size + TEXTURE_BATCH_ALIGNMENT - 1) & ~(TEXTURE_BATCH_ALIGNMENT - 1);
+        }
+
+        // One persistently mapped staging buffer, reused for every chunk of the batch. Small batches only take what they need
+        const VkDeviceSize stagingSize = std::max(std::min(TEXTURE_BATCH_STAGING_BUDGET, totalSize), largestTexture);
+        BufferAndMemory staging;
+        uint8_t* mapped = nullptr;
+        if (largestTexture > 0)
+        {
+            staging = BufferAndMemory(VkCore, stagingSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+                batchStagingMemoryFlags(*VkCore), "TextureHandler.BatchStaging");
+            mapped = static_cast<uint8_t*>(staging.map(device));
+        }
+
+        size_t chunkBegin = 0;
+        while (chunkBegin < count && mapped)
+        {
+            // Pack as many textures as fit in the staging budget
+            size_t chunkEnd = chunkBegin;
+            VkDeviceSize offset = 0;
+            while (chunkEnd < count)
+            {
+                PendingTexture& texture = pending[chunkEnd];
+                const VkDeviceSize alignedOffset = (offset + TEXTURE_BATCH_ALIGNMENT - 1) & ~(TEXTURE_BATCH_ALIGNMENT - 1);
+                if (chunkEnd > chunkBegin && alignedOffset + texture.size > stagingSize)
+                    break;
+                texture.offset = alignedOffset;
+                offset = alignedOffset + texture.size;
+                chunkEnd++;
+            }
+
+            // Decode in parallel, each worker's stb output lands in its texture's slot of the mapped staging memory
+            Utils::parallelFor(chunkEnd - chunkBegin, 1, [&](size_t _index)
+            {
+                const size_t i = chunkBegin + _index;
+                PendingTexture& texture = pending[i];
+                if (texture.size == 0) return;
+
+                uint8_t* destination = mapped + texture.offset;
+                t_stagingDecodeSlot = { .m_memory = destination, .m_size = static_cast<size_t>(texture.size) };
+
+                int width = 0, height = 0;
+                stbi_uc* pixels = stbi_load(_texturePaths[i], &width, &height, nullptr, STBI_rgb_alpha);
+                t_stagingDecodeSlot = {};
+
+                if (pixels == destination)
+                {
+                    texture.decoded = width == texture.width && height == texture.height;
+                    texture.inPlace = true;
+                    return;
+                }
+                if (pixels && width == texture.width && height == texture.height)
+                {
+                    std::memcpy(destination, pixels, static_cast<size_t>(texture.size));
+                    texture.decoded = true;
+                }
+                stbi_image_free(pixels);
+            });
+
+            // Image creation stays on this thread, all uploads share one submission
+            VkCommandBuffer cmd = first.m_commandBuffersRef->copyCommandBuffer();
+            first.m_commandBuffersRef->beginCommandBuffer(cmd, VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT);
+            for (size_t i = chunkBegin; i < chunkEnd; i++)
+            {
+                const PendingTexture& texture = pending[i];
+                if (!texture.decoded) continue;
+
+                TextureHandler& handler = *_textures[i];
+                handler.createTextureResources(texture.width, texture.height, format);
+                handler.recordUpload(cmd, staging.m_buffer, texture.offset, static_cast<uint32_t>(texture.width), static_cast<uint32_t>(texture.height), texture.size, 1);
+            }
+            first.submitCopyCommand();
+
+            chunkBegin = chunkEnd;
+        }
+
+        if (mapped)
+        {
+            staging.unmap(device);
+            staging.destroy(device);
+        }
+
+        size_t failed = 0;
+        size_t inPlace = 0;
+        for (size_t i = 0; i < count; i++)
+        {
+            inPlace += pending[i].inPlace ? 1 : 0;
+            if (!pending[i].decoded) {
+                _textures[i]->generateTexture(_texturePaths[i]);
+                failed++;
+            }
+        }
+
+        double loadMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - loadStart).count();
+        MARK_INFO(Utils::Category::Vulkan, "Loaded %zu textures in %.2f ms (%u decode threads, %zu decoded in place, %zu fell back)",
+            count, loadMs, Utils::parallelForThreadCount(count, 1), inPlace, failed);
+    }
+
+    void TextureHandler::benchmarkTextureLoading(std::weak_ptr<VulkanCore> _vulkanCoreRef, VulkanCommandBuffers* _commandBuffersRef, const char* _texturePath, uint32_t _count)
+    {
+        VkDevice device = _vulkanCoreRef.lock()->device();
+
+        auto destroyAll = [&](std::vector<TextureHandler>& _handlers)
+        {
+            for (TextureHandler& handler : _handlers) {
+                handler.destroyTextureHandler(device);
+            }
+            _handlers.clear();
+        };
+
+        // Warm the file cache so neither path pays for the first disk read
+        {
+            std::vector<TextureHandler> warmup(1, TextureHandler(_vulkanCoreRef, _commandBuffersRef));
+            warmup[0].generateTexture(_texturePath);
+            destroyAll(warmup);
+        }
+
+        std::vector<TextureHandler> handlers(_count, TextureHandler(_vulkanCoreRef, _commandBuffersRef));
+
+        auto serialStart = std::chrono::steady_clock::now();
+        for (TextureHandler& handler : handlers) {
+            handler.generateTexture(_texturePath);
+        }
+        double serialMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - serialStart).count();
+        destroyAll(handlers);
+
+        handlers.assign(_count, TextureHandler(_vulkanCoreRef, _commandBuffersRef));
+        std::vector<TextureHandler*> handlerPtrs;
+        std::vector<const char*> paths(_count, _texturePath);
+        for (TextureHandler& handler : handlers) {
+            handlerPtrs.push_back(&handler);
+        }
+
+        auto batchStart = std::chrono::steady_clock::now();
+        generateTextures(handlerPtrs, paths);
+        double batchMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - batchStart).count();
+        destroyAll(handlers);
+
+        const auto level = Utils::Level::Info;
+        const auto category = Utils::Category::Vulkan;
+        MARK_SCOPE(category, level, "Texture load benchmark (%u x %s):", _count, Utils::ShortPathForLog(_texturePath).c_str());
+        MARK_IN_SCOPE(category, level, "generateTexture:  %.2f ms (%.3f ms per texture)", serialMs, serialMs / _count);
+        MARK_IN_SCOPE(category, level, "generateTextures: %.2f ms (%.3f ms per texture)", batchMs, batchMs / _count);
+        MARK_IN_SCOPE(category, level, "Speedup: %.2fx", batchMs > 0.0 ? serialMs / batchMs : 0.0);
+    }
+
     void TextureHandler::createTextureImageFromData(const void* _pixels, int _width, int _height, VkFormat _format, bool _isCubemap)
+    {
+        createTextureResources(_width, _height, _format, _isCubemap);
+        updateTextureImage(_pixels, _width, _height, _format, _isCubemap);
+    }
+
+    void TextureHandler::createTextureResources(int _width, int _height, VkFormat _format, bool _isCubemap)
     {
         VkImageUsageFlagBits usage = (VkImageUsageFlagBits)(VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT);
         VkMemoryPropertyFlagBits properties = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
@@ -96,18 +397,16 @@ namespace Mark::RendererVK
         VkSamplerAddressMode adressMode = VK_SAMPLER_ADDRESS_MODE_REPEAT;
 
         m_textureSampler = createTextureSampler(minFilter, maxFilter, adressMode);
-
-        updateTextureImage(_pixels, _width, _height, _format, _isCubemap);
     }
 
-    void TextureHandler::createImage(int _width, int _height, VkFormat _format, VkImageUsageFlags _usage, VkMemoryPropertyFlagBits _properties, bool _isCubemap)
+    void TextureHandler::createImage(int _width, int _height, VkFormat _format, VkImageUsageFlags _usage, VkMemoryPropertyFlagBits _properties, bool _isCubemap, uint32_t _mipLevels, VkImageCreateFlags _extraFlags)
     {
         VkDevice device = m_vulkanCoreRef.lock()->device();
 
         VkImageCreateInfo imageInfo{
             .sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
             .pNext = nullptr,
-            .flags = _isCubemap ? VK_IMAGE_CREATE_CUBE_COMPATIBLE_BIT : (VkImageCreateFlags)0,
+            .flags = (_isCubemap ? VK_IMAGE_CREATE_CUBE_COMPATIBLE_BIT : (VkImageCreateFlags)0) | _extraFlags,
             .imageType = VK_IMAGE_TYPE_2D,
             .format = _format,
             .extent = {
@@ -115,7 +414,7 @@ namespace Mark::RendererVK
                 .height = static_cast<uint32_t>(_height),
                 .depth = 1u,
             },
-            .mipLevels = 1u,
+            .mipLevels = _mipLevels,
             .arrayLayers = _isCubemap ? 6u : 1u,
             .samples = VK_SAMPLE_COUNT_1_BIT,
             .tiling = VK_IMAGE_TILING_OPTIMAL,
@@ -148,6 +447,8 @@ namespace Mark::RendererVK
 
         res = vkBindImageMemory(device, m_textureImage, m_textureMemory, 0);
         CHECK_VK_RESULT(res, "Failed to bind texture image memory!");
+
+        m_mipLevels = _mipLevels;
     }
 
     uint32_t TextureHandler::getMemoryTypeIndex(uint32_t _typeFilter, VkMemoryPropertyFlagBits _properties)
@@ -186,13 +487,28 @@ namespace Mark::RendererVK
         BufferAndMemory stagingTexture = BufferAndMemory(m_vulkanCoreRef.lock(), imageSize, usage, properties, "TextureHandler.StagingTexture");
         stagingTexture.update(device, _pixels, static_cast<size_t>(imageSize));
 
-        transitionImageLayout(m_textureImage, _format, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, layerCount);
+        // Layout transitions and the copy go out in one submission
+        VkCommandBuffer cmd = m_commandBuffersRef->copyCommandBuffer();
+        m_commandBuffersRef->beginCommandBuffer(cmd, VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT);
+        recordUpload(cmd, stagingTexture.m_buffer, 0, static_cast<uint32_t>(_width), static_cast<uint32_t>(_height), layerSize, layerCount);
+        submitCopyCommand();
 
-        copyBufferToImage(stagingTexture.m_buffer, m_textureImage, static_cast<uint32_t>(_width), static_cast<uint32_t>(_height), layerSize, layerCount);
+        stagingTexture.destroy(device);
+    }
 
-        transitionImageLayout(m_textureImage, _format, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, layerCount);
+    void TextureHandler::recordUpload(VkCommandBuffer _cmd, VkBuffer _buffer, VkDeviceSize _bufferOffset, uint32_t _width, uint32_t _height, VkDeviceSize _layerSize, int _layerCount)
+    {
+        recordImageBarrier(_cmd, m_textureImage, 0, 1, static_cast<uint32_t>(_layerCount),
+            VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+            0, VK_ACCESS_TRANSFER_WRITE_BIT,
+            VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT);
 
-        stagingTexture.destroy(device);
+        recordCopyBufferToImage(_cmd, _buffer, _bufferOffset, m_textureImage, _width, _height, _layerSize, _layerCount);
+
+        recordImageBarrier(_cmd, m_textureImage, 0, 1, static_cast<uint32_t>(_layerCount),
+            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+            VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT,
+            VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT);
     }
 
     int TextureHandler::getBytesPerTexFormat(VkFormat _format)
@@ -337,16 +653,14 @@ namespace Mark::RendererVK
                 _format == VK_FORMAT_D32_SFLOAT_S8_UINT);
     }
 
-    void TextureHandler::copyBufferToImage(VkBuffer _buffer, VkImage _image, uint32_t _width, uint32_t _height, VkDeviceSize _layerSize, int _layerCount)
+    void TextureHandler::recordCopyBufferToImage(VkCommandBuffer _cmd, VkBuffer _buffer, VkDeviceSize _bufferOffset, VkImage _image, uint32_t _width, uint32_t _height, VkDeviceSize _layerSize, int _layerCount)
     {
-        m_commandBuffersRef->beginCommandBuffer(m_commandBuffersRef->copyCommandBuffer(), VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT);
-
         std::vector<VkBufferImageCopy> bufferImageCopies(_layerCount);
 
         for (size_t i = 0; i < _layerCount; i++)
         {
             bufferImageCopies[i] = {
-                .bufferOffset = i * _layerSize,
+                .bufferOffset = _bufferOffset + i * _layerSize,
                 .bufferRowLength = 0,
                 .bufferImageHeight = 0,
                 .imageSubresource = {
@@ -369,15 +683,13 @@ namespace Mark::RendererVK
         }
 
         vkCmdCopyBufferToImage(
-            m_commandBuffersRef->copyCommandBuffer(),
+            _cmd,
             _buffer,
             _image,
             VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
             (uint32_t)bufferImageCopies.size(),
             bufferImageCopies.data()
         );
-
-        submitCopyCommand();
     }
 
     void TextureHandler::submitCopyCommand()
@@ -390,11 +702,16 @@ namespace Mark::RendererVK
         graphicsQueue.waitIdle();
     }
 
-    VkImageView TextureHandler::createImageView(VkFormat _format, VkImageAspectFlags _aspectFlags, bool _isCubemap)
+    VkImageView TextureHandler::createImageView(VkFormat _format, VkImageAspectFlags _aspectFlags, bool _isCubemap, uint32_t _mipLevels, VkImageUsageFlags _viewUsage)
     {
+        VkImageViewUsageCreateInfo usageInfo{
+            .sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_USAGE_CREATE_INFO,
+            .pNext = nullptr,
+            .usage = _viewUsage
+        };
         VkImageViewCreateInfo viewInfo{
             .sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
-            .pNext = nullptr,
+            .pNext = _viewUsage ? &usageInfo : nullptr,
             .flags = 0,
             .image = m_textureImage,
             .viewType = _isCubemap ? VK_IMAGE_VIEW_TYPE_CUBE : VK_IMAGE_VIEW_TYPE_2D,
@@ -408,7 +725,7 @@ namespace Mark::RendererVK
             .subresourceRange = {
                 .aspectMask = _aspectFlags,
                 .baseMipLevel = 0,
-                .levelCount = 1,
+                .levelCount = _mipLevels,
                 .baseArrayLayer = 0,
                 .layerCount = _isCubemap ? 6u : 1u,
             }
@@ -421,7 +738,7 @@ namespace Mark::RendererVK
         return imageView;
     }
 
-    VkSampler TextureHandler::createTextureSampler(VkFilter _minFilter, VkFilter _maxFilter, VkSamplerAddressMode _adressMode)
+    VkSampler TextureHandler::createTextureSampler(VkFilter _minFilter, VkFilter _maxFilter, VkSamplerAddressMode _adressMode, float _maxLod)
     {
         VkSamplerCreateInfo samplerInfo{
             .sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO,
@@ -439,7 +756,7 @@ namespace Mark::RendererVK
             .compareEnable = VK_FALSE,
             .compareOp = VK_COMPARE_OP_ALWAYS,
             .minLod = 0.0f,
-            .maxLod = 0.0f,
+            .maxLod = _maxLod,
             .borderColor = VK_BORDER_COLOR_INT_OPAQUE_BLACK,
             .unnormalizedCoordinates = VK_FALSE
         };
@@ -470,37 +787,553 @@ namespace Mark::RendererVK
 
     #define CUBEMAP_NUM_FACES 6
 
+    // Set to 1 to run the reference conversion alongside the fast path and log timing / error
+    #ifndef MARK_CUBEMAP_VALIDATE
+        #define MARK_CUBEMAP_VALIDATE 0
+    #endif
+
+    namespace
+    {
+        constexpr int CUBEMAP_CHANNELS = 4;     // Source is always decoded as RGBA8
+        constexpr int CUBEMAP_ROW_BLOCK = 16;   // Pixels processed per vectorisable block
+        constexpr int CUBEMAP_ROWS_PER_TASK = 8;
+        constexpr int CUBEMAP_MAX_CHANNEL_ERROR = 2;
+        constexpr int CUBEMAP_MAX_GPU_CHANNEL_ERROR = 4; // Hardware bilinear weights are lower precision than the CPU's
+
+        // Per-channel difference between two RGBA8 cubemaps
+        struct CubemapChannelError
+        {
+            int m_max{ 0 };
+            uint64_t m_sum{ 0 };
+            size_t m_count{ 0 };
+            size_t m_overTolerance{ 0 };
+
+            void accumulate(const uint8_t* _a, const uint8_t* _b, size_t _bytes, int _tolerance)
+            {
+                for (size_t i = 0; i < _bytes; i++)
+                {
+                    const int error = std::abs(int(_a[i]) - int(_b[i]));
+                    m_max = std::max(m_max, error);
+                    m_sum += error;
+                    if (error > _tolerance) m_overTolerance++;
+                }
+                m_count += _bytes;
+            }
+            double mean() const { return m_count ? double(m_sum) / double(m_count) : 0.0; }
+        };
+
+        // Per-face direction as origin + A * axisA + B * axisB, matches faceCoordsToXYZ
+        struct CubeFaceBasis
+        {
+            float ox, oy, oz;
+            float ax, ay, az;
+            float bx, by, bz;
+        };
+
+        constexpr CubeFaceBasis c_cubeFaceBasis[CUBEMAP_NUM_FACES] = {
+            { -1.0f,  1.0f,  1.0f,    1.0f,  0.0f, 0.0f,    0.0f, 0.0f, -1.0f }, // POS_X
+            {  1.0f, -1.0f,  1.0f,   -1.0f,  0.0f, 0.0f,    0.0f, 0.0f, -1.0f }, // NEG_X
+            {  1.0f, -1.0f,  1.0f,    0.0f,  1.0f, 0.0f,   -1.0f, 0.0f,  0.0f }, // POS_Y
+            { -1.0f, -1.0f, -1.0f,    0.0f,  1.0f, 0.0f,    1.0f, 0.0f,  0.0f }, // NEG_Y
+            { -1.0f, -1.0f,  1.0f,    0.0f,  1.0f, 0.0f,    0.0f, 0.0f, -1.0f }, // POS_Z
+            {  1.0f,  1.0f,  1.0f,    0.0f, -1.0f, 0.0f,    0.0f, 0.0f, -1.0f }, // NEG_Z
+        };
+
+        // Branch-free atan2 approximation (max error ~2e-6 rad, well under a texel at 16K)
+        inline float fastAtan2(float _y, float _x)
+        {
+            const float ax = std::fabs(_x);
+            const float ay = std::fabs(_y);
+            const float mx = std::max(ax, ay);
+            const float mn = std::min(ax, ay);
+            const float a = mn / std::max(mx, 1e-30f);
+            const float s = a * a;
+            float r = a * (0.99997726f + s * (-0.33262347f + s * (0.19354346f + s * (-0.11643287f + s * (0.05265332f + s * -0.01172120f)))));
+            r = (ay > ax) ? glm::half_pi<float>() - r : r;
+            r = (_x < 0.0f) ? glm::pi<float>() - r : r;
+            return (_y < 0.0f) ? -r : r;
+        }
+
+        void convertCubemapRow(const ConstBitmapViewRGBA8& _src, const BitmapViewRGBA8& _face, int _faceIndex, int _y)
+        {
+            const int faceSize = _face.m_width;
+            const CubeFaceBasis& basis = c_cubeFaceBasis[_faceIndex];
+            const float invFace = 2.0f / float(faceSize);
+            const float B = float(_y) * invFace;
+            const float baseX = basis.ox + B * basis.bx;
+            const float baseY = basis.oy + B * basis.by;
+            const float baseZ = basis.oz + B * basis.bz;
+
+            const float uScale = float(_src.m_width) / glm::two_pi<float>();
+            const float vScale = float(_src.m_height) / glm::pi<float>();
+
+            alignas(64) float U[CUBEMAP_ROW_BLOCK];
+            alignas(64) float V[CUBEMAP_ROW_BLOCK];
+
+            for (int x0 = 0; x0 < faceSize; x0 += CUBEMAP_ROW_BLOCK)
+            {
+                const int count = std::min(CUBEMAP_ROW_BLOCK, faceSize - x0);
+
+                // Direction -> equirect coordinates, no branches so the compiler can vectorise it
+                for (int i = 0; i < CUBEMAP_ROW_BLOCK; i++)
+                {
+                    const float A = float(x0 + i) * invFace;
+                    const float px = baseX + A * basis.ax;
+                    const float py = baseY + A * basis.ay;
+                    const float pz = baseZ + A * basis.az;
+                    const float R = std::sqrt(px * px + py * py);
+                    const float phi = fastAtan2(py, px);
+                    const float theta = fastAtan2(pz, R);
+                    U[i] = (phi + glm::pi<float>()) * uScale;
+                    V[i] = (glm::half_pi<float>() - theta) * vScale;
+                }
+
+                for (int i = 0; i < count; i++) {
+                    BitmapOps::sampleBilinear(_src, U[i], V[i], _face.pixel(x0 + i, _y));
+                }
+            }
+        }
+    }
+
     void TextureHandler::generateCubemapTexture(const char* _cubemapTexturePath)
     {
-        int width, height;
+        const bool useGPU = Settings::MarkSettings::Get().generateCubemapsOnGPU() && isCubemapComputeSupported();
+
+        // Key off the source file before decoding so a warm start skips stb and the conversion entirely
+        int width = 0, height = 0, channels = 0;
+        CubemapCacheKey cacheKey{};
+        bool hasCacheKey = false;
+        if (stbi_info(_cubemapTexturePath, &width, &height, &channels))
+        {
+            const uint32_t faceSize = static_cast<uint32_t>(width / 4);
+            const uint32_t mipLevels = useGPU ? static_cast<uint32_t>(std::bit_width(faceSize)) : 1u;
+            hasCacheKey = VulkanCubemapCache::makeKey(_cubemapTexturePath, faceSize, mipLevels, VK_FORMAT_R8G8B8A8_SRGB, cacheKey);
+
+            if (hasCacheKey && loadCubemapFromCache(cacheKey)) {
+                return;
+            }
+
+            // A previous run may have fallen back to the CPU path, which stores a single mip
+            if (hasCacheKey && mipLevels != 1u)
+            {
+                CubemapCacheKey fallbackKey = cacheKey;
+                fallbackKey.mipLevels = 1u;
+                if (loadCubemapFromCache(fallbackKey)) {
+                    return;
+                }
+            }
+        }
+
         stbi_uc* pixels = stbi_load(_cubemapTexturePath, &width, &height, nullptr, STBI_rgb_alpha);
 
         if (!pixels) {
             MARK_ERROR(Utils::Category::Vulkan, "Failed to load cubemap texture image: %s  (Check File Path/Type Is Correct)", Utils::ShortPathForLog(_cubemapTexturePath).c_str());
         }
 
-        Bitmap source(width, height, 4, BitmapFormat_UnsignedByte, pixels);
-        std::vector<Bitmap> cubeMap;
-        int faceSize = convertEquirectangularImageToCubemap(source, cubeMap);
+        if (useGPU && generateCubemapTextureGPU(pixels, width, height, hasCacheKey ? &cacheKey : nullptr))
+        {
+            stbi_image_free(pixels);
+            return;
+        }
+
+        auto convertStart = std::chrono::steady_clock::now();
+        std::vector<uint8_t> faces;
+        int faceSize = convertEquirectangularImageToCubemap(pixels, width, height, faces);
+        double convertMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - convertStart).count();
+
+        MARK_DEBUG(Utils::Category::Vulkan, "Cubemap converted (%dx%d -> 6x%d) in %.2f ms", width, height, faceSize, convertMs);
+
+#if MARK_CUBEMAP_VALIDATE
+        validateCubemapConversion(pixels, width, height, faces, faceSize, convertMs);
+#endif
 
         stbi_image_free(pixels);
 
+        if (hasCacheKey)
+        {
+            cacheKey.mipLevels = 1;
+            VulkanCubemapCache::store(cacheKey, faces.data(), faces.size());
+        }
+
         VkFormat imageFormat = VK_FORMAT_R8G8B8A8_SRGB;
-        int bytesPerPixel = getBytesPerTexFormat(imageFormat);
-        size_t singleFaceNumBytes = faceSize * faceSize * bytesPerPixel;
-        size_t totalBytes = singleFaceNumBytes * CUBEMAP_NUM_FACES;
-        char* p = (char*)malloc(totalBytes);
+        createTextureImageFromData(faces.data(), faceSize, faceSize, imageFormat, true);
+    }
 
-        for (size_t i = 0; i < CUBEMAP_NUM_FACES; i++) {
-            memcpy(p + i * singleFaceNumBytes, cubeMap[i].m_data.data(), singleFaceNumBytes);
+    // One region per mip, all six faces in a single copy. Matches the cache payload layout
+    static void fillCubeMipCopyRegions(uint32_t _faceSize, uint32_t _mipLevels, uint32_t _bytesPerPixel, std::vector<VkBufferImageCopy>& _outRegions)
+    {
+        _outRegions.resize(_mipLevels);
+        for (uint32_t mip = 0; mip < _mipLevels; mip++)
+        {
+            const uint32_t mipSize = std::max(1u, _faceSize >> mip);
+            _outRegions[mip] = {
+                .bufferOffset = VulkanCubemapCache::mipOffset(_faceSize, mip, _bytesPerPixel),
+                .bufferRowLength = 0,
+                .bufferImageHeight = 0,
+                .imageSubresource = {
+                    .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+                    .mipLevel = mip,
+                    .baseArrayLayer = 0,
+                    .layerCount = CUBEMAP_NUM_FACES,
+                },
+                .imageOffset = { 0, 0, 0 },
+                .imageExtent = {
+                    .width = mipSize,
+                    .height = mipSize,
+                    .depth = 1,
+                }
+            };
+        }
+    }
+
+    bool TextureHandler::isCubemapComputeSupported()
+    {
+        VkFormatProperties formatProperties{};
+        vkGetPhysicalDeviceFormatProperties(m_vulkanCoreRef.lock()->physicalDevices().selected().m_device, VK_FORMAT_R8G8B8A8_UNORM, &formatProperties);
+        if (!(formatProperties.optimalTilingFeatures & VK_FORMAT_FEATURE_STORAGE_IMAGE_BIT)) {
+            MARK_WARN(Utils::Category::Vulkan, "Cubemap compute path unavailable (no storage image support for RGBA8), using CPU conversion");
+            return false;
         }
+        return true;
+    }
+
+    bool TextureHandler::generateCubemapTextureGPU(const uint8_t* _pixels, int _width, int _height, const CubemapCacheKey* _cacheKey)
+    {
+        auto VkCore = m_vulkanCoreRef.lock();
+        VkDevice device = VkCore->device();
+
+        // Faces are written through UNORM storage views and sampled through an sRGB view of the same image
+        const VkFormat storageFormat = VK_FORMAT_R8G8B8A8_UNORM;
+        const VkFormat sampledFormat = VK_FORMAT_R8G8B8A8_SRGB;
 
-        createTextureImageFromData(p, faceSize, faceSize, imageFormat, true);
+        auto gpuStart = std::chrono::steady_clock::now();
+
+        const int faceSize = _width / 4;
+        const uint32_t mipLevels = static_cast<uint32_t>(std::bit_width(static_cast<uint32_t>(faceSize)));
+
+        const std::filesystem::path equirectShaderPath = std::filesystem::path(MARK_CORE_ASSETS) / "EquirectToCubemap.comp";
+        const std::filesystem::path downsampleShaderPath = std::filesystem::path(MARK_CORE_ASSETS) / "CubemapDownsample.comp";
+
+        VulkanEquirectToCubemapCompute equirectPass;
+        equirectPass.initialize(m_vulkanCoreRef, "EquirectToCubemap", 1, equirectShaderPath.string().c_str());
+
+        VulkanCubemapDownsampleCompute downsamplePass;
+        const bool hasMipChain = mipLevels > 1;
+        if (hasMipChain) {
+            downsamplePass.initialize(m_vulkanCoreRef, "CubemapDownsample", mipLevels - 1, downsampleShaderPath.string().c_str());
+        }
+
+        if (!equirectPass.isValid() || (hasMipChain && !downsamplePass.isValid()))
+        {
+            equirectPass.destroyComputePipeline();
+            if (hasMipChain) downsamplePass.destroyComputePipeline();
+            MARK_WARN(Utils::Category::Vulkan, "Cubemap compute shaders failed to load, using CPU conversion");
+            return false;
+        }
+
+        // Equirect source lives only for the duration of the dispatch
+        TextureHandler source(m_vulkanCoreRef, m_commandBuffersRef);
+        source.createTextureImageFromData(_pixels, _width, _height, storageFormat);
+
+        // Read back for the disk cache, and for validation against the CPU conversion
+        const bool readBack = _cacheKey != nullptr || MARK_CUBEMAP_VALIDATE;
+
+        VkImageUsageFlags usage = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_STORAGE_BIT;
+        if (readBack) {
+            usage |= VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+        }
+        createImage(faceSize, faceSize, storageFormat, usage, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, true, mipLevels, VK_IMAGE_CREATE_MUTABLE_FORMAT_BIT);
+        // sRGB formats generally lack storage support, so the sampled view must not inherit the image's STORAGE usage
+        m_textureImageView = createImageView(sampledFormat, VK_IMAGE_ASPECT_COLOR_BIT, true, mipLevels, VK_IMAGE_USAGE_SAMPLED_BIT);
+        m_textureSampler = createTextureSampler(VK_FILTER_LINEAR, VK_FILTER_LINEAR, VK_SAMPLER_ADDRESS_MODE_REPEAT, static_cast<float>(mipLevels));
+
+        std::vector<VkImageView> mipViews(mipLevels);
+        for (uint32_t mip = 0; mip < mipLevels; mip++) {
+            mipViews[mip] = createCubeMipStorageView(storageFormat, mip);
+        }
+
+        std::vector<VkDescriptorSet> equirectSets;
+        equirectPass.allocateDescriptorSets(1, equirectSets);
+        equirectPass.writeDescriptorSet(equirectSets[0], source.sampler(), source.imageView(), mipViews[0]);
+
+        std::vector<VkDescriptorSet> downsampleSets;
+        if (hasMipChain)
+        {
+            downsamplePass.allocateDescriptorSets(mipLevels - 1, downsampleSets);
+            for (uint32_t mip = 1; mip < mipLevels; mip++) {
+                downsamplePass.writeDescriptorSet(downsampleSets[mip - 1], mipViews[mip - 1], mipViews[mip]);
+            }
+        }
+
+        // Record every pass into one submission
+        VkCommandBuffer cmd = m_commandBuffersRef->copyCommandBuffer();
+        m_commandBuffersRef->beginCommandBuffer(cmd, VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT);
+
+        recordImageBarrier(cmd, m_textureImage, 0, mipLevels, CUBEMAP_NUM_FACES,
+            VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_GENERAL,
+            0, VK_ACCESS_SHADER_WRITE_BIT,
+            VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT);
+
+        uint32_t groups = (static_cast<uint32_t>(faceSize) + CUBEMAP_COMPUTE_GROUP_SIZE - 1) / CUBEMAP_COMPUTE_GROUP_SIZE;
+        equirectPass.recordCommandBuffer(equirectSets[0], cmd, groups, groups, CUBEMAP_NUM_FACES);
+
+        for (uint32_t mip = 1; mip < mipLevels; mip++)
+        {
+            // Previous mip must be fully written before it is read
+            recordImageBarrier(cmd, m_textureImage, mip - 1, 1, CUBEMAP_NUM_FACES,
+                VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_GENERAL,
+                VK_ACCESS_SHADER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT,
+                VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT);
+
+            const uint32_t mipSize = std::max(1u, static_cast<uint32_t>(faceSize) >> mip);
+            groups = (mipSize + CUBEMAP_COMPUTE_GROUP_SIZE - 1) / CUBEMAP_COMPUTE_GROUP_SIZE;
+            downsamplePass.recordCommandBuffer(downsampleSets[mip - 1], cmd, groups, groups, CUBEMAP_NUM_FACES);
+        }
+
+        // Optional readback of every face and mip so the next launch can skip generation
+        BufferAndMemory readback;
+        const uint32_t bytesPerPixel = static_cast<uint32_t>(getBytesPerTexFormat(storageFormat));
+        const uint64_t readbackSize = VulkanCubemapCache::payloadSize(static_cast<uint32_t>(faceSize), mipLevels, bytesPerPixel);
+        if (readBack)
+        {
+            readback = BufferAndMemory(VkCore, readbackSize, VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, "TextureHandler.CubemapReadback");
+
+            recordImageBarrier(cmd, m_textureImage, 0, mipLevels, CUBEMAP_NUM_FACES,
+                VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_SHADER_READ_BIT, VK_ACCESS_TRANSFER_READ_BIT,
+                VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT);
+
+            std::vector<VkBufferImageCopy> regions;
+            fillCubeMipCopyRegions(static_cast<uint32_t>(faceSize), mipLevels, bytesPerPixel, regions);
+            vkCmdCopyImageToBuffer(cmd, m_textureImage, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, readback.m_buffer,
+                static_cast<uint32_t>(regions.size()), regions.data());
+
+            recordImageBarrier(cmd, m_textureImage, 0, mipLevels, CUBEMAP_NUM_FACES,
+                VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+                VK_ACCESS_TRANSFER_READ_BIT, VK_ACCESS_SHADER_READ_BIT,
+                VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT);
+        }
+        else
+        {
+            recordImageBarrier(cmd, m_textureImage, 0, mipLevels, CUBEMAP_NUM_FACES,
+                VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+                VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_SHADER_READ_BIT, VK_ACCESS_SHADER_READ_BIT,
+                VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT);
+        }
+
+        submitCopyCommand();
+        double gpuMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - gpuStart).count();
+
+        if (readBack)
+        {
+            const uint8_t* mapped = static_cast<const uint8_t*>(readback.map(device));
+            if (_cacheKey) {
+                VulkanCubemapCache::store(*_cacheKey, mapped, readbackSize);
+            }
+#if MARK_CUBEMAP_VALIDATE
+            // Mip 0 leads the payload, all six faces back to back like the CPU conversion's output
+            validateCubemapGPU(_pixels, _width, _height, mapped + VulkanCubemapCache::mipOffset(static_cast<uint32_t>(faceSize), 0, bytesPerPixel), faceSize, gpuMs);
+#endif
+            readback.unmap(device);
+            readback.destroy(device);
+        }
+
+        // Transient resources
+        for (VkImageView view : mipViews) {
+            vkDestroyImageView(device, view, nullptr);
+        }
+        equirectPass.destroyComputePipeline();
+        if (hasMipChain) downsamplePass.destroyComputePipeline();
+        source.destroyTextureHandler(device);
 
-        free(p);
+        MARK_DEBUG(Utils::Category::Vulkan, "Cubemap generated on GPU (%dx%d -> 6x%d, %u mips) in %.2f ms", _width, _height, faceSize, mipLevels, gpuMs);
+
+        return true;
+    }
+
+    bool TextureHandler::loadCubemapFromCache(const CubemapCacheKey& _key)
+    {
+        std::ifstream file;
+        uint64_t payloadSize = 0;
+        if (!VulkanCubemapCache::openForRead(_key, file, payloadSize)) {
+            return false;
+        }
+
+        const uint32_t bytesPerPixel = static_cast<uint32_t>(getBytesPerTexFormat(_key.format));
+        if (payloadSize != VulkanCubemapCache::payloadSize(_key.faceSize, _key.mipLevels, bytesPerPixel)) {
+            MARK_WARN(Utils::Category::Vulkan, "Cubemap cache payload size mismatch, regenerating");
+            return false;
+        }
+
+        auto loadStart = std::chrono::steady_clock::now();
+
+        auto VkCore = m_vulkanCoreRef.lock();
+        VkDevice device = VkCore->device();
+
+        // One read straight into the mapped staging buffer, no intermediate copy
+        BufferAndMemory staging(VkCore, payloadSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, "TextureHandler.CubemapCacheStaging");
+
+        void* mapped = staging.map(device);
+        file.read(static_cast<char*>(mapped), static_cast<std::streamsize>(payloadSize));
+        const bool readOk = static_cast<uint64_t>(file.gcount()) == payloadSize;
+        staging.unmap(device);
+
+        if (!readOk)
+        {
+            MARK_WARN(Utils::Category::Vulkan, "Cubemap cache read was short, regenerating");
+            staging.destroy(device);
+            return false;
+        }
+
+        const int faceSize = static_cast<int>(_key.faceSize);
+        createImage(faceSize, faceSize, _key.format, VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT,
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, true, _key.mipLevels);
+        m_textureImageView = createImageView(_key.format, VK_IMAGE_ASPECT_COLOR_BIT, true, _key.mipLevels);
+        m_textureSampler = createTextureSampler(VK_FILTER_LINEAR, VK_FILTER_LINEAR, VK_SAMPLER_ADDRESS_MODE_REPEAT, static_cast<float>(_key.mipLevels));
+
+        VkCommandBuffer cmd = m_commandBuffersRef->copyCommandBuffer();
+        m_commandBuffersRef->beginCommandBuffer(cmd, VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT);
+
+        recordImageBarrier(cmd, m_textureImage, 0, _key.mipLevels, CUBEMAP_NUM_FACES,
+            VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+            0, VK_ACCESS_TRANSFER_WRITE_BIT,
+            VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT);
+
+        std::vector<VkBufferImageCopy> regions;
+        fillCubeMipCopyRegions(_key.faceSize, _key.mipLevels, bytesPerPixel, regions);
+        vkCmdCopyBufferToImage(cmd, staging.m_buffer, m_textureImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+            static_cast<uint32_t>(regions.size()), regions.data());
+
+        recordImageBarrier(cmd, m_textureImage, 0, _key.mipLevels, CUBEMAP_NUM_FACES,
+            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+            VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT,
+            VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT);
+
+        submitCopyCommand();
+        staging.destroy(device);
+
+        double loadMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - loadStart).count();
+        MARK_INFO(Utils::Category::Vulkan, "Cubemap loaded from cache (6x%u, %u mips, %.1f KB) in %.2f ms",
+            _key.faceSize, _key.mipLevels, payloadSize / 1024.0, loadMs);
+
+        return true;
+    }
+
+    VkImageView TextureHandler::createCubeMipStorageView(VkFormat _format, uint32_t _mipLevel)
+    {
+        // Storage only, the downsample pass reads the previous mip through its storage view as well
+        VkImageViewUsageCreateInfo usageInfo{
+            .sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_USAGE_CREATE_INFO,
+            .pNext = nullptr,
+            .usage = VK_IMAGE_USAGE_STORAGE_BIT
+        };
+        VkImageViewCreateInfo viewInfo{
+            .sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
+            .pNext = &usageInfo,
+            .flags = 0,
+            .image = m_textureImage,
+            .viewType = VK_IMAGE_VIEW_TYPE_2D_ARRAY,
+            .format = _format,
+            .components = {
+                .r = VK_COMPONENT_SWIZZLE_IDENTITY,
+                .g = VK_COMPONENT_SWIZZLE_IDENTITY,
+                .b = VK_COMPONENT_SWIZZLE_IDENTITY,
+                .a = VK_COMPONENT_SWIZZLE_IDENTITY,
+            },
+            .subresourceRange = {
+                .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+                .baseMipLevel = _mipLevel,
+                .levelCount = 1,
+                .baseArrayLayer = 0,
+                .layerCount = CUBEMAP_NUM_FACES,
+            }
+        };
+
+        VkImageView imageView;
+        VkResult res = vkCreateImageView(m_vulkanCoreRef.lock()->device(), &viewInfo, nullptr, &imageView);
+        CHECK_VK_RESULT(res, "Failed to create cubemap mip storage view!");
+
+        return imageView;
+    }
+
+    int TextureHandler::convertEquirectangularImageToCubemap(const uint8_t* _pixels, int _width, int _height, std::vector<uint8_t>& _faces)
+    {
+        const int faceSize = _width / 4;
+        const size_t faceBytes = size_t(faceSize) * faceSize * BitmapViewRGBA8::c_pixelBytes;
+        _faces.resize(faceBytes * CUBEMAP_NUM_FACES);
+
+        // Decoder output is wrapped in place, faces are views into the one output buffer
+        const ConstBitmapViewRGBA8 source(_pixels, _width, _height);
+        BitmapViewRGBA8 faceViews[CUBEMAP_NUM_FACES];
+        for (int face = 0; face < CUBEMAP_NUM_FACES; face++) {
+            faceViews[face] = BitmapViewRGBA8(_faces.data() + face * faceBytes, faceSize, faceSize);
+        }
+
+        // Every row of every face is independent, hand them out in small chunks
+        const size_t totalRows = size_t(faceSize) * CUBEMAP_NUM_FACES;
+        Utils::parallelFor(totalRows, CUBEMAP_ROWS_PER_TASK, [&](size_t _row)
+        {
+            const int face = int(_row) / faceSize;
+            convertCubemapRow(source, faceViews[face], face, int(_row) % faceSize);
+        });
+
+        return faceSize;
+    }
+
+    void TextureHandler::validateCubemapConversion(const uint8_t* _pixels, int _width, int _height, const std::vector<uint8_t>& _faces, int _faceSize, double _fastMs)
+    {
+        Bitmap source(_width, _height, CUBEMAP_CHANNELS, BitmapFormat_UnsignedByte, const_cast<uint8_t*>(_pixels));
+        std::vector<Bitmap> reference;
+
+        auto referenceStart = std::chrono::steady_clock::now();
+        int referenceFaceSize = convertEquirectangularImageToCubemapReference(source, reference);
+        double referenceMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - referenceStart).count();
+
+        if (referenceFaceSize != _faceSize) {
+            MARK_ERROR(Utils::Category::Vulkan, "Cubemap validation: face size mismatch (fast %d, reference %d)", _faceSize, referenceFaceSize);
+            return;
+        }
+
+        const size_t faceBytes = size_t(_faceSize) * _faceSize * CUBEMAP_CHANNELS;
+        CubemapChannelError error;
+        for (int face = 0; face < CUBEMAP_NUM_FACES; face++) {
+            error.accumulate(_faces.data() + face * faceBytes, reference[face].m_data.data(), faceBytes, CUBEMAP_MAX_CHANNEL_ERROR);
+        }
+
+        MARK_INFO(Utils::Category::Vulkan, "Cubemap validation: fast %.2f ms, reference %.2f ms (x%.1f), max channel error %d, mean %.4f",
+            _fastMs, referenceMs, _fastMs > 0.0 ? referenceMs / _fastMs : 0.0, error.m_max, error.mean());
+
+        if (error.m_overTolerance > 0) {
+            MARK_WARN(Utils::Category::Vulkan, "Cubemap validation: %zu channels exceed the error bound of %d", error.m_overTolerance, CUBEMAP_MAX_CHANNEL_ERROR);
+        }
+    }
+
+    void TextureHandler::validateCubemapGPU(const uint8_t* _pixels, int _width, int _height, const uint8_t* _gpuFaces, int _faceSize, double _gpuMs)
+    {
+        auto cpuStart = std::chrono::steady_clock::now();
+        std::vector<uint8_t> cpuFaces;
+        const int cpuFaceSize = convertEquirectangularImageToCubemap(_pixels, _width, _height, cpuFaces);
+        double cpuMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - cpuStart).count();
+
+        if (cpuFaceSize != _faceSize) {
+            MARK_ERROR(Utils::Category::Vulkan, "Cubemap GPU validation: face size mismatch (GPU %d, CPU %d)", _faceSize, cpuFaceSize);
+            return;
+        }
+
+        CubemapChannelError error;
+        error.accumulate(_gpuFaces, cpuFaces.data(), cpuFaces.size(), CUBEMAP_MAX_GPU_CHANNEL_ERROR);
+
+        MARK_INFO(Utils::Category::Vulkan, "Cubemap GPU validation: GPU %.2f ms, CPU %.2f ms, mip 0 max channel error %d, mean %.4f",
+            _gpuMs, cpuMs, error.m_max, error.mean());
+
+        if (error.m_overTolerance > 0) {
+            MARK_WARN(Utils::Category::Vulkan, "Cubemap GPU validation: %zu channels exceed the error bound of %d", error.m_overTolerance, CUBEMAP_MAX_GPU_CHANNEL_ERROR);
+        }
     }
 
-    int TextureHandler::convertEquirectangularImageToCubemap(const Bitmap& _source, std::vector<Bitmap>& _cubeMap)
+    int TextureHandler::convertEquirectangularImageToCubemapReference(const Bitmap& _source, std::vector<Bitmap>& _cubeMap)
     {
         int FaceSize = _source.m_width / 4;
 
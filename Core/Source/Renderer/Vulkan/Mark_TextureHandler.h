@@ -1,9 +1,19 @@
 #pragma once
+#include "Mark_CubemapCache.h"
 #include "Engine/Bitmap.h"
 
 #include <Volk/volk.h>
 #include <glm/glm.hpp>
 #include <memory>
+#include <vector>
+
+// Set to 1 to time MARK_TEXTURE_LOAD_BENCHMARK_COUNT texture loads through both load paths at startup
+#ifndef MARK_TEXTURE_LOAD_BENCHMARK
+    #define MARK_TEXTURE_LOAD_BENCHMARK 0
+#endif
+#ifndef MARK_TEXTURE_LOAD_BENCHMARK_COUNT
+    #define MARK_TEXTURE_LOAD_BENCHMARK_COUNT 200
+#endif
 
 namespace Mark::RendererVK
 {
@@ -16,6 +26,13 @@ namespace Mark::RendererVK
         void destroyTextureHandler(VkDevice _device);
 
         void generateTexture(const char* _texturePath);
+
+        // Decodes every texture on worker threads straight into one mapped staging buffer, then uploads the batch in a single submission
+        // Entries that fail to decode go through generateTexture so they still get the fallback texture
+        static void generateTextures(const std::vector<TextureHandler*>& _textures, const std::vector<const char*>& _texturePaths);
+
+        // Loads _count copies of a texture through generateTexture and generateTextures and logs both timings
+        static void benchmarkTextureLoading(std::weak_ptr<VulkanCore> _vulkanCoreRef, VulkanCommandBuffers* _commandBuffersRef, const char* _texturePath, uint32_t _count);
         void generateCubemapTexture(const char* _cubemapTexturePath);
 
         VkSampler sampler() const { return m_textureSampler; }
@@ -33,9 +50,11 @@ namespace Mark::RendererVK
         VkDeviceMemory m_textureMemory{ VK_NULL_HANDLE };
         VkImageView m_textureImageView{ VK_NULL_HANDLE };
         VkSampler m_textureSampler{ VK_NULL_HANDLE };
+        uint32_t m_mipLevels{ 1 };
 
         void createTextureImageFromData(const void* _pixels, int _width, int _height, VkFormat _format, bool _isCubemap = false);
-        void createImage(int _width, int _height, VkFormat _format, VkImageUsageFlags _usage, VkMemoryPropertyFlagBits _properties, bool _isCubemap = false);
+        void createTextureResources(int _width, int _height, VkFormat _format, bool _isCubemap = false);
+        void createImage(int _width, int _height, VkFormat _format, VkImageUsageFlags _usage, VkMemoryPropertyFlagBits _properties, bool _isCubemap = false, uint32_t _mipLevels = 1, VkImageCreateFlags _extraFlags = 0);
         void updateTextureImage(const void* _pixels, int _width, int _height, VkFormat _format, bool _isCubemap = false);
         
         uint32_t getMemoryTypeIndex(uint32_t _typeFilter, VkMemoryPropertyFlagBits _properties);
@@ -43,14 +62,35 @@ namespace Mark::RendererVK
 
         void transitionImageLayout(VkImage& _image, VkFormat _format, VkImageLayout _oldLayout, VkImageLayout _newLayout, int _layerCount);
         static bool hasStencilComponent(VkFormat _format);
-        void copyBufferToImage(VkBuffer _buffer, VkImage _image, uint32_t _width, uint32_t _height, VkDeviceSize _layerSize, int _layerCount);
+        void recordCopyBufferToImage(VkCommandBuffer _cmd, VkBuffer _buffer, VkDeviceSize _bufferOffset, VkImage _image, uint32_t _width, uint32_t _height, VkDeviceSize _layerSize, int _layerCount);
+        // Records UNDEFINED -> copy -> SHADER_READ_ONLY for mip 0 of this texture
+        void recordUpload(VkCommandBuffer _cmd, VkBuffer _buffer, VkDeviceSize _bufferOffset, uint32_t _width, uint32_t _height, VkDeviceSize _layerSize, int _layerCount);
         void submitCopyCommand();
 
-        VkImageView createImageView(VkFormat _format, VkImageAspectFlags _aspectFlags, bool _isCubemap = false);
-        VkSampler createTextureSampler(VkFilter _minFilter, VkFilter _maxFilter, VkSamplerAddressMode _adressMode);
+        // _viewUsage narrows the view to a subset of the image usage, 0 inherits it. Needed when a view format can't do
+        // everything the image was created for (an sRGB view of a MUTABLE_FORMAT image with storage usage)
+        VkImageView createImageView(VkFormat _format, VkImageAspectFlags _aspectFlags, bool _isCubemap = false, uint32_t _mipLevels = 1, VkImageUsageFlags _viewUsage = 0);
+        VkSampler createTextureSampler(VkFilter _minFilter, VkFilter _maxFilter, VkSamplerAddressMode _adressMode, float _maxLod = 0.0f);
         
         // Cubemap generation
-        int convertEquirectangularImageToCubemap(const Bitmap& _source, std::vector<Bitmap>& _cubeMap);
+        // Compute path: uploads the equirect image and writes all faces + mips on the GPU. Returns false if unavailable
+        // When a cache key is given the result is read back and stored on disk. With MARK_CUBEMAP_VALIDATE mip 0 is
+        // always read back and compared against the CPU conversion before returning
+        bool generateCubemapTextureGPU(const uint8_t* _pixels, int _width, int _height, const CubemapCacheKey* _cacheKey = nullptr);
+        bool isCubemapComputeSupported();
+        VkImageView createCubeMipStorageView(VkFormat _format, uint32_t _mipLevel);
+
+        // Reads a processed cubemap straight into mapped staging memory and uploads every face and mip
+        bool loadCubemapFromCache(const CubemapCacheKey& _key);
+
+        // Writes all six RGBA8 faces into one contiguous buffer (face-major), returns the face size
+        int convertEquirectangularImageToCubemap(const uint8_t* _pixels, int _width, int _height, std::vector<uint8_t>& _faces);
+
+        // Original per-pixel conversion, kept as the reference for validating the fast path
+        int convertEquirectangularImageToCubemapReference(const Bitmap& _source, std::vector<Bitmap>& _cubeMap);
+        void validateCubemapConversion(const uint8_t* _pixels, int _width, int _height, const std::vector<uint8_t>& _faces, int _faceSize, double _fastMs);
+        // _gpuFaces is the compute path's mip 0, six faces back to back
+        void validateCubemapGPU(const uint8_t* _pixels, int _width, int _height, const uint8_t* _gpuFaces, int _faceSize, double _gpuMs);
         glm::vec3 faceCoordsToXYZ(int _x, int _y, int _faceID, int _faceSize);
     };
 } // namespace Mark::RendererVK
\ No newline at end of file
@@ -25,7 +25,7 @@ namespace Mark::RendererVK
         const VkDevice device = vkCore->device();
         const VkDeviceSize dataSize = sizeof(UniformData);
 
-        VkBufferUsageFlags usage = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT;
+        VkBufferUsageFlags usage = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | vkCore->descriptorResourceUsage();
         VkMemoryPropertyFlags properties = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
         
         for (uint32_t i = 0; i < _numImages; i++)
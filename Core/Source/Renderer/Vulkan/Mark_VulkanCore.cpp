@@ -1,6 +1,7 @@
 #include <Mark/Engine.h>
 #include "Mark_VulkanCore.h"
 #include "Mark_VertexBuffer.h"
+#include "Mark_DescriptorBuffer.h"
 #include "Mark_WindowToVulkanHandler.h"
 
 #include "Core.h"
@@ -62,6 +63,11 @@ namespace Mark::RendererVK
     {
         if (m_device != VK_NULL_HANDLE)
         {
+            // Background pipeline compiles still reference shader modules
+            if (m_graphicsPipelineCache) {
+                m_graphicsPipelineCache->waitForPending();
+            }
+            m_pipelineManifest.destroy();
             if (m_shaderCache)
             {
                 m_shaderCache->destroy();
@@ -72,6 +78,7 @@ namespace Mark::RendererVK
                 m_graphicsPipelineCache->destroyAll();
                 m_graphicsPipelineCache.reset();
             }
+            m_pipelineDiskCache.destroy();
             if (m_vertexUploader) 
             {
                 m_vertexUploader->destroy();
@@ -346,15 +353,141 @@ namespace Mark::RendererVK
             MARK_FATAL(Utils::Category::Vulkan, "Selected GPU does not support draw indirect count, which is required for Mark");
         }
 
+        // Extended dynamic state: depth/cull are core in 1.3, blend state needs _state3
+        VkPhysicalDeviceExtendedDynamicState3FeaturesEXT eds3Supported = {
+            .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_EXTENDED_DYNAMIC_STATE_3_FEATURES_EXT
+        };
+        const bool hasEds3Extension = selectedPhysical.isExtensionSupported(VK_EXT_EXTENDED_DYNAMIC_STATE_3_EXTENSION_NAME);
+        if (hasEds3Extension)
+        {
+            VkPhysicalDeviceFeatures2 features2 = {
+                .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2,
+                .pNext = &eds3Supported
+            };
+            vkGetPhysicalDeviceFeatures2(selectedPhysical.m_device, &features2);
+        }
+
+        m_dynamicStateCaps.depthAndCull = deviceIsVulkan13OrHigher;
+        m_dynamicStateCaps.blend = hasEds3Extension &&
+            eds3Supported.extendedDynamicState3ColorBlendEnable &&
+            eds3Supported.extendedDynamicState3ColorBlendEquation &&
+            eds3Supported.extendedDynamicState3ColorWriteMask;
+
+        if (m_dynamicStateCaps.blend) {
+            deviceExtensions.push_back(VK_EXT_EXTENDED_DYNAMIC_STATE_3_EXTENSION_NAME);
+        }
+
+        MARK_INFO(Utils::Category::Vulkan, "Extended dynamic state: depth/cull=%s, blend=%s",
+            m_dynamicStateCaps.depthAndCull ? "yes" : "no", m_dynamicStateCaps.blend ? "yes" : "no (baked into pipelines)");
+
+        // Graphics pipeline library: pipelines are linked from separately cached parts, monolithic when missing
+        VkPhysicalDeviceGraphicsPipelineLibraryFeaturesEXT gplSupported = {
+            .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_GRAPHICS_PIPELINE_LIBRARY_FEATURES_EXT
+        };
+        VkPhysicalDeviceGraphicsPipelineLibraryPropertiesEXT gplProperties = {
+            .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_GRAPHICS_PIPELINE_LIBRARY_PROPERTIES_EXT
+        };
+        const bool hasGplExtensions = MARK_PIPELINE_LIBRARY &&
+            selectedPhysical.isExtensionSupported(VK_KHR_PIPELINE_LIBRARY_EXTENSION_NAME) &&
+            selectedPhysical.isExtensionSupported(VK_EXT_GRAPHICS_PIPELINE_LIBRARY_EXTENSION_NAME);
+        if (hasGplExtensions)
+        {
+            VkPhysicalDeviceFeatures2 features2 = {
+                .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2,
+                .pNext = &gplSupported
+            };
+            vkGetPhysicalDeviceFeatures2(selectedPhysical.m_device, &features2);
+
+            VkPhysicalDeviceProperties2 properties2 = {
+                .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2,
+                .pNext = &gplProperties
+            };
+            vkGetPhysicalDeviceProperties2(selectedPhysical.m_device, &properties2);
+        }
+
+        m_pipelineLibrarySupported = hasGplExtensions && gplSupported.graphicsPipelineLibrary;
+        m_pipelineLibraryFastLinking = m_pipelineLibrarySupported && gplProperties.graphicsPipelineLibraryFastLinking;
+        if (m_pipelineLibrarySupported) {
+            deviceExtensions.push_back(VK_KHR_PIPELINE_LIBRARY_EXTENSION_NAME);
+            deviceExtensions.push_back(VK_EXT_GRAPHICS_PIPELINE_LIBRARY_EXTENSION_NAME);
+        }
+
+        MARK_INFO(Utils::Category::Vulkan, "Graphics pipeline library: %s",
+            m_pipelineLibrarySupported ? (m_pipelineLibraryFastLinking ? "yes (fast linking)" : "yes") : "no (monolithic pipelines)");
+
+        // Update-after-bind lets the single bindless set take new mesh slots while frames are in flight
+        VkPhysicalDeviceVulkan12Features v12Supported = {
+            .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES
+        };
+        VkPhysicalDeviceVulkan12Properties v12Properties = {
+            .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_PROPERTIES
+        };
+        {
+            VkPhysicalDeviceFeatures2 features2 = {
+                .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2,
+                .pNext = &v12Supported
+            };
+            vkGetPhysicalDeviceFeatures2(selectedPhysical.m_device, &features2);
+
+            VkPhysicalDeviceProperties2 properties2 = {
+                .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2,
+                .pNext = &v12Properties
+            };
+            vkGetPhysicalDeviceProperties2(selectedPhysical.m_device, &properties2);
+        }
+        REQ_FEATURE(v12Supported, descriptorBindingSampledImageUpdateAfterBind);
+        REQ_FEATURE(v12Supported, descriptorBindingStorageBufferUpdateAfterBind);
+        REQ_FEATURE(v12Supported, descriptorBindingUpdateUnusedWhilePending);
+
+        // Descriptor buffer: bindless descriptors are written straight into buffer memory, pools/sets when missing
+        VkPhysicalDeviceDescriptorBufferFeaturesEXT descriptorBufferSupported = {
+            .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_BUFFER_FEATURES_EXT
+        };
+        VkPhysicalDeviceDescriptorBufferPropertiesEXT descriptorBufferProperties = {
+            .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_BUFFER_PROPERTIES_EXT
+        };
+        const bool hasDescriptorBufferExtension = MARK_DESCRIPTOR_BUFFER &&
+            selectedPhysical.isExtensionSupported(VK_EXT_DESCRIPTOR_BUFFER_EXTENSION_NAME);
+        if (hasDescriptorBufferExtension)
+        {
+            VkPhysicalDeviceFeatures2 features2 = {
+                .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2,
+                .pNext = &descriptorBufferSupported
+            };
+            vkGetPhysicalDeviceFeatures2(selectedPhysical.m_device, &features2);
+
+            VkPhysicalDeviceProperties2 properties2 = {
+                .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2,
+                .pNext = &descriptorBufferProperties
+            };
+            vkGetPhysicalDeviceProperties2(selectedPhysical.m_device, &properties2);
+        }
+
+        // Devices that split combined image sampler arrays into image + sampler halves keep the pool path
+        m_descriptorBufferCaps.enabled = hasDescriptorBufferExtension &&
+            descriptorBufferSupported.descriptorBuffer &&
+            v12Supported.bufferDeviceAddress &&
+            descriptorBufferProperties.combinedImageSamplerDescriptorSingleArray;
+        if (m_descriptorBufferCaps.enabled) {
+            m_descriptorBufferCaps.offsetAlignment = descriptorBufferProperties.descriptorBufferOffsetAlignment;
+            m_descriptorBufferCaps.uniformBufferDescriptorSize = descriptorBufferProperties.uniformBufferDescriptorSize;
+            m_descriptorBufferCaps.storageBufferDescriptorSize = descriptorBufferProperties.storageBufferDescriptorSize;
+            m_descriptorBufferCaps.combinedImageSamplerDescriptorSize = descriptorBufferProperties.combinedImageSamplerDescriptorSize;
+            deviceExtensions.push_back(VK_EXT_DESCRIPTOR_BUFFER_EXTENSION_NAME);
+        }
+
+        MARK_INFO(Utils::Category::Vulkan, "Descriptor buffer: %s",
+            m_descriptorBufferCaps.enabled ? "yes" : "no (descriptor pools/sets)");
+
         // --- Decide caps ---
         const VkPhysicalDeviceLimits& limits = selectedPhysical.m_properties.limits;
 
         // Indirect multi-draw upper bound
         m_bindlessCaps.maxDrawIndirectCount = limits.maxDrawIndirectCount;
 
-        // Meshes: each mesh requires 2 storage buffer descriptors (vertex + index)
-        const uint32_t maxMeshesFromSet = limits.maxDescriptorSetStorageBuffers / 2u;
-        const uint32_t maxMeshesFromStage = limits.maxPerStageDescriptorStorageBuffers / 2u;
+        // Meshes: each mesh requires 2 storage buffer descriptors (vertex + index), bound under the update-after-bind limits
+        const uint32_t maxMeshesFromSet = std::min(limits.maxDescriptorSetStorageBuffers, v12Properties.maxDescriptorSetUpdateAfterBindStorageBuffers) / 2u;
+        const uint32_t maxMeshesFromStage = std::min(limits.maxPerStageDescriptorStorageBuffers, v12Properties.maxPerStageDescriptorUpdateAfterBindStorageBuffers) / 2u;
         const uint32_t maxMeshesHard = std::min(maxMeshesFromSet, maxMeshesFromStage);
         const uint32_t requestedMaxMeshes = 4096u;
         m_bindlessCaps.maxMeshes = std::min(requestedMaxMeshes, maxMeshesHard);
@@ -363,8 +496,10 @@ namespace Mark::RendererVK
         }
 
         // Textures: combined image sampler counts against both sampler + sampled-image limits.
-        const uint32_t maxCombinedSet = std::min(limits.maxDescriptorSetSamplers, limits.maxDescriptorSetSampledImages);
-        const uint32_t maxCombinedStage = std::min(limits.maxPerStageDescriptorSamplers, limits.maxPerStageDescriptorSampledImages);
+        const uint32_t maxCombinedSet = std::min({ limits.maxDescriptorSetSamplers, limits.maxDescriptorSetSampledImages,
+            v12Properties.maxDescriptorSetUpdateAfterBindSamplers, v12Properties.maxDescriptorSetUpdateAfterBindSampledImages });
+        const uint32_t maxCombinedStage = std::min({ limits.maxPerStageDescriptorSamplers, limits.maxPerStageDescriptorSampledImages,
+            v12Properties.maxPerStageDescriptorUpdateAfterBindSamplers, v12Properties.maxPerStageDescriptorUpdateAfterBindSampledImages });
         const uint32_t maxTexturesHard = std::min(maxCombinedSet, maxCombinedStage);
         const uint32_t requestedMaxTextures = m_bindlessCaps.maxMeshes * m_bindlessCaps.numAttachableTextures;
         m_bindlessCaps.maxTextureDescriptors = std::min(requestedMaxTextures, maxTexturesHard);
@@ -383,14 +518,50 @@ namespace Mark::RendererVK
             .drawIndirectCount = VK_TRUE,
             .shaderSampledImageArrayNonUniformIndexing = VK_TRUE,
             .shaderStorageBufferArrayNonUniformIndexing = VK_TRUE,
+            .descriptorBindingSampledImageUpdateAfterBind = VK_TRUE,
+            .descriptorBindingStorageBufferUpdateAfterBind = VK_TRUE,
+            .descriptorBindingUpdateUnusedWhilePending = VK_TRUE,
             .descriptorBindingPartiallyBound = VK_TRUE,
             .descriptorBindingVariableDescriptorCount = VK_TRUE,
-            .runtimeDescriptorArray = VK_TRUE
+            .runtimeDescriptorArray = VK_TRUE,
+            .bufferDeviceAddress = m_descriptorBufferCaps.enabled ? VK_TRUE : VK_FALSE
         };
 
+        // Optional feature structs are pushed onto the front of the chain when supported
+        void* optionalFeatures = &v12;
+
+        VkPhysicalDeviceExtendedDynamicState3FeaturesEXT eds3 = {
+            .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_EXTENDED_DYNAMIC_STATE_3_FEATURES_EXT,
+            .extendedDynamicState3ColorBlendEnable = VK_TRUE,
+            .extendedDynamicState3ColorBlendEquation = VK_TRUE,
+            .extendedDynamicState3ColorWriteMask = VK_TRUE
+        };
+        if (m_dynamicStateCaps.blend) {
+            eds3.pNext = optionalFeatures;
+            optionalFeatures = &eds3;
+        }
+
+        VkPhysicalDeviceGraphicsPipelineLibraryFeaturesEXT gpl = {
+            .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_GRAPHICS_PIPELINE_LIBRARY_FEATURES_EXT,
+            .graphicsPipelineLibrary = VK_TRUE
+        };
+        if (m_pipelineLibrarySupported) {
+            gpl.pNext = optionalFeatures;
+            optionalFeatures = &gpl;
+        }
+
+        VkPhysicalDeviceDescriptorBufferFeaturesEXT descriptorBuffer = {
+            .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_BUFFER_FEATURES_EXT,
+            .descriptorBuffer = VK_TRUE
+        };
+        if (m_descriptorBufferCaps.enabled) {
+            descriptorBuffer.pNext = optionalFeatures;
+            optionalFeatures = &descriptorBuffer;
+        }
+
         VkPhysicalDeviceVulkan13Features v13 = {
             .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_3_FEATURES,
-            .pNext = &v12,
+            .pNext = optionalFeatures,
             .synchronization2 = VK_TRUE,
             .dynamicRendering = VK_TRUE
         };
@@ -400,11 +571,19 @@ namespace Mark::RendererVK
         REQ_FEATURE(selectedPhysical.m_features, tessellationShader);
         REQ_FEATURE(selectedPhysical.m_features, multiDrawIndirect);
         REQ_FEATURE(selectedPhysical.m_features, drawIndirectFirstInstance);
+        REQ_FEATURE(selectedPhysical.m_features, shaderUniformBufferArrayDynamicIndexing);
+
+        // Optional, only used for the per-frame fragment invocation counter
+        m_pipelineStatisticsSupported = selectedPhysical.m_features.pipelineStatisticsQuery == VK_TRUE;
+        MARK_INFO(Utils::Category::Vulkan, "Pipeline statistics queries: %s", m_pipelineStatisticsSupported ? "yes" : "no (fragment counter disabled)");
+
         VkPhysicalDeviceFeatures deviceFeatures = { 
             .geometryShader = VK_TRUE,
             .tessellationShader = VK_TRUE,
             .multiDrawIndirect = VK_TRUE,
-            .drawIndirectFirstInstance = VK_TRUE
+            .drawIndirectFirstInstance = VK_TRUE,
+            .pipelineStatisticsQuery = m_pipelineStatisticsSupported ? VK_TRUE : VK_FALSE,
+            .shaderUniformBufferArrayDynamicIndexing = VK_TRUE
         };
 
         VkDeviceCreateInfo deviceCreateInfo = {
@@ -447,8 +626,19 @@ namespace Mark::RendererVK
 
     void VulkanCore::createCaches()
     {
+        m_pipelineDiskCache.create(m_device, m_physicalDevices.selected().m_properties);
         m_shaderCache = std::make_unique<VulkanShaderCache>(m_device);
-        m_graphicsPipelineCache = std::make_unique<VulkanGraphicsPipelineCache>(m_device);
+        // Compile every uncached shader across threads up front, later loads are cache hits
+        m_shaderCache->precompileDirectories({ m_assetRoot / "Shaders", std::filesystem::path(MARK_CORE_ASSETS) });
+        m_graphicsPipelineCache = std::make_unique<VulkanGraphicsPipelineCache>(m_device, &m_pipelineDiskCache, &m_pipelineManifest);
+        m_graphicsPipelineCache->setDynamicStateCaps(m_dynamicStateCaps);
+        if (m_pipelineLibrarySupported) {
+            m_graphicsPipelineCache->enablePipelineLibrary(m_pipelineLibraryFastLinking, m_shaderCache.get());
+        }
+        m_pipelineManifest.create(m_device, m_shaderCache.get(), m_graphicsPipelineCache.get());
+#if MARK_PIPELINE_KEY_BENCHMARK
+        BenchmarkPipelineKeys(*m_graphicsPipelineCache);
+#endif
     }
 
 } // namespace Mark::RendererVK
\ No newline at end of file
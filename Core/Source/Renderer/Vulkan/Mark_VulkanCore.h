@@ -3,6 +3,7 @@
 #include "Mark_Shader.h"
 #include "Mark_Queue.h"
 #include "Mark_GraphicsPipelineCache.h"
+#include "Mark_PipelineDiskCache.h"
 #include "Platform/imguiHandler.h"
 
 #include <filesystem>
@@ -22,6 +23,15 @@ namespace Mark::RendererVK
         const uint32_t numAttachableTextures = 1; // Max number of textures that the mesh can use
         uint32_t maxDrawIndirectCount = 0;
     };
+    // VK_EXT_descriptor_buffer sizes, only meaningful when enabled
+    struct DescriptorBufferCaps
+    {
+        bool enabled = false;
+        VkDeviceSize offsetAlignment = 0;
+        size_t uniformBufferDescriptorSize = 0;
+        size_t storageBufferDescriptorSize = 0;
+        size_t combinedImageSamplerDescriptorSize = 0;
+    };
     struct VulkanCore
     {
         VulkanCore(const EngineAppInfo& _appInfo, Core& _core);
@@ -58,11 +68,20 @@ namespace Mark::RendererVK
         // Cache getters
         VulkanShaderCache& shaderCache() { return *m_shaderCache; }
         VulkanGraphicsPipelineCache& graphicsPipelineCache() { return *m_graphicsPipelineCache; }
+        VulkanPipelineDiskCache& pipelineDiskCache() { return m_pipelineDiskCache; }
+        VulkanPipelineManifest& pipelineManifest() { return m_pipelineManifest; }
 
         // Vertex buffer uploader getter
         VulkanVertexBuffer& vertexUploader() { return *m_vertexUploader; }
 
         BindlessCaps& bindlessCaps() noexcept { return m_bindlessCaps; }
+        const DescriptorBufferCaps& descriptorBufferCaps() const noexcept { return m_descriptorBufferCaps; }
+        // Extra usage for buffers the bindless descriptors point at, descriptor buffers reference them by address
+        VkBufferUsageFlags descriptorResourceUsage() const noexcept {
+            return m_descriptorBufferCaps.enabled ? static_cast<VkBufferUsageFlags>(VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT) : 0u;
+        }
+        const PipelineDynamicStateCaps& dynamicStateCaps() const noexcept { return m_dynamicStateCaps; }
+        bool pipelineStatisticsSupported() const noexcept { return m_pipelineStatisticsSupported; }
 
         // TEMP FILE PATH
         // --- Asset root / path helpers ---
@@ -107,9 +126,22 @@ namespace Mark::RendererVK
 
         // Bindless / descriptor indexing caps
         BindlessCaps m_bindlessCaps{};
+        DescriptorBufferCaps m_descriptorBufferCaps{};
+
+        // Extended dynamic state support, handed to the graphics pipeline cache
+        PipelineDynamicStateCaps m_dynamicStateCaps{};
+
+        // VK_EXT_graphics_pipeline_library support, handed to the graphics pipeline cache
+        bool m_pipelineLibrarySupported{ false };
+        bool m_pipelineLibraryFastLinking{ false };
+
+        // pipelineStatisticsQuery feature, enabled when the device has it
+        bool m_pipelineStatisticsSupported{ false };
 
         // Cache
         std::unique_ptr<VulkanShaderCache> m_shaderCache;
         std::unique_ptr<VulkanGraphicsPipelineCache> m_graphicsPipelineCache;
+        VulkanPipelineDiskCache m_pipelineDiskCache;
+        VulkanPipelineManifest m_pipelineManifest;
     };
 } // namespace Mark::RendererVK
\ No newline at end of file
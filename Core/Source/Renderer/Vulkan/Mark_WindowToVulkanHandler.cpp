@@ -2,6 +2,7 @@
 #include "Mark_VulkanCore.h"
 #include "Mark_ModelHandler.h"
 #include "Platform/Window.h"
+#include "Engine/SettingsHandler.h"
 #include "Utils/VulkanUtils.h"
 
 #include <GLFW/glfw3.h>
@@ -9,17 +10,66 @@
 
 namespace Mark::RendererVK
 {
+    // Opaque and transparent only differ in depth write and blend, with these dynamic they share one VkPipeline
+    static PipelineDynamicStateDesc makeSharedSceneDynamicDesc()
+    {
+        return PipelineDynamicStateDesc{
+            .dynamicDepth = true,
+            .dynamicCull = true,
+            .dynamicBlend = true
+        };
+    }
+
     static PipelineDesc makeOpaquePipelineDesc(std::shared_ptr<VulkanCore> _vkCore, const VulkanSwapChain& _swapChain)
     {
+        // Behind a depth pre-pass the depth buffer already holds the nearest opaque surface, only that one passes
+        PipelineDepthStencilDesc depthStencil{};
+        if (Settings::MarkSettings::Get().depthPrepass()) {
+            depthStencil.depthWriteEnable = false;
+            depthStencil.depthCompareOp = VK_COMPARE_OP_EQUAL;
+        }
+
         return PipelineDesc{
             .device = _vkCore->device(),
             .cache = _vkCore->graphicsPipelineCache(),
             .vertexShader = _vkCore->shaderCache().getOrCreateFromGLSL(_vkCore->assetPath("Shaders/TriangleTest.vert").string().c_str()),
             .fragmentShader = _vkCore->shaderCache().getOrCreateFromGLSL(_vkCore->assetPath("Shaders/TriangleTest.frag").string().c_str()),
             .debugName = "WindowToVulkanHandler.Opaque",
+            .descriptorBuffer = _vkCore->descriptorBufferCaps().enabled, // Matches the bindless set backend
+            .renderTargetsDesc {
+                .colourFormats = {_swapChain.surfaceFormat().format},
+                .depthFormat = _vkCore->physicalDevices().selected().m_depthFormat
+            },
+            .depthStencilDesc = depthStencil,
+            .dynamicDesc = makeSharedSceneDynamicDesc()
+        };
+    }
+
+    // DEPTH_ONLY permutation of the scene vertex shader and no fragment shader. The colour attachment stays in the
+    // formats so the pipeline fits the scene's dynamic rendering instance, with nothing written to it
+    static PipelineDesc makeDepthPrepassPipelineDesc(std::shared_ptr<VulkanCore> _vkCore, const VulkanSwapChain& _swapChain)
+    {
+        return PipelineDesc{
+            .device = _vkCore->device(),
+            .cache = _vkCore->graphicsPipelineCache(),
+            .vertexShader = _vkCore->shaderCache().getOrCreateFromGLSL(_vkCore->assetPath("Shaders/TriangleTest.vert").string().c_str(), { { .m_name = "DEPTH_ONLY" } }),
+            .fragmentShader = VK_NULL_HANDLE,
+            .debugName = "WindowToVulkanHandler.DepthPrepass",
+            .descriptorBuffer = _vkCore->descriptorBufferCaps().enabled, // Matches the bindless set backend
             .renderTargetsDesc {
                 .colourFormats = {_swapChain.surfaceFormat().format},
                 .depthFormat = _vkCore->physicalDevices().selected().m_depthFormat
+            },
+            .blendDesc {
+                .attachments = {
+                    PipelineBlendAttachmentDesc{
+                        .colorWriteMask = 0
+                    }
+                }
+            },
+            .dynamicDesc = PipelineDynamicStateDesc{
+                .dynamicDepth = true,
+                .dynamicCull = true
             }
         };
     }
@@ -32,6 +82,7 @@ namespace Mark::RendererVK
             .vertexShader = _vkCore->shaderCache().getOrCreateFromGLSL(_vkCore->assetPath("Shaders/TriangleTest.vert").string().c_str()),
             .fragmentShader = _vkCore->shaderCache().getOrCreateFromGLSL(_vkCore->assetPath("Shaders/TriangleTest.frag").string().c_str()),
             .debugName = "WindowToVulkanHandler.Transparent",
+            .descriptorBuffer = _vkCore->descriptorBufferCaps().enabled, // Matches the bindless set backend
             .renderTargetsDesc {
                 .colourFormats = {_swapChain.surfaceFormat().format},
                 .depthFormat = _vkCore->physicalDevices().selected().m_depthFormat
@@ -52,7 +103,8 @@ namespace Mark::RendererVK
                         .alphaOp = VK_BLEND_OP_ADD
                     }
                 }
-            }
+            },
+            .dynamicDesc = makeSharedSceneDynamicDesc()
         };
     }
 
@@ -75,41 +127,67 @@ namespace Mark::RendererVK
         m_windowQueueHelper.initialize(&VkCore->graphicsQueue(), &VkCore->presentQueue(), VkCore->device());
         m_windowQueueHelper.createFrameSyncObjects(FRAMES_IN_FLIGHT, static_cast<uint32_t>(m_swapChain.numImages()));
 
-        m_uniformBuffer.createUniformBuffers(static_cast<uint32_t>(m_swapChain.numImages()));
+        // One UBO per frame slot, indexed by swapchain image. Sized for the largest swapchain so rebuilds never touch it
+        if (static_cast<uint32_t>(m_swapChain.numImages()) > VulkanBindlessMeshResourceSet::FRAME_SLOTS) {
+            MARK_FATAL(Utils::Category::Vulkan, "Swapchain has %d images, bindless set supports %u frame slots", m_swapChain.numImages(), VulkanBindlessMeshResourceSet::FRAME_SLOTS);
+        }
+        m_uniformBuffer.createUniformBuffers(VulkanBindlessMeshResourceSet::FRAME_SLOTS);
+
+        // The bindless set uploads its fallback texture through the copy command buffer
+        m_vulkanCommandBuffers.createCommandPool();
+        m_vulkanCommandBuffers.createCopyCommandBuffer();
 
-        // Bindless resource set: owns descriptor pool/layout/sets + writes UBO + mesh slots
+        // Bindless resource set: single update-after-bind set owning layout/pool, writes UBO slots + mesh slots
         m_bindlessSet.initialize(
             m_vulkanCoreRef,
-            m_swapChain,
+            &m_vulkanCommandBuffers,
             m_uniformBuffer,
-            &m_meshesToDraw,
+            &m_meshes,
             m_windowRef.title().data()
         );
+        m_meshes.reset(m_bindlessSet.maxMeshesLayout());
+        m_meshSlots.reset(m_bindlessSet.maxMeshesLayout());
+        m_textureSlots.reset(m_bindlessSet.textureCapacity());
+        m_textureSlots.allocate(); // FALLBACK_TEXTURE_SLOT, held for the window's life
 
         // Pipeline layouts must be created from the bindless set layout
         m_opaqueGraphicsPipeline.setResourceLayout(m_bindlessSet.layout(), m_bindlessSet.layoutHash());
         m_transparentGraphicsPipeline.setResourceLayout(m_bindlessSet.layout(), m_bindlessSet.layoutHash());
+        m_depthPrepassGraphicsPipeline.setResourceLayout(m_bindlessSet.layout(), m_bindlessSet.layoutHash());
 
-        // Initializing basic graphics pipelines
+        // Initializing basic graphics pipelines. Opaque is needed on the first frame, transparent compiles in the background
         m_opaqueGraphicsPipeline.createGraphicsPipeline(makeOpaquePipelineDesc(VkCore, m_swapChain));
-        m_transparentGraphicsPipeline.createGraphicsPipeline(makeTransparentPipelineDesc(VkCore, m_swapChain));
+        m_transparentGraphicsPipeline.createGraphicsPipelineAsync(makeTransparentPipelineDesc(VkCore, m_swapChain));
+        createDepthPrepassPipeline();
 
         m_opaqueIndirectRenderingHelper.initialize();
         m_transparentIndirectRenderingHelper.initialize();
 
-        m_vulkanCommandBuffers.createCommandPool();
+        // Queries are indexed by frame slot like the UBOs, so swapchain rebuilds leave the pool alone
+        m_gpuFrameStats.initialize(VulkanBindlessMeshResourceSet::FRAME_SLOTS);
 
         if (m_renderImGui) {
             m_vulkanCommandBuffers.createCommandBuffers(m_swapChain.numImages(), m_vulkanCommandBuffers.commandBuffersWithGUI());
         }
         m_vulkanCommandBuffers.createCommandBuffers(m_swapChain.numImages(), m_vulkanCommandBuffers.commandBuffersWithoutGUI());
 
-        m_vulkanCommandBuffers.createCopyCommandBuffer();
-
         /* TEMP: Sets skybox to default engine skybox for now, will be more customizable in the future with the engine side */
         std::filesystem::path defaultSkyboxPath = std::filesystem::path(MARK_CORE_ASSETS) / "DefaultSkyboxTexture.png";
         m_skybox.initialize(m_swapChain, defaultSkyboxPath.string().c_str());
 
+#if MARK_TEXTURE_LOAD_BENCHMARK
+        if (m_renderImGui) {
+            TextureHandler::benchmarkTextureLoading(m_vulkanCoreRef, &m_vulkanCommandBuffers,
+                VkCore->assetPath("Textures/Curuthers.png").string().c_str(), MARK_TEXTURE_LOAD_BENCHMARK_COUNT);
+        }
+#endif
+#if MARK_DESCRIPTOR_TEMPLATE_BENCHMARK
+        if (m_renderImGui) {
+            VulkanBindlessMeshResourceSet::benchmarkDescriptorRewrite(m_vulkanCoreRef, &m_vulkanCommandBuffers, m_uniformBuffer,
+                VkCore->assetPath("Textures/Curuthers.png").string().c_str(), MARK_DESCRIPTOR_TEMPLATE_BENCHMARK_COUNT);
+        }
+#endif
+
         m_vulkanCommandBuffers.recordCommandBuffers(_clearColour);
     }
 
@@ -122,6 +200,8 @@ namespace Mark::RendererVK
         VkCore->graphicsQueue().waitIdle();
         VkCore->presentQueue().waitIdle();
 
+        releaseRetiredResources(true);
+
         // Destroy frame data sync objects
         m_windowQueueHelper.destroyFrameSyncObjects();
 
@@ -141,9 +221,13 @@ namespace Mark::RendererVK
         m_opaqueIndirectRenderingHelper.destroy(VkCore->device());
         m_transparentIndirectRenderingHelper.destroy(VkCore->device());
 
+        // Destroy GPU query pools
+        m_gpuFrameStats.destroy(VkCore->device());
+
         // Destroy graphics pipeline
         m_opaqueGraphicsPipeline.destroyGraphicsPipeline();
         m_transparentGraphicsPipeline.destroyGraphicsPipeline();
+        m_depthPrepassGraphicsPipeline.destroyGraphicsPipeline();
         
 
         // Explicitly destroy swap chain before surface
@@ -185,8 +269,21 @@ namespace Mark::RendererVK
         auto VkCore = m_vulkanCoreRef.lock();
         if (!VkCore) { MARK_FATAL(Utils::Category::Vulkan, "VulkanCore expired during renderFrame()"); }
 
+        pollPendingPipelines();
+
         uint32_t imageIndex = m_windowQueueHelper.acquireNextImage(m_swapChain.swapChain());
 
+        // The acquire waited on the frame FRAMES_IN_FLIGHT back, anything deferred before it can go now
+        m_frameNumber++;
+        releaseRetiredResources();
+#if MARK_BINDLESS_SLOT_COMPACTION
+        compactSlots(); // Moved slots are picked up by the opaque rebuild below
+#endif
+        m_gpuFrameStats.collect(imageIndex);
+
+        // Its previous submission has retired, so this image's buffers can be re-recorded for any pipeline that landed
+        m_vulkanCommandBuffers.recordImageIfDirty(imageIndex, m_clearColour);
+
         /* TEMP UNIFORM DATA UPDATING FOR TESTING */
         UniformData tempData;
         glm::mat4 skyVP = glm::mat4(1.0f);
@@ -215,8 +312,14 @@ namespace Mark::RendererVK
 
         m_skybox.update(imageIndex, skyVP);
 
-        // Transparent draw order is view dependent so its rebuilt
-        m_transparentIndirectRenderingHelper.rebuildDrawCommands(m_meshesToDraw, hasCameraPosition ? &cameraPosition : nullptr);
+        // Both draw orders are view dependent so they're rebuilt every frame, slots only re-upload when the commands changed
+        const bool orderForEarlyZ = Settings::MarkSettings::Get().orderForEarlyZ();
+        m_opaqueIndirectRenderingHelper.rebuildDrawCommands(m_meshes, (orderForEarlyZ && hasCameraPosition) ? &cameraPosition : nullptr);
+        m_transparentIndirectRenderingHelper.rebuildDrawCommands(m_meshes, hasCameraPosition ? &cameraPosition : nullptr);
+
+        // This image's previous submission has retired, so its indirect regions can take any rebuilds since it last ran
+        m_opaqueIndirectRenderingHelper.uploadForFrameSlot(imageIndex);
+        m_transparentIndirectRenderingHelper.uploadForFrameSlot(imageIndex);
 
         // Submit the command buffer for this image
         if (m_renderImGui && VkCore->imguiHandler().showGUI()) {
@@ -229,10 +332,32 @@ namespace Mark::RendererVK
             VkCommandBuffer cmdBuffer = m_vulkanCommandBuffers.commandBufferWithoutGUI(imageIndex);
             m_windowQueueHelper.submitAsync(imageIndex , &cmdBuffer, 1);
         }
+        m_gpuFrameStats.markSubmitted(imageIndex);
 
         m_windowQueueHelper.present(m_swapChain.swapChain(), imageIndex);
     }
 
+    void WindowToVulkanHandler::createDepthPrepassPipeline()
+    {
+        if (!Settings::MarkSettings::Get().depthPrepass()) return;
+
+        // Not async, the opaque pass tests EQUAL against its depth and would draw nothing while it compiled
+        m_depthPrepassGraphicsPipeline.createGraphicsPipeline(makeDepthPrepassPipelineDesc(m_vulkanCoreRef.lock(), m_swapChain));
+    }
+
+    void WindowToVulkanHandler::pollPendingPipelines()
+    {
+        bool resolved = m_opaqueGraphicsPipeline.poll();
+        resolved |= m_transparentGraphicsPipeline.poll();
+        resolved |= m_depthPrepassGraphicsPipeline.poll();
+        resolved |= m_skybox.pollPipeline();
+        if (!resolved) return;
+
+        // Pre-recorded buffers still bind the fallback (or skip the pass). Each image picks up the compiled pipeline when
+        // it's next acquired, the handles they bind until then stay alive in the pipeline cache
+        m_vulkanCommandBuffers.markImagesDirty();
+    }
+
     void WindowToVulkanHandler::rebuildRendererResources()
     {
         auto VkCore = m_vulkanCoreRef.lock();
@@ -242,6 +367,8 @@ namespace Mark::RendererVK
         VkCore->presentQueue().waitIdle();
         m_windowRef.waitUntilFramebufferValid();
 
+        releaseRetiredResources(true);
+
         // Re-query surface properties
         VkCore->physicalDevices().querySurfaceProperties(m_surface);
 
@@ -256,22 +383,24 @@ namespace Mark::RendererVK
         m_windowQueueHelper.destroyFrameSyncObjects();
         m_windowQueueHelper.createFrameSyncObjects(FRAMES_IN_FLIGHT, static_cast<uint32_t>(m_swapChain.numImages()));
 
-        // Uniform buffers
-        m_uniformBuffer.destroyUniformBuffers(m_vulkanCoreRef.lock()->device());
-        m_uniformBuffer.createUniformBuffers(m_swapChain.numImages());
-
-        // Bindless resource set: recreate pool+sets for new swapchain image count and rewrite descriptors
-        m_bindlessSet.recreateForSwapchain(m_swapChain, m_uniformBuffer, &m_meshesToDraw);
+        // Uniform buffers and the bindless set are sized by frame slots, not image count, so they survive the rebuild
+        if (static_cast<uint32_t>(m_swapChain.numImages()) > VulkanBindlessMeshResourceSet::FRAME_SLOTS) {
+            MARK_FATAL(Utils::Category::Vulkan, "Swapchain has %d images, bindless set supports %u frame slots", m_swapChain.numImages(), VulkanBindlessMeshResourceSet::FRAME_SLOTS);
+        }
         
         // Graphics pipeline
         m_opaqueGraphicsPipeline.destroyGraphicsPipeline();
         m_transparentGraphicsPipeline.destroyGraphicsPipeline();
+        m_depthPrepassGraphicsPipeline.destroyGraphicsPipeline();
         
         m_opaqueGraphicsPipeline.setResourceLayout(m_bindlessSet.layout(), m_bindlessSet.layoutHash());
         m_transparentGraphicsPipeline.setResourceLayout(m_bindlessSet.layout(), m_bindlessSet.layoutHash());
+        m_depthPrepassGraphicsPipeline.setResourceLayout(m_bindlessSet.layout(), m_bindlessSet.layoutHash());
         
+        // The depth pre-pass toggle lands here, it changes the opaque depth state and whether the pre-pass exists
         m_opaqueGraphicsPipeline.createGraphicsPipeline(makeOpaquePipelineDesc(VkCore, m_swapChain));
-        m_transparentGraphicsPipeline.createGraphicsPipeline(makeTransparentPipelineDesc(VkCore, m_swapChain));
+        m_transparentGraphicsPipeline.createGraphicsPipelineAsync(makeTransparentPipelineDesc(VkCore, m_swapChain));
+        createDepthPrepassPipeline();
 
         // Command buffers
         m_vulkanCommandBuffers.destroyCommandBuffers();
@@ -306,51 +435,173 @@ namespace Mark::RendererVK
         MARK_INFO(Utils::Category::Vulkan, "GLFW Window Surface Created");
     }
 
-    void WindowToVulkanHandler::setMeshVisible(uint32_t _meshIndex, bool _visible)
+    void WindowToVulkanHandler::setMeshVisible(MeshHandle _mesh, bool _visible)
     {
-        if (_meshIndex >= m_meshesToDraw.size() || !m_meshesToDraw[_meshIndex]) return;
+        const uint32_t dense = m_meshes.denseIndex(_mesh);
+        if (dense == UINT32_MAX || (m_meshes.visible()[dense] != 0) == _visible) return;
 
-        if (m_meshesToDraw[_meshIndex]->isTransparent()) {
-            m_transparentIndirectRenderingHelper.setMeshVisible(m_meshesToDraw, _meshIndex, _visible);
+        // CPU side rebuild, each frame slot picks it up in renderToWindow once that image is free
+        m_meshes.setVisible(dense, _visible);
+        if (m_meshes.renderTypes()[dense] == RenderType::Transparent) {
+            m_transparentIndirectRenderingHelper.rebuildDrawCommands(m_meshes);
         }
         else {
-            m_opaqueIndirectRenderingHelper.setMeshVisible(m_meshesToDraw, _meshIndex, _visible);
+            m_opaqueIndirectRenderingHelper.rebuildDrawCommands(m_meshes);
         }
     }
 
-    void WindowToVulkanHandler::removeMesh(uint32_t _meshIndex)
+    void WindowToVulkanHandler::setMeshRenderType(MeshHandle _mesh, RenderType _type)
     {
-        if (_meshIndex >= m_meshesToDraw.size()) return;
-        
-        // TODO: PROPER HANDLING OF REMOVING MESHES
-        setMeshVisible(_meshIndex, false);
+        const uint32_t dense = m_meshes.denseIndex(_mesh);
+        if (dense == UINT32_MAX || m_meshes.renderTypes()[dense] == _type) return;
+
+        // The mesh can change pass, so both lists are rebuilt
+        m_meshes.setRenderType(dense, _type);
+        m_opaqueIndirectRenderingHelper.rebuildDrawCommands(m_meshes);
+        m_transparentIndirectRenderingHelper.rebuildDrawCommands(m_meshes);
     }
 
-    std::weak_ptr<MeshHandler> WindowToVulkanHandler::addMesh(const char* _meshPath)
+    void WindowToVulkanHandler::setMeshSortPosition(MeshHandle _mesh, const glm::vec3& _position)
     {
-        auto rtn = std::make_shared<MeshHandler>(m_vulkanCoreRef, m_vulkanCommandBuffers);
+        const uint32_t dense = m_meshes.denseIndex(_mesh);
+        if (dense == UINT32_MAX) return;
 
-        const auto assetPath = m_vulkanCoreRef.lock()->assetPath(_meshPath);
-        rtn->loadFromOBJ(assetPath.string().c_str(), true/*Flip texture vertically for Vulkan*/);
-        rtn->uploadToGPU();
+        m_meshes.setSortPosition(dense, _position);
+    }
 
-        m_meshesToDraw.push_back(rtn);
-        const uint32_t newMeshIndex = static_cast<uint32_t>(m_meshesToDraw.size() - 1);
+    void WindowToVulkanHandler::removeMesh(MeshHandle _mesh)
+    {
+        const uint32_t dense = m_meshes.denseIndex(_mesh);
+        if (dense == UINT32_MAX) return;
+
+        const Utils::SlotHandle meshSlot = m_meshes.meshSlotHandle(dense);
+        const Utils::SlotHandle textureSlot = m_meshes.textureSlotHandle(dense);
+        std::shared_ptr<MeshHandler> mesh = m_meshes.remove(_mesh);
+
+        // Frames submitted from here on no longer draw it, the draw count lives in the count buffer so nothing is re-recorded
+        m_opaqueIndirectRenderingHelper.rebuildDrawCommands(m_meshes);
+        m_transparentIndirectRenderingHelper.rebuildDrawCommands(m_meshes);
+
+        // Frames already in flight may still read its slots and buffers
+        m_deferredReleases.push_back({
+            .mesh = std::move(mesh),
+            .meshSlot = meshSlot,
+            .textureSlot = textureSlot,
+            .retireFrame = m_frameNumber + FRAMES_IN_FLIGHT
+        });
+    }
 
-        // Wait for GPU to finish before updating buffers
-        m_vulkanCoreRef.lock()->graphicsQueue().waitIdle();
+    void WindowToVulkanHandler::releaseRetiredResources(bool _gpuIdle)
+    {
+        auto retired = [&](const DeferredRelease& _release) { return _gpuIdle || _release.retireFrame <= m_frameNumber; };
+
+        for (DeferredRelease& release : m_deferredReleases)
+        {
+            if (!retired(release)) continue;
 
-        if (!m_bindlessSet.tryWriteMeshSlot(m_swapChain, m_uniformBuffer, newMeshIndex, *rtn)) {
-            m_bindlessSet.recreateForSwapchain(m_swapChain, m_uniformBuffer, &m_meshesToDraw);
+            m_meshSlots.release(release.meshSlot);
+            m_textureSlots.release(release.textureSlot);
+            release.mesh.reset(); // Last owner, destroys the mesh buffers and texture
         }
+        std::erase_if(m_deferredReleases, retired);
+    }
 
-        // Update indirect draw commands with new mesh
-        m_opaqueIndirectRenderingHelper.rebuildDrawCommands(m_meshesToDraw);
-        m_transparentIndirectRenderingHelper.rebuildDrawCommands(m_meshesToDraw);
+    bool WindowToVulkanHandler::compactSlots()
+    {
+        // Linear scans over the hot slot arrays, only the moved meshes are touched
+        const std::vector<uint32_t>& meshSlots = m_meshes.meshSlots();
+        const std::vector<uint32_t>& textureSlots = m_meshes.textureSlots();
+        uint32_t highestMesh = UINT32_MAX;
+        uint32_t highestTexture = UINT32_MAX;
+        for (uint32_t i = 0; i < m_meshes.size(); i++)
+        {
+            if (highestMesh == UINT32_MAX || meshSlots[i] > meshSlots[highestMesh]) {
+                highestMesh = i;
+            }
+            if (textureSlots[i] != UINT32_MAX && (highestTexture == UINT32_MAX || textureSlots[i] > textureSlots[highestTexture])) {
+                highestTexture = i;
+            }
+        }
 
-        // Re-record command buffers to bind the new descriptor set handles
-        m_vulkanCommandBuffers.recordCommandBuffers(m_clearColour);
+        // The new slots were released a full FRAMES_IN_FLIGHT ago, so writing them is safe while frames are in flight
+        // The old slots keep their descriptors until the frames that may still use them retire
+        const uint64_t retireFrame = m_frameNumber + FRAMES_IN_FLIGHT;
+        bool moved = false;
+
+        if (highestMesh != UINT32_MAX && m_meshSlots.lowestFree() < meshSlots[highestMesh])
+        {
+            const Utils::SlotHandle newSlot = m_meshSlots.allocate();
+            m_bindlessSet.writeMeshSlot(newSlot.index, UINT32_MAX, m_meshes.mesh(highestMesh));
+            m_deferredReleases.push_back({ .meshSlot = m_meshes.meshSlotHandle(highestMesh), .retireFrame = retireFrame });
+            m_meshes.setMeshSlot(highestMesh, newSlot);
+            moved = true;
+        }
+
+        if (highestTexture != UINT32_MAX && m_textureSlots.lowestFree() < textureSlots[highestTexture])
+        {
+            const Utils::SlotHandle newSlot = m_textureSlots.allocate();
+            m_bindlessSet.writeTextureSlot(newSlot.index, *m_meshes.mesh(highestTexture).texture());
+            m_deferredReleases.push_back({ .textureSlot = m_meshes.textureSlotHandle(highestTexture), .retireFrame = retireFrame });
+            m_meshes.setTextureSlot(highestTexture, newSlot);
+            moved = true;
+        }
+
+        return moved;
+    }
+
+    MeshHandle WindowToVulkanHandler::addMesh(const char* _meshPath, MeshCPUResidency _cpuResidency)
+    {
+        return addMeshes({ _meshPath }, _cpuResidency)[0];
+    }
+
+    std::vector<MeshHandle> WindowToVulkanHandler::addMeshes(const std::vector<const char*>& _meshPaths, MeshCPUResidency _cpuResidency)
+    {
+        std::vector<std::shared_ptr<MeshHandler>> meshes;
+        std::vector<MeshHandler*> meshPtrs;
+        meshes.reserve(_meshPaths.size());
+        meshPtrs.reserve(_meshPaths.size());
+        for (const char* meshPath : _meshPaths)
+        {
+            auto rtn = std::make_shared<MeshHandler>(m_vulkanCoreRef, m_vulkanCommandBuffers);
+
+            const auto assetPath = m_vulkanCoreRef.lock()->assetPath(meshPath);
+            rtn->loadFromOBJ(assetPath.string().c_str(), true/*Flip texture vertically for Vulkan*/);
+            rtn->m_cpuResidency = _cpuResidency;
+            rtn->uploadToGPU(); // Releases or compresses the CPU copy per _cpuResidency, counts and bounds stay valid
+
+            meshPtrs.push_back(rtn.get());
+            meshes.push_back(std::move(rtn));
+        }
+
+        // All textures decode on worker threads and upload in one submission, before any descriptor references them
+        MeshHandler::loadTextures(meshPtrs);
+
+        std::vector<MeshHandle> handles(_meshPaths.size());
+        for (size_t i = 0; i < meshes.size(); i++)
+        {
+            std::shared_ptr<MeshHandler>& rtn = meshes[i];
+
+            // Lowest free slots, then a single descriptor write. Freed slots only come back once no frame in flight reads them
+            const Utils::SlotHandle meshSlot = m_meshSlots.allocate();
+            const Utils::SlotHandle textureSlot = rtn->texture() ? m_textureSlots.allocate() : Utils::SlotHandle{};
+            if (!meshSlot.valid() || (rtn->texture() && !textureSlot.valid()) ||
+                !m_bindlessSet.writeMeshSlot(meshSlot.index, textureSlot.index, *rtn))
+            {
+                MARK_WARN(Utils::Category::Vulkan, "Mesh '%s' exceeds bindless capacity (%u meshes, %u textures), not added",
+                    _meshPaths[i], m_meshSlots.capacity(), m_textureSlots.capacity());
+                m_meshSlots.release(meshSlot);
+                m_textureSlots.release(textureSlot);
+                continue;
+            }
+
+            handles[i] = m_meshes.add(std::move(rtn), meshSlot, textureSlot);
+        }
+
+        // Update indirect draw commands with the new meshes. The recorded buffers read the draw count from the count buffer
+        // and the frame slot regions are refreshed before each submit, so there is no need to wait or re-record
+        m_opaqueIndirectRenderingHelper.rebuildDrawCommands(m_meshes);
+        m_transparentIndirectRenderingHelper.rebuildDrawCommands(m_meshes);
 
-        return rtn;
+        return handles;
     }
 } // namespace Mark::RendererVK
\ No newline at end of file
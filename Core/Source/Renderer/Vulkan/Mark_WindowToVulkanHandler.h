@@ -2,10 +2,18 @@
 #include "Mark_CommandBuffers.h"
 #include "Mark_WindowQueueHelper.h"
 #include "Mark_IndirectRenderingHelper.h"
+#include "Mark_MeshPool.h"
 #include "Mark_UniformBuffer.h"
 #include "Mark_Skybox.h"
+#include "Mark_GPUFrameStats.h"
 
 #include "Engine/EarlyCameraController.h" // TEMP
+#include "Utils/Mark_SlotAllocator.h"
+
+// Set to 0 to stop moving meshes and textures down into freed bindless slots (one of each per frame)
+#ifndef MARK_BINDLESS_SLOT_COMPACTION
+    #define MARK_BINDLESS_SLOT_COMPACTION 1
+#endif
 
 namespace Mark::Platform { struct Window; struct ImGuiHandler; }
 namespace Mark::RendererVK
@@ -23,17 +31,37 @@ namespace Mark::RendererVK
         void createSurface();
         VkSurfaceKHR surface() const { return m_surface; }
 
-        void setMeshVisible(uint32_t _meshIndex, bool _visible);
-        void removeMesh(uint32_t _meshIndex);
+        // Stale handles are ignored
+        void setMeshVisible(MeshHandle _mesh, bool _visible);
+        void setMeshRenderType(MeshHandle _mesh, RenderType _type);
+        void setMeshSortPosition(MeshHandle _mesh, const glm::vec3& _position); // Picked up by the next transparent rebuild
+        // Stops drawing the mesh straight away, its buffers and bindless slots are released once in-flight frames retire
+        void removeMesh(MeshHandle _mesh);
+
+        const MeshPool& meshes() const noexcept { return m_meshes; }
+        const VulkanGPUFrameStats& gpuFrameStats() const noexcept { return m_gpuFrameStats; }
 
         // TEMP FOR TESTING
-        std::weak_ptr<MeshHandler> addMesh(const char* _meshPath);
+        MeshHandle addMesh(const char* _meshPath, MeshCPUResidency _cpuResidency = static_cast<MeshCPUResidency>(MARK_MESH_CPU_RESIDENCY_DEFAULT));
+        // Textures of the whole list are decoded as one parallel batch, handles match _meshPaths (invalid if not added)
+        std::vector<MeshHandle> addMeshes(const std::vector<const char*>& _meshPaths, MeshCPUResidency _cpuResidency = static_cast<MeshCPUResidency>(MARK_MESH_CPU_RESIDENCY_DEFAULT));
         void initCameraController();
 
     private:
         friend struct ImGuiRenderer; // Allows access to main windows info for ImGui init
         friend Platform::ImGuiHandler;
 
+        // Re-records command buffers when a background pipeline compile lands
+        void pollPendingPipelines();
+        // Only created while the depth pre-pass setting is on
+        void createDepthPrepassPipeline();
+
+        // Frees deferred meshes and slots whose frames have retired, or all of them once the GPU is idle
+        void releaseRetiredResources(bool _gpuIdle = false);
+        // Moves the mesh in the highest mesh slot and the texture in the highest texture slot down into the lowest free ones
+        // Returns true if anything moved, the opaque draw commands then need a rebuild
+        bool compactSlots();
+
         std::weak_ptr<VulkanCore> m_vulkanCoreRef;
         Platform::Window& m_windowRef;
         VkClearColorValue m_clearColour{};
@@ -42,8 +70,23 @@ namespace Mark::RendererVK
 
         static constexpr uint32_t FRAMES_IN_FLIGHT = 3;
 
-        // TEMP list of meshes to render for this window
-        std::vector<std::shared_ptr<MeshHandler>> m_meshesToDraw;
+        // TEMP meshes to render for this window
+        MeshPool m_meshes;
+
+        // Bindless slot spaces, mesh slots index bindings 0/1 and texture slots binding 3
+        Utils::GenerationalSlotAllocator m_meshSlots;
+        Utils::GenerationalSlotAllocator m_textureSlots;
+
+        // Meshes and slots that frames still in flight may read, released after FRAMES_IN_FLIGHT more acquires
+        struct DeferredRelease
+        {
+            std::shared_ptr<MeshHandler> mesh; // Null when only slots are released
+            Utils::SlotHandle meshSlot;
+            Utils::SlotHandle textureSlot;
+            uint64_t retireFrame{ 0 };
+        };
+        std::vector<DeferredRelease> m_deferredReleases;
+        uint64_t m_frameNumber{ 0 }; // Images acquired so far
         // TEMP camera controller for testing
         std::shared_ptr<Systems::EarlyCameraController> m_cameraController;
 
@@ -53,11 +96,13 @@ namespace Mark::RendererVK
         VkSurfaceKHR m_surface{ VK_NULL_HANDLE };
         VulkanGraphicsPipeline m_opaqueGraphicsPipeline;
         VulkanGraphicsPipeline m_transparentGraphicsPipeline;
+        VulkanGraphicsPipeline m_depthPrepassGraphicsPipeline;
         VulkanBindlessMeshResourceSet m_bindlessSet;
         VulkanWindowQueueHelper m_windowQueueHelper;
         VulkanSwapChain m_swapChain{ m_vulkanCoreRef, m_surface };
         VulkanUniformBuffer m_uniformBuffer{ m_vulkanCoreRef };
-        VulkanCommandBuffers m_vulkanCommandBuffers{ m_vulkanCoreRef, m_swapChain, m_opaqueGraphicsPipeline, m_transparentGraphicsPipeline, m_bindlessSet, m_skybox };
+        VulkanGPUFrameStats m_gpuFrameStats{ m_vulkanCoreRef };
+        VulkanCommandBuffers m_vulkanCommandBuffers{ m_vulkanCoreRef, m_swapChain, m_opaqueGraphicsPipeline, m_transparentGraphicsPipeline, m_depthPrepassGraphicsPipeline, m_bindlessSet, m_skybox, m_gpuFrameStats };
         VulkanIndirectRenderingHelper m_opaqueIndirectRenderingHelper{ m_vulkanCoreRef, m_vulkanCommandBuffers, IndirectDrawPass::Opaque };
         VulkanIndirectRenderingHelper m_transparentIndirectRenderingHelper{ m_vulkanCoreRef, m_vulkanCommandBuffers, IndirectDrawPass::Transparent };
     };
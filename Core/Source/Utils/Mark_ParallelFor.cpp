@@ -0,0 +1,91 @@
+#include "Mark_ParallelFor.h"
+
+namespace Mark::Utils
+{
+    namespace
+    {
+        thread_local bool t_isPoolThread = false;
+    }
+
+    WorkerPool& WorkerPool::get()
+    {
+        static WorkerPool pool;
+        return pool;
+    }
+
+    WorkerPool::WorkerPool()
+    {
+        const unsigned hwThreads = std::max(1u, std::thread::hardware_concurrency());
+        m_threads.reserve(hwThreads - 1);
+        for (unsigned i = 1; i < hwThreads; i++) {
+            m_threads.emplace_back([this]() { workerLoop(); });
+        }
+    }
+
+    WorkerPool::~WorkerPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stop = true;
+        }
+        m_wake.notify_all();
+        for (std::thread& thread : m_threads) {
+            thread.join();
+        }
+    }
+
+    void WorkerPool::run(const std::function<void()>& _job, unsigned _helpers)
+    {
+        _helpers = std::min(_helpers, workerCount());
+
+        // Nested or concurrent runs would wait on threads that are busy with the current job
+        if (_helpers == 0 || t_isPoolThread || !m_runMutex.try_lock())
+        {
+            _job();
+            return;
+        }
+        std::lock_guard<std::mutex> runLock(m_runMutex, std::adopt_lock);
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_job = &_job;
+            m_openClaims = _helpers;
+            m_generation++;
+        }
+        m_wake.notify_all();
+
+        _job();
+
+        // Helpers that haven't woken yet would only find the work exhausted, so close the job instead of waiting for them
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_openClaims = 0;
+        m_done.wait(lock, [this]() { return m_active == 0; });
+        m_job = nullptr;
+    }
+
+    void WorkerPool::workerLoop()
+    {
+        t_isPoolThread = true;
+        uint64_t seenGeneration = 0;
+
+        std::unique_lock<std::mutex> lock(m_mutex);
+        for (;;)
+        {
+            m_wake.wait(lock, [&]() { return m_stop || (m_openClaims > 0 && m_generation != seenGeneration); });
+            if (m_stop) return;
+
+            seenGeneration = m_generation;
+            m_openClaims--;
+            m_active++;
+            const std::function<void()>* job = m_job;
+
+            lock.unlock();
+            (*job)();
+            lock.lock();
+
+            if (--m_active == 0) {
+                m_done.notify_all();
+            }
+        }
+    }
+} // namespace Mark::Utils
@@ -0,0 +1,91 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Mark::Utils
+{
+    // --------- PARALLEL FOR HELPER  ---------
+    // Process-wide threads created on first use and parked between jobs, so a parallelFor doesn't pay for thread creation
+    // One job runs at a time. A run from a pool thread, or while another job is running, executes on the caller alone
+    struct WorkerPool
+    {
+        static WorkerPool& get();
+
+        WorkerPool(const WorkerPool&) = delete;
+        WorkerPool& operator=(const WorkerPool&) = delete;
+
+        // Threads besides the caller, hardware_concurrency - 1
+        unsigned workerCount() const noexcept { return static_cast<unsigned>(m_threads.size()); }
+
+        // Runs _job on the caller and on up to _helpers pool threads, returns once every copy has returned
+        // _job must share its work through its own state (e.g. an atomic counter), a helper may join after the caller finished
+        void run(const std::function<void()>& _job, unsigned _helpers);
+
+    private:
+        WorkerPool();
+        ~WorkerPool();
+        void workerLoop();
+
+        std::vector<std::thread> m_threads;
+        std::mutex m_runMutex; // Held by the caller for the whole job
+        std::mutex m_mutex;
+        std::condition_variable m_wake;
+        std::condition_variable m_done;
+        const std::function<void()>* m_job{ nullptr };
+        uint64_t m_generation{ 0 };
+        unsigned m_openClaims{ 0 }; // Helpers that may still join the current job
+        unsigned m_active{ 0 };     // Helpers inside the current job
+        bool m_stop{ false };
+    };
+
+    // Runs _fn(index) for every index in [0, _count). Indices are handed out _grain at a time from a
+    // shared counter so uneven work balances itself. The calling thread takes a share too
+    template <typename Fn>
+    void parallelFor(size_t _count, size_t _grain, Fn&& _fn, unsigned _maxThreads = 0)
+    {
+        if (_count == 0) return;
+        _grain = std::max<size_t>(1, _grain);
+
+        std::atomic<size_t> next{ 0 };
+        auto worker = [&]()
+        {
+            for (;;)
+            {
+                const size_t first = next.fetch_add(_grain);
+                if (first >= _count)
+                    break;
+
+                const size_t last = std::min(first + _grain, _count);
+                for (size_t i = first; i < last; i++) {
+                    _fn(i);
+                }
+            }
+        };
+
+        const unsigned maxTasks = static_cast<unsigned>((_count + _grain - 1) / _grain);
+        unsigned numThreads = std::min(WorkerPool::get().workerCount() + 1u, maxTasks);
+        if (_maxThreads > 0) {
+            numThreads = std::min(numThreads, _maxThreads);
+        }
+
+        if (numThreads <= 1) {
+            worker();
+            return;
+        }
+        WorkerPool::get().run(worker, numThreads - 1);
+    }
+
+    inline unsigned parallelForThreadCount(size_t _count, size_t _grain)
+    {
+        const unsigned maxTasks = static_cast<unsigned>((_count + std::max<size_t>(1, _grain) - 1) / std::max<size_t>(1, _grain));
+        return std::max(1u, std::min(WorkerPool::get().workerCount() + 1u, maxTasks));
+    }
+    // --------- End PARALLEL FOR HELPER  ---------
+} // namespace Mark::Utils
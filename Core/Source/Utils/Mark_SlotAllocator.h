@@ -0,0 +1,123 @@
+#pragma once
+#include <bit>
+#include <cstdint>
+#include <vector>
+
+namespace Mark::Utils
+{
+    // --------- GENERATIONAL SLOT ALLOCATOR  ---------
+    // Slot index plus the generation it was handed out with. Releasing a slot bumps its generation,
+    // so a stale handle to a reused slot is detected instead of silently aliasing the new owner
+    struct SlotHandle
+    {
+        uint32_t index{ UINT32_MAX };
+        uint32_t generation{ 0 };
+
+        bool valid() const noexcept { return index != UINT32_MAX; }
+        bool operator==(const SlotHandle&) const = default;
+    };
+
+    // Hands out indices in [0, capacity). Released indices are set in a free bitset and allocation always
+    // takes the lowest free one (first set bit), so the used range [0, usedRangeEnd) stays as dense as removals allow.
+    // Nothing allocates after reset()
+    struct GenerationalSlotAllocator
+    {
+        void reset(uint32_t _capacity)
+        {
+            m_capacity = _capacity;
+            m_generations.assign(_capacity, 1u);
+            m_live.assign(_capacity, 0);
+            m_free.assign((_capacity + 63u) / 64u, 0);
+            m_freeCount = 0;
+            m_firstFreeWord = 0;
+            m_end = 0;
+            m_liveCount = 0;
+        }
+
+        // Invalid handle when every slot is taken
+        SlotHandle allocate()
+        {
+            uint32_t index = UINT32_MAX;
+            if (m_freeCount > 0) {
+                index = lowestFreeBit();
+                clearFree(index);
+            }
+            else if (m_end < m_capacity) {
+                index = m_end++;
+            }
+            else {
+                return {};
+            }
+
+            m_live[index] = 1;
+            m_liveCount++;
+            return { index, m_generations[index] };
+        }
+
+        // Returns false for stale or invalid handles
+        bool release(SlotHandle _handle)
+        {
+            if (!alive(_handle)) return false;
+
+            m_live[_handle.index] = 0;
+            m_generations[_handle.index]++;
+            m_liveCount--;
+
+            if (_handle.index + 1u == m_end)
+            {
+                // Pull any free slots that are now trailing off the list as well
+                m_end--;
+                while (m_end > 0 && isFree(m_end - 1u)) {
+                    clearFree(--m_end);
+                }
+            }
+            else {
+                setFree(_handle.index);
+            }
+            return true;
+        }
+
+        bool alive(SlotHandle _handle) const noexcept
+        {
+            return _handle.index < m_capacity && m_live[_handle.index] && m_generations[_handle.index] == _handle.generation;
+        }
+
+        // Slot the next allocate() returns, capacity when full. A live slot above it means the range has holes
+        uint32_t lowestFree() const noexcept { return m_freeCount > 0 ? lowestFreeBit() : m_end; }
+
+        uint32_t capacity() const noexcept { return m_capacity; }
+        uint32_t liveCount() const noexcept { return m_liveCount; }
+        uint32_t usedRangeEnd() const noexcept { return m_end; }
+
+    private:
+        bool isFree(uint32_t _index) const noexcept { return (m_free[_index / 64u] >> (_index % 64u)) & 1u; }
+        void setFree(uint32_t _index) noexcept
+        {
+            m_free[_index / 64u] |= 1ull << (_index % 64u);
+            m_freeCount++;
+            if (_index / 64u < m_firstFreeWord) m_firstFreeWord = _index / 64u;
+        }
+        void clearFree(uint32_t _index) noexcept
+        {
+            m_free[_index / 64u] &= ~(1ull << (_index % 64u));
+            m_freeCount--;
+        }
+        // Caller checks m_freeCount first. Words below m_firstFreeWord are known to be empty
+        uint32_t lowestFreeBit() const noexcept
+        {
+            uint32_t word = m_firstFreeWord;
+            while (m_free[word] == 0) word++;
+            m_firstFreeWord = word;
+            return word * 64u + static_cast<uint32_t>(std::countr_zero(m_free[word]));
+        }
+
+        uint32_t m_capacity{ 0 };
+        std::vector<uint32_t> m_generations;
+        std::vector<uint8_t> m_live;
+        std::vector<uint64_t> m_free; // Bit per slot, only indices below m_end are ever set
+        uint32_t m_freeCount{ 0 };
+        mutable uint32_t m_firstFreeWord{ 0 };
+        uint32_t m_end{ 0 };
+        uint32_t m_liveCount{ 0 };
+    };
+} // namespace Mark::Utils
@@ -57,26 +57,28 @@ if (NOT TARGET glm::glm)
 endif()
 
 
-### glslang
-set(ENABLE_GLSLANG_BINARIES    OFF CACHE BOOL "" FORCE)
-set(ENABLE_HLSL                OFF CACHE BOOL "" FORCE)
-set(ENABLE_SPVREMAPPER         OFF CACHE BOOL "" FORCE)
-set(BUILD_TESTING              OFF CACHE BOOL "" FORCE)
-set(ENABLE_CTEST               OFF CACHE BOOL "" FORCE)
-set(ENABLE_OPT                 OFF CACHE BOOL "" FORCE)
-
-FetchContent_Declare(glslang
-  GIT_REPOSITORY https://github.com/KhronosGroup/glslang.git
-  GIT_TAG        main
-)
-FetchContent_MakeAvailable(glslang)
+### glslang (runtime shader compiler only)
+if (MARK_RUNTIME_SHADER_COMPILER)
+  set(ENABLE_GLSLANG_BINARIES    OFF CACHE BOOL "" FORCE)
+  set(ENABLE_HLSL                OFF CACHE BOOL "" FORCE)
+  set(ENABLE_SPVREMAPPER         OFF CACHE BOOL "" FORCE)
+  set(BUILD_TESTING              OFF CACHE BOOL "" FORCE)
+  set(ENABLE_CTEST               OFF CACHE BOOL "" FORCE)
+  set(ENABLE_OPT                 OFF CACHE BOOL "" FORCE)
+
+  FetchContent_Declare(glslang
+    GIT_REPOSITORY https://github.com/KhronosGroup/glslang.git
+    GIT_TAG        main
+  )
+  FetchContent_MakeAvailable(glslang)
 
-set(MARK_GLSLANG_TARGETS
-    glslang::glslang
-    glslang::SPIRV
-    glslang::glslang-default-resource-limits
-    CACHE INTERNAL "glslang targets to link"
-)
+  set(MARK_GLSLANG_TARGETS
+      glslang::glslang
+      glslang::SPIRV
+      glslang::glslang-default-resource-limits
+      CACHE INTERNAL "glslang targets to link"
+  )
+endif()
 
 
 ### Dear ImGui